@@ -4,14 +4,53 @@
 #include <memory>
 #include "esp_err.h"
 
+/// Layout of the frames handed out by get_next_frame().
+enum class WebpPixelFormat : uint8_t {
+    RGBA8888,  // 4 bytes/pixel, R,G,B,A byte order (libwebp native)
+    RGB888,    // 3 bytes/pixel, R,G,B byte order
+    RGB565,    // 2 bytes/pixel, native-endian uint16, R in the top 5 bits
+};
+
 struct WebpDecoderInfo {
     uint32_t canvas_width = 0;
     uint32_t canvas_height = 0;
     uint32_t frame_count = 0;
+    uint32_t bytes_per_pixel = 4;  // of the output format
     bool has_alpha = false;
     bool is_animated = false;
 };
 
+/// Per-frame metadata from get_next_frame().
+struct WebpFrameInfo {
+    /// Canvas area that may differ from the previously returned frame;
+    /// every pixel outside it is unchanged. Derived from the frame's ANMF
+    /// rectangle and the previous frame's dispose method, so it covers the
+    /// whole canvas for the first frame after init()/reset() or a loop wrap,
+    /// and for static images.
+    uint32_t dirty_x = 0;
+    uint32_t dirty_y = 0;
+    uint32_t dirty_width = 0;
+    uint32_t dirty_height = 0;
+};
+
+struct WebpFrameCacheStats {
+    bool enabled = false;    // a cache buffer is reserved for this image
+    bool complete = false;   // every frame is cached; playback is replay-only
+    uint32_t hits = 0;       // frames served from the cache
+    uint32_t misses = 0;     // frames decoded by libwebp
+    size_t bytes = 0;        // size of the reserved cache buffer
+};
+
+/// Incremental ingest: when the first frame of an animated WebP that is still
+/// arriving lies entirely within data[0..available), copy it out as a
+/// standalone still WebP so it can be shown before the rest of the file is
+/// in. *out is heap_caps_malloc'd (SPIRAM preferred); the caller frees it.
+/// Returns ESP_ERR_NOT_FINISHED while the frame's bytes are incomplete, and
+/// ESP_ERR_NOT_SUPPORTED for still images or a first frame that does not
+/// cover the whole canvas.
+esp_err_t webp_extract_first_frame(const uint8_t* data, size_t available,
+                                   uint8_t** out, size_t* out_len);
+
 class WebpDecoder {
 public:
     WebpDecoder();
@@ -23,23 +62,45 @@ public:
     WebpDecoder& operator=(WebpDecoder&&) noexcept;
 
     /// Initialize from WebP data. Data must remain valid for lifetime of decoder.
-    esp_err_t init(const uint8_t* data, size_t size);
+    /// Frames are emitted in @p format; anything other than RGBA8888 is
+    /// packed from libwebp's RGBA canvas once per decoded frame, so every
+    /// downstream copy and compare moves fewer bytes.
+    esp_err_t init(const uint8_t* data, size_t size,
+                   WebpPixelFormat format = WebpPixelFormat::RGBA8888);
 
     /// Get info about the loaded WebP.
     WebpDecoderInfo get_info() const;
 
     /// Decode the next frame. On success *pixels_out points to the decoded
-    /// RGBA canvas (canvas_width * canvas_height * 4 bytes). The buffer is
-    /// owned by the decoder and stays valid until the next get_next_frame()
-    /// call, reset(), or destruction. Auto-loops for animations.
+    /// canvas in the output format (canvas_width * canvas_height *
+    /// bytes_per_pixel bytes). The buffer is owned by the decoder and stays
+    /// valid until the next get_next_frame() call, reset(), or destruction.
+    /// Auto-loops for animations.
     esp_err_t get_next_frame(const uint8_t** pixels_out);
 
+    /// Same as above; additionally fills @p info_out (may be null) with the
+    /// frame's changed rectangle, so callers can skip comparing the rest of
+    /// the canvas.
+    esp_err_t get_next_frame(const uint8_t** pixels_out,
+                             WebpFrameInfo* info_out);
+
     /// Get delay of last decoded frame in ms. 0 for static images.
     uint32_t get_frame_delay() const;
 
     /// Reset to first frame.
     esp_err_t reset();
 
+    /// Keep every decoded frame of an animation so later loops replay from
+    /// memory instead of running libwebp again. The whole cache (frame_count *
+    /// canvas_width * canvas_height * bytes_per_pixel) is reserved in SPIRAM
+    /// up front; returns ESP_ERR_NO_MEM without changing anything when
+    /// it would exceed @p budget_bytes or the allocation fails. No-op for
+    /// static images, which are only decoded once anyway.
+    esp_err_t enable_frame_cache(size_t budget_bytes);
+
+    /// Cache counters for the loaded image.
+    WebpFrameCacheStats get_cache_stats() const;
+
     /// Check if decoder is initialized.
     bool is_valid() const;
 
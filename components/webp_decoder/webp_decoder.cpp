@@ -1,5 +1,7 @@
 #include "webp_decoder.h"
 
+#include <cstring>
+
 #include <esp_heap_caps.h>
 #include <esp_log.h>
 #include <webp/decode.h>
@@ -7,17 +9,75 @@
 
 static const char* TAG = "webp_decoder";
 
+static uint32_t bytes_per_pixel(WebpPixelFormat format) {
+    switch (format) {
+        case WebpPixelFormat::RGB888:
+            return 3;
+        case WebpPixelFormat::RGB565:
+            return 2;
+        case WebpPixelFormat::RGBA8888:
+        default:
+            return 4;
+    }
+}
+
+// Pack RGBA pixels into a narrower output format. Each output pixel is no
+// wider than its source, so dst may alias src for an in-place conversion.
+static void pack_rgba(const uint8_t* src, uint8_t* dst, size_t pixels,
+                      WebpPixelFormat format) {
+    if (format == WebpPixelFormat::RGB888) {
+        for (size_t i = 0; i < pixels; i++, src += 4, dst += 3) {
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+        }
+    } else if (format == WebpPixelFormat::RGB565) {
+        uint16_t* out = reinterpret_cast<uint16_t*>(dst);
+        for (size_t i = 0; i < pixels; i++, src += 4) {
+            out[i] = static_cast<uint16_t>(((src[0] & 0xF8) << 8) |
+                                           ((src[1] & 0xFC) << 3) |
+                                           (src[2] >> 3));
+        }
+    }
+}
+
+// Changed area of one animation frame relative to the frame before it.
+struct DirtyRect {
+    uint16_t x, y, w, h;
+};
+
 struct WebpDecoder::Impl {
     // Common
     const uint8_t* data = nullptr;
     size_t data_size = 0;
     WebpDecoderInfo info = {};
+    WebpPixelFormat format = WebpPixelFormat::RGBA8888;
 
     // Animated
     WebPAnimDecoder* anim_decoder = nullptr;
     WebPData webp_data = {nullptr, 0};
     int last_timestamp = 0;
     uint32_t current_frame_delay_ms = 0;
+    uint32_t next_frame_index = 0;  // index of the frame GetNext returns next
+
+    // Per-frame changed rectangles, indexed like the frames; null when they
+    // could not be built, in which case every frame reports the full canvas.
+    DirtyRect* dirty_rects = nullptr;
+
+    // Frame cache (animated only). Filled in decode order on the first pass;
+    // once every frame is present, playback replays from it and libwebp is
+    // no longer called.
+    uint8_t* cache_buf = nullptr;
+    uint32_t* cache_delays = nullptr;
+    uint32_t cache_filled = 0;  // frames stored so far
+    uint32_t cache_pos = 0;     // next frame to replay once complete
+    WebpFrameCacheStats cache_stats = {};
+
+    // Packed output frame for non-RGBA formats when the frame is not being
+    // written straight into the cache. out_buf_prev is set while it holds the
+    // previously returned frame, so only the changed rectangle needs packing.
+    uint8_t* out_buf = nullptr;
+    bool out_buf_prev = false;
 
     // Static: decode on-demand from source data into a decoder-owned buffer
     bool still_decoded = false;
@@ -28,15 +88,159 @@ struct WebpDecoder::Impl {
             WebPAnimDecoderDelete(anim_decoder);
         }
         heap_caps_free(still_buf);
+        heap_caps_free(out_buf);
+        heap_caps_free(cache_buf);
+        heap_caps_free(cache_delays);
+        heap_caps_free(dirty_rects);
+    }
+
+    size_t frame_bytes() const {
+        return static_cast<size_t>(info.canvas_width) * info.canvas_height *
+               info.bytes_per_pixel;
+    }
+
+    DirtyRect full_rect() const {
+        return {0, 0, static_cast<uint16_t>(info.canvas_width),
+                static_cast<uint16_t>(info.canvas_height)};
+    }
+
+    DirtyRect dirty_rect(uint32_t index) const {
+        if (!dirty_rects || index >= info.frame_count) return full_rect();
+        return dirty_rects[index];
     }
 };
 
+static DirtyRect rect_union(DirtyRect a, DirtyRect b) {
+    const uint16_t x0 = a.x < b.x ? a.x : b.x;
+    const uint16_t y0 = a.y < b.y ? a.y : b.y;
+    const int x1 = a.x + a.w > b.x + b.w ? a.x + a.w : b.x + b.w;
+    const int y1 = a.y + a.h > b.y + b.h ? a.y + a.h : b.y + b.h;
+    return {x0, y0, static_cast<uint16_t>(x1 - x0),
+            static_cast<uint16_t>(y1 - y0)};
+}
+
+// Walk the ANMF chunks once and record what each composited frame can change.
+// WebPAnimDecoder only writes inside a frame's rectangle, except that a
+// previous frame disposed to background is cleared first, and a keyframe
+// clears the canvas (which, for every keyframe after the first, only touches
+// pixels already covered by those two rectangles). Frame 0 follows the last
+// frame or a reset, so it is always the full canvas.
+static bool build_dirty_rects(const WebPDemuxer* demux, uint32_t canvas_w,
+                              uint32_t canvas_h, uint32_t frame_count,
+                              DirtyRect* out) {
+    WebPIterator iter;
+    if (!demux || !WebPDemuxGetFrame(demux, 1, &iter)) return false;
+
+    DirtyRect prev = {};
+    bool prev_disposed = false;
+    uint32_t i = 0;
+    do {
+        if (i >= frame_count) break;
+        const DirtyRect r = {static_cast<uint16_t>(iter.x_offset),
+                             static_cast<uint16_t>(iter.y_offset),
+                             static_cast<uint16_t>(iter.width),
+                             static_cast<uint16_t>(iter.height)};
+        if (i == 0) {
+            out[i] = {0, 0, static_cast<uint16_t>(canvas_w),
+                      static_cast<uint16_t>(canvas_h)};
+        } else {
+            out[i] = prev_disposed ? rect_union(r, prev) : r;
+        }
+        prev = r;
+        prev_disposed = iter.dispose_method == WEBP_MUX_DISPOSE_BACKGROUND;
+        i++;
+    } while (WebPDemuxNextFrame(&iter));
+    WebPDemuxReleaseIterator(&iter);
+    return i == frame_count;
+}
+
+// Frame buffers prefer PSRAM; internal RAM is only a fallback.
+static uint8_t* alloc_frame_buf(size_t size) {
+    uint8_t* buf = static_cast<uint8_t*>(
+        heap_caps_malloc(size, MALLOC_CAP_SPIRAM));
+    if (!buf) {
+        buf = static_cast<uint8_t*>(
+            heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+    }
+    return buf;
+}
+
+static void put_le24(uint8_t* p, uint32_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+    p[2] = static_cast<uint8_t>(v >> 16);
+}
+
+static void put_le32(uint8_t* p, uint32_t v) {
+    put_le24(p, v);
+    p[3] = static_cast<uint8_t>(v >> 24);
+}
+
+esp_err_t webp_extract_first_frame(const uint8_t* data, size_t available,
+                                   uint8_t** out, size_t* out_len) {
+    if (!data || !out || !out_len) return ESP_ERR_INVALID_ARG;
+
+    WebPData partial = {data, available};
+    WebPDemuxState state = WEBP_DEMUX_PARSING_HEADER;
+    WebPDemuxer* demux = WebPDemuxPartial(&partial, &state);
+    if (!demux) {
+        // Not even the headers yet, or a malformed file.
+        return state == WEBP_DEMUX_PARSE_ERROR ? ESP_FAIL
+                                               : ESP_ERR_NOT_FINISHED;
+    }
+
+    const uint32_t flags = WebPDemuxGetI(demux, WEBP_FF_FORMAT_FLAGS);
+    const uint32_t canvas_w = WebPDemuxGetI(demux, WEBP_FF_CANVAS_WIDTH);
+    const uint32_t canvas_h = WebPDemuxGetI(demux, WEBP_FF_CANVAS_HEIGHT);
+    if (!(flags & ANIMATION_FLAG)) {
+        WebPDemuxDelete(demux);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    WebPIterator iter;
+    esp_err_t err = ESP_ERR_NOT_FINISHED;
+    if (WebPDemuxGetFrame(demux, 1, &iter)) {
+        if (iter.x_offset != 0 || iter.y_offset != 0 ||
+            static_cast<uint32_t>(iter.width) != canvas_w ||
+            static_cast<uint32_t>(iter.height) != canvas_h) {
+            err = ESP_ERR_NOT_SUPPORTED;
+        } else if (iter.complete) {
+            // RIFF + VP8X header in front of the frame's ALPH/VP8/VP8L
+            // chunks, which the fragment already carries padded.
+            constexpr size_t kHeader = 12 + 8 + 10;
+            const size_t len = kHeader + iter.fragment.size;
+            uint8_t* buf = alloc_frame_buf(len);
+            if (!buf) {
+                err = ESP_ERR_NO_MEM;
+            } else {
+                memcpy(buf, "RIFF", 4);
+                put_le32(buf + 4, static_cast<uint32_t>(len - 8));
+                memcpy(buf + 8, "WEBPVP8X", 8);
+                put_le32(buf + 16, 10);
+                put_le32(buf + 20, iter.has_alpha ? ALPHA_FLAG : 0);
+                put_le24(buf + 24, canvas_w - 1);
+                put_le24(buf + 27, canvas_h - 1);
+                memcpy(buf + kHeader, iter.fragment.bytes, iter.fragment.size);
+                *out = buf;
+                *out_len = len;
+                err = ESP_OK;
+            }
+        }
+        WebPDemuxReleaseIterator(&iter);
+    } else if (state == WEBP_DEMUX_PARSE_ERROR) {
+        err = ESP_FAIL;
+    }
+    WebPDemuxDelete(demux);
+    return err;
+}
+
 WebpDecoder::WebpDecoder() = default;
 WebpDecoder::~WebpDecoder() = default;
 WebpDecoder::WebpDecoder(WebpDecoder&&) noexcept = default;
 WebpDecoder& WebpDecoder::operator=(WebpDecoder&&) noexcept = default;
 
-esp_err_t WebpDecoder::init(const uint8_t* data, size_t size) {
+esp_err_t WebpDecoder::init(const uint8_t* data, size_t size,
+                            WebpPixelFormat format) {
     if (!data || size == 0) {
         ESP_LOGE(TAG, "No WebP data");
         return ESP_ERR_INVALID_ARG;
@@ -45,6 +249,8 @@ esp_err_t WebpDecoder::init(const uint8_t* data, size_t size) {
     auto p = std::make_unique<Impl>();
     p->data = data;
     p->data_size = size;
+    p->format = format;
+    p->info.bytes_per_pixel = bytes_per_pixel(format);
 
     // Detect static vs animated using WebPGetFeatures
     WebPBitstreamFeatures features;
@@ -66,7 +272,8 @@ esp_err_t WebpDecoder::init(const uint8_t* data, size_t size) {
     }
 
     if (p->info.is_animated) {
-        // Animated path: use WebPAnimDecoder
+        // Animated path: use WebPAnimDecoder. It only composites into 4-byte
+        // modes, so packed formats are produced after each GetNext.
         p->webp_data.bytes = data;
         p->webp_data.size = size;
 
@@ -90,6 +297,18 @@ esp_err_t WebpDecoder::init(const uint8_t* data, size_t size) {
         p->last_timestamp = 0;
         p->current_frame_delay_ms = 0;
 
+        // Optional: without the table every frame reports the full canvas.
+        p->dirty_rects = static_cast<DirtyRect*>(heap_caps_malloc(
+            p->info.frame_count * sizeof(DirtyRect), MALLOC_CAP_SPIRAM));
+        if (p->dirty_rects &&
+            !build_dirty_rects(WebPAnimDecoderGetDemuxer(p->anim_decoder),
+                               p->info.canvas_width, p->info.canvas_height,
+                               p->info.frame_count, p->dirty_rects)) {
+            ESP_LOGW(TAG, "Frame rectangles unavailable; reporting full canvas");
+            heap_caps_free(p->dirty_rects);
+            p->dirty_rects = nullptr;
+        }
+
         ESP_LOGI(TAG, "Animated: %u frames, %ux%u",
                  p->info.frame_count, p->info.canvas_width,
                  p->info.canvas_height);
@@ -113,22 +332,31 @@ WebpDecoderInfo WebpDecoder::get_info() const {
     return impl_->info;
 }
 
+static void fill_frame_info(WebpFrameInfo* info, DirtyRect r) {
+    if (!info) return;
+    info->dirty_x = r.x;
+    info->dirty_y = r.y;
+    info->dirty_width = r.w;
+    info->dirty_height = r.h;
+}
+
 esp_err_t WebpDecoder::get_next_frame(const uint8_t** pixels_out) {
+    return get_next_frame(pixels_out, nullptr);
+}
+
+esp_err_t WebpDecoder::get_next_frame(const uint8_t** pixels_out,
+                                      WebpFrameInfo* info_out) {
     if (!impl_ || !pixels_out) return ESP_ERR_INVALID_STATE;
 
     if (!impl_->info.is_animated) {
         // Static: decode once into a decoder-owned buffer; subsequent calls
-        // just hand the cached pixels back.
+        // just hand the cached pixels back. The buffer is sized for RGBA and
+        // packed in place for narrower formats.
         if (!impl_->still_decoded) {
             size_t frame_size = static_cast<size_t>(impl_->info.canvas_width) *
                                 impl_->info.canvas_height * 4;
             if (!impl_->still_buf) {
-                impl_->still_buf = static_cast<uint8_t*>(
-                    heap_caps_malloc(frame_size, MALLOC_CAP_SPIRAM));
-                if (!impl_->still_buf) {
-                    impl_->still_buf = static_cast<uint8_t*>(heap_caps_malloc(
-                        frame_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
-                }
+                impl_->still_buf = alloc_frame_buf(frame_size);
                 if (!impl_->still_buf) {
                     ESP_LOGE(TAG, "Static frame buffer alloc failed (%zu)",
                              frame_size);
@@ -141,10 +369,27 @@ esp_err_t WebpDecoder::get_next_frame(const uint8_t** pixels_out) {
                 ESP_LOGE(TAG, "Failed to decode static WebP");
                 return ESP_FAIL;
             }
+            pack_rgba(impl_->still_buf, impl_->still_buf,
+                      frame_size / 4, impl_->format);
             impl_->still_decoded = true;
         }
         impl_->current_frame_delay_ms = 0;
         *pixels_out = impl_->still_buf;
+        fill_frame_info(info_out, impl_->full_rect());
+        return ESP_OK;
+    }
+
+    Impl& p = *impl_;
+
+    // Fully cached: replay without touching libwebp.
+    if (p.cache_stats.complete) {
+        if (p.cache_pos >= p.info.frame_count) p.cache_pos = 0;
+        *pixels_out = p.cache_buf + p.cache_pos * p.frame_bytes();
+        p.current_frame_delay_ms = p.cache_delays[p.cache_pos];
+        fill_frame_info(info_out, p.dirty_rect(p.cache_pos));
+        p.out_buf_prev = false;
+        p.cache_pos++;
+        p.cache_stats.hits++;
         return ESP_OK;
     }
 
@@ -152,23 +397,77 @@ esp_err_t WebpDecoder::get_next_frame(const uint8_t** pixels_out) {
     if (!WebPAnimDecoderHasMoreFrames(impl_->anim_decoder)) {
         WebPAnimDecoderReset(impl_->anim_decoder);
         impl_->last_timestamp = 0;
+        impl_->next_frame_index = 0;
     }
 
-    // The returned pointer references the anim decoder's internal canvas,
-    // valid until the next WebPAnimDecoderGetNext/Reset. Handing it out
-    // directly avoids a full-canvas PSRAM-to-PSRAM copy per frame.
+    // For RGBA the returned pointer references the anim decoder's internal
+    // canvas, valid until the next WebPAnimDecoderGetNext/Reset. Handing it
+    // out directly avoids a full-canvas PSRAM-to-PSRAM copy per frame.
     uint8_t* pix = nullptr;
     int timestamp = 0;
     if (!WebPAnimDecoderGetNext(impl_->anim_decoder, &pix, &timestamp)) {
         ESP_LOGE(TAG, "WebPAnimDecoderGetNext failed");
+        impl_->out_buf_prev = false;
         return ESP_FAIL;
     }
-    *pixels_out = pix;
 
     int delay = timestamp - impl_->last_timestamp;
     impl_->current_frame_delay_ms =
         static_cast<uint32_t>(delay > 0 ? delay : 1);
     impl_->last_timestamp = timestamp;
+    p.cache_stats.misses++;
+
+    // Frames arrive in order, so a frame is stored only when it extends the
+    // cached prefix; a reset mid-fill just re-decodes frames already held.
+    const uint32_t index = p.next_frame_index++;
+    const bool store = p.cache_buf && !p.cache_stats.complete &&
+                       index == p.cache_filled && index < p.info.frame_count;
+    uint8_t* slot = store ? p.cache_buf + index * p.frame_bytes() : nullptr;
+    const DirtyRect dirty = p.dirty_rect(index);
+    fill_frame_info(info_out, dirty);
+
+    if (p.format == WebpPixelFormat::RGBA8888) {
+        if (slot) memcpy(slot, pix, p.frame_bytes());
+        *pixels_out = pix;
+    } else if (slot) {
+        // Pack straight into the cache slot when filling, so the packed
+        // frame is written once.
+        pack_rgba(pix, slot,
+                  static_cast<size_t>(p.info.canvas_width) *
+                      p.info.canvas_height,
+                  p.format);
+        p.out_buf_prev = false;
+        *pixels_out = slot;
+    } else {
+        if (!p.out_buf) p.out_buf = alloc_frame_buf(p.frame_bytes());
+        if (!p.out_buf) {
+            ESP_LOGE(TAG, "Output frame alloc failed (%zu)", p.frame_bytes());
+            return ESP_ERR_NO_MEM;
+        }
+        // out_buf still holds the previous frame: repack only what changed.
+        const DirtyRect r = p.out_buf_prev ? dirty : p.full_rect();
+        const size_t stride = p.info.canvas_width;
+        for (uint32_t y = r.y; y < static_cast<uint32_t>(r.y + r.h); y++) {
+            const size_t px = y * stride + r.x;
+            pack_rgba(pix + px * 4, p.out_buf + px * p.info.bytes_per_pixel,
+                      r.w, p.format);
+        }
+        p.out_buf_prev = true;
+        *pixels_out = p.out_buf;
+    }
+
+    if (store) {
+        p.cache_delays[index] = p.current_frame_delay_ms;
+        p.cache_filled++;
+        if (p.cache_filled == p.info.frame_count) {
+            // The anim decoder is positioned after the last frame, so the
+            // next replayed frame is frame 0, same as the auto-loop above.
+            p.cache_stats.complete = true;
+            p.cache_pos = p.info.frame_count;
+            ESP_LOGI(TAG, "Frame cache complete: %u frames, %zu bytes",
+                     p.info.frame_count, p.cache_stats.bytes);
+        }
+    }
 
     return ESP_OK;
 }
@@ -186,10 +485,56 @@ esp_err_t WebpDecoder::reset() {
     }
     impl_->last_timestamp = 0;
     impl_->current_frame_delay_ms = 0;
+    impl_->next_frame_index = 0;
+    impl_->cache_pos = 0;
+    impl_->out_buf_prev = false;
     impl_->still_decoded = false;
     return ESP_OK;
 }
 
+esp_err_t WebpDecoder::enable_frame_cache(size_t budget_bytes) {
+    if (!impl_) return ESP_ERR_INVALID_STATE;
+    Impl& p = *impl_;
+    if (!p.info.is_animated || p.cache_buf) return ESP_OK;
+    if (p.info.frame_count == 0) return ESP_ERR_INVALID_STATE;
+
+    const size_t total = p.frame_bytes() * p.info.frame_count;
+    if (total / p.info.frame_count != p.frame_bytes() || total > budget_bytes) {
+        ESP_LOGD(TAG, "Frame cache skipped: %u frames need %zu bytes (budget %zu)",
+                 p.info.frame_count, total, budget_bytes);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // SPIRAM only: the cache is a convenience and must never compete with
+    // TLS or task stacks for internal RAM.
+    p.cache_buf = static_cast<uint8_t*>(
+        heap_caps_malloc(total, MALLOC_CAP_SPIRAM));
+    p.cache_delays = static_cast<uint32_t*>(heap_caps_malloc(
+        p.info.frame_count * sizeof(uint32_t), MALLOC_CAP_SPIRAM));
+    if (!p.cache_buf || !p.cache_delays) {
+        heap_caps_free(p.cache_buf);
+        heap_caps_free(p.cache_delays);
+        p.cache_buf = nullptr;
+        p.cache_delays = nullptr;
+        ESP_LOGW(TAG, "Frame cache alloc failed (%zu bytes)", total);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Frames already decoded before the cache existed are not stored; the
+    // fill starts over from frame 0 on the next loop.
+    p.cache_filled = 0;
+    p.cache_stats.enabled = true;
+    p.cache_stats.bytes = total;
+    ESP_LOGI(TAG, "Frame cache reserved: %u frames, %zu bytes",
+             p.info.frame_count, total);
+    return ESP_OK;
+}
+
+WebpFrameCacheStats WebpDecoder::get_cache_stats() const {
+    if (!impl_) return {};
+    return impl_->cache_stats;
+}
+
 bool WebpDecoder::is_valid() const {
     return impl_ != nullptr;
 }
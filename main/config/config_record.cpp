@@ -0,0 +1,97 @@
+#include "config_record.h"
+
+#include <string.h>
+
+namespace {
+
+constexpr size_t FIELD_HEADER = 3;  // tag + 16-bit length
+
+size_t str_len(const config_field_t& f, const uint8_t* base) {
+  const char* s = reinterpret_cast<const char*>(base + f.offset);
+  return strnlen(s, f.size > 0 ? f.size - 1 : 0);
+}
+
+const config_field_t* find(const config_field_t* fields, size_t count,
+                           uint8_t tag) {
+  for (size_t i = 0; i < count; i++) {
+    if (fields[i].tag == tag) return &fields[i];
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+size_t config_record_max_size(const config_field_t* fields, size_t count) {
+  size_t n = 1;
+  for (size_t i = 0; i < count; i++) n += FIELD_HEADER + fields[i].size;
+  return n;
+}
+
+size_t config_record_encode(const config_field_t* fields, size_t count,
+                            const void* cfg, uint8_t* out, size_t out_len) {
+  if (!fields || !cfg || !out || out_len < 1) return 0;
+  const auto* base = static_cast<const uint8_t*>(cfg);
+  size_t pos = 0;
+  out[pos++] = CONFIG_RECORD_VERSION;
+  for (size_t i = 0; i < count; i++) {
+    const config_field_t& f = fields[i];
+    const size_t len = f.kind == CONFIG_FIELD_STR ? str_len(f, base) : f.size;
+    if (pos + FIELD_HEADER + len > out_len) return 0;
+    out[pos++] = f.tag;
+    out[pos++] = static_cast<uint8_t>(len & 0xFF);
+    out[pos++] = static_cast<uint8_t>(len >> 8);
+    memcpy(out + pos, base + f.offset, len);
+    pos += len;
+  }
+  return pos;
+}
+
+bool config_record_decode(const config_field_t* fields, size_t count,
+                          const uint8_t* in, size_t in_len, void* cfg) {
+  if (!fields || !in || !cfg || in_len < 1 ||
+      in[0] != CONFIG_RECORD_VERSION) {
+    return false;
+  }
+  auto* base = static_cast<uint8_t*>(cfg);
+  size_t pos = 1;
+  while (pos < in_len) {
+    if (in_len - pos < FIELD_HEADER) return false;
+    const uint8_t tag = in[pos];
+    const size_t len = in[pos + 1] | (static_cast<size_t>(in[pos + 2]) << 8);
+    pos += FIELD_HEADER;
+    if (in_len - pos < len) return false;
+
+    const config_field_t* f = find(fields, count, tag);
+    if (f && f->kind == CONFIG_FIELD_STR && f->size > 0) {
+      const size_t n = len < f->size ? len : f->size - 1;
+      memcpy(base + f->offset, in + pos, n);
+      base[f->offset + n] = '\0';
+    } else if (f && f->kind == CONFIG_FIELD_RAW && len == f->size) {
+      memcpy(base + f->offset, in + pos, len);
+    }
+    // Unknown tags and size mismatches are skipped.
+    pos += len;
+  }
+  return true;
+}
+
+uint32_t config_record_changed(const config_field_t* fields, size_t count,
+                               const void* a, const void* b) {
+  if (!fields || !a || !b) return 0;
+  const auto* pa = static_cast<const uint8_t*>(a);
+  const auto* pb = static_cast<const uint8_t*>(b);
+  uint32_t mask = 0;
+  for (size_t i = 0; i < count && i < 32; i++) {
+    const config_field_t& f = fields[i];
+    bool differs;
+    if (f.kind == CONFIG_FIELD_STR) {
+      const size_t la = str_len(f, pa);
+      differs = la != str_len(f, pb) ||
+                memcmp(pa + f.offset, pb + f.offset, la) != 0;
+    } else {
+      differs = memcmp(pa + f.offset, pb + f.offset, f.size) != 0;
+    }
+    if (differs) mask |= 1u << i;
+  }
+  return mask;
+}
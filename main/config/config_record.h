@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Version byte leading every record.
+#define CONFIG_RECORD_VERSION 1
+
+typedef enum {
+  CONFIG_FIELD_STR = 0,  // NUL-terminated char[size]; stored without padding
+  CONFIG_FIELD_RAW,      // size bytes stored as is (bools, enums)
+} config_field_kind_t;
+
+// One settings field: a stable tag plus where it lives in the struct.
+// Tags are part of the stored format and must never be reused.
+typedef struct {
+  uint8_t tag;
+  uint8_t kind;     // config_field_kind_t
+  uint16_t offset;  // offsetof in the settings struct
+  uint16_t size;    // sizeof the member
+} config_field_t;
+
+// Compact, versioned serialization of a settings struct described by a field
+// table: a version byte, then per field its tag, a 16-bit little-endian
+// length and the value. Strings are stored only up to their NUL, so a record
+// is a fraction of the struct size. Decoding skips tags it does not know and
+// leaves fields missing from the record untouched, so fields can be added
+// without a format change. Pure, with no ESP dependencies so it is
+// host-testable.
+
+// Largest record the table can produce.
+size_t config_record_max_size(const config_field_t* fields, size_t count);
+
+// Encode cfg into out. Returns the length, or 0 if out is too small.
+size_t config_record_encode(const config_field_t* fields, size_t count,
+                            const void* cfg, uint8_t* out, size_t out_len);
+
+// Apply a record onto cfg. Returns false (cfg possibly partly updated) for a
+// record that is truncated or from an unknown version.
+bool config_record_decode(const config_field_t* fields, size_t count,
+                          const uint8_t* in, size_t in_len, void* cfg);
+
+// Bit i set when fields[i] differs between a and b (first 32 fields).
+uint32_t config_record_changed(const config_field_t* fields, size_t count,
+                               const void* a, const void* b);
+
+#ifdef __cplusplus
+}
+#endif
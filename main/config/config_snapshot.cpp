@@ -0,0 +1,54 @@
+#include "config_snapshot.h"
+
+#include <string.h>
+
+bool config_snapshot_init(config_snapshot_t* s, void* buffers, size_t size,
+                          const void* initial) {
+  if (!s || !buffers || size == 0 || !initial) return false;
+  auto* base = static_cast<uint8_t*>(buffers);
+  for (uint32_t i = 0; i < CONFIG_SNAPSHOT_SLOTS; i++) {
+    s->slots[i].data = base + i * size;
+    s->slots[i].refs = 0;
+  }
+  s->size = size;
+  memcpy(s->slots[0].data, initial, size);
+  __atomic_store_n(&s->current, 0, __ATOMIC_SEQ_CST);
+  return true;
+}
+
+const void* config_snapshot_acquire(config_snapshot_t* s) {
+  while (true) {
+    const uint32_t i = __atomic_load_n(&s->current, __ATOMIC_SEQ_CST);
+    __atomic_fetch_add(&s->slots[i].refs, 1, __ATOMIC_SEQ_CST);
+    // The slot may have been retired and picked up for refilling between the
+    // load and the increment. If it is still (or again) the published one,
+    // the writer has finished with it and the increment keeps it that way.
+    if (__atomic_load_n(&s->current, __ATOMIC_SEQ_CST) == i) {
+      return s->slots[i].data;
+    }
+    __atomic_fetch_sub(&s->slots[i].refs, 1, __ATOMIC_SEQ_CST);
+  }
+}
+
+void config_snapshot_release(config_snapshot_t* s, const void* data) {
+  for (uint32_t i = 0; i < CONFIG_SNAPSHOT_SLOTS; i++) {
+    if (s->slots[i].data == data) {
+      __atomic_fetch_sub(&s->slots[i].refs, 1, __ATOMIC_SEQ_CST);
+      return;
+    }
+  }
+}
+
+bool config_snapshot_publish(config_snapshot_t* s, const void* value) {
+  const uint32_t cur = __atomic_load_n(&s->current, __ATOMIC_SEQ_CST);
+  for (uint32_t k = 1; k < CONFIG_SNAPSHOT_SLOTS; k++) {
+    const uint32_t i = (cur + k) % CONFIG_SNAPSHOT_SLOTS;
+    // A reader that increments after this check sees current != i and backs
+    // off without reading, so the slot is ours until it is published.
+    if (__atomic_load_n(&s->slots[i].refs, __ATOMIC_SEQ_CST) != 0) continue;
+    memcpy(s->slots[i].data, value, s->size);
+    __atomic_store_n(&s->current, i, __ATOMIC_SEQ_CST);
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Buffers per snapshot: the published one plus spares for the writer.
+#define CONFIG_SNAPSHOT_SLOTS 3
+
+typedef struct {
+  uint8_t* data;
+  uint32_t refs;  // readers holding this buffer
+} config_snapshot_slot_t;
+
+// Read-mostly value published as immutable copies. Readers borrow the
+// current copy without locking or copying; a publish fills a spare buffer
+// no reader holds and then switches readers over to it, so a borrowed copy
+// never changes underneath its reader. Any number of readers, one writer at
+// a time (the caller serializes publishes). Uses GCC __atomic builtins only,
+// with no RTOS or ESP dependencies so it is host-testable.
+typedef struct {
+  config_snapshot_slot_t slots[CONFIG_SNAPSHOT_SLOTS];
+  size_t size;
+  uint32_t current;  // index of the published slot
+} config_snapshot_t;
+
+// buffers holds CONFIG_SNAPSHOT_SLOTS * size bytes; initial is published.
+bool config_snapshot_init(config_snapshot_t* s, void* buffers, size_t size,
+                          const void* initial);
+
+// Borrow the published copy. Never null after init. Pair with release.
+const void* config_snapshot_acquire(config_snapshot_t* s);
+void config_snapshot_release(config_snapshot_t* s, const void* data);
+
+// Publish a copy of value. Returns false, publishing nothing, while readers
+// still hold every spare buffer; retry once they have released.
+bool config_snapshot_publish(config_snapshot_t* s, const void* value);
+
+#ifdef __cplusplus
+}
+#endif
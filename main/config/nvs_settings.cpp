@@ -1,11 +1,18 @@
 #include "nvs_settings.h"
 
+#include <cstddef>
 #include <cstdlib>
 #include <cstring>
 
+#include <esp_heap_caps.h>
+#include <esp_system.h>
+#include <esp_timer.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
+#include <freertos/task.h>
 
+#include "config_record.h"
+#include "config_snapshot.h"
 #include "esp_log.h"
 #include "event_bus.h"
 #include "nvs_flash.h"
@@ -30,24 +37,77 @@ constexpr const char* NVS_KEY_AP_MODE = "ap_mode";
 constexpr const char* NVS_KEY_PREFER_IPV6 = "prefer_ipv6";
 constexpr const char* NVS_KEY_DISABLE_TOUCH = "dis_touch";
 
-// Atomic save keys — blob-based config persistence
+// Settings are stored as one config_record. NVS keeps the old value of a key
+// until the new one is completely written, so a single set is power-loss
+// safe. The keys above and the raw struct blobs below are the older formats,
+// read once to migrate; "cfg" is left in place for a firmware downgrade.
+constexpr const char* NVS_KEY_CFG_RECORD = "cfg2";
 constexpr const char* NVS_KEY_CFG_CUR = "cfg";
 constexpr const char* NVS_KEY_CFG_NEW = "cfg_new";
 
+#ifndef CONFIG_SETTINGS_SAVE_DELAY_MS
+#define CONFIG_SETTINGS_SAVE_DELAY_MS 2000
+#endif
+
+// A change is written once no further change came for the save delay, or
+// after this long under a steady stream of changes.
+constexpr int64_t MAX_SAVE_DEFER_US =
+    5LL * CONFIG_SETTINGS_SAVE_DELAY_MS * 1000;
+constexpr size_t WRITER_STACK_SIZE = 3072;  // NVS writes: internal RAM stack
+constexpr int WRITER_TASK_PRIORITY = 1;
+constexpr uint32_t NOTIFY_CHANGED = 1u << 0;
+constexpr uint32_t NOTIFY_FLUSH = 1u << 1;
+constexpr TickType_t FLUSH_TIMEOUT = pdMS_TO_TICKS(1000);
+
+// Tags are stored in flash: append new fields, never renumber or reuse.
+#define CFG_FIELD(tag, kind, member)                                      \
+  {tag, kind, static_cast<uint16_t>(offsetof(system_config_t, member)), \
+   static_cast<uint16_t>(sizeof(system_config_t::member))}
+const config_field_t kFields[] = {
+    CFG_FIELD(1, CONFIG_FIELD_STR, hostname),
+    CFG_FIELD(2, CONFIG_FIELD_STR, syslog_addr),
+    CFG_FIELD(3, CONFIG_FIELD_STR, sntp_server),
+    CFG_FIELD(4, CONFIG_FIELD_STR, image_url),
+    CFG_FIELD(5, CONFIG_FIELD_STR, api_key),
+    CFG_FIELD(6, CONFIG_FIELD_RAW, swap_colors),
+    CFG_FIELD(7, CONFIG_FIELD_RAW, wifi_power_save),
+    CFG_FIELD(8, CONFIG_FIELD_RAW, skip_display_version),
+    CFG_FIELD(9, CONFIG_FIELD_RAW, skip_boot_animation),
+    CFG_FIELD(10, CONFIG_FIELD_RAW, ap_mode),
+    CFG_FIELD(11, CONFIG_FIELD_RAW, prefer_ipv6),
+    CFG_FIELD(12, CONFIG_FIELD_RAW, disable_touch),
+};
+#undef CFG_FIELD
+constexpr size_t FIELD_COUNT = sizeof(kFields) / sizeof(kFields[0]);
+constexpr size_t RECORD_MAX = 1 + 3 * FIELD_COUNT + sizeof(system_config_t);
+
 // Multi-network list lives in its own namespace so the main config blob (and
 // its NVS-migration risk) is untouched. A device that loses this blob degrades
 // to a single-credential device via the legacy keys, not a factory reset.
 constexpr const char* NVS_NETS_NAMESPACE = "wifi_nets";
 constexpr const char* NVS_NETS_KEY = "nets";
+constexpr const char* NVS_LAST_AP_KEY = "last_ap";
 
 // Persist a refreshed last_rssi only when it moves at least this much (or was
 // previously unknown), so frequent reconnects don't grind the flash.
 constexpr int RSSI_PERSIST_DELTA_DB = 5;
 
+// s_config is the writer's copy, under s_mutex; readers get s_snapshot.
 system_config_t s_config = {};
+config_snapshot_t s_snapshot = {};
 wifi_network_t s_nets[MAX_WIFI_NETS] = {};
+wifi_last_ap_t s_last_ap = {};
 SemaphoreHandle_t s_mutex = nullptr;
-uint32_t s_generation = 0;
+uint32_t s_generation = 0;  // atomic; written under s_mutex
+
+// Writer state, guarded by s_mutex. s_persisted mirrors the stored record.
+system_config_t s_persisted = {};
+bool s_have_record = false;
+bool s_dirty = false;
+uint8_t s_record[RECORD_MAX];
+config_persist_stats_t s_stats = {};
+TaskHandle_t s_writer = nullptr;
+SemaphoreHandle_t s_flushed = nullptr;  // given after a requested flush
 
 #ifndef WIFI_SSID
 #define WIFI_SSID ""
@@ -59,68 +119,154 @@ uint32_t s_generation = 0;
 #define REMOTE_URL ""
 #endif
 
-/// Atomic save: write to temp key, validate, swap to main key, erase temp.
-/// Caller must hold s_mutex.
-esp_err_t persist_to_nvs() {
+/// Write s_config as a record unless flash already holds the same values.
+/// On failure the change stays pending for the next flush. Caller must hold
+/// s_mutex.
+esp_err_t persist_locked() {
+  if (!s_dirty) return ESP_OK;
+  const uint32_t changed =
+      config_record_changed(kFields, FIELD_COUNT, &s_persisted, &s_config);
+  if (s_have_record && changed == 0) {
+    s_dirty = false;
+    s_stats.unchanged++;
+    return ESP_OK;
+  }
+
+  const size_t len = config_record_encode(kFields, FIELD_COUNT, &s_config,
+                                          s_record, sizeof(s_record));
   NvsHandle nvs(NVS_NAMESPACE, NVS_READWRITE);
   if (!nvs) return nvs.open_error();
-
-  // Step 1: Write config blob to temp key
-  esp_err_t err =
-      nvs.set_blob(NVS_KEY_CFG_NEW, &s_config, sizeof(system_config_t));
+  esp_err_t err = nvs.set_blob(NVS_KEY_CFG_RECORD, s_record, len);
+  if (err == ESP_OK) err = nvs.commit();
   if (err != ESP_OK) {
-    ESP_LOGE(TAG, "Failed to write temp config blob: %s",
-             esp_err_to_name(err));
+    ESP_LOGE(TAG, "Failed to write config record: %s", esp_err_to_name(err));
     return err;
   }
-  err = nvs.commit();
-  if (err != ESP_OK) return err;
 
-  // Step 2: Read back and validate temp key matches
-  system_config_t verify = {};
-  size_t verify_len = sizeof(verify);
-  err = nvs.get_blob(NVS_KEY_CFG_NEW, &verify, &verify_len);
-  if (err != ESP_OK || verify_len != sizeof(system_config_t) ||
-      memcmp(&verify, &s_config, sizeof(system_config_t)) != 0) {
-    ESP_LOGE(TAG, "Config blob verification failed");
-    nvs.erase_key(NVS_KEY_CFG_NEW);
-    nvs.commit();
-    return ESP_FAIL;
+  memcpy(&s_persisted, &s_config, sizeof(system_config_t));
+  s_have_record = true;
+  s_dirty = false;
+  s_stats.writes++;
+  s_stats.bytes_written += len;
+  s_stats.record_bytes = len;
+  ESP_LOGI(TAG, "Config saved (%u bytes, fields changed 0x%03lx)",
+           static_cast<unsigned>(len), static_cast<unsigned long>(changed));
+  return ESP_OK;
+}
+
+void writer_task(void*) {
+  while (true) {
+    uint32_t bits = 0;
+    xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+    // Let a burst settle: every further change restarts the wait.
+    const int64_t first_us = esp_timer_get_time();
+    while (!(bits & NOTIFY_FLUSH) &&
+           esp_timer_get_time() - first_us < MAX_SAVE_DEFER_US &&
+           xTaskNotifyWait(0, UINT32_MAX, &bits,
+                           pdMS_TO_TICKS(CONFIG_SETTINGS_SAVE_DELAY_MS)) ==
+               pdTRUE) {
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    persist_locked();
+    xSemaphoreGive(s_mutex);
+    if (bits & NOTIFY_FLUSH) xSemaphoreGive(s_flushed);
   }
+}
 
-  // Step 3: Write validated data to main key
-  err = nvs.set_blob(NVS_KEY_CFG_CUR, &s_config, sizeof(system_config_t));
-  if (err != ESP_OK) {
-    ESP_LOGE(TAG, "Failed to write main config blob: %s",
-             esp_err_to_name(err));
-    return err;
+void on_shutdown() { config_flush(); }
+
+/// Load the settings record over the defaults in s_config. Init only.
+bool load_record() {
+  NvsHandle nvs(NVS_NAMESPACE, NVS_READONLY);
+  if (!nvs) return false;
+  size_t len = sizeof(s_record);
+  if (nvs.get_blob(NVS_KEY_CFG_RECORD, s_record, &len) != ESP_OK) {
+    return false;
   }
+  system_config_t cfg = s_config;
+  if (!config_record_decode(kFields, FIELD_COUNT, s_record, len, &cfg)) {
+    ESP_LOGW(TAG, "Ignoring unreadable config record");
+    return false;
+  }
+  memcpy(&s_config, &cfg, sizeof(system_config_t));
+  return true;
+}
+
+/// Whether the per-field keys exist: they were rewritten on every save by
+/// firmware before the config record, so after migration they only come
+/// back if older firmware has run since.
+bool has_legacy_keys() {
+  NvsHandle nvs(NVS_NAMESPACE, NVS_READONLY);
+  if (!nvs) return false;
+  uint8_t val_u8;
+  size_t sz = 0;
+  return nvs.get_u8(NVS_KEY_AP_MODE, &val_u8) == ESP_OK ||
+         nvs.get_str(NVS_KEY_IMAGE_URL, nullptr, &sz) == ESP_OK;
+}
 
-  // Step 4: Erase temp key and commit
-  nvs.erase_key(NVS_KEY_CFG_NEW);
-  err = nvs.commit();
-
-  // Also persist individual keys for backward compatibility with
-  // existing code that reads them (e.g., on downgrade)
-  nvs.set_str(NVS_KEY_HOSTNAME, s_config.hostname);
-  nvs.set_str(NVS_KEY_SYSLOG_ADDR, s_config.syslog_addr);
-  nvs.set_str(NVS_KEY_SNTP_SERVER, s_config.sntp_server);
-  nvs.set_str(NVS_KEY_IMAGE_URL, s_config.image_url);
-  nvs.set_str(NVS_KEY_API_KEY, s_config.api_key);
-  nvs.set_u8(NVS_KEY_SWAP_COLORS, s_config.swap_colors ? 1 : 0);
-  nvs.set_u8(NVS_KEY_WIFI_POWER_SAVE,
-             static_cast<uint8_t>(s_config.wifi_power_save));
-  nvs.set_u8(NVS_KEY_SKIP_VERSION, s_config.skip_display_version ? 1 : 0);
-  nvs.set_u8(NVS_KEY_SKIP_BOOT, s_config.skip_boot_animation ? 1 : 0);
-  nvs.set_u8(NVS_KEY_AP_MODE, s_config.ap_mode ? 1 : 0);
-  nvs.set_u8(NVS_KEY_PREFER_IPV6, s_config.prefer_ipv6 ? 1 : 0);
-  nvs.set_u8(NVS_KEY_DISABLE_TOUCH, s_config.disable_touch ? 1 : 0);
+void erase_legacy_keys() {
+  NvsHandle nvs(NVS_NAMESPACE, NVS_READWRITE);
+  if (!nvs) return;
+  const char* const keys[] = {
+      NVS_KEY_HOSTNAME,       NVS_KEY_SYSLOG_ADDR, NVS_KEY_SNTP_SERVER,
+      NVS_KEY_IMAGE_URL,      NVS_KEY_API_KEY,     NVS_KEY_SWAP_COLORS,
+      NVS_KEY_WIFI_POWER_SAVE, NVS_KEY_SKIP_VERSION, NVS_KEY_SKIP_BOOT,
+      NVS_KEY_AP_MODE,        NVS_KEY_PREFER_IPV6, NVS_KEY_DISABLE_TOUCH,
+  };
+  for (const char* key : keys) nvs.erase_key(key);
   nvs.commit();
+}
+
+/// Load settings from the per-field keys over the defaults in s_config.
+void load_legacy_keys() {
+  NvsHandle nvs(NVS_NAMESPACE, NVS_READONLY);
+  if (!nvs) return;
+
+  size_t sz = sizeof(s_config.hostname);
+  if (nvs.get_str(NVS_KEY_HOSTNAME, s_config.hostname, &sz) != ESP_OK)
+    s_config.hostname[0] = '\0';
+
+  sz = sizeof(s_config.syslog_addr);
+  if (nvs.get_str(NVS_KEY_SYSLOG_ADDR, s_config.syslog_addr, &sz) != ESP_OK)
+    s_config.syslog_addr[0] = '\0';
+
+  sz = sizeof(s_config.sntp_server);
+  if (nvs.get_str(NVS_KEY_SNTP_SERVER, s_config.sntp_server, &sz) != ESP_OK)
+    s_config.sntp_server[0] = '\0';
 
-  return err;
+  sz = sizeof(s_config.image_url);
+  if (nvs.get_str(NVS_KEY_IMAGE_URL, s_config.image_url, &sz) != ESP_OK)
+    s_config.image_url[0] = '\0';
+
+  sz = sizeof(s_config.api_key);
+  if (nvs.get_str(NVS_KEY_API_KEY, s_config.api_key, &sz) != ESP_OK)
+    s_config.api_key[0] = '\0';
+
+  uint8_t val_u8;
+
+  if (nvs.get_u8(NVS_KEY_SWAP_COLORS, &val_u8) == ESP_OK)
+    s_config.swap_colors = (val_u8 != 0);
+
+  if (nvs.get_u8(NVS_KEY_WIFI_POWER_SAVE, &val_u8) == ESP_OK)
+    s_config.wifi_power_save = static_cast<wifi_ps_type_t>(val_u8);
+
+  if (nvs.get_u8(NVS_KEY_SKIP_VERSION, &val_u8) == ESP_OK)
+    s_config.skip_display_version = (val_u8 != 0);
+
+  if (nvs.get_u8(NVS_KEY_SKIP_BOOT, &val_u8) == ESP_OK)
+    s_config.skip_boot_animation = (val_u8 != 0);
+
+  if (nvs.get_u8(NVS_KEY_AP_MODE, &val_u8) == ESP_OK)
+    s_config.ap_mode = (val_u8 != 0);
+
+  if (nvs.get_u8(NVS_KEY_PREFER_IPV6, &val_u8) == ESP_OK)
+    s_config.prefer_ipv6 = (val_u8 != 0);
+
+  if (nvs.get_u8(NVS_KEY_DISABLE_TOUCH, &val_u8) == ESP_OK)
+    s_config.disable_touch = (val_u8 != 0);
 }
 
-/// Attempt to load config from the atomic blob keys.
+/// Attempt to load config from the raw struct blob keys.
 /// Returns true if a valid blob was found and loaded into s_config.
 bool load_from_blob() {
   NvsHandle nvs(NVS_NAMESPACE, NVS_READWRITE);
@@ -185,6 +331,11 @@ void load_nets() {
       len != sizeof(s_nets)) {
     memset(s_nets, 0, sizeof(s_nets));
   }
+  len = sizeof(s_last_ap);
+  if (nvs.get_blob(NVS_LAST_AP_KEY, &s_last_ap, &len) != ESP_OK ||
+      len != sizeof(s_last_ap)) {
+    memset(&s_last_ap, 0, sizeof(s_last_ap));
+  }
 }
 
 }  // namespace
@@ -230,59 +381,26 @@ esp_err_t nvs_settings_init(void) {
   s_config.prefer_ipv6 = true;
 #endif
 
-  // Try atomic blob load first (new format)
-  if (load_from_blob()) {
-    ESP_LOGI(TAG, "Config loaded from atomic blob");
-  } else {
-    // Fall back to individual key loading (legacy format)
-    NvsHandle nvs(NVS_NAMESPACE, NVS_READONLY);
-    if (nvs) {
-      size_t sz;
-
-      sz = sizeof(s_config.hostname);
-      if (nvs.get_str(NVS_KEY_HOSTNAME, s_config.hostname, &sz) != ESP_OK)
-        s_config.hostname[0] = '\0';
-
-      sz = sizeof(s_config.syslog_addr);
-      if (nvs.get_str(NVS_KEY_SYSLOG_ADDR, s_config.syslog_addr, &sz) !=
-          ESP_OK)
-        s_config.syslog_addr[0] = '\0';
-
-      sz = sizeof(s_config.sntp_server);
-      if (nvs.get_str(NVS_KEY_SNTP_SERVER, s_config.sntp_server, &sz) !=
-          ESP_OK)
-        s_config.sntp_server[0] = '\0';
-
-      sz = sizeof(s_config.image_url);
-      if (nvs.get_str(NVS_KEY_IMAGE_URL, s_config.image_url, &sz) != ESP_OK)
-        s_config.image_url[0] = '\0';
-
-      sz = sizeof(s_config.api_key);
-      if (nvs.get_str(NVS_KEY_API_KEY, s_config.api_key, &sz) != ESP_OK)
-        s_config.api_key[0] = '\0';
-
-      uint8_t val_u8;
-
-      if (nvs.get_u8(NVS_KEY_SWAP_COLORS, &val_u8) == ESP_OK)
-        s_config.swap_colors = (val_u8 != 0);
-
-      if (nvs.get_u8(NVS_KEY_WIFI_POWER_SAVE, &val_u8) == ESP_OK)
-        s_config.wifi_power_save = static_cast<wifi_ps_type_t>(val_u8);
-
-      if (nvs.get_u8(NVS_KEY_SKIP_VERSION, &val_u8) == ESP_OK)
-        s_config.skip_display_version = (val_u8 != 0);
-
-      if (nvs.get_u8(NVS_KEY_SKIP_BOOT, &val_u8) == ESP_OK)
-        s_config.skip_boot_animation = (val_u8 != 0);
-
-      if (nvs.get_u8(NVS_KEY_AP_MODE, &val_u8) == ESP_OK)
-        s_config.ap_mode = (val_u8 != 0);
-
-      if (nvs.get_u8(NVS_KEY_PREFER_IPV6, &val_u8) == ESP_OK)
-        s_config.prefer_ipv6 = (val_u8 != 0);
-
-      if (nvs.get_u8(NVS_KEY_DISABLE_TOUCH, &val_u8) == ESP_OK)
-        s_config.disable_touch = (val_u8 != 0);
+  // The settings record, unless the per-field keys show that older firmware
+  // has written settings since (or never migrated): then the older formats
+  // are current and get migrated into a new record, once.
+  s_have_record = load_record();
+  if (s_have_record) memcpy(&s_persisted, &s_config, sizeof(system_config_t));
+  bool migrate = has_legacy_keys();
+  if (s_have_record && !migrate) {
+    ESP_LOGI(TAG, "Config loaded from record");
+  } else if (load_from_blob()) {
+    ESP_LOGI(TAG, "Config loaded from struct blob");
+    migrate = true;
+  } else if (migrate) {
+    load_legacy_keys();
+    ESP_LOGI(TAG, "Config loaded from per-field keys");
+  }
+  if (migrate) {
+    s_dirty = true;
+    if (persist_locked() == ESP_OK) {
+      erase_legacy_keys();
+      ESP_LOGI(TAG, "Migrated config to record");
     }
   }
 
@@ -321,7 +439,8 @@ esp_err_t nvs_settings_init(void) {
   }
 
   if (save_cfg_defaults) {
-    persist_to_nvs();
+    s_dirty = true;
+    persist_locked();
   }
 
   // Apply brand default server URL if NVS has none and secrets.json had none
@@ -341,6 +460,27 @@ esp_err_t nvs_settings_init(void) {
   }
 #endif
 
+  const size_t snapshot_bytes = CONFIG_SNAPSHOT_SLOTS * sizeof(system_config_t);
+  void* snapshots =
+      heap_caps_malloc(snapshot_bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (!snapshots) snapshots = heap_caps_malloc(snapshot_bytes, MALLOC_CAP_8BIT);
+  if (!snapshots) {
+    ESP_LOGE(TAG, "Failed to allocate config snapshots");
+    return ESP_ERR_NO_MEM;
+  }
+  config_snapshot_init(&s_snapshot, snapshots, sizeof(system_config_t),
+                       &s_config);
+
+  s_flushed = xSemaphoreCreateBinary();
+  if (!s_flushed ||
+      xTaskCreate(writer_task, "cfg_writer", WRITER_STACK_SIZE, nullptr,
+                  WRITER_TASK_PRIORITY, &s_writer) != pdPASS) {
+    // config_set then writes synchronously.
+    ESP_LOGE(TAG, "Failed to create config writer task");
+    s_writer = nullptr;
+  }
+  esp_register_shutdown_handler(&on_shutdown);
+
   ESP_LOGI(TAG, "Settings initialized. Networks: %u, URL: %s, AP Mode: %d",
            (unsigned)wifi_network_list_count(), s_config.image_url,
            s_config.ap_mode);
@@ -350,28 +490,65 @@ esp_err_t nvs_settings_init(void) {
 
 system_config_t config_get(void) {
   system_config_t copy;
-  xSemaphoreTake(s_mutex, portMAX_DELAY);
-  memcpy(&copy, &s_config, sizeof(system_config_t));
-  xSemaphoreGive(s_mutex);
+  const system_config_t* cfg = config_acquire();
+  memcpy(&copy, cfg, sizeof(system_config_t));
+  config_release(cfg);
   return copy;
 }
 
+const system_config_t* config_acquire(void) {
+  return static_cast<const system_config_t*>(
+      config_snapshot_acquire(&s_snapshot));
+}
+
+void config_release(const system_config_t* cfg) {
+  config_snapshot_release(&s_snapshot, cfg);
+}
+
 void config_set(const system_config_t* cfg) {
   xSemaphoreTake(s_mutex, portMAX_DELAY);
   memcpy(&s_config, cfg, sizeof(system_config_t));
-  persist_to_nvs();
-  s_generation++;
+  // Readers hold a snapshot only for a few field reads, so waiting for one
+  // to be released is rare and short.
+  while (!config_snapshot_publish(&s_snapshot, &s_config)) {
+    vTaskDelay(1);
+  }
+  s_dirty = true;
+  s_stats.saves++;
+  const uint32_t gen = __atomic_add_fetch(&s_generation, 1, __ATOMIC_RELEASE);
+  if (!s_writer) persist_locked();
   xSemaphoreGive(s_mutex);
+  if (s_writer) xTaskNotify(s_writer, NOTIFY_CHANGED, eSetBits);
 
-  event_bus_emit_i32(TRONBYT_EVENT_CONFIG_CHANGED,
-                     static_cast<int32_t>(s_generation));
+  event_bus_emit_i32(TRONBYT_EVENT_CONFIG_CHANGED, static_cast<int32_t>(gen));
 }
 
-uint32_t config_generation(void) {
+void config_flush(void) {
+  if (!s_mutex) return;
+  if (s_writer && xTaskGetCurrentTaskHandle() != s_writer) {
+    // Flash writes need an internal-RAM stack, which the caller (a task
+    // with a PSRAM stack, or one restarting the device) may not have.
+    xSemaphoreTake(s_flushed, 0);  // drop a stale completion
+    xTaskNotify(s_writer, NOTIFY_FLUSH, eSetBits);
+    if (xSemaphoreTake(s_flushed, FLUSH_TIMEOUT) != pdTRUE) {
+      ESP_LOGW(TAG, "Config flush timed out");
+    }
+    return;
+  }
+  xSemaphoreTake(s_mutex, portMAX_DELAY);
+  persist_locked();
+  xSemaphoreGive(s_mutex);
+}
+
+void config_get_persist_stats(config_persist_stats_t* out) {
+  if (!out) return;
   xSemaphoreTake(s_mutex, portMAX_DELAY);
-  uint32_t gen = s_generation;
+  *out = s_stats;
   xSemaphoreGive(s_mutex);
-  return gen;
+}
+
+uint32_t config_generation(void) {
+  return __atomic_load_n(&s_generation, __ATOMIC_ACQUIRE);
 }
 
 // --- Multi-network list public API -----------------------------------------
@@ -381,8 +558,7 @@ namespace {
 // and notify. Caller holds s_mutex; this releases it.
 void commit_list_change_locked() {
   persist_nets_locked();
-  s_generation++;
-  uint32_t gen = s_generation;
+  const uint32_t gen = __atomic_add_fetch(&s_generation, 1, __ATOMIC_RELEASE);
   xSemaphoreGive(s_mutex);
   event_bus_emit_i32(TRONBYT_EVENT_CONFIG_CHANGED, static_cast<int32_t>(gen));
 }
@@ -501,3 +677,26 @@ void wifi_network_note_rssi(const char* ssid, int8_t rssi) {
   }
   xSemaphoreGive(s_mutex);
 }
+
+bool wifi_last_ap_get(wifi_last_ap_t* out) {
+  if (!out) return false;
+  xSemaphoreTake(s_mutex, portMAX_DELAY);
+  *out = s_last_ap;
+  xSemaphoreGive(s_mutex);
+  return out->channel != 0 && out->ssid[0] != '\0';
+}
+
+void wifi_last_ap_note(const wifi_last_ap_t* ap) {
+  if (!ap || ap->channel == 0 || ap->ssid[0] == '\0') return;
+  xSemaphoreTake(s_mutex, portMAX_DELAY);
+  // Roaming between the same APs rewrites this rarely; a steady link never.
+  if (memcmp(&s_last_ap, ap, sizeof(s_last_ap)) != 0) {
+    s_last_ap = *ap;
+    NvsHandle nvs(NVS_NETS_NAMESPACE, NVS_READWRITE);
+    if (nvs) {
+      nvs.set_blob(NVS_LAST_AP_KEY, &s_last_ap, sizeof(s_last_ap));
+      nvs.commit();
+    }
+  }
+  xSemaphoreGive(s_mutex);
+}
@@ -48,6 +48,15 @@ typedef struct {
   uint8_t _pad[2];    // reserved
 } wifi_network_t;
 
+// The access point of the last successful connect, so the next connect can go
+// straight to it instead of scanning every channel.
+typedef struct {
+  char ssid[MAX_SSID_LEN + 1];
+  uint8_t bssid[6];
+  uint8_t channel;   // primary channel; 0 = no AP recorded
+  uint8_t authmode;  // wifi_auth_mode_t the AP advertised
+} wifi_last_ap_t;
+
 /// Initialize NVS and load settings into the config struct.
 esp_err_t nvs_settings_init(void);
 
@@ -75,17 +84,69 @@ size_t wifi_network_list_count(void);
 /// bound flash wear). No-op if the SSID is not stored. Thread-safe.
 void wifi_network_note_rssi(const char* ssid, int8_t rssi);
 
-/// Return a thread-safe copy of the current configuration.
+/// Copy the last-good AP into *out. Returns false when none is recorded.
+/// Thread-safe.
+bool wifi_last_ap_get(wifi_last_ap_t* out);
+
+/// Record the AP of a successful connect. Persists only when it differs from
+/// the stored one. Thread-safe.
+void wifi_last_ap_note(const wifi_last_ap_t* ap);
+
+/// Return a copy of the current configuration. Lock-free; prefer
+/// config_acquire (or ConfigSnapshot) to read a few fields.
 system_config_t config_get(void);
 
-/// Apply a new configuration and persist it to NVS (atomic save).
+/// Borrow the current configuration without copying or locking. The snapshot
+/// never changes: config_set publishes a new one. Release it promptly and do
+/// not block while holding it, since config_set waits once every spare
+/// snapshot is borrowed. Thread-safe; not for ISRs.
+const system_config_t* config_acquire(void);
+void config_release(const system_config_t* cfg);
+
+/// Apply a new configuration. It takes effect immediately; the write to NVS
+/// is deferred briefly so a burst of changes costs one flash write (see
+/// config_flush).
 void config_set(const system_config_t* cfg);
 
+/// Write a pending configuration change to NVS now. Also runs on
+/// esp_restart(); call it before a reset that skips shutdown handlers.
+void config_flush(void);
+
+typedef struct {
+  uint32_t saves;          // config_set calls
+  uint32_t writes;         // records written to NVS
+  uint32_t unchanged;      // flushes skipped: nothing differed from flash
+  uint32_t bytes_written;  // record bytes written to NVS since boot
+  uint32_t record_bytes;   // size of the stored record
+} config_persist_stats_t;
+
+/// Counters of the config writer since boot. Thread-safe.
+void config_get_persist_stats(config_persist_stats_t* out);
+
 /// Return a monotonically-increasing generation counter that increments
 /// on every config_set() call. Useful for change detection (e.g., web UI
-/// can poll to know when settings changed).
+/// can poll to know when settings changed, or a caller can key a value it
+/// derives from the config on it). Lock-free.
 uint32_t config_generation(void);
 
 #ifdef __cplusplus
 }
+
+/// Scoped config_acquire: `if (ConfigSnapshot()->ap_mode)`, or a named
+/// ConfigSnapshot to read several fields from the same snapshot.
+class ConfigSnapshot {
+ public:
+  ConfigSnapshot() : cfg_(config_acquire()) {}
+  ~ConfigSnapshot() { config_release(cfg_); }
+
+  const system_config_t* operator->() const { return cfg_; }
+  const system_config_t& operator*() const { return *cfg_; }
+
+  // Non-copyable
+  ConfigSnapshot(const ConfigSnapshot&) = delete;
+  ConfigSnapshot& operator=(const ConfigSnapshot&) = delete;
+
+ private:
+  const system_config_t* cfg_;
+};
 #endif
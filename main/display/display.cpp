@@ -9,6 +9,7 @@
 #include "nvs_handle.h"
 #include "nvs_settings.h"
 #include "scheduler.h"
+#include "upscale2x.h"
 #include "webp_player.h"
 
 static Hub75Driver *_matrix;
@@ -25,14 +26,33 @@ static bool IRAM_ATTR frame_sync_isr(void *arg) {
 static uint8_t _brightness = (CONFIG_HUB75_BRIGHTNESS * 100) / 255;
 static const char *TAG = "display";
 
+// One pixel of a frame buffer in the build's DISPLAY_PIXEL_FORMAT. Only ever
+// copied whole, so the packed RGB888 case can be a plain byte triple.
+#if defined(CONFIG_DISPLAY_PIXEL_FORMAT_RGB565)
+typedef uint16_t display_px_t;
+static constexpr Hub75PixelFormat kPixelFormat = Hub75PixelFormat::RGB565;
+#elif defined(CONFIG_DISPLAY_PIXEL_FORMAT_RGB888)
+typedef struct {
+  uint8_t c[3];
+} display_px_t;
+static constexpr Hub75PixelFormat kPixelFormat = Hub75PixelFormat::RGB888;
+#else
+typedef uint32_t display_px_t;
+static constexpr Hub75PixelFormat kPixelFormat = Hub75PixelFormat::RGB888_32;
+#endif
+static_assert(sizeof(display_px_t) == DISPLAY_BYTES_PER_PIXEL,
+              "display_px_t must match DISPLAY_BYTES_PER_PIXEL");
+
 #if CONFIG_HUB75_PANEL_WIDTH == 128 && CONFIG_HUB75_PANEL_HEIGHT == 64
-// Batched upscale buffer: 4 source rows → 8 output rows per draw_pixels call.
-// 4 KB in BSS (internal SRAM) replaces a 32 KB PSRAM heap allocation while
-// keeping the call count low (8 calls vs 1 original vs 64 in the row-at-a-time
-// approach).  draw_pixels reads from fast internal SRAM instead of PSRAM.
+// Batched upscale buffer: 4 full-width source rows → 8 output rows per
+// draw_pixels call, or proportionally more rows of a narrower block.
+// At most 4 KB in BSS (internal SRAM) replaces a 32 KB PSRAM heap allocation
+// while keeping the call count low (8 calls vs 1 original vs 64 in the
+// row-at-a-time approach).  draw_pixels reads from fast internal SRAM instead
+// of PSRAM.
 constexpr int kUpscaleBatchSrcRows = 4;
 constexpr int kUpscaleBatchDstRows = kUpscaleBatchSrcRows * 2;
-static uint32_t _scale_buf[128 * kUpscaleBatchDstRows];
+static display_px_t _scale_buf[128 * kUpscaleBatchDstRows];
 #endif
 
 // ---- Panel hardware tuning (console-settable, persisted in NVS) ----
@@ -65,9 +85,15 @@ static Hub75Driver *_reinit_orphan = NULL;
 // Our RGBA frame buffers are handed to the driver as BGR on a normal panel
 // (that is the byte order libwebp produces for RGB888_32), so a swapped panel
 // is the one that needs RGB. The user-facing name follows the panel, not the
-// buffer, hence the inversion here.
+// buffer, hence the inversion here. The packed formats are produced in R,G,B
+// order by the decoder and need no inversion.
 static inline Hub75ColorOrder rgba_draw_order() {
+#if defined(CONFIG_DISPLAY_PIXEL_FORMAT_RGB565) || \
+    defined(CONFIG_DISPLAY_PIXEL_FORMAT_RGB888)
+  return _panel_bgr ? Hub75ColorOrder::BGR : Hub75ColorOrder::RGB;
+#else
   return _panel_bgr ? Hub75ColorOrder::RGB : Hub75ColorOrder::BGR;
+#endif
 }
 
 static bool clock_speed_from_mhz(int mhz, Hub75ClockSpeed *out) {
@@ -229,7 +255,7 @@ static bool display_apply_tuning(const char *key, void (*apply)(uint8_t),
 
 int display_initialize(void) {
   // Get swap_colors setting
-  bool swap_colors = config_get().swap_colors;
+  bool swap_colors = ConfigSnapshot()->swap_colors;
 
   // Initialize pin values based on hardware and swap_colors setting
   ESP_LOGI(TAG, "Initializing display with swap_colors=%s",
@@ -577,6 +603,27 @@ bool display_wait_frame(uint32_t timeout_ms) {
 #endif
 }
 
+#if CONFIG_HUB75_PANEL_WIDTH == 128 && CONFIG_HUB75_PANEL_HEIGHT == 64
+// 2x upscale of the w x h block at (x, y) of a 64x32 canvas (src points at
+// its top-left pixel, rows stride bytes apart): as many source rows as fit
+// in _scale_buf are doubled per draw_pixels call, so a dirty rectangle goes
+// out in one or a few blits rather than one per source row.
+static void draw_upscaled_block(const uint8_t *src, size_t stride, int x,
+                                int y, int w, int h) {
+  const int batch = upscale2x_rows_per_batch(
+      w, sizeof(_scale_buf) / sizeof(_scale_buf[0]));
+  if (batch <= 0) return;
+  for (int row = 0; row < h; row += batch) {
+    const int n = h - row < batch ? h - row : batch;
+    upscale2x_block(src + row * stride, stride, w, n,
+                    DISPLAY_BYTES_PER_PIXEL, (uint8_t *)_scale_buf);
+    _matrix->draw_pixels(x * 2, (y + row) * 2, w * 2, n * 2,
+                         (uint8_t *)_scale_buf, kPixelFormat,
+                         rgba_draw_order());
+  }
+}
+#endif
+
 void display_draw_buffer(const uint8_t *pix, int width, int height) {
   if (!pix || width <= 0 || height <= 0) return;
   if (_matrix == NULL) return;
@@ -589,34 +636,14 @@ void display_draw_buffer(const uint8_t *pix, int width, int height) {
 
 #if CONFIG_HUB75_PANEL_WIDTH == 128 && CONFIG_HUB75_PANEL_HEIGHT == 64
   if (width == 64 && height == 32) {
-    // Batched 2x upscale: process kUpscaleBatchSrcRows source rows at a
-    // time into a static internal-SRAM buffer, then hand the batch to
-    // draw_pixels in a single call.  This keeps the call count low (8)
-    // while reading from fast SRAM instead of PSRAM.
-    const uint32_t *src32 = (const uint32_t *)pix;
-    for (int batch_y = 0; batch_y < height; batch_y += kUpscaleBatchSrcRows) {
-      for (int y = 0; y < kUpscaleBatchSrcRows; y++) {
-        const uint32_t *src_row = &src32[(batch_y + y) * width];
-        uint32_t *dst_row1 = &_scale_buf[(y * 2) * 128];
-        uint32_t *dst_row2 = &_scale_buf[(y * 2 + 1) * 128];
-        for (int sx = 0; sx < width; sx++) {
-          uint32_t pixel = src_row[sx];
-          dst_row1[sx * 2] = pixel;
-          dst_row1[sx * 2 + 1] = pixel;
-          dst_row2[sx * 2] = pixel;
-          dst_row2[sx * 2 + 1] = pixel;
-        }
-      }
-      _matrix->draw_pixels(0, batch_y * 2, 128, kUpscaleBatchDstRows,
-                           (uint8_t *)_scale_buf,
-                           Hub75PixelFormat::RGB888_32, rgba_draw_order());
-    }
+    draw_upscaled_block(pix, (size_t)width * DISPLAY_BYTES_PER_PIXEL, 0, 0,
+                        width, height);
     return;
   }
 #endif
 
   // Default path: bulk transfer for native resolution
-  _matrix->draw_pixels(0, 0, width, height, pix, Hub75PixelFormat::RGB888_32,
+  _matrix->draw_pixels(0, 0, width, height, pix, kPixelFormat,
                        rgba_draw_order());
 }
 
@@ -631,7 +658,7 @@ bool display_span_supported(int canvas_w, int canvas_h) {
          canvas_h == CONFIG_HUB75_PANEL_HEIGHT;
 }
 
-// Draw a single row segment of RGBA pixels given in canvas coordinates,
+// Draw a single row segment of pixels given in canvas coordinates,
 // applying the same scaling display_draw_buffer would use for that canvas.
 // Writes into the active buffer without flipping, so it is only meaningful
 // when double buffering is disabled and the active buffer is live.
@@ -644,19 +671,7 @@ void display_draw_span(const uint8_t *pix, int x, int y, int width,
   if (canvas_w == 64 && canvas_h == 32) {
     // 2x upscale: one canvas row span becomes a doubled-width two-row blit.
     if (x < 0 || y < 0 || x + width > 64 || y >= 32) return;
-    const int dst_w = width * 2;
-    const uint32_t *src = (const uint32_t *)pix;
-    uint32_t *dst_row1 = &_scale_buf[0];
-    uint32_t *dst_row2 = &_scale_buf[dst_w];
-    for (int sx = 0; sx < width; sx++) {
-      uint32_t pixel = src[sx];
-      dst_row1[sx * 2] = pixel;
-      dst_row1[sx * 2 + 1] = pixel;
-      dst_row2[sx * 2] = pixel;
-      dst_row2[sx * 2 + 1] = pixel;
-    }
-    _matrix->draw_pixels(x * 2, y * 2, dst_w, 2, (uint8_t *)_scale_buf,
-                         Hub75PixelFormat::RGB888_32, rgba_draw_order());
+    draw_upscaled_block(pix, 0, x, y, width, 1);
     return;
   }
 #endif
@@ -669,8 +684,40 @@ void display_draw_span(const uint8_t *pix, int x, int y, int width,
       y >= CONFIG_HUB75_PANEL_HEIGHT) {
     return;
   }
-  _matrix->draw_pixels(x, y, width, 1, pix, Hub75PixelFormat::RGB888_32,
-                       rgba_draw_order());
+  _matrix->draw_pixels(x, y, width, 1, pix, kPixelFormat, rgba_draw_order());
+}
+
+// Draw the w x h rectangle at (x, y) of a full canvas frame, with the same
+// scaling and liveness caveats as display_draw_span. Upscaled rectangles go
+// out in batched multi-row blits and full-width rectangles at native
+// resolution, being contiguous in the frame, as one blit; anything else is
+// drawn row by row.
+void display_draw_rect(const uint8_t *frame, int x, int y, int w, int h,
+                       int canvas_w, int canvas_h) {
+  if (!frame || w <= 0 || h <= 0) return;
+  if (_matrix == NULL) return;
+
+  const size_t stride = (size_t)canvas_w * DISPLAY_BYTES_PER_PIXEL;
+#if CONFIG_HUB75_PANEL_WIDTH == 128 && CONFIG_HUB75_PANEL_HEIGHT == 64
+  if (canvas_w == 64 && canvas_h == 32) {
+    if (x < 0 || y < 0 || x + w > 64 || y + h > 32) return;
+    draw_upscaled_block(frame + y * stride + x * DISPLAY_BYTES_PER_PIXEL,
+                        stride, x, y, w, h);
+    return;
+  }
+#endif
+  if (canvas_w == CONFIG_HUB75_PANEL_WIDTH &&
+      canvas_h == CONFIG_HUB75_PANEL_HEIGHT && x == 0 && w == canvas_w) {
+    if (y < 0 || y + h > CONFIG_HUB75_PANEL_HEIGHT) return;
+    _matrix->draw_pixels(0, y, w, h, frame + y * stride, kPixelFormat,
+                         rgba_draw_order());
+    return;
+  }
+
+  for (int row = y; row < y + h; row++) {
+    display_draw_span(frame + row * stride + x * DISPLAY_BYTES_PER_PIXEL, x,
+                      row, w, canvas_w, canvas_h);
+  }
 }
 
 bool display_get_panel_bgr(void) { return _panel_bgr; }
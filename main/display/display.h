@@ -8,6 +8,17 @@
 #define DISPLAY_MAX_BRIGHTNESS 100
 #define DISPLAY_MIN_BRIGHTNESS 0
 
+// Pixel buffers passed to display_draw/display_draw_buffer/display_draw_span
+// use the build's DISPLAY_PIXEL_FORMAT (see Kconfig): RGBA8888, packed RGB888
+// (R,G,B bytes) or native-endian RGB565.
+#if defined(CONFIG_DISPLAY_PIXEL_FORMAT_RGB565)
+#define DISPLAY_BYTES_PER_PIXEL 2
+#elif defined(CONFIG_DISPLAY_PIXEL_FORMAT_RGB888)
+#define DISPLAY_BYTES_PER_PIXEL 3
+#else
+#define DISPLAY_BYTES_PER_PIXEL 4
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -21,6 +32,8 @@ void display_draw_buffer(const uint8_t* pix, int width, int height);
 void display_draw_span(const uint8_t* pix, int x, int y, int width,
                        int canvas_w, int canvas_h);
 bool display_span_supported(int canvas_w, int canvas_h);
+void display_draw_rect(const uint8_t* frame, int x, int y, int w, int h,
+                       int canvas_w, int canvas_h);
 void display_clear(void);
 void display_draw_pixel(int x, int y, uint8_t r, uint8_t g, uint8_t b);
 void display_fill_rect(int x, int y, int w, int h, uint8_t r, uint8_t g,
@@ -0,0 +1,51 @@
+#include "upscale2x.h"
+
+#include <string.h>
+
+namespace {
+
+struct Px24 {
+  uint8_t c[3];
+};
+
+template <typename Px>
+void double_row(const uint8_t* src, int w, uint8_t* dst) {
+  const Px* s = reinterpret_cast<const Px*>(src);
+  Px* d = reinterpret_cast<Px*>(dst);
+  for (int x = 0; x < w; x++) {
+    const Px p = s[x];
+    d[2 * x] = p;
+    d[2 * x + 1] = p;
+  }
+}
+
+}  // namespace
+
+void upscale2x_block(const uint8_t* src, size_t src_stride, int w, int h,
+                     size_t bpp, uint8_t* dst) {
+  if (!src || !dst || w <= 0 || h <= 0) return;
+  const size_t dst_row = static_cast<size_t>(w) * 2 * bpp;
+  for (int y = 0; y < h; y++) {
+    const uint8_t* s = src + static_cast<size_t>(y) * src_stride;
+    uint8_t* d = dst + static_cast<size_t>(y) * 2 * dst_row;
+    switch (bpp) {
+      case 4:
+        double_row<uint32_t>(s, w, d);
+        break;
+      case 3:
+        double_row<Px24>(s, w, d);
+        break;
+      case 2:
+        double_row<uint16_t>(s, w, d);
+        break;
+      default:
+        return;
+    }
+    memcpy(d + dst_row, d, dst_row);
+  }
+}
+
+int upscale2x_rows_per_batch(int w, size_t capacity_px) {
+  if (w <= 0) return 0;
+  return static_cast<int>(capacity_px / (static_cast<size_t>(w) * 4));
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Pixel-double the w x h block at src (rows src_stride bytes apart, bpp bytes
+// per pixel, bpp 2, 3 or 4) into dst as a packed 2w x 2h block. Each source
+// row is widened once and the second output row copied from the first.
+//
+// Pure and allocation-free so it is host-testable and benchmarkable.
+void upscale2x_block(const uint8_t* src, size_t src_stride, int w, int h,
+                     size_t bpp, uint8_t* dst);
+
+// Source rows of a w pixel wide block whose upscaled rows fit in a buffer of
+// capacity_px pixels; at least 1 when even one doubled row pair fits, else 0.
+int upscale2x_rows_per_batch(int w, size_t capacity_px);
+
+#ifdef __cplusplus
+}
+#endif
@@ -7,14 +7,15 @@
 
 #include "ap.h"
 #include "app_state.h"
+#include "boot_profile.h"
 #include "console.h"
 #include "display.h"
 #include "diag_event_ring.h"
 #include "event_bus.h"
 #include "heap_monitor.h"
+#include "image_arena.h"
 #include "http_server.h"
 #include "mdns_service.h"
-#include "webui_server.h"
 #include "nvs_settings.h"
 #include "startup/runtime_orchestrator.h"
 #include "sdkconfig.h"
@@ -100,6 +101,7 @@ void on_brightness_changed(const tronbyt_event_t* event, void*) {
 }  // namespace
 
 extern "C" void app_main(void) {
+  boot_profile_init();
   ESP_LOGI(TAG, "App Main Start");
 
 #if CONFIG_BUTTON_PIN >= 0
@@ -123,31 +125,57 @@ extern "C" void app_main(void) {
 
   ESP_LOGI(TAG, "Check for button press");
 
+  boot_profile_begin(BOOT_STAGE_NVS);
   ESP_ERROR_CHECK(nvs_settings_init());
+  boot_profile_end(BOOT_STAGE_NVS);
+  boot_profile_begin(BOOT_STAGE_EVENT_BUS);
   ESP_ERROR_CHECK(event_bus_init());
+  boot_profile_end(BOOT_STAGE_EVENT_BUS);
+  boot_profile_begin(BOOT_STAGE_APP_STATE);
   app_state_init();
+  boot_profile_end(BOOT_STAGE_APP_STATE);
+  boot_profile_begin(BOOT_STAGE_DIAG_EVENTS);
   diag_event_ring_init();
+  boot_profile_end(BOOT_STAGE_DIAG_EVENTS);
+  boot_profile_begin(BOOT_STAGE_CONSOLE);
   console_init();
+  boot_profile_end(BOOT_STAGE_CONSOLE);
+  boot_profile_begin(BOOT_STAGE_HEAP_MONITOR);
   heap_monitor_init();
-
-  ESP_LOGI(TAG, "Initializing WiFi manager...");
-  if (wifi_initialize("", "")) {
-    ESP_LOGE(TAG, "failed to initialize WiFi");
-    return;
-  }
-  esp_register_shutdown_handler(&wifi_shutdown);
-  http_server_init();
-  webui_server_init();
-  mdns_service_init();
+  boot_profile_end(BOOT_STAGE_HEAP_MONITOR);
+  boot_profile_begin(BOOT_STAGE_IMAGE_ARENA);
+  image_arena_init();
+  boot_profile_end(BOOT_STAGE_IMAGE_ARENA);
 
   auto cfg = config_get();
   const char* image_url = (cfg.image_url[0] != '\0') ? cfg.image_url : nullptr;
 
+  // Display first: the version screen and boot animation play on the player
+  // task while the rest of startup runs, instead of after it.
+  boot_profile_begin(BOOT_STAGE_DISPLAY);
   if (gfx_initialize(image_url)) {
     ESP_LOGE(TAG, "failed to initialize gfx");
     return;
   }
   esp_register_shutdown_handler(&display_shutdown);
+  boot_profile_end(BOOT_STAGE_DISPLAY);
+
+  // The LittleFS mounts only gate the web UI and the scheduler, so they run
+  // alongside Wi-Fi bring-up; the runtime task waits for them.
+  runtime_orchestrator_mount_storage();
+
+  ESP_LOGI(TAG, "Initializing WiFi manager...");
+  boot_profile_begin(BOOT_STAGE_WIFI_INIT);
+  if (wifi_initialize("", "")) {
+    ESP_LOGE(TAG, "failed to initialize WiFi");
+    return;
+  }
+  esp_register_shutdown_handler(&wifi_shutdown);
+  boot_profile_end(BOOT_STAGE_WIFI_INIT);
+
+  boot_profile_begin(BOOT_STAGE_SERVICES);
+  http_server_init();
+  mdns_service_init();
 
 #ifdef CONFIG_BOARD_TIDBYT_GEN2
   // Initialize touch controls (GPIO33 on Tidbyt Gen2). Skipping init entirely
@@ -178,6 +206,7 @@ extern "C" void app_main(void) {
     ESP_LOGI(TAG, "Starting AP Web Server...");
     ap_start();
   }
+  boot_profile_end(BOOT_STAGE_SERVICES);
 
   runtime_orchestrator_start(button_boot);
 
@@ -0,0 +1,134 @@
+#include "etag_table.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+constexpr const char* LIST_SEP = ", ";
+
+bool etag_ok(const char* etag) {
+  return etag && etag[0] != '\0' && strlen(etag) < ETAG_TABLE_KEY_MAX;
+}
+
+int slot_of(const etag_table_t* t, const char* etag) {
+  for (int i = 0; i < t->count; i++) {
+    if (strcmp(t->slots[i].etag, etag) == 0) return i;
+  }
+  return -1;
+}
+
+// Least recently used slot, optionally only among those holding a body and
+// never `skip`.
+int lru_slot(const etag_table_t* t, bool with_body, int skip) {
+  int lru = -1;
+  for (int i = 0; i < t->count; i++) {
+    if (i == skip || (with_body && !t->slots[i].body)) continue;
+    if (lru < 0 || t->slots[i].last_use < t->slots[lru].last_use) lru = i;
+  }
+  return lru;
+}
+
+void drop_body(etag_table_t* t, int i, void* dropped[], int* n) {
+  etag_table_entry_t& e = t->slots[i];
+  if (!e.body) return;
+  dropped[(*n)++] = e.body;
+  t->body_bytes -= e.len;
+  e.body = nullptr;
+}
+
+// Whole-entry match of etag in a ", "-separated list.
+bool list_contains(const char* list, const char* etag) {
+  const size_t n = strlen(etag);
+  for (const char* p = strstr(list, etag); p; p = strstr(p + 1, etag)) {
+    const bool starts = p == list || (p >= list + 2 && p[-2] == ',' &&
+                                      p[-1] == ' ');
+    const bool ends = p[n] == '\0' || p[n] == ',';
+    if (starts && ends) return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+void etag_table_init(etag_table_t* t) { memset(t, 0, sizeof(*t)); }
+
+etag_table_entry_t* etag_table_find(etag_table_t* t, const char* etag) {
+  if (!etag_ok(etag)) return nullptr;
+  const int i = slot_of(t, etag);
+  if (i < 0) return nullptr;
+  t->slots[i].last_use = ++t->clock;
+  return &t->slots[i];
+}
+
+int etag_table_put(etag_table_t* t, const char* etag, void* body,
+                   uint32_t len, uint64_t budget_bytes, bool* kept,
+                   void* dropped[ETAG_TABLE_SLOTS]) {
+  if (kept) *kept = false;
+  if (!etag_ok(etag)) return -1;
+
+  int n = 0;
+  int i = slot_of(t, etag);
+  if (i < 0) {
+    if (t->count < ETAG_TABLE_SLOTS) {
+      i = t->count++;
+    } else {
+      i = lru_slot(t, false, -1);
+      drop_body(t, i, dropped, &n);
+    }
+    snprintf(t->slots[i].etag, ETAG_TABLE_KEY_MAX, "%s", etag);
+  } else {
+    drop_body(t, i, dropped, &n);
+  }
+  etag_table_entry_t& e = t->slots[i];
+  e.len = len;
+  e.last_use = ++t->clock;
+
+  if (!body || len > budget_bytes) return n;
+  while (t->body_bytes + len > budget_bytes) {
+    drop_body(t, lru_slot(t, true, i), dropped, &n);
+  }
+  e.body = body;
+  t->body_bytes += len;
+  if (kept) *kept = true;
+  return n;
+}
+
+bool etag_list_append(char* out, size_t out_len, const char* etag) {
+  if (!etag_ok(etag)) return false;
+  if (list_contains(out, etag)) return true;
+  const size_t len = strlen(out);
+  const char* sep = len > 0 ? LIST_SEP : "";
+  if (len + strlen(sep) + strlen(etag) + 1 > out_len) return false;
+  snprintf(out + len, out_len - len, "%s%s", sep, etag);
+  return true;
+}
+
+void etag_mru_order(const uint32_t* last_use, int count, int* order) {
+  // Insertion sort: the tables hold a few dozen entries at most.
+  for (int i = 0; i < count; i++) {
+    int j = i;
+    while (j > 0 && last_use[order[j - 1]] < last_use[i]) {
+      order[j] = order[j - 1];
+      j--;
+    }
+    order[j] = i;
+  }
+}
+
+size_t etag_table_format_validators(const etag_table_t* t, const char* first,
+                                    char* out, size_t out_len) {
+  if (!out || out_len == 0) return 0;
+  out[0] = '\0';
+  if (etag_ok(first)) etag_list_append(out, out_len, first);
+
+  uint32_t uses[ETAG_TABLE_SLOTS];
+  int order[ETAG_TABLE_SLOTS];
+  for (int i = 0; i < t->count; i++) uses[i] = t->slots[i].last_use;
+  etag_mru_order(uses, t->count, order);
+  for (int n = 0; n < t->count; n++) {
+    const etag_table_entry_t& e = t->slots[order[n]];
+    if (e.body) etag_list_append(out, out_len, e.etag);
+  }
+  return strlen(out);
+}
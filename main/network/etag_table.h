@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A poll URL usually rotates through a handful of apps, so a few slots cover
+// the rotation; bodies beyond the byte budget are kept as bare validators.
+#define ETAG_TABLE_SLOTS 8
+// Matches remote.cpp's ETAG_MAX.
+#define ETAG_TABLE_KEY_MAX 80
+
+typedef struct {
+  char etag[ETAG_TABLE_KEY_MAX];
+  void* body;  // owned copy of the response, or NULL when over budget
+  uint32_t len;
+  uint32_t last_use;
+} etag_table_entry_t;
+
+// Recently seen responses keyed by ETag, least recently used evicted first.
+// Pure bookkeeping with no RTOS or ESP dependencies so it is host-testable;
+// NOT thread safe, and the caller allocates and frees the bodies: put hands
+// back the bodies it drops.
+typedef struct {
+  etag_table_entry_t slots[ETAG_TABLE_SLOTS];
+  int count;
+  uint32_t clock;
+  uint64_t body_bytes;
+} etag_table_t;
+
+void etag_table_init(etag_table_t* t);
+
+// Entry for etag, marked most recently used; NULL when unknown.
+etag_table_entry_t* etag_table_find(etag_table_t* t, const char* etag);
+
+// Record a response of len bytes. body (may be NULL) is kept when it fits in
+// budget_bytes after evicting older bodies; otherwise the entry keeps only
+// the validator and *kept is false, leaving body with the caller. Bodies the
+// table lets go of (evicted or replaced) are written to dropped[] for the
+// caller to free; returns how many, at most ETAG_TABLE_SLOTS. Returns -1 and
+// changes nothing when etag is empty or too long.
+int etag_table_put(etag_table_t* t, const char* etag, void* body,
+                   uint32_t len, uint64_t budget_bytes, bool* kept,
+                   void* dropped[ETAG_TABLE_SLOTS]);
+
+// Append etag to the If-None-Match list in out (`"a", W/"b"`) unless it is
+// already listed or would not fit whole. Returns true when it is in the
+// list afterwards.
+bool etag_list_append(char* out, size_t out_len, const char* etag);
+
+// Write the positions 0..count-1 to order[], most recent last_use stamp
+// first. Lists validators in recency order for this table and the image
+// cache index alike.
+void etag_mru_order(const uint32_t* last_use, int count, int* order);
+
+// Start an If-None-Match list in out: `first` (when non-empty), then the
+// ETags that have a body, most recently used first. Returns the length.
+size_t etag_table_format_validators(const etag_table_t* t, const char* first,
+                                    char* out, size_t out_len);
+
+#ifdef __cplusplus
+}
+#endif
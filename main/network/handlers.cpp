@@ -15,15 +15,21 @@
 #include "api_validation.h"
 #include "diag_event_ring.h"
 #include "event_bus.h"
+#include "image_arena.h"
+#include "image_cache.h"
 #include "messages.h"
 #include "nvs_settings.h"
 #include "ota.h"
+#include "playlist.h"
 #include "quiet_hours.h"
+#include "scheduler.h"
 #include "sdkconfig.h"
 #include "syslog.h"
+#include "webp_decoder.h"
 #include "webp_frame.h"
 #include "webp_player.h"
 #include "wifi.h"
+#include "ws_control.h"
 
 namespace {
 
@@ -35,6 +41,13 @@ constexpr int DEFAULT_REFRESH_INTERVAL = 10;
 constexpr int DEFAULT_REFRESH_INTERVAL = CONFIG_REFRESH_INTERVAL_SECONDS;
 #endif
 
+#ifndef CONFIG_WS_STREAM_PREVIEW_MIN_KB
+#define CONFIG_WS_STREAM_PREVIEW_MIN_KB 32
+#endif
+
+// Re-parse the partial push for its first frame at most this often.
+constexpr size_t PREVIEW_RETRY_BYTES = 4096;
+
 constexpr int CONSUMER_STACK_SIZE = 6144;
 constexpr int CONSUMER_PRIORITY = 4;
 constexpr int CONFIG_TASK_STACK_SIZE = 4096;
@@ -51,8 +64,13 @@ void config_persist_task(void*);
 int32_t s_dwell_secs = DEFAULT_REFRESH_INTERVAL;
 uint8_t* s_webp = nullptr;
 size_t s_ws_accumulated_len = 0;
+size_t s_ws_header_len = 0;  // ws_control header in front of the WebP
+bool s_ws_immediate = false;
+char s_ws_playlist_id[WS_CONTROL_KEY_MAX] = "";  // push is a playlist entry
 bool s_oversize_detected = false;
 bool s_first_image_received = false;
+bool s_preview_done = false;
+size_t s_preview_checked_len = 0;
 
 TaskHandle_t s_consumer_task = nullptr;
 SemaphoreHandle_t s_text_mutex = nullptr;
@@ -173,6 +191,120 @@ void config_persist_task(void*) {
   }
 }
 
+void play_cached(const char* key) {
+  uint8_t* webp = nullptr;
+  size_t len = 0;
+  if (!image_cache_get(key, &webp, &len)) {
+    ESP_LOGI(TAG, "play_cached: %s not cached", key);
+    msg_send_cache_miss(key);
+    return;
+  }
+  int32_t dwell_gfx =
+      effective_dwell_for_brightness(display_get_brightness(), s_dwell_secs);
+  int counter = gfx_update(webp, len, dwell_gfx);
+  if (counter < 0) {
+    ESP_LOGE(TAG, "Failed to queue cached WebP");
+    image_arena_free(webp);
+    return;
+  }
+  ESP_LOGI(TAG, "Queued cached image %s counter=%d size=%zu", key, counter,
+           len);
+  s_first_image_received = true;
+}
+
+// {"playlist":[{"id":"a","dwell_secs":15}, ...]}: hand the list to the
+// scheduler and ask for the images the device does not hold yet, which the
+// server then pushes with their playlist id in the binary control header.
+void apply_playlist(const cJSON* list) {
+  char err[128] = {0};
+  playlist_item_t items[PLAYLIST_MAX_ENTRIES];
+  int count = 0;
+  bool ok = cJSON_IsArray(list);
+  if (!ok) snprintf(err, sizeof(err), "playlist must be an array");
+
+  const cJSON* item = nullptr;
+  cJSON_ArrayForEach(item, list) {
+    if (!ok) break;
+    if (count == PLAYLIST_MAX_ENTRIES) {
+      snprintf(err, sizeof(err), "playlist has more than %d entries",
+               PLAYLIST_MAX_ENTRIES);
+      ok = false;
+      break;
+    }
+    const char* id = nullptr;
+    bool has_id = false;
+    int dwell = s_dwell_secs;
+    bool has_dwell = false;
+    ok = cJSON_IsObject(item) &&
+         api_validate_optional_string(item, "id", 1, PLAYLIST_ID_MAX - 1, &id,
+                                      &has_id, err, sizeof(err)) &&
+         api_validate_optional_int(item, "dwell_secs", 1, 3600, &dwell,
+                                   &has_dwell, err, sizeof(err));
+    if (ok && !has_id) {
+      snprintf(err, sizeof(err), "playlist entry %d has no id", count);
+      ok = false;
+    }
+    if (ok) items[count++] = {id, dwell};
+  }
+  if (ok && !scheduler_playlist_set(items, count)) {
+    snprintf(err, sizeof(err), "playlist lists an id twice");
+    ok = false;
+  }
+  if (!ok) {
+    if (err[0] == '\0') snprintf(err, sizeof(err), "invalid playlist entry");
+    ESP_LOGW(TAG, "Validation failed: %s", err);
+    diag_event_log("WARN", "json_validation_error", -1, err);
+    return;
+  }
+
+  const char* missing[PLAYLIST_MAX_ENTRIES];
+  int n = 0;
+  for (int i = 0; i < count; i++) {
+    if (!scheduler_playlist_has_image(items[i].id)) missing[n++] = items[i].id;
+  }
+  ESP_LOGI(TAG, "Playlist of %d, %d images needed", count, n);
+  msg_send_playlist_missing(missing, n);
+}
+
+void apply_brightness(int brightness) {
+  display_set_brightness(static_cast<uint8_t>(brightness));
+  ESP_LOGI(TAG, "Updated brightness to %d", brightness);
+  // A server brightness command means the display is on; announce it so any
+  // board-level consumer (e.g. the Gen2 touch controller) can resync its
+  // state. The network layer stays board-agnostic.
+  event_bus_emit_i32(TRONBYT_EVENT_BRIGHTNESS_CHANGED, brightness);
+}
+
+// Settings from a binary control header, applied before the image behind it
+// is queued, as if the same JSON keys had arrived first. Its arrival also
+// tells us the server reads binary notifications.
+void apply_control_header(const ws_control_t& ctl) {
+  msg_set_binary_control(true);
+  if (ctl.has_dwell) {
+    s_dwell_secs = ctl.dwell_secs;
+    ESP_LOGD(TAG, "Updated dwell_secs to %" PRId32 " seconds", s_dwell_secs);
+  }
+  if (ctl.has_brightness) {
+    if (ctl.brightness > DISPLAY_MAX_BRIGHTNESS) {
+      ESP_LOGW(TAG, "Ignoring out-of-range brightness %u", ctl.brightness);
+    } else {
+      apply_brightness(ctl.brightness);
+    }
+  }
+}
+
+// A control header with no image behind it: the binary form of
+// {"immediate":true} and {"play_cached":key}.
+void finish_control_only(const ws_control_t& ctl) {
+  if (ctl.immediate) {
+    ESP_LOGD(TAG, "Interrupting current animation to load queued image");
+    gfx_preempt();
+  }
+  if (ctl.play_cached[0] != '\0') {
+    play_cached(ctl.play_cached);
+  }
+}
+
 void process_text_message(const char* json_str) {
   cJSON* root = cJSON_Parse(json_str);
 
@@ -192,7 +324,8 @@ void process_text_message(const char* json_str) {
                                       "hostname",        "syslog_addr",
                                       "sntp_server",     "image_url",
                                       "api_key",         "quiet_hours",
-                                      "reboot"};
+                                      "reboot",          "play_cached",
+                                      "playlist"};
 
   char validation_err[128] = {0};
   if (!api_validate_no_unknown_keys(root, kAllowedKeys,
@@ -224,6 +357,8 @@ void process_text_message(const char* json_str) {
   bool has_image_url = false;
   const char* api_key_value = nullptr;
   bool has_api_key = false;
+  const char* play_cached_value = nullptr;
+  bool has_play_cached = false;
   auto validate_or_abort = [&](bool ok) {
     if (!ok) {
       ESP_LOGW(TAG, "Validation failed: %s", validation_err);
@@ -272,6 +407,10 @@ void process_text_message(const char* json_str) {
           root, "api_key", 0, MAX_API_KEY_LEN, &api_key_value, &has_api_key,
           validation_err, sizeof(validation_err))))
     return;
+  if (!validate_or_abort(api_validate_optional_string(
+          root, "play_cached", 1, IMAGE_CACHE_KEY_MAX - 1, &play_cached_value,
+          &has_play_cached, validation_err, sizeof(validation_err))))
+    return;
 
   bool settings_changed = false;
   auto cfg = config_get();
@@ -287,13 +426,20 @@ void process_text_message(const char* json_str) {
     ESP_LOGD(TAG, "Updated dwell_secs to %" PRId32 " seconds", s_dwell_secs);
   }
 
+  // Replay an image the device already holds instead of receiving it again.
+  // Keys are the content hashes of earlier binary pushes; unknown keys are
+  // answered with cache_miss.
+  if (has_play_cached && !quiet_hours_is_active()) {
+    play_cached(play_cached_value);
+  }
+
   if (has_brightness) {
-    display_set_brightness(static_cast<uint8_t>(brightness_value));
-    ESP_LOGI(TAG, "Updated brightness to %d", brightness_value);
-    // A server brightness command means the display is on; announce it so any
-    // board-level consumer (e.g. the Gen2 touch controller) can resync its
-    // state. The network layer stays board-agnostic.
-    event_bus_emit_i32(TRONBYT_EVENT_BRIGHTNESS_CHANGED, brightness_value);
+    apply_brightness(brightness_value);
+  }
+
+  cJSON* playlist_item = cJSON_GetObjectItem(root, "playlist");
+  if (playlist_item) {
+    apply_playlist(playlist_item);
   }
 
   if (has_ota_url) {
@@ -461,6 +607,44 @@ void consumer_task(void*) {
   }
 }
 
+// Large animated pushes: queue the first frame as a still as soon as its
+// bytes are in, so the panel updates while the rest is still arriving.
+// Chunks are appended in order, so s_webp[0..s_ws_accumulated_len) is
+// complete.
+void maybe_queue_preview(int payload_len) {
+  if (s_preview_done || !s_webp) return;
+  if (CONFIG_WS_STREAM_PREVIEW_MIN_KB == 0 ||
+      payload_len < CONFIG_WS_STREAM_PREVIEW_MIN_KB * 1024 ||
+      s_ws_accumulated_len >= static_cast<size_t>(payload_len)) {
+    s_preview_done = true;
+    return;
+  }
+  if (s_ws_accumulated_len < s_preview_checked_len + PREVIEW_RETRY_BYTES) {
+    return;
+  }
+  s_preview_checked_len = s_ws_accumulated_len;
+
+  uint8_t* still = nullptr;
+  size_t still_len = 0;
+  esp_err_t err = webp_extract_first_frame(s_webp, s_ws_accumulated_len,
+                                           &still, &still_len);
+  if (err == ESP_ERR_NOT_FINISHED) return;
+  s_preview_done = true;
+  if (err != ESP_OK) {
+    ESP_LOGD(TAG, "No early preview: %s", esp_err_to_name(err));
+    return;
+  }
+
+  int32_t dwell_gfx =
+      effective_dwell_for_brightness(display_get_brightness(), s_dwell_secs);
+  if (gfx_update_preview(still, still_len, dwell_gfx) != 0) {
+    image_arena_free(still);
+    return;
+  }
+  ESP_LOGI(TAG, "Queued first-frame preview after %zu/%d bytes",
+           s_ws_accumulated_len, payload_len);
+}
+
 }  // namespace
 
 void handlers_init() {
@@ -545,28 +729,92 @@ void handle_text_message(esp_websocket_event_data_t* data) {
 }
 
 void handle_binary_message(esp_websocket_event_data_t* data) {
+  const bool start = data->op_code == 2 && data->payload_offset == 0;
+
+  // Protocol version 2: settings ride in a header in front of the image.
+  // They apply even in quiet hours, like the same keys sent as JSON.
+  ws_control_t ctl = {};
+  ws_control_result_t ctl_rc = WS_CONTROL_NONE;
+  if (start) {
+    ctl_rc = ws_control_parse(reinterpret_cast<const uint8_t*>(data->data_ptr),
+                              static_cast<size_t>(data->data_len), &ctl);
+    if (ctl_rc == WS_CONTROL_OK) {
+      apply_control_header(ctl);
+    }
+  }
+
   // WebSocket image pushes bypass the scheduler, so they need their own quiet
   // hours gate: drop incoming frames while the panel is intentionally dark.
-  if (quiet_hours_is_active()) return;
+  // Playlist images are only stored, so they still come in.
+  const bool to_playlist = start ? ctl_rc == WS_CONTROL_OK &&
+                                       ctl.playlist_id[0] != '\0'
+                                 : s_ws_playlist_id[0] != '\0';
+  if (quiet_hours_is_active() && !to_playlist) return;
 
-  if (data->op_code == 2 && data->payload_offset == 0) {
+  if (start) {
     ESP_LOGI(TAG, "WS binary start: total=%d dwell=%" PRId32
                   " first_image=%d",
              data->payload_len, s_dwell_secs, s_first_image_received);
     if (s_webp) {
       ESP_LOGW(TAG, "Discarding incomplete previous WebP buffer");
-      free(s_webp);
+      image_arena_free(s_webp);
       s_webp = nullptr;
     }
     s_ws_accumulated_len = 0;
+    s_ws_header_len = 0;
+    s_ws_immediate = false;
+    s_ws_playlist_id[0] = '\0';
     s_oversize_detected = false;
+    s_preview_done = false;
+    s_preview_checked_len = 0;
+
+    if (ctl_rc == WS_CONTROL_SHORT || ctl_rc == WS_CONTROL_INVALID) {
+      ESP_LOGW(TAG, "Dropping binary message with a malformed control header");
+      diag_event_log("WARN", "ws_control_error", ctl_rc,
+                     "Malformed binary control header");
+      s_oversize_detected = true;
+      return;
+    }
+    if (ctl_rc == WS_CONTROL_OK) {
+      if (data->payload_len <= ctl.header_len) {
+        finish_control_only(ctl);
+        return;
+      }
+      s_ws_header_len = ctl.header_len;
+      s_ws_immediate = ctl.immediate;
+      snprintf(s_ws_playlist_id, sizeof(s_ws_playlist_id), "%s",
+               ctl.playlist_id);
+      // A playlist image waits for its turn; no early preview.
+      s_preview_done = s_ws_playlist_id[0] != '\0';
+    }
+  }
+
+  if (s_oversize_detected) return;
 
-    if (webp_frame_check_offsets((uint32_t)data->payload_offset,
-                                 (uint32_t)data->data_len,
-                                 (uint32_t)data->payload_len,
+  // From here on offsets are into the WebP behind any control header, which
+  // the parser has checked lies wholly in the first chunk.
+  const char* chunk = data->data_ptr;
+  int chunk_len = data->data_len;
+  int offset = data->payload_offset;
+  int total = data->payload_len;
+  if (s_ws_header_len > 0) {
+    const int skip = static_cast<int>(s_ws_header_len);
+    if (offset < skip) {
+      chunk += skip - offset;
+      chunk_len -= skip - offset;
+      offset = 0;
+    } else {
+      offset -= skip;
+    }
+    total -= skip;
+  }
+
+  if (start) {
+    if (webp_frame_check_offsets((uint32_t)offset, (uint32_t)chunk_len,
+                                 (uint32_t)total,
                                  (size_t)CONFIG_HTTP_BUFFER_SIZE_MAX) !=
         WEBP_FRAME_OK) {
-      ESP_LOGE(TAG, "WebP size (%d bytes) exceeds max (%d)", data->payload_len,
+      ESP_LOGE(TAG, "WebP size (%d bytes) exceeds max (%d)", total,
                CONFIG_HTTP_BUFFER_SIZE_MAX);
       s_oversize_detected = true;
       if (gfx_display_asset("oversize") != 0) {
@@ -575,27 +823,23 @@ void handle_binary_message(esp_websocket_event_data_t* data) {
       return;
     }
 
-    if (data->payload_len > 0) {
-      s_webp = static_cast<uint8_t*>(heap_caps_malloc(
-          static_cast<size_t>(data->payload_len),
-          MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+    if (total > 0) {
+      s_webp = static_cast<uint8_t*>(
+          image_arena_alloc(static_cast<size_t>(total)));
       if (!s_webp) {
-        ESP_LOGE(TAG, "Failed to allocate WebP buffer (%d bytes)",
-                 data->payload_len);
+        ESP_LOGE(TAG, "Failed to allocate WebP buffer (%d bytes)", total);
         s_oversize_detected = true;
         return;
       }
     }
   }
 
-  if (s_oversize_detected) return;
-
   if (data->op_code == 0 && !s_webp) return;
 
-  size_t end_offset = static_cast<size_t>(data->payload_offset) + data->data_len;
+  size_t end_offset = static_cast<size_t>(offset) + chunk_len;
   webp_frame_check_t frame_chk = webp_frame_check_offsets(
-      (uint32_t)data->payload_offset, (uint32_t)data->data_len,
-      (uint32_t)data->payload_len, (size_t)CONFIG_HTTP_BUFFER_SIZE_MAX);
+      (uint32_t)offset, (uint32_t)chunk_len, (uint32_t)total,
+      (size_t)CONFIG_HTTP_BUFFER_SIZE_MAX);
   if (frame_chk == WEBP_FRAME_OVERSIZE) {
     ESP_LOGE(TAG, "WebP size (%zu bytes) exceeds max (%d)", end_offset,
              CONFIG_HTTP_BUFFER_SIZE_MAX);
@@ -603,7 +847,7 @@ void handle_binary_message(esp_websocket_event_data_t* data) {
     if (gfx_display_asset("oversize") != 0) {
       ESP_LOGE(TAG, "Failed to display oversize graphic");
     }
-    free(s_webp);
+    image_arena_free(s_webp);
     s_webp = nullptr;
     s_ws_accumulated_len = 0;
     return;
@@ -611,39 +855,54 @@ void handle_binary_message(esp_websocket_event_data_t* data) {
   if (frame_chk == WEBP_FRAME_INVALID_OFFSET) {
     ESP_LOGE(TAG,
              "Invalid WebSocket payload offsets (%zu > total %d); dropping",
-             end_offset, data->payload_len);
-    free(s_webp);
+             end_offset, total);
+    image_arena_free(s_webp);
     s_webp = nullptr;
     s_ws_accumulated_len = 0;
     s_oversize_detected = true;
     return;
   }
 
-  if (data->data_len > 0 && s_webp) {
-    memcpy(s_webp + data->payload_offset, data->data_ptr, data->data_len);
+  if (chunk_len > 0 && s_webp) {
+    memcpy(s_webp + offset, chunk, chunk_len);
   }
   if (end_offset > s_ws_accumulated_len) {
     s_ws_accumulated_len = end_offset;
   }
+  maybe_queue_preview(total);
 
-  bool frame_complete = (data->payload_len > 0)
-                            ? (s_ws_accumulated_len >=
-                               static_cast<size_t>(data->payload_len))
-                            : (data->payload_offset + data->data_len >=
-                               data->payload_len);
+  bool frame_complete =
+      (total > 0) ? (s_ws_accumulated_len >= static_cast<size_t>(total))
+                  : (offset + chunk_len >= total);
 
   if (data->fin && frame_complete) {
     ESP_LOGD(TAG, "WebP download complete (%zu bytes)", s_ws_accumulated_len);
 
+    if (s_ws_playlist_id[0] != '\0') {
+      // The scheduler takes the buffer and plays it in rotation; the image
+      // cache would only add a flash write for it.
+      scheduler_playlist_store(s_ws_playlist_id, s_webp, s_ws_accumulated_len);
+      s_webp = nullptr;
+      s_ws_accumulated_len = 0;
+      s_ws_header_len = 0;
+      s_ws_playlist_id[0] = '\0';
+      return;
+    }
+
+    // Keep a copy under its content hash for later play_cached requests.
+    // The store copies the buffer before gfx takes ownership of it.
+    image_cache_put(nullptr, s_webp, s_ws_accumulated_len);
+
     int32_t dwell_gfx =
         effective_dwell_for_brightness(display_get_brightness(), s_dwell_secs);
     int counter = gfx_update(s_webp, s_ws_accumulated_len, dwell_gfx);
     if (counter < 0) {
       ESP_LOGE(TAG, "Failed to queue downloaded WebP");
-      free(s_webp);
+      image_arena_free(s_webp);
     } else {
       ESP_LOGI(TAG, "Queued WS image counter=%d size=%zu dwell=%" PRId32,
                counter, s_ws_accumulated_len, dwell_gfx);
+      if (s_ws_immediate) gfx_preempt();
     }
 
     if (counter >= 0 && !s_first_image_received) {
@@ -655,5 +914,7 @@ void handle_binary_message(esp_websocket_event_data_t* data) {
     // Ownership transferred to gfx
     s_webp = nullptr;
     s_ws_accumulated_len = 0;
+    s_ws_header_len = 0;
+    s_ws_immediate = false;
   }
 }
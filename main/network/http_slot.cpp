@@ -1,6 +1,7 @@
 #include "http_slot.h"
 
 #include <cinttypes>
+#include <cstring>
 
 #include <esp_log.h>
 #include <esp_timer.h>
@@ -26,6 +27,23 @@ SemaphoreHandle_t slot() {
   return s;
 }
 
+// Kept-alive connection left open by the last holder. Only touched while the
+// slot is held, so the slot itself serializes access.
+const char* s_idle_tag = nullptr;
+void (*s_idle_close)(void) = nullptr;
+
+// Called with the slot held.
+void close_foreign_idle_connection(const char* tag) {
+  if (!s_idle_close) return;
+  if (tag && s_idle_tag && strcmp(tag, s_idle_tag) == 0) return;
+  ESP_LOGI(TAG, "closing idle '%s' connection for '%s'", s_idle_tag,
+           tag ? tag : "?");
+  void (*close_fn)(void) = s_idle_close;
+  s_idle_close = nullptr;
+  s_idle_tag = nullptr;
+  close_fn();
+}
+
 }  // namespace
 
 extern "C" bool http_slot_acquire(const char* tag, uint32_t timeout_ms) {
@@ -38,6 +56,7 @@ extern "C" bool http_slot_acquire(const char* tag, uint32_t timeout_ms) {
   // Fast path: take it immediately when uncontended, so the contention log
   // only fires when a caller actually has to wait.
   if (xSemaphoreTake(s, 0) == pdTRUE) {
+    close_foreign_idle_connection(tag);
     return true;
   }
 
@@ -55,9 +74,16 @@ extern "C" bool http_slot_acquire(const char* tag, uint32_t timeout_ms) {
   int64_t waited_ms = (esp_timer_get_time() - start_us) / 1000;
   ESP_LOGI(TAG, "slot acquired by '%s' after waiting %" PRId64 " ms", who,
            waited_ms);
+  close_foreign_idle_connection(tag);
   return true;
 }
 
+extern "C" void http_slot_set_idle_connection(const char* tag,
+                                              void (*close_fn)(void)) {
+  s_idle_tag = tag;
+  s_idle_close = close_fn;
+}
+
 extern "C" void http_slot_release(void) {
   SemaphoreHandle_t s = slot();
   if (s) {
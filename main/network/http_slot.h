@@ -28,6 +28,13 @@ bool http_slot_acquire(const char* tag, uint32_t timeout_ms);
 // Releases a slot previously acquired by http_slot_acquire.
 void http_slot_release(void);
 
+// Registers the caller's kept-alive connection (call while holding the slot).
+// The next acquire by a caller with a different tag runs close_fn, with the
+// slot held, before returning, so an idle connection's TLS state never
+// coexists with someone else's handshake. Runs at most once; re-register
+// after every request that leaves the connection open.
+void http_slot_set_idle_connection(const char* tag, void (*close_fn)(void));
+
 #ifdef __cplusplus
 }  // extern "C"
 
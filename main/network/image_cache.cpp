@@ -0,0 +1,463 @@
+#include "image_cache.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <esp_littlefs.h>
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <mbedtls/sha256.h>
+
+#include "image_arena.h"
+#include "image_cache_index.h"
+#include "raii_utils.hpp"
+#include "sdkconfig.h"
+
+#ifndef CONFIG_IMAGE_CACHE_KB
+#define CONFIG_IMAGE_CACHE_KB 2048
+#endif
+
+namespace {
+
+const char* TAG = "image_cache";
+
+constexpr const char* MOUNT_POINT = "/imgcache";
+constexpr const char* PARTITION_LABEL = "imgcache";
+constexpr const char* INDEX_PATH = "/imgcache/index.bin";
+constexpr const char* TMP_PATH = "/imgcache/store.tmp";
+constexpr uint32_t INDEX_MAGIC = 0x31434d49;  // "IMC1"
+
+// The writer erases and programs flash, which disables the flash cache, so
+// its stack must be in internal RAM. Lowest priority: storing is pure
+// background work. Reads go through it too, for callers on PSRAM stacks.
+constexpr uint32_t WRITER_STACK_SIZE = 4096;
+constexpr int WRITER_PRIORITY = 1;
+constexpr uint32_t NOTIFY_STORE = 1u << 0;
+constexpr uint32_t NOTIFY_READ = 1u << 1;
+// A read queued behind a large store can wait for its flash write.
+constexpr TickType_t READ_TIMEOUT = pdMS_TO_TICKS(5000);
+
+// Content-addressed keys for pushes that carry no ETag:
+// IMAGE_CACHE_HASH_PREFIX + 32 hex digits (the first 128 bits of the digest).
+constexpr size_t HASH_KEY_BYTES = 16;
+
+struct IndexHeader {
+  uint32_t magic;
+  uint32_t count;
+};
+
+// One store waiting for the writer task. An empty key means "derive one
+// from the content".
+struct PendingStore {
+  uint8_t* buf;
+  size_t len;
+  char key[IMAGE_CACHE_KEY_MAX];
+};
+
+// A read handed to the writer task. seq tells a request apart from one its
+// caller gave up on.
+struct ReadRequest {
+  char key[IMAGE_CACHE_KEY_MAX];
+  uint32_t seq;
+  bool waiting;  // false once served or abandoned
+  bool ok;
+  uint8_t* buf;
+  size_t len;
+};
+
+SemaphoreHandle_t s_read_lock = nullptr;  // one read request at a time
+SemaphoreHandle_t s_read_done = nullptr;
+SemaphoreHandle_t s_mutex = nullptr;  // guards everything below
+TaskHandle_t s_writer = nullptr;
+ReadRequest s_read = {};
+image_cache_index_t s_index;
+image_cache_seen_t s_seen;
+PendingStore s_pending = {};
+uint64_t s_budget = 0;
+bool s_enabled = false;
+uint32_t s_hits = 0;
+uint32_t s_misses = 0;
+uint32_t s_stores = 0;
+uint32_t s_evictions = 0;
+
+void path_for(const char* key, char* out, size_t out_len) {
+  char name[IMAGE_CACHE_NAME_LEN];
+  image_cache_file_name(key, name);
+  snprintf(out, out_len, "%s/%s", MOUNT_POINT, name);
+}
+
+void content_key(const uint8_t* buf, size_t len,
+                 char out[IMAGE_CACHE_KEY_MAX]) {
+  uint8_t digest[32];
+  mbedtls_sha256(buf, len, digest, 0);
+  size_t pos =
+      snprintf(out, IMAGE_CACHE_KEY_MAX, "%s", IMAGE_CACHE_HASH_PREFIX);
+  for (size_t i = 0; i < HASH_KEY_BYTES; i++) {
+    pos += snprintf(out + pos, IMAGE_CACHE_KEY_MAX - pos, "%02x", digest[i]);
+  }
+}
+
+// Caller holds s_mutex. Index writes go to a temp file first so a power cut
+// leaves either the old or the new index.
+void save_index_locked() {
+  const char* tmp = "/imgcache/index.tmp";
+  FILE* f = fopen(tmp, "wb");
+  if (!f) {
+    ESP_LOGW(TAG, "Cannot write index");
+    return;
+  }
+  IndexHeader hdr = {INDEX_MAGIC, static_cast<uint32_t>(s_index.count)};
+  bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+  if (ok && s_index.count > 0) {
+    ok = fwrite(s_index.entries, sizeof(s_index.entries[0]), s_index.count,
+                f) == static_cast<size_t>(s_index.count);
+  }
+  ok = fclose(f) == 0 && ok;
+  if (!ok || rename(tmp, INDEX_PATH) != 0) {
+    ESP_LOGW(TAG, "Index write failed");
+    remove(tmp);
+  }
+}
+
+// Rebuild s_index from the saved index, keeping only entries whose file is
+// present with the recorded size, then delete files no entry refers to.
+void load_index() {
+  image_cache_index_init(&s_index);
+  FILE* f = fopen(INDEX_PATH, "rb");
+  IndexHeader hdr = {};
+  if (f && fread(&hdr, sizeof(hdr), 1, f) == 1 && hdr.magic == INDEX_MAGIC &&
+      hdr.count <= IMAGE_CACHE_MAX_ENTRIES) {
+    for (uint32_t i = 0; i < hdr.count; i++) {
+      image_cache_entry_t e;
+      if (fread(&e, sizeof(e), 1, f) != 1) break;
+      e.key[IMAGE_CACHE_KEY_MAX - 1] = '\0';
+      char path[64];
+      path_for(e.key, path, sizeof(path));
+      struct stat st;
+      if (stat(path, &st) != 0 || static_cast<uint32_t>(st.st_size) != e.size) {
+        continue;
+      }
+      const int pos = image_cache_index_add(&s_index, e.key, e.size);
+      if (pos < 0) continue;
+      s_index.entries[pos].last_use = e.last_use;
+      if (e.last_use > s_index.clock) s_index.clock = e.last_use;
+    }
+  }
+  if (f) fclose(f);
+
+  DIR* dir = opendir(MOUNT_POINT);
+  if (!dir) return;
+  while (struct dirent* de = readdir(dir)) {
+    if (strcmp(de->d_name, "index.bin") == 0) continue;
+    bool referenced = false;
+    for (int i = 0; i < s_index.count && !referenced; i++) {
+      char name[IMAGE_CACHE_NAME_LEN];
+      image_cache_file_name(s_index.entries[i].key, name);
+      referenced = strcmp(name, de->d_name) == 0;
+    }
+    if (!referenced) {
+      char path[300];
+      snprintf(path, sizeof(path), "%s/%s", MOUNT_POINT, de->d_name);
+      remove(path);
+    }
+  }
+  closedir(dir);
+}
+
+bool write_file(const char* path, const uint8_t* buf, size_t len) {
+  FILE* f = fopen(TMP_PATH, "wb");
+  if (!f) return false;
+  bool ok = fwrite(buf, 1, len, f) == len;
+  ok = fclose(f) == 0 && ok;
+  // Replace atomically so a reader never sees a half-written image.
+  if (ok) {
+    remove(path);
+    ok = rename(TMP_PATH, path) == 0;
+  }
+  if (!ok) remove(TMP_PATH);
+  return ok;
+}
+
+void store(PendingStore& p) {
+  if (p.key[0] == '\0') content_key(p.buf, p.len, p.key);
+  char path[64];
+  path_for(p.key, path, sizeof(path));
+
+  // 2.5 KB: static rather than on the writer's 4 KB stack, which LittleFS
+  // and the logging below need. Only the writer task calls store().
+  static char victims[IMAGE_CACHE_MAX_ENTRIES][IMAGE_CACHE_KEY_MAX];
+  int evicted;
+  {
+    raii::MutexGuard lock(s_mutex);
+    if (!lock) return;
+    const int existing = image_cache_index_find(&s_index, p.key);
+    if (existing >= 0 && s_index.entries[existing].size == p.len) {
+      image_cache_index_touch(&s_index, existing);
+      return;  // already stored
+    }
+    if (existing < 0 && !image_cache_seen_note(&s_seen, p.key)) return;
+    image_cache_index_remove(&s_index, existing);
+    evicted = image_cache_index_make_room(&s_index, p.len, s_budget, victims,
+                                          IMAGE_CACHE_MAX_ENTRIES);
+    if (evicted < 0) return;
+    s_evictions += evicted;
+    // Drop evicted entries from the saved index before their files go.
+    if (evicted > 0 || existing >= 0) save_index_locked();
+  }
+
+  for (int i = 0; i < evicted; i++) {
+    char victim_path[64];
+    path_for(victims[i], victim_path, sizeof(victim_path));
+    remove(victim_path);
+  }
+
+  if (!write_file(path, p.buf, p.len)) {
+    ESP_LOGW(TAG, "Failed to store %s (%zu bytes)", p.key, p.len);
+    return;
+  }
+
+  raii::MutexGuard lock(s_mutex);
+  if (!lock) return;
+  image_cache_index_add(&s_index, p.key, static_cast<uint32_t>(p.len));
+  s_stores++;
+  save_index_locked();
+  ESP_LOGI(TAG, "Stored %s (%zu bytes, %d entries, %llu/%llu bytes)", p.key,
+           p.len, s_index.count, static_cast<unsigned long long>(s_index.bytes),
+           static_cast<unsigned long long>(s_budget));
+}
+
+// Load key's image into a new arena buffer. Needs an internal-RAM stack.
+bool read_entry(const char* key, uint8_t** buf, size_t* len) {
+  uint32_t size = 0;
+  {
+    raii::MutexGuard lock(s_mutex);
+    if (!lock) return false;
+    const int i = image_cache_index_find(&s_index, key);
+    if (i < 0) {
+      s_misses++;
+      return false;
+    }
+    size = s_index.entries[i].size;
+    image_cache_index_touch(&s_index, i);
+  }
+
+  // Read outside the lock; stores run on this same task.
+  char path[64];
+  path_for(key, path, sizeof(path));
+  auto* data = static_cast<uint8_t*>(image_arena_alloc(size));
+  FILE* f = data ? fopen(path, "rb") : nullptr;
+  const bool ok = f && fread(data, 1, size, f) == size;
+  if (f) fclose(f);
+
+  raii::MutexGuard lock(s_mutex);
+  if (!ok) {
+    image_arena_free(data);
+    if (lock) s_misses++;
+    return false;
+  }
+  if (lock) s_hits++;
+  *buf = data;
+  *len = size;
+  return true;
+}
+
+void serve_read() {
+  char key[IMAGE_CACHE_KEY_MAX];
+  uint32_t seq;
+  {
+    raii::MutexGuard lock(s_mutex);
+    if (!lock || !s_read.waiting) return;
+    memcpy(key, s_read.key, sizeof(key));
+    seq = s_read.seq;
+  }
+  uint8_t* buf = nullptr;
+  size_t len = 0;
+  const bool ok = read_entry(key, &buf, &len);
+  {
+    raii::MutexGuard lock(s_mutex);
+    if (lock && s_read.waiting && s_read.seq == seq) {
+      s_read.waiting = false;
+      s_read.ok = ok;
+      s_read.buf = buf;
+      s_read.len = len;
+      buf = nullptr;
+    }
+  }
+  if (buf) {
+    image_arena_free(buf);  // the caller gave up
+    return;
+  }
+  xSemaphoreGive(s_read_done);
+}
+
+void writer_task(void*) {
+  while (true) {
+    uint32_t bits = 0;
+    xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+    if (bits & NOTIFY_READ) serve_read();
+    if (!(bits & NOTIFY_STORE)) continue;
+    PendingStore p = {};
+    {
+      raii::MutexGuard lock(s_mutex);
+      if (!lock) continue;
+      p = s_pending;
+      s_pending = {};
+    }
+    if (!p.buf) continue;
+    store(p);
+    image_arena_free(p.buf);
+  }
+}
+
+}  // namespace
+
+void image_cache_init(void) {
+  if (s_mutex || CONFIG_IMAGE_CACHE_KB == 0) return;
+
+  esp_vfs_littlefs_conf_t conf = {};
+  conf.base_path = MOUNT_POINT;
+  conf.partition_label = PARTITION_LABEL;
+  conf.format_if_mount_failed = true;
+  conf.dont_mount = false;
+  esp_err_t err = esp_vfs_littlefs_register(&conf);
+  if (err != ESP_OK) {
+    ESP_LOGI(TAG, "No image cache partition (%s); cache disabled",
+             esp_err_to_name(err));
+    return;
+  }
+
+  // Leave a quarter of the partition free: LittleFS copies on write and
+  // needs spare blocks for metadata and the temp file of a replacement.
+  size_t total = 0;
+  size_t used = 0;
+  esp_littlefs_info(PARTITION_LABEL, &total, &used);
+  s_budget = static_cast<uint64_t>(CONFIG_IMAGE_CACHE_KB) * 1024;
+  if (s_budget > total * 3 / 4) s_budget = total * 3 / 4;
+
+  s_mutex = xSemaphoreCreateMutex();
+  s_read_lock = xSemaphoreCreateMutex();
+  s_read_done = xSemaphoreCreateBinary();
+  if (!s_mutex || !s_read_lock || !s_read_done ||
+      xTaskCreate(writer_task, "img_cache", WRITER_STACK_SIZE, nullptr,
+                  WRITER_PRIORITY, &s_writer) != pdPASS) {
+    ESP_LOGE(TAG, "Failed to start image cache writer");
+    if (s_mutex) vSemaphoreDelete(s_mutex);
+    if (s_read_lock) vSemaphoreDelete(s_read_lock);
+    if (s_read_done) vSemaphoreDelete(s_read_done);
+    s_mutex = nullptr;
+    s_read_lock = nullptr;
+    s_read_done = nullptr;
+    esp_vfs_littlefs_unregister(PARTITION_LABEL);
+    return;
+  }
+
+  load_index();
+  image_cache_seen_init(&s_seen);
+  s_enabled = true;
+  ESP_LOGI(TAG, "Image cache: %d entries, %llu bytes, budget %llu bytes",
+           s_index.count, static_cast<unsigned long long>(s_index.bytes),
+           static_cast<unsigned long long>(s_budget));
+}
+
+bool image_cache_enabled(void) { return s_enabled; }
+
+bool image_cache_get(const char* key, uint8_t** buf, size_t* len) {
+  if (!s_enabled || !buf || !len) return false;
+  if (!key || strlen(key) >= IMAGE_CACHE_KEY_MAX) return false;
+  if (xTaskGetCurrentTaskHandle() == s_writer) return read_entry(key, buf, len);
+
+  // LittleFS reads disable the flash cache too, and callers such as
+  // http_fetch run on PSRAM stacks: the writer task does the read.
+  raii::MutexGuard request(s_read_lock);
+  if (!request) return false;
+  {
+    raii::MutexGuard lock(s_mutex);
+    if (!lock) return false;
+    snprintf(s_read.key, sizeof(s_read.key), "%s", key);
+    s_read.seq++;
+    s_read.waiting = true;
+    s_read.ok = false;
+    s_read.buf = nullptr;
+  }
+  xSemaphoreTake(s_read_done, 0);  // drop a stale completion
+  xTaskNotify(s_writer, NOTIFY_READ, eSetBits);
+  const bool done = xSemaphoreTake(s_read_done, READ_TIMEOUT) == pdTRUE;
+
+  raii::MutexGuard lock(s_mutex);
+  if (!lock) return false;
+  if (!done && s_read.waiting) {
+    s_read.waiting = false;  // the writer frees what it reads
+    ESP_LOGW(TAG, "Read of %s timed out", key);
+    return false;
+  }
+  if (!s_read.ok) return false;
+  *buf = s_read.buf;
+  *len = s_read.len;
+  s_read.buf = nullptr;
+  return true;
+}
+
+void image_cache_put(const char* key, const uint8_t* buf, size_t len) {
+  if (!s_enabled || !buf || len == 0 || len > s_budget) return;
+  if (key && strlen(key) >= IMAGE_CACHE_KEY_MAX) return;
+
+  // With the key at hand, skip the copy for images already stored and for
+  // first sightings. Content keys are hashed, and gated, on the writer task.
+  if (key) {
+    raii::MutexGuard lock(s_mutex);
+    if (!lock) return;
+    const int existing = image_cache_index_find(&s_index, key);
+    if (existing >= 0 && s_index.entries[existing].size == len) {
+      image_cache_index_touch(&s_index, existing);
+      return;
+    }
+    if (existing < 0 && !image_cache_seen_note(&s_seen, key)) return;
+  }
+
+  auto* copy = static_cast<uint8_t*>(image_arena_alloc(len));
+  if (!copy) return;
+  memcpy(copy, buf, len);
+
+  {
+    raii::MutexGuard lock(s_mutex);
+    if (!lock) {
+      image_arena_free(copy);
+      return;
+    }
+    image_arena_free(s_pending.buf);
+    s_pending.buf = copy;
+    s_pending.len = len;
+    snprintf(s_pending.key, sizeof(s_pending.key), "%s", key ? key : "");
+  }
+  xTaskNotify(s_writer, NOTIFY_STORE, eSetBits);
+}
+
+size_t image_cache_append_validators(char* out, size_t out_len) {
+  if (!out || out_len == 0) return 0;
+  if (!s_enabled) return strlen(out);
+  raii::MutexGuard lock(s_mutex);
+  if (!lock) return strlen(out);
+  return image_cache_index_append_validators(&s_index, out, out_len);
+}
+
+void image_cache_get_stats(image_cache_stats_t* out) {
+  if (!out) return;
+  *out = {};
+  out->enabled = s_enabled;
+  if (!s_enabled) return;
+  raii::MutexGuard lock(s_mutex);
+  if (!lock) return;
+  out->hits = s_hits;
+  out->misses = s_misses;
+  out->stores = s_stores;
+  out->evictions = s_evictions;
+  out->entries = static_cast<uint32_t>(s_index.count);
+  out->bytes = static_cast<uint32_t>(s_index.bytes);
+  out->budget_bytes = static_cast<uint32_t>(s_budget);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "image_cache_index.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Mount the "imgcache" LittleFS partition and load its index. Without that
+/// partition (boards whose table has no room for it) or with
+/// CONFIG_IMAGE_CACHE_KB at 0 the cache stays disabled: lookups miss and
+/// stores are dropped.
+void image_cache_init(void);
+
+bool image_cache_enabled(void);
+
+/// Load the image stored under @p key (an ETag as the server sent it) into a
+/// new image_arena buffer the caller frees. The read runs on the cache's own
+/// task, so any caller may use it, PSRAM stack or not; it blocks until then,
+/// behind a store in progress, and gives up as a miss after a few seconds.
+/// Counts a hit or a miss.
+bool image_cache_get(const char* key, uint8_t** buf, size_t* len);
+
+/// Offer @p buf for storage under @p key (NULL: a key derived from the
+/// content). The first offer of a key is only noted, so one-off images cost
+/// no flash wear; from the second on, a copy is queued and written on the
+/// cache's own low-priority task, evicting least recently used images to
+/// stay within the budget. A store still pending is replaced by a newer one.
+void image_cache_put(const char* key, const uint8_t* buf, size_t len);
+
+/// Append the stored keys, most recently used first, to the If-None-Match
+/// list in @p out, skipping any already listed. Returns the list length.
+size_t image_cache_append_validators(char* out, size_t out_len);
+
+typedef struct {
+  bool enabled;
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t stores;
+  uint32_t evictions;
+  uint32_t entries;
+  uint32_t bytes;
+  uint32_t budget_bytes;
+} image_cache_stats_t;
+
+void image_cache_get_stats(image_cache_stats_t* out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,141 @@
+#include "image_cache_index.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "etag_table.h"
+
+namespace {
+
+bool key_ok(const char* key) {
+  return key && key[0] != '\0' && strlen(key) < IMAGE_CACHE_KEY_MAX;
+}
+
+uint64_t key_hash(const char* key) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (const char* p = key ? key : ""; *p; p++) {
+    h ^= static_cast<uint8_t>(*p);
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+bool is_hash_key(const char* key) {
+  return strncmp(key, IMAGE_CACHE_HASH_PREFIX,
+                 sizeof(IMAGE_CACHE_HASH_PREFIX) - 1) == 0;
+}
+
+int lru_position(const image_cache_index_t* idx) {
+  int lru = -1;
+  for (int i = 0; i < idx->count; i++) {
+    if (lru < 0 || idx->entries[i].last_use < idx->entries[lru].last_use) {
+      lru = i;
+    }
+  }
+  return lru;
+}
+
+}  // namespace
+
+void image_cache_index_init(image_cache_index_t* idx) {
+  memset(idx, 0, sizeof(*idx));
+}
+
+int image_cache_index_find(const image_cache_index_t* idx, const char* key) {
+  if (!key_ok(key)) return -1;
+  for (int i = 0; i < idx->count; i++) {
+    if (strcmp(idx->entries[i].key, key) == 0) return i;
+  }
+  return -1;
+}
+
+void image_cache_index_touch(image_cache_index_t* idx, int i) {
+  if (i < 0 || i >= idx->count) return;
+  idx->entries[i].last_use = ++idx->clock;
+}
+
+void image_cache_index_remove(image_cache_index_t* idx, int i) {
+  if (i < 0 || i >= idx->count) return;
+  idx->bytes -= idx->entries[i].size;
+  idx->entries[i] = idx->entries[idx->count - 1];
+  idx->count--;
+}
+
+int image_cache_index_make_room(image_cache_index_t* idx, uint32_t size,
+                                uint64_t budget,
+                                char (*victims)[IMAGE_CACHE_KEY_MAX],
+                                int max_victims) {
+  if (size > budget) return -1;
+
+  // Count first so a refusal leaves the index untouched.
+  image_cache_index_t trial = *idx;
+  int n = 0;
+  while (trial.count > 0 && (trial.bytes + size > budget ||
+                             trial.count >= IMAGE_CACHE_MAX_ENTRIES)) {
+    image_cache_index_remove(&trial, lru_position(&trial));
+    n++;
+  }
+  if (n > max_victims) return -1;
+
+  for (int v = 0; v < n; v++) {
+    const int lru = lru_position(idx);
+    snprintf(victims[v], IMAGE_CACHE_KEY_MAX, "%s", idx->entries[lru].key);
+    image_cache_index_remove(idx, lru);
+  }
+  return n;
+}
+
+int image_cache_index_add(image_cache_index_t* idx, const char* key,
+                          uint32_t size) {
+  if (!key_ok(key)) return -1;
+  int i = image_cache_index_find(idx, key);
+  if (i >= 0) {
+    idx->bytes -= idx->entries[i].size;
+  } else {
+    if (idx->count >= IMAGE_CACHE_MAX_ENTRIES) return -1;
+    i = idx->count++;
+    snprintf(idx->entries[i].key, IMAGE_CACHE_KEY_MAX, "%s", key);
+  }
+  idx->entries[i].size = size;
+  idx->bytes += size;
+  image_cache_index_touch(idx, i);
+  return i;
+}
+
+void image_cache_file_name(const char* key, char out[IMAGE_CACHE_NAME_LEN]) {
+  snprintf(out, IMAGE_CACHE_NAME_LEN, "%016llx",
+           static_cast<unsigned long long>(key_hash(key)));
+}
+
+void image_cache_seen_init(image_cache_seen_t* seen) {
+  memset(seen, 0, sizeof(*seen));
+}
+
+bool image_cache_seen_note(image_cache_seen_t* seen, const char* key) {
+  if (!key_ok(key)) return false;
+  uint64_t h = key_hash(key);
+  if (h == 0) h = 1;  // 0 marks an unused slot
+  for (int i = 0; i < IMAGE_CACHE_SEEN_SLOTS; i++) {
+    if (seen->hashes[i] == h) return true;
+  }
+  seen->hashes[seen->next] = h;
+  seen->next = (seen->next + 1) % IMAGE_CACHE_SEEN_SLOTS;
+  return false;
+}
+
+size_t image_cache_index_append_validators(const image_cache_index_t* idx,
+                                           char* out, size_t out_len) {
+  if (!out || out_len == 0) return 0;
+
+  uint32_t uses[IMAGE_CACHE_MAX_ENTRIES];
+  int order[IMAGE_CACHE_MAX_ENTRIES];
+  for (int i = 0; i < idx->count; i++) uses[i] = idx->entries[i].last_use;
+  etag_mru_order(uses, idx->count, order);
+  for (int n = 0; n < idx->count; n++) {
+    const char* key = idx->entries[order[n]].key;
+    // Content-hash keys from WebSocket pushes are not HTTP validators.
+    if (is_hash_key(key)) continue;
+    etag_list_append(out, out_len, key);
+  }
+  return strlen(out);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bounded by the rotation size we care about (5-15 apps) with headroom for
+// apps whose content changes through the day.
+#define IMAGE_CACHE_MAX_ENTRIES 32
+// Matches remote.cpp's ETAG_MAX; keys are ETags as the server sent them.
+#define IMAGE_CACHE_KEY_MAX 80
+// Prefix of content-hash keys (WebSocket pushes); any other key is an ETag.
+#define IMAGE_CACHE_HASH_PREFIX "sha256:"
+// FNV-1a 64 of the key in hex, plus NUL.
+#define IMAGE_CACHE_NAME_LEN 17
+// Keys seen once and not yet stored: a few rotations' worth.
+#define IMAGE_CACHE_SEEN_SLOTS 64
+
+typedef struct {
+  char key[IMAGE_CACHE_KEY_MAX];
+  uint32_t size;
+  uint32_t last_use;  // index clock at the last hit or insert
+} image_cache_entry_t;
+
+// LRU index of the stored images under a byte budget. Pure data structure
+// with no RTOS, ESP or filesystem dependencies so it is host-testable; it is
+// NOT thread safe, callers serialize access (image_cache.cpp guards it with a
+// mutex) and own the files the entries describe.
+typedef struct {
+  image_cache_entry_t entries[IMAGE_CACHE_MAX_ENTRIES];
+  int count;
+  uint32_t clock;
+  uint64_t bytes;
+} image_cache_index_t;
+
+// Keys (as FNV-1a 64 hashes) offered for storage once. An image is only
+// worth a flash write and an eviction when it comes back, so the first
+// sighting of a key is just noted here. Oldest sightings are forgotten
+// first. Same rules as image_cache_index_t: pure, NOT thread safe.
+typedef struct {
+  uint64_t hashes[IMAGE_CACHE_SEEN_SLOTS];  // 0 for an unused slot
+  int next;
+} image_cache_seen_t;
+
+void image_cache_index_init(image_cache_index_t* idx);
+
+void image_cache_seen_init(image_cache_seen_t* seen);
+
+// Note a sighting of key. Returns true when key was noted before, false
+// (remembering it) the first time.
+bool image_cache_seen_note(image_cache_seen_t* seen, const char* key);
+
+// Entry position for key, or -1.
+int image_cache_index_find(const image_cache_index_t* idx, const char* key);
+
+// Mark entry i most recently used.
+void image_cache_index_touch(image_cache_index_t* idx, int i);
+
+void image_cache_index_remove(image_cache_index_t* idx, int i);
+
+// Evict least recently used entries until an image of `size` bytes fits in
+// `budget` bytes and a free slot exists. Evicted keys are copied to
+// victims[0..n) for the caller to delete; returns n, or -1 (evicting nothing)
+// when size alone exceeds the budget or more than max_victims would go.
+int image_cache_index_make_room(image_cache_index_t* idx, uint32_t size,
+                                uint64_t budget,
+                                char (*victims)[IMAGE_CACHE_KEY_MAX],
+                                int max_victims);
+
+// Add key as the most recently used entry (replacing an existing entry for
+// the same key). Call image_cache_index_make_room first. Returns its
+// position, or -1 when the key is empty or too long, or the index is full.
+int image_cache_index_add(image_cache_index_t* idx, const char* key,
+                          uint32_t size);
+
+// Stable file name for key: FNV-1a 64 in lowercase hex.
+void image_cache_file_name(const char* key, char out[IMAGE_CACHE_NAME_LEN]);
+
+// Append the stored ETag keys, most recently used first, to the If-None-Match
+// list in out (see etag_list_append): content-hash keys, keys already listed
+// and keys that do not fit whole are left off. Returns the list length.
+size_t image_cache_index_append_validators(const image_cache_index_t* idx,
+                                           char* out, size_t out_len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,5 +1,6 @@
 #include "messages.h"
 
+#include <atomic>
 #include <cstring>
 
 #include <cJSON.h>
@@ -7,19 +8,27 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
+#include "image_cache.h"
 #include "mdns_service.h"
 #include "nvs_settings.h"
+#include "playlist.h"
 #include "sockets.h"
 #include "version.h"
 #include "wifi.h"
+#include "ws_control.h"
 
 namespace {
 
 const char* TAG = "messages";
 
-constexpr int WEBSOCKET_PROTOCOL_VERSION = 1;
+// Version 2 adds the binary ws_control header; version 1 messages are still
+// accepted.
+constexpr int WEBSOCKET_PROTOCOL_VERSION = WS_CONTROL_VERSION;
+
+constexpr TickType_t NOTICE_SEND_TIMEOUT = pdMS_TO_TICKS(2000);
 
 TaskHandle_t s_client_info_task = nullptr;
+std::atomic<bool> s_binary_control{false};
 
 void client_info_task(void*) {
   while (true) {
@@ -28,12 +37,36 @@ void client_info_task(void*) {
   }
 }
 
+esp_err_t send_counter(uint8_t type, uint8_t msg_key, const char* key,
+                       int counter) {
+  if (s_binary_control.load(std::memory_order_relaxed)) {
+    uint8_t frame[16];
+    size_t len = ws_control_encode_counter(
+        type, static_cast<uint32_t>(counter), frame, sizeof(frame));
+    if (len > 0 && sockets_send_binary(frame, len, NOTICE_SEND_TIMEOUT) >= 0) {
+      ESP_LOGD(TAG, "WS send: %s %d (binary)", key, counter);
+      return ESP_OK;
+    }
+  }
+
+  char message[64];
+  int len = snprintf(message, sizeof(message), "{\"%s\":%d}", key, counter);
+  if (len <= 0 || static_cast<size_t>(len) >= sizeof(message)) {
+    return ESP_FAIL;
+  }
+  if (sockets_send_text(message, len, NOTICE_SEND_TIMEOUT, msg_key) < 0) {
+    ESP_LOGD(TAG, "WS send skipped (%s:%d)", key, counter);
+    return ESP_FAIL;
+  }
+  ESP_LOGD(TAG, "WS send: %s", message);
+  return ESP_OK;
+}
+
 }  // namespace
 
 esp_err_t msg_send_client_info_now() {
   esp_err_t ret = ESP_OK;
   uint8_t mac[6];
-  auto cfg = config_get();
 
   cJSON* root = cJSON_CreateObject();
   if (!root) return ESP_ERR_NO_MEM;
@@ -62,28 +95,35 @@ esp_err_t msg_send_client_info_now() {
   char active_ssid[MAX_SSID_LEN + 1] = {0};
   wifi_get_ssid_str(active_ssid, sizeof(active_ssid));
   cJSON_AddStringToObject(ci, "ssid", active_ssid);
-  cJSON_AddStringToObject(ci, "hostname", cfg.hostname);
-  cJSON_AddStringToObject(ci, "syslog_addr", cfg.syslog_addr);
-  cJSON_AddStringToObject(ci, "sntp_server", cfg.sntp_server);
-  cJSON_AddStringToObject(ci, "image_url", cfg.image_url);
-  if (cfg.api_key[0] != '\0') {
-    cJSON_AddBoolToObject(ci, "has_api_key", true);
+  {
+    // cJSON copies the strings, so the snapshot is released before sending.
+    ConfigSnapshot cfg;
+    cJSON_AddStringToObject(ci, "hostname", cfg->hostname);
+    cJSON_AddStringToObject(ci, "syslog_addr", cfg->syslog_addr);
+    cJSON_AddStringToObject(ci, "sntp_server", cfg->sntp_server);
+    cJSON_AddStringToObject(ci, "image_url", cfg->image_url);
+    if (cfg->api_key[0] != '\0') {
+      cJSON_AddBoolToObject(ci, "has_api_key", true);
+    }
+    cJSON_AddBoolToObject(ci, "swap_colors", cfg->swap_colors);
+    cJSON_AddNumberToObject(ci, "wifi_power_save", cfg->wifi_power_save);
+    cJSON_AddBoolToObject(ci, "skip_display_version",
+                          cfg->skip_display_version);
+    cJSON_AddBoolToObject(ci, "skip_boot_animation", cfg->skip_boot_animation);
+    cJSON_AddBoolToObject(ci, "ap_mode", cfg->ap_mode);
+    cJSON_AddBoolToObject(ci, "prefer_ipv6", cfg->prefer_ipv6);
+    cJSON_AddBoolToObject(ci, "disable_touch", cfg->disable_touch);
   }
-  cJSON_AddBoolToObject(ci, "swap_colors", cfg.swap_colors);
-  cJSON_AddNumberToObject(ci, "wifi_power_save", cfg.wifi_power_save);
-  cJSON_AddBoolToObject(ci, "skip_display_version",
-                        cfg.skip_display_version);
-  cJSON_AddBoolToObject(ci, "skip_boot_animation",
-                        cfg.skip_boot_animation);
-  cJSON_AddBoolToObject(ci, "ap_mode", cfg.ap_mode);
-  cJSON_AddBoolToObject(ci, "prefer_ipv6", cfg.prefer_ipv6);
-  cJSON_AddBoolToObject(ci, "disable_touch", cfg.disable_touch);
+  if (image_cache_enabled()) {
+    cJSON_AddBoolToObject(ci, "image_cache", true);
+  }
+  cJSON_AddNumberToObject(ci, "playlist_max_entries", PLAYLIST_MAX_ENTRIES);
 
   char* json_str = cJSON_PrintUnformatted(root);
   if (json_str) {
     ESP_LOGI(TAG, "Sending client info: %s", json_str);
     int sent = sockets_send_text(json_str, strlen(json_str),
-                                 pdMS_TO_TICKS(5000));
+                                 pdMS_TO_TICKS(5000), SOCKETS_MSG_CLIENT_INFO);
     if (sent < 0) {
       ESP_LOGE(TAG, "Failed to send client info: %d", sent);
       ret = ESP_FAIL;
@@ -114,3 +154,69 @@ esp_err_t msg_send_client_info() {
   xTaskNotifyGive(s_client_info_task);
   return ESP_OK;
 }
+
+esp_err_t msg_send_cache_miss(const char* key) {
+  cJSON* root = cJSON_CreateObject();
+  if (!root) return ESP_ERR_NO_MEM;
+  cJSON_AddStringToObject(root, "cache_miss", key);
+
+  esp_err_t ret = ESP_OK;
+  char* json_str = cJSON_PrintUnformatted(root);
+  if (json_str) {
+    int sent = sockets_send_text(json_str, strlen(json_str),
+                                 pdMS_TO_TICKS(5000));
+    if (sent < 0) {
+      ESP_LOGE(TAG, "Failed to send cache miss: %d", sent);
+      ret = ESP_FAIL;
+    }
+    free(json_str);
+  } else {
+    ret = ESP_ERR_NO_MEM;
+  }
+
+  cJSON_Delete(root);
+  return ret;
+}
+
+esp_err_t msg_send_playlist_missing(const char* const* ids, int count) {
+  cJSON* root = cJSON_CreateObject();
+  if (!root) return ESP_ERR_NO_MEM;
+  cJSON* list = cJSON_AddArrayToObject(root, "playlist_missing");
+  for (int i = 0; list && i < count; i++) {
+    cJSON_AddItemToArray(list, cJSON_CreateString(ids[i]));
+  }
+
+  esp_err_t ret = ESP_OK;
+  char* json_str = list ? cJSON_PrintUnformatted(root) : nullptr;
+  if (json_str) {
+    int sent = sockets_send_text(json_str, strlen(json_str),
+                                 pdMS_TO_TICKS(5000),
+                                 SOCKETS_MSG_PLAYLIST_MISSING);
+    if (sent < 0) {
+      ESP_LOGE(TAG, "Failed to send playlist_missing: %d", sent);
+      ret = ESP_FAIL;
+    }
+    free(json_str);
+  } else {
+    ret = ESP_ERR_NO_MEM;
+  }
+
+  cJSON_Delete(root);
+  return ret;
+}
+
+esp_err_t msg_send_queued(int counter) {
+  return send_counter(WS_CONTROL_QUEUED, SOCKETS_MSG_QUEUED, "queued",
+                      counter);
+}
+
+esp_err_t msg_send_displaying(int counter) {
+  return send_counter(WS_CONTROL_DISPLAYING, SOCKETS_MSG_DISPLAYING,
+                      "displaying", counter);
+}
+
+void msg_set_binary_control(bool enabled) {
+  if (s_binary_control.exchange(enabled) != enabled && enabled) {
+    ESP_LOGI(TAG, "Server speaks binary control; notifications go binary");
+  }
+}
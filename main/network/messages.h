@@ -11,3 +11,21 @@ esp_err_t msg_send_client_info();
 
 /// Send device/client info JSON to the server from the current task.
 esp_err_t msg_send_client_info_now();
+
+/// Tell the server a "play_cached" key is not in the image cache, so it can
+/// push the image itself.
+esp_err_t msg_send_cache_miss(const char* key);
+
+/// Answer a playlist with the ids whose images the device still needs, so
+/// the server sends only those: {"playlist_missing":[...]}.
+esp_err_t msg_send_playlist_missing(const char* const* ids, int count);
+
+/// Report the counter of an image the player queued / started showing. Sent
+/// as a binary ws_control message once the server has sent one on this
+/// connection, else as {"queued":N} / {"displaying":N}.
+esp_err_t msg_send_queued(int counter);
+esp_err_t msg_send_displaying(int counter);
+
+/// Switch the notifications above to binary (the server sent a ws_control
+/// header) or back to JSON (new connection).
+void msg_set_binary_control(bool enabled);
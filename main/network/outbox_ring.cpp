@@ -1,45 +1,82 @@
 #include "outbox_ring.h"
 
-#include <stdlib.h>
+#include <string.h>
 
-void outbox_ring_init(outbox_ring_t* ring) {
-  for (size_t i = 0; i < OUTBOX_RING_DEPTH; i++) {
-    ring->slots[i].data = nullptr;
-    ring->slots[i].len = 0;
+namespace {
+
+// Remove entry i, closing the gap it leaves in buf.
+void remove_entry(outbox_ring_t* ring, size_t i) {
+  const outbox_ring_entry_t gone = ring->entries[i];
+  const size_t tail = gone.offset + gone.len;
+  memmove(ring->buf + gone.offset, ring->buf + tail, ring->used - tail);
+  ring->used -= gone.len;
+  for (size_t j = i + 1; j < ring->count; j++) {
+    ring->entries[j - 1] = ring->entries[j];
+    ring->entries[j - 1].offset -= gone.len;
   }
-  ring->head = 0;
-  ring->count = 0;
+  ring->count--;
 }
 
-bool outbox_ring_push(outbox_ring_t* ring, char* data, size_t len) {
-  bool dropped = false;
-  if (ring->count == OUTBOX_RING_DEPTH) {
-    free(ring->slots[ring->head].data);
-    ring->slots[ring->head].data = nullptr;
-    ring->head = (ring->head + 1) % OUTBOX_RING_DEPTH;
-    ring->count--;
-    dropped = true;
+// Overwrite entry i with data, moving the entries behind it when the length
+// changes. The caller has checked the new length fits.
+void replace_entry(outbox_ring_t* ring, size_t i, const char* data,
+                   size_t len) {
+  outbox_ring_entry_t& e = ring->entries[i];
+  const size_t tail = e.offset + e.len;
+  memmove(ring->buf + e.offset + len, ring->buf + tail, ring->used - tail);
+  memcpy(ring->buf + e.offset, data, len);
+  const long delta = static_cast<long>(len) - static_cast<long>(e.len);
+  for (size_t j = i + 1; j < ring->count; j++) {
+    ring->entries[j].offset =
+        static_cast<uint16_t>(ring->entries[j].offset + delta);
   }
-  size_t idx = (ring->head + ring->count) % OUTBOX_RING_DEPTH;
-  ring->slots[idx].data = data;
-  ring->slots[idx].len = len;
-  ring->count++;
-  return dropped;
+  ring->used = static_cast<size_t>(static_cast<long>(ring->used) + delta);
+  e.len = static_cast<uint16_t>(len);
 }
 
-bool outbox_ring_pop(outbox_ring_t* ring, outbox_ring_slot_t* out) {
-  if (ring->count == 0) return false;
-  *out = ring->slots[ring->head];
-  ring->slots[ring->head].data = nullptr;
-  ring->slots[ring->head].len = 0;
-  ring->head = (ring->head + 1) % OUTBOX_RING_DEPTH;
-  ring->count--;
+}  // namespace
+
+void outbox_ring_init(outbox_ring_t* ring) {
+  ring->count = 0;
+  ring->used = 0;
+}
+
+bool outbox_ring_push(outbox_ring_t* ring, const char* data, size_t len,
+                      uint8_t key) {
+  if (!data || len == 0 || len > OUTBOX_RING_BYTES) return false;
+
+  if (key != OUTBOX_KEY_NONE) {
+    for (size_t i = 0; i < ring->count; i++) {
+      if (ring->entries[i].key != key) continue;
+      if (ring->used - ring->entries[i].len + len > OUTBOX_RING_BYTES) {
+        return false;
+      }
+      replace_entry(ring, i, data, len);
+      return true;
+    }
+  }
+
+  if (ring->count == OUTBOX_RING_DEPTH ||
+      ring->used + len > OUTBOX_RING_BYTES) {
+    return false;
+  }
+  outbox_ring_entry_t& e = ring->entries[ring->count++];
+  e.offset = static_cast<uint16_t>(ring->used);
+  e.len = static_cast<uint16_t>(len);
+  e.key = key;
+  memcpy(ring->buf + ring->used, data, len);
+  ring->used += len;
   return true;
 }
 
+size_t outbox_ring_pop(outbox_ring_t* ring, char* out) {
+  if (ring->count == 0) return 0;
+  const size_t len = ring->entries[0].len;
+  memcpy(out, ring->buf, len);
+  remove_entry(ring, 0);
+  return len;
+}
+
 size_t outbox_ring_count(const outbox_ring_t* ring) { return ring->count; }
 
-void outbox_ring_clear(outbox_ring_t* ring) {
-  outbox_ring_slot_t slot;
-  while (outbox_ring_pop(ring, &slot)) free(slot.data);
-}
+void outbox_ring_clear(outbox_ring_t* ring) { outbox_ring_init(ring); }
@@ -2,43 +2,56 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-// Fixed depth keeps the queue bounded on a long outage. On overflow the
-// OLDEST entry is dropped (a display device favours the newest state).
+// Fixed depth and storage keep the queue bounded on a long outage. A full
+// queue refuses new messages rather than dropping queued ones, so senders
+// see the back-pressure and decide what to retry.
 #define OUTBOX_RING_DEPTH 12
+#define OUTBOX_RING_BYTES 4096
 
-typedef struct {
-  char* data;
-  size_t len;
-} outbox_ring_slot_t;
+// Messages pushed with this key never coalesce.
+#define OUTBOX_KEY_NONE 0
 
-// Bounded FIFO of heap-owned messages. Pure data structure with no RTOS or
-// ESP dependencies so it is host-testable; it is NOT thread safe, callers
-// serialize access (sockets.cpp guards it with a mutex).
 typedef struct {
-  outbox_ring_slot_t slots[OUTBOX_RING_DEPTH];
-  size_t head;   // index of the oldest queued message
-  size_t count;  // number of occupied slots
+  uint16_t offset;  // into buf
+  uint16_t len;
+  uint8_t key;
+} outbox_ring_entry_t;
+
+// Bounded FIFO of messages copied into one preallocated buffer, oldest
+// first. A message pushed with a key replaces the queued message with the
+// same key in place, so a burst of status updates leaves only the latest.
+// Pure data structure with no RTOS or ESP dependencies so it is
+// host-testable; it is NOT thread safe, callers serialize access (sockets.cpp
+// guards it with a mutex).
+typedef struct {
+  outbox_ring_entry_t entries[OUTBOX_RING_DEPTH];
+  size_t count;
+  size_t used;  // bytes of buf holding entries, which are packed in order
+  char buf[OUTBOX_RING_BYTES];
 } outbox_ring_t;
 
 void outbox_ring_init(outbox_ring_t* ring);
 
-// Takes ownership of data (heap allocated, len bytes) and appends it. On a
-// full ring the oldest entry is freed and dropped to make room; returns true
-// when that happened.
-bool outbox_ring_push(outbox_ring_t* ring, char* data, size_t len);
+// Copy len bytes of data in. With a key other than OUTBOX_KEY_NONE a queued
+// message with the same key is replaced, keeping its place in the queue.
+// Returns false, changing nothing, when the message is empty or there is no
+// room for it (no free entry, or too few free bytes).
+bool outbox_ring_push(outbox_ring_t* ring, const char* data, size_t len,
+                      uint8_t key);
 
-// Pops the oldest entry into *out (the caller then owns out->data). Returns
-// false when the ring is empty.
-bool outbox_ring_pop(outbox_ring_t* ring, outbox_ring_slot_t* out);
+// Copy the oldest message into out (which must hold OUTBOX_RING_BYTES) and
+// remove it. Returns its length, 0 when the ring is empty.
+size_t outbox_ring_pop(outbox_ring_t* ring, char* out);
 
 size_t outbox_ring_count(const outbox_ring_t* ring);
 
-// Frees every queued message.
+// Forgets every queued message.
 void outbox_ring_clear(outbox_ring_t* ring);
 
 #ifdef __cplusplus
@@ -10,11 +10,15 @@
 #include <esp_netif.h>
 #include <esp_random.h>
 #include <esp_system.h>
+#include <esp_timer.h>
 #include <esp_tls.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
+#include "etag_table.h"
 #include "http_slot.h"
+#include "image_arena.h"
+#include "image_cache.h"
 #include "nvs_settings.h"
 #include "ota.h"
 #include "quiet_hours.h"
@@ -43,11 +47,77 @@ bool http_status_is_transient(int status) {
 constexpr size_t ETAG_MAX = 80;
 constexpr size_t ETAG_URL_MAX = 256;
 
-// Single-slot ETag cache for conditional GETs. remote_get has one caller
-// (the scheduler fetch task), so plain statics need no locking. The cached
-// validator only applies while the poll URL stays the same.
+#ifndef CONFIG_REMOTE_ETAG_CACHE_KB
+#define CONFIG_REMOTE_ETAG_CACHE_KB 512
+#endif
+constexpr uint64_t ETAG_CACHE_BUDGET =
+    static_cast<uint64_t>(CONFIG_REMOTE_ETAG_CACHE_KB) * 1024;
+
+// Conditional-GET state. remote_get has one caller (the scheduler fetch
+// task), so these need no locking. s_etag is the validator of the image on
+// screen and only applies while the poll URL stays the same; s_table keeps
+// the last few responses in PSRAM so a 304 naming any of them is served
+// without a download.
 char s_etag[ETAG_MAX] = {};
 char s_etag_url[ETAG_URL_MAX] = {};
+size_t s_etag_len = 0;
+etag_table_t s_table = {};
+
+// "Bearer <api key>", rebuilt only when the config generation moves so a poll
+// does not copy the whole config. Same single caller as above.
+char s_auth_header[MAX_API_KEY_LEN + 8] = {};  // "Bearer " + key
+uint32_t s_auth_generation = 0;
+bool s_auth_valid = false;
+
+// The Authorization header value, or null when no API key is set.
+const char* auth_header() {
+  const uint32_t gen = config_generation();
+  if (!s_auth_valid || gen != s_auth_generation) {
+    ConfigSnapshot cfg;
+    if (cfg->api_key[0] != '\0') {
+      snprintf(s_auth_header, sizeof(s_auth_header), "Bearer %s",
+               cfg->api_key);
+    } else {
+      s_auth_header[0] = '\0';
+    }
+    s_auth_generation = gen;
+    s_auth_valid = true;
+  }
+  return s_auth_header[0] != '\0' ? s_auth_header : nullptr;
+}
+
+// Counters are also read by /api/diag.
+portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+remote_cache_stats_t s_stats = {};
+
+// If-None-Match lists the current validator plus every image held in PSRAM or
+// in the flash cache, so a server that finds its answer among them can reply
+// 304 with that ETag and the device loads the image locally. Capped well
+// inside the client's TX buffer, which holds the whole request head.
+constexpr size_t VALIDATORS_MAX = 768;
+constexpr int HTTP_TX_BUFFER_SIZE = 1280;
+
+constexpr int HTTP_TIMEOUT_MS = 20000;
+
+#ifndef CONFIG_REMOTE_KEEPALIVE_IDLE_SECS
+#define CONFIG_REMOTE_KEEPALIVE_IDLE_SECS 60
+#endif
+constexpr int64_t KEEPALIVE_IDLE_US =
+    static_cast<int64_t>(CONFIG_REMOTE_KEEPALIVE_IDLE_SECS) * 1000000;
+
+// One client serves every poll, so its TLS session ticket survives between
+// polls (a reconnect resumes instead of running a full handshake) and, while
+// the server keeps it open, so does the connection itself. Like the ETag
+// state it is only used by the fetch task, except that another http_slot
+// holder may close the idle connection (see http_slot_set_idle_connection);
+// the slot serializes the two. s_conn_open follows the client's
+// connect/disconnect events.
+esp_http_client_handle_t s_client = nullptr;
+bool s_conn_open = false;
+int64_t s_idle_since_us = 0;
+remote_conn_stats_t s_conn_stats = {};  // guarded by s_stats_lock
+uint64_t s_new_ms_total = 0;
+uint64_t s_reused_ms_total = 0;
 
 struct RemoteState {
   void* buf;
@@ -61,7 +131,9 @@ struct RemoteState {
   char* image_url;
   bool reboot_requested;
   bool oversize_detected;
+  bool alloc_failed;  // the receive buffer could not grow; data is dropped
   bool quiet;
+  bool connected;  // this request opened a new connection
   char etag[ETAG_MAX];
 };
 
@@ -81,6 +153,20 @@ char* dup_header_value(const char* value) {
   return copy;
 }
 
+// Make the receive buffer hold size bytes. It comes from the image arena, so
+// when the size is known up front (Content-Length) the response lands in a
+// slab reserved at boot and reaches gfx without any heap allocation.
+bool reserve(RemoteState* state, size_t size) {
+  state->buf = image_arena_grow(state->buf, state->len, size);
+  if (!state->buf) {
+    state->size = 0;
+    state->alloc_failed = true;
+    return false;
+  }
+  state->size = size;
+  return true;
+}
+
 template <typename T>
 constexpr T max_val(T a, T b) {
   return (a > b) ? a : b;
@@ -91,6 +177,60 @@ constexpr T min_val(T a, T b) {
   return (a < b) ? a : b;
 }
 
+void set_current(const char* etag, const char* url, size_t len) {
+  if (strlen(url) >= ETAG_URL_MAX) {
+    s_etag[0] = '\0';
+    return;
+  }
+  snprintf(s_etag, sizeof(s_etag), "%s", etag);
+  snprintf(s_etag_url, sizeof(s_etag_url), "%s", url);
+  s_etag_len = len;
+}
+
+// Keep a PSRAM copy of a downloaded image under its ETag. The copy comes
+// from the image arena like the download itself, so it needs no heap block.
+void remember(const char* etag, const uint8_t* body, size_t len) {
+  void* copy = nullptr;
+  if (len <= ETAG_CACHE_BUDGET) {
+    copy = image_arena_alloc(len);
+    if (copy) memcpy(copy, body, len);
+  }
+  void* dropped[ETAG_TABLE_SLOTS];
+  bool kept = false;
+  int n = etag_table_put(&s_table, etag, copy, static_cast<uint32_t>(len),
+                         ETAG_CACHE_BUDGET, &kept, dropped);
+  for (int i = 0; i < n; i++) image_arena_free(dropped[i]);
+  if (!kept) image_arena_free(copy);
+
+  portENTER_CRITICAL(&s_stats_lock);
+  s_stats.entries = static_cast<uint32_t>(s_table.count);
+  s_stats.body_bytes = static_cast<uint32_t>(s_table.body_bytes);
+  portEXIT_CRITICAL(&s_stats_lock);
+}
+
+// Fresh copy of the image remembered under etag (gfx takes ownership of
+// what remote_get returns, so the table's own copy never leaves it).
+uint8_t* recall(const char* etag, size_t* len) {
+  etag_table_entry_t* e = etag_table_find(&s_table, etag);
+  if (!e || !e->body) return nullptr;
+  auto* copy = static_cast<uint8_t*>(image_arena_alloc(e->len));
+  if (!copy) return nullptr;
+  memcpy(copy, e->body, e->len);
+  *len = e->len;
+  return copy;
+}
+
+void count_response(bool hit, size_t bytes_saved) {
+  portENTER_CRITICAL(&s_stats_lock);
+  if (hit) {
+    s_stats.hits++;
+    s_stats.bytes_saved += bytes_saved;
+  } else {
+    s_stats.misses++;
+  }
+  portEXIT_CRITICAL(&s_stats_lock);
+}
+
 esp_err_t http_callback(esp_http_client_event_t* event) {
   esp_err_t err = ESP_OK;
   auto* state = static_cast<RemoteState*>(event->user_data);
@@ -102,6 +242,8 @@ esp_err_t http_callback(esp_http_client_event_t* event) {
 
     case HTTP_EVENT_ON_CONNECTED:
       ESP_LOGD(TAG, "HTTP_EVENT_ON_CONNECTED");
+      s_conn_open = true;
+      if (state) state->connected = true;
       break;
 
     case HTTP_EVENT_HEADER_SENT:
@@ -127,20 +269,12 @@ esp_err_t http_callback(esp_http_client_event_t* event) {
           esp_http_client_close(event->client);
         } else {
           state->expected_len = content_length;
-          if (content_length > state->size) {
-            void* resized = heap_caps_realloc(state->buf, content_length,
-                                              MALLOC_CAP_SPIRAM);
-            if (!resized) {
-              ESP_LOGE(TAG, "Failed to reserve Content-Length buffer (%zu)",
-                       content_length);
-              free(state->buf);
-              state->buf = nullptr;
-              err = ESP_ERR_NO_MEM;
-              esp_http_client_close(event->client);
-              break;
-            }
-            state->buf = resized;
-            state->size = content_length;
+          if (content_length > state->size && !reserve(state, content_length)) {
+            ESP_LOGE(TAG, "Failed to reserve Content-Length buffer (%zu)",
+                     content_length);
+            err = ESP_ERR_NO_MEM;
+            esp_http_client_close(event->client);
+            break;
           }
           ESP_LOGI(TAG, "Content-Length Header: %zu", content_length);
         }
@@ -184,8 +318,8 @@ esp_err_t http_callback(esp_http_client_event_t* event) {
         break;
       }
 
-      if (!state->buf) {
-        ESP_LOGD(TAG, "Discarding HTTP data due to freed buffer");
+      if (state->alloc_failed) {
+        ESP_LOGD(TAG, "Discarding HTTP data due to failed allocation");
         break;
       }
 
@@ -194,6 +328,9 @@ esp_err_t http_callback(esp_http_client_event_t* event) {
         size_t target = required;
         if (state->expected_len > 0 && state->expected_len <= state->max) {
           target = max_val(required, state->expected_len);
+        } else if (state->size == 0) {
+          target = max_val(static_cast<size_t>(CONFIG_HTTP_BUFFER_SIZE_DEFAULT),
+                           required);
         } else {
           target = max_val(min_val(state->size * 2, state->max), required);
         }
@@ -204,7 +341,7 @@ esp_err_t http_callback(esp_http_client_event_t* event) {
           if (gfx_display_asset("oversize") != 0) {
             ESP_LOGE(TAG, "Failed to display oversize graphic");
           }
-          free(state->buf);
+          image_arena_free(state->buf);
           state->buf = nullptr;
           state->oversize_detected = true;
           err = ESP_ERR_NO_MEM;
@@ -212,16 +349,11 @@ esp_err_t http_callback(esp_http_client_event_t* event) {
           break;
         }
 
-        void* resized = heap_caps_realloc(state->buf, state->size,
-                                          MALLOC_CAP_SPIRAM);
-        if (!resized) {
+        if (!reserve(state, target)) {
           ESP_LOGE(TAG, "Resizing response buffer failed");
-          free(state->buf);
-          state->buf = nullptr;
           err = ESP_ERR_NO_MEM;
           break;
         }
-        state->buf = resized;
       }
 
       memcpy(static_cast<uint8_t*>(state->buf) + state->len,
@@ -235,6 +367,7 @@ esp_err_t http_callback(esp_http_client_event_t* event) {
 
     case HTTP_EVENT_DISCONNECTED: {
       ESP_LOGD(TAG, "HTTP_EVENT_DISCONNECTED");
+      s_conn_open = false;
       int mbedtls_err = 0;
       esp_err_t tls_err = esp_tls_get_and_clear_last_error(
           static_cast<esp_tls_error_handle_t>(event->data), &mbedtls_err,
@@ -262,22 +395,105 @@ esp_err_t http_callback(esp_http_client_event_t* event) {
   return err;
 }
 
+// http_slot closer for the connection left open after a poll.
+void close_idle_connection() {
+  if (s_client) esp_http_client_close(s_client);
+}
+
+// The shared poll client pointed at url, with its events routed to state.
+esp_http_client_handle_t poll_client(const char* url, RemoteState* state) {
+  if (s_client && s_conn_open &&
+      esp_timer_get_time() - s_idle_since_us > KEEPALIVE_IDLE_US) {
+    // Likely timed out on the server (or a NAT) already; writing into it
+    // would only fail or stall, so reconnect, resuming the TLS session.
+    esp_http_client_close(s_client);
+  }
+
+  if (!s_client) {
+    esp_http_client_config_t config = {};
+    config.url = url;
+    config.event_handler = http_callback;
+    config.timeout_ms = HTTP_TIMEOUT_MS;
+    config.crt_bundle_attach = esp_crt_bundle_attach;
+    config.buffer_size_tx = HTTP_TX_BUFFER_SIZE;
+    config.keep_alive_enable = true;
+    config.save_client_session = true;
+    s_client = esp_http_client_init(&config);
+    if (!s_client) return nullptr;
+  } else if (esp_http_client_set_url(s_client, url) != ESP_OK) {
+    // Leaves the old URL in place; the next poll tries again.
+    return nullptr;
+  }
+  esp_http_client_set_user_data(s_client, state);
+  return s_client;
+}
+
+// End a request. With keep set, a connection the server left open stays open
+// for the next poll; the client and its TLS session are kept either way.
+void finish_request(esp_http_client_handle_t http, bool keep) {
+  esp_http_client_set_user_data(http, nullptr);
+  if (keep && KEEPALIVE_IDLE_US > 0 && s_conn_open) {
+    s_idle_since_us = esp_timer_get_time();
+    http_slot_set_idle_connection("remote", close_idle_connection);
+  } else {
+    esp_http_client_close(http);
+  }
+}
+
+void count_request(bool new_connection, int64_t elapsed_us) {
+  const uint64_t ms = elapsed_us > 0 ? elapsed_us / 1000 : 0;
+  portENTER_CRITICAL(&s_stats_lock);
+  s_conn_stats.requests++;
+  if (new_connection) {
+    s_conn_stats.connects++;
+    s_new_ms_total += ms;
+  } else {
+    s_conn_stats.reused++;
+    s_reused_ms_total += ms;
+  }
+  portEXIT_CRITICAL(&s_stats_lock);
+}
+
 }  // namespace
 
 void remote_reset_cache(void) {
   s_etag[0] = '\0';
   s_etag_url[0] = '\0';
+  s_etag_len = 0;
+}
+
+void remote_get_cache_stats(remote_cache_stats_t* out) {
+  if (!out) return;
+  portENTER_CRITICAL(&s_stats_lock);
+  *out = s_stats;
+  portEXIT_CRITICAL(&s_stats_lock);
+}
+
+void remote_get_conn_stats(remote_conn_stats_t* out) {
+  if (!out) return;
+  portENTER_CRITICAL(&s_stats_lock);
+  *out = s_conn_stats;
+  out->avg_new_ms = s_conn_stats.connects
+                        ? static_cast<uint32_t>(s_new_ms_total /
+                                                s_conn_stats.connects)
+                        : 0;
+  out->avg_reused_ms = s_conn_stats.reused
+                           ? static_cast<uint32_t>(s_reused_ms_total /
+                                                   s_conn_stats.reused)
+                           : 0;
+  portEXIT_CRITICAL(&s_stats_lock);
 }
 
 int remote_get(const char* url, uint8_t** buf, size_t* len,
                uint8_t* brightness_pct, int32_t* dwell_secs,
                int* return_status_code, char** ota_url, char** image_url,
                bool* reboot_requested) {
+  // The receive buffer is taken from the image arena once the response size
+  // is known, so nothing is allocated for a 304.
   RemoteState state = {
-      .buf = heap_caps_malloc(CONFIG_HTTP_BUFFER_SIZE_DEFAULT,
-                              MALLOC_CAP_SPIRAM),
+      .buf = nullptr,
       .len = 0,
-      .size = CONFIG_HTTP_BUFFER_SIZE_DEFAULT,
+      .size = 0,
       .max = CONFIG_HTTP_BUFFER_SIZE_MAX,
       .expected_len = 0,
       .brightness = 255,
@@ -286,72 +502,63 @@ int remote_get(const char* url, uint8_t** buf, size_t* len,
       .image_url = nullptr,
       .reboot_requested = false,
       .oversize_detected = false,
+      .alloc_failed = false,
       .quiet = false,
+      .connected = false,
       .etag = {},
   };
 
-  if (!state.buf) {
-    ESP_LOGE(TAG, "couldn't allocate HTTP receive buffer");
-    return 1;
-  }
-
-  esp_http_client_config_t config = {};
-  config.url = url;
-  config.event_handler = http_callback;
-  config.user_data = &state;
-  config.timeout_ms = 20000;
-  config.crt_bundle_attach = esp_crt_bundle_attach;
+  // Cleared when a 304 names nothing we can show, so the repeat request gets
+  // the image itself.
+  bool send_validators = true;
+  // Set to repeat the request at once, without backoff or using up an
+  // attempt: after such a 304, or when a kept-alive connection turns out to
+  // have been dropped by the server.
+  bool redo = false;
+  bool stale_retried = false;
 
   // Read auth config once; API key is stable for the lifetime of this call.
-  auto cfg = config_get();
+  const char* const auth = auth_header();
 
   // Yield to OTA: an update holds the shared TLS slot for its whole download,
   // so there is no point contending. Skip this poll cycle entirely; the
   // scheduler retries on its next interval once the update finishes.
   if (ota_in_progress()) {
     ESP_LOGI(TAG, "OTA in progress, skipping image fetch");
-    free(state.buf);
     return 1;
   }
 
   for (int attempt = 0; attempt < REMOTE_MAX_ATTEMPTS; ++attempt) {
-    if (attempt > 0) {
-      uint32_t base   = REMOTE_BACKOFF_MS[attempt];
-      uint32_t jitter = base ? (esp_random() % (base / 2 + 1)) : 0;
-      vTaskDelay(pdMS_TO_TICKS(base + jitter));
+    if (attempt > 0 || redo) {
+      if (!redo) {
+        uint32_t base   = REMOTE_BACKOFF_MS[attempt];
+        uint32_t jitter = base ? (esp_random() % (base / 2 + 1)) : 0;
+        vTaskDelay(pdMS_TO_TICKS(base + jitter));
+      }
+      redo = false;
 
       // Reset per-attempt accumulation state.
       state.len              = 0;
       state.expected_len     = 0;
       state.oversize_detected = false;
+      state.alloc_failed     = false;
       if (state.ota_url) { free(state.ota_url); state.ota_url = nullptr; }
       if (state.image_url) { free(state.image_url); state.image_url = nullptr; }
       state.reboot_requested = false;
       state.brightness  = 255;
       state.dwell_secs  = -1;
       state.quiet       = false;
+      state.connected   = false;
       state.etag[0]     = '\0';
-
-      // A previous attempt's callback may have freed the buffer on an OOM/
-      // realloc failure (sets buf to nullptr). Re-allocate so this attempt
-      // starts with a clean receive buffer.
-      if (!state.buf) {
-        state.buf  = heap_caps_malloc(CONFIG_HTTP_BUFFER_SIZE_DEFAULT,
-                                      MALLOC_CAP_SPIRAM);
-        state.size = CONFIG_HTTP_BUFFER_SIZE_DEFAULT;
-        if (!state.buf) {
-          ESP_LOGE(TAG, "couldn't reallocate HTTP receive buffer");
-          // state.ota_url / state.image_url are nullptr (reset above);
-          // nothing else to free.
-          return 1;
-        }
-      }
+      // The buffer (if any) is kept for this attempt; after a failed
+      // allocation the callback takes a new one as data arrives.
     }
 
     // Hold the shared TLS slot across connect + transfer so this handshake
     // cannot collide with another client's. The guard releases at the end of
     // each loop iteration (before the next attempt's backoff) and on every
-    // return below, always after esp_http_client_cleanup has freed the socket.
+    // return below, always after finish_request has closed the socket or
+    // handed it to the slot as an idle connection.
     http_slot::Guard slot("remote", REMOTE_SLOT_WAIT_MS);
     if (!slot) {
       // Slot stayed busy (an OTA download is likely running). Do not spin
@@ -361,10 +568,10 @@ int remote_get(const char* url, uint8_t** buf, size_t* len,
       break;
     }
 
-    esp_http_client_handle_t http = esp_http_client_init(&config);
+    esp_http_client_handle_t http = poll_client(url, &state);
     if (!http) {
-      // Re-create fails on this attempt; treat as transient and retry.
-      ESP_LOGW(TAG, "HTTP client init failed (attempt %d/%d)",
+      // Treat as transient and retry.
+      ESP_LOGW(TAG, "HTTP client setup failed (attempt %d/%d)",
                attempt + 1, REMOTE_MAX_ATTEMPTS);
       continue;
     }
@@ -374,39 +581,59 @@ int remote_get(const char* url, uint8_t** buf, size_t* len,
       ESP_LOGE(TAG, "Failed to set firmware version header");
     }
 
-    if (cfg.api_key[0] != '\0') {
-      char auth_header[MAX_API_KEY_LEN + 8];  // "Bearer " + key
-      snprintf(auth_header, sizeof(auth_header), "Bearer %s", cfg.api_key);
+    // The client outlives this call, so headers from the previous poll are
+    // still set: replace or delete each one.
+    if (auth) {
       ESP_LOGD(TAG, "Using Authorization Bearer header");
-      if (esp_http_client_set_header(http, "Authorization",
-                                     auth_header) != ESP_OK) {
+      if (esp_http_client_set_header(http, "Authorization", auth) != ESP_OK) {
         ESP_LOGE(TAG, "Failed to set Authorization header");
       }
+    } else {
+      esp_http_client_delete_header(http, "Authorization");
     }
 
     // Conditional GET: with the cached validator the server can answer 304
     // and the device skips the download and re-decode of unchanged content.
-    if (s_etag[0] != '\0' && strcmp(s_etag_url, url) == 0) {
-      if (esp_http_client_set_header(http, "If-None-Match", s_etag) !=
+    const bool same_url = s_etag[0] != '\0' && strcmp(s_etag_url, url) == 0;
+    char validators[VALIDATORS_MAX];
+    if (send_validators) {
+      etag_table_format_validators(&s_table, same_url ? s_etag : "",
+                                   validators, sizeof(validators));
+      image_cache_append_validators(validators, sizeof(validators));
+    }
+    if (send_validators && validators[0] != '\0') {
+      if (esp_http_client_set_header(http, "If-None-Match", validators) !=
           ESP_OK) {
         ESP_LOGE(TAG, "Failed to set If-None-Match header");
       }
+    } else {
+      esp_http_client_delete_header(http, "If-None-Match");
     }
 
+    const bool reusing = s_conn_open;
+    const int64_t start_us = esp_timer_get_time();
     esp_err_t err = esp_http_client_perform(http);
 
     if (err != ESP_OK) {                     // connection / TLS / timeout
+      finish_request(http, false);
+      if (reusing && !state.connected && !stale_retried) {
+        ESP_LOGI(TAG, "Kept-alive connection was dropped, reconnecting");
+        stale_retried = true;
+        redo = true;
+        --attempt;
+        continue;
+      }
       ESP_LOGW(TAG, "fetch attempt %d/%d failed: %s", attempt + 1,
                REMOTE_MAX_ATTEMPTS, esp_err_to_name(err));
-      esp_http_client_cleanup(http);
       continue;                              // transient -> retry
     }
+    count_request(state.connected, esp_timer_get_time() - start_us);
 
     if (state.oversize_detected) {           // fatal: never retry
       ESP_LOGI(TAG, "Request aborted due to oversize content");
       *return_status_code = 413;
-      esp_http_client_cleanup(http);
-      free(state.buf);                       // safe even if nullptr (OOM path)
+      finish_request(http, false);
+      image_arena_free(state.buf);           // safe even if nullptr (OOM path)
       free(state.ota_url);
       free(state.image_url);
       return 1;
@@ -419,9 +646,12 @@ int remote_get(const char* url, uint8_t** buf, size_t* len,
       // Feed the server quiet signal into the OR-combined quiet-hours engine.
       // Only trust it on a real response, so transient errors do not flip state.
       quiet_hours_set_remote_active(state.quiet);
-      if (state.etag[0] != '\0' && strlen(url) < ETAG_URL_MAX) {
-        snprintf(s_etag, sizeof(s_etag), "%s", state.etag);
-        snprintf(s_etag_url, sizeof(s_etag_url), "%s", url);
+      count_response(false, 0);
+      if (state.etag[0] != '\0') {
+        set_current(state.etag, url, state.len);
+        remember(state.etag, static_cast<uint8_t*>(state.buf), state.len);
+        image_cache_put(state.etag, static_cast<uint8_t*>(state.buf),
+                        state.len);
       } else {
         s_etag[0] = '\0';
       }
@@ -433,31 +663,70 @@ int remote_get(const char* url, uint8_t** buf, size_t* len,
       *ota_url = state.ota_url;
       *image_url = state.image_url;
       *reboot_requested = state.reboot_requested;
-      esp_http_client_cleanup(http);
+      finish_request(http, true);
       return 0;
     }
 
     if (status_code == 304) {  // not modified: keep displaying current content
+      // A 304 naming another validator we sent points at a remembered image,
+      // in PSRAM or in the flash cache. Without an ETag it can only mean the
+      // current one; if there is none, ask again for the image itself.
+      const bool is_current =
+          same_url && (state.etag[0] == '\0' || strcmp(state.etag, s_etag) == 0);
+      uint8_t* cached = nullptr;
+      size_t cached_len = 0;
+      if (!is_current && state.etag[0] != '\0') {
+        cached = recall(state.etag, &cached_len);
+        if (cached) {
+          // A repeat of an image seen before: worth keeping across reboots.
+          image_cache_put(state.etag, cached, cached_len);
+        } else {
+          image_cache_get(state.etag, &cached, &cached_len);
+        }
+      }
+      if (!is_current && !cached) {
+        if (send_validators) {
+          ESP_LOGW(TAG, "304 for an image not in the cache, refetching");
+          finish_request(http, true);
+          send_validators = false;
+          redo = true;
+          --attempt;  // not a failure: do not use up an attempt
+          continue;
+        }
+        // Already asked without validators; fall through to "unchanged".
+      }
       quiet_hours_set_remote_active(state.quiet);
-      *buf            = nullptr;
-      *len            = 0;
+      if (is_current || cached) {
+        count_response(true, is_current ? s_etag_len : cached_len);
+      }
+      if (cached) {
+        ESP_LOGI(TAG, "Serving %s from cache (%zu bytes)", state.etag,
+                 cached_len);
+        set_current(state.etag, url, cached_len);
+        image_arena_free(state.buf);
+        state.buf = cached;
+        state.len = cached_len;
+        *return_status_code = 200;
+      }
+      *buf            = static_cast<uint8_t*>(cached);
+      *len            = cached_len;
       *brightness_pct = state.brightness;
       if (state.dwell_secs > -1 && state.dwell_secs < 300)
         *dwell_secs = state.dwell_secs;
       *ota_url = state.ota_url;
       *image_url = state.image_url;
       *reboot_requested = state.reboot_requested;
-      esp_http_client_cleanup(http);
-      free(state.buf);
+      finish_request(http, true);
+      if (!cached) image_arena_free(state.buf);
       return 0;
     }
 
     ESP_LOGW(TAG, "HTTP status %d (attempt %d/%d)", status_code,
              attempt + 1, REMOTE_MAX_ATTEMPTS);
-    esp_http_client_cleanup(http);
+    finish_request(http, false);
 
     if (!http_status_is_transient(status_code)) {  // 4xx (not 408/429): fatal
-      free(state.buf);
+      image_arena_free(state.buf);
       free(state.ota_url);
       free(state.image_url);
       return 1;
@@ -467,7 +736,7 @@ int remote_get(const char* url, uint8_t** buf, size_t* len,
 
   // All attempts exhausted without a successful response.
   ESP_LOGE(TAG, "fetch failed after %d attempts", REMOTE_MAX_ATTEMPTS);
-  free(state.buf);      // safe if nullptr (callback OOM'd the buffer)
+  image_arena_free(state.buf);  // safe if nullptr (callback OOM'd the buffer)
   free(state.ota_url);  // safe if nullptr (no OTA header or reset between attempts)
   free(state.image_url);  // ditto for the image-URL header
   return 1;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 // Retrieves url via HTTP GET. Caller is responsible for freeing buf,
@@ -15,9 +16,38 @@ int remote_get(const char* url, uint8_t** buf, size_t* len,
                uint8_t* brightness_pct, int32_t* dwell_secs, int* return_code,
                char** ota_url, char** image_url, bool* reboot_requested);
 
-// Drops the cached conditional-GET validator so the next remote_get performs a
-// full download instead of possibly receiving a 304. Call this after the panel
-// has been blanked while the displayed content is unchanged (for example when
-// resuming from quiet hours): a 304 would tell the scheduler to keep showing
-// content that is no longer on screen, leaving the panel blank.
-void remote_reset_cache(void);
\ No newline at end of file
+// Forgets which image is on screen, so the next remote_get returns image data
+// (from the ETag table or the flash image cache when the server answers 304,
+// otherwise a full download) rather than a bare 304. Call this after the
+// panel has been blanked while the displayed content is unchanged (for
+// example when resuming from quiet hours): a 304 would tell the scheduler to
+// keep showing content that is no longer on screen, leaving the panel blank.
+// Remembered images are kept.
+void remote_reset_cache(void);
+
+// Conditional-GET counters since boot. A hit is a 304 (the image on screen
+// confirmed, or one served from PSRAM or flash); a miss is a full download.
+// entries/body_bytes describe the in-RAM ETag table.
+typedef struct {
+  uint32_t hits;
+  uint32_t misses;
+  uint64_t bytes_saved;
+  uint32_t entries;
+  uint32_t body_bytes;
+} remote_cache_stats_t;
+
+void remote_get_cache_stats(remote_cache_stats_t* out);
+
+// Poll connection reuse since boot. Polls share one HTTP client: a request
+// either reuses the connection the previous poll left open or connects anew
+// (resuming the TLS session when the server accepts the ticket). Averages
+// are per request, connect included.
+typedef struct {
+  uint32_t requests;
+  uint32_t reused;
+  uint32_t connects;
+  uint32_t avg_new_ms;
+  uint32_t avg_reused_ms;
+} remote_conn_stats_t;
+
+void remote_get_conn_stats(remote_conn_stats_t* out);
\ No newline at end of file
@@ -92,9 +92,12 @@ int wifi_disconnect_count = 0;
 // onto the ring and flushed in order once the link is ready. The ring itself
 // is a pure structure (outbox_ring.h, host-tested); it is guarded by its own
 // mutex here (never nested with client_mutex: a flush pops under
-// outbox_mutex, releases it, then sends under client_mutex).
+// outbox_mutex, releases it, then sends under client_mutex). flush_mutex
+// makes flushes take turns, as they share flush_buf.
 outbox_ring_t outbox;
 SemaphoreHandle_t outbox_mutex = nullptr;
+SemaphoreHandle_t flush_mutex = nullptr;
+char flush_buf[OUTBOX_RING_BYTES];
 
 // Timers
 esp_timer_handle_t reconnect_timer = nullptr;
@@ -158,15 +161,18 @@ void schedule_reconnect() {
 // Bounded outbox
 // ---------------------------------------------------------------------------
 
-// Send a text frame on the live client. Returns true only if the whole frame
-// was handed to the socket. Takes client_mutex; must NOT be called while
-// holding outbox_mutex.
-bool ws_send_now(const char* data, size_t len, TickType_t timeout) {
+// Send a text (or binary) frame on the live client. Returns true only if the
+// whole frame was handed to the socket. Takes client_mutex; must NOT be called
+// while holding outbox_mutex.
+bool ws_send_now(const char* data, size_t len, TickType_t timeout,
+                 bool binary = false) {
   raii::MutexGuard lock(client_mutex, timeout);
   if (!lock || !ctx.client) return false;
   if (!esp_websocket_client_is_connected(ctx.client)) return false;
-  int sent = esp_websocket_client_send_text(ctx.client, data,
-                                             static_cast<int>(len), timeout);
+  int sent = binary ? esp_websocket_client_send_bin(
+                          ctx.client, data, static_cast<int>(len), timeout)
+                    : esp_websocket_client_send_text(
+                          ctx.client, data, static_cast<int>(len), timeout);
   return sent >= 0;
 }
 
@@ -181,25 +187,24 @@ bool outbox_is_empty() {
   return !lock || outbox_ring_count(&outbox) == 0;
 }
 
-// Take ownership of `copy` (heap-allocated, `len` bytes) and append it. On a
-// full ring the oldest entry is freed and dropped to make room. Frees `copy`
-// itself if the mutex cannot be taken so no message ever leaks.
-void outbox_enqueue(char* copy, size_t len) {
+// Copy a message onto the ring. A queued message with the same key is
+// replaced in place; a full ring refuses the message and keeps the backlog.
+bool outbox_enqueue(const char* data, size_t len, uint8_t key) {
   raii::MutexGuard lock(outbox_mutex);
-  if (!lock) {
-    free(copy);
-    return;
-  }
-  if (outbox_ring_push(&outbox, copy, len)) {
-    ESP_LOGW(TAG, "Outbox full, dropping oldest queued message");
+  if (!lock) return false;
+  if (!outbox_ring_push(&outbox, data, len, key)) {
+    ESP_LOGW(TAG, "Outbox full, refused a message of %u bytes",
+             (unsigned)len);
+    return false;
   }
+  return true;
 }
 
-// Pop the oldest entry into `out` (caller then owns out->data). Returns false
-// when the ring is empty.
-bool outbox_dequeue(outbox_ring_slot_t* out) {
+// Pop the oldest entry into flush_buf. Returns its length, 0 when the ring is
+// empty. Call with flush_mutex held.
+size_t outbox_dequeue() {
   raii::MutexGuard lock(outbox_mutex);
-  return lock && outbox_ring_pop(&outbox, out);
+  return lock ? outbox_ring_pop(&outbox, flush_buf) : 0;
 }
 
 // Drain queued messages in FIFO order while the socket keeps accepting them.
@@ -209,19 +214,17 @@ bool outbox_dequeue(outbox_ring_slot_t* out) {
 // for the next connection.
 void outbox_flush() {
   if (!ws_is_connected_now()) return;
-  outbox_ring_slot_t slot;
-  while (outbox_dequeue(&slot)) {
-    bool ok = slot.data && ws_send_now(slot.data, slot.len,
-                                        OUTBOX_FLUSH_TIMEOUT);
-    free(slot.data);
-    if (!ok) break;
+  raii::MutexGuard flushing(flush_mutex, OUTBOX_FLUSH_TIMEOUT);
+  if (!flushing) return;
+  while (size_t len = outbox_dequeue()) {
+    if (!ws_send_now(flush_buf, len, OUTBOX_FLUSH_TIMEOUT)) break;
   }
 }
 
-// Free every queued message. Used on deinit.
+// Forget every queued message. Used on deinit.
 void outbox_drain_free() {
-  outbox_ring_slot_t slot;
-  while (outbox_dequeue(&slot)) free(slot.data);
+  raii::MutexGuard lock(outbox_mutex);
+  if (lock) outbox_ring_clear(&outbox);
 }
 
 // ---------------------------------------------------------------------------
@@ -272,6 +275,8 @@ void ws_event_handler(void*, esp_event_base_t, int32_t event_id,
       sock_failure_count = 0;
       wifi_disconnect_count = 0;
       ctx.sent_client_info = false;
+      // A new connection may be to a server that only speaks JSON.
+      msg_set_binary_control(false);
       msg_send_client_info();
       ctx.sent_client_info = true;
       // Drain anything queued while the link was down, in order.
@@ -438,8 +443,13 @@ void sockets_init(const char* url) {
     return;
   }
   outbox_mutex = xSemaphoreCreateMutex();
-  if (!outbox_mutex) {
+  flush_mutex = xSemaphoreCreateMutex();
+  if (!outbox_mutex || !flush_mutex) {
     ESP_LOGE(TAG, "Failed to create outbox mutex");
+    if (outbox_mutex) vSemaphoreDelete(outbox_mutex);
+    if (flush_mutex) vSemaphoreDelete(flush_mutex);
+    outbox_mutex = nullptr;
+    flush_mutex = nullptr;
     vSemaphoreDelete(client_mutex);
     client_mutex = nullptr;
     return;
@@ -512,12 +522,16 @@ void sockets_deinit() {
 
   ctx.state.store(State::Disconnected);
 
-  // Free any messages still queued, then drop the outbox mutex.
+  // Forget any messages still queued, then drop the outbox mutexes.
   outbox_drain_free();
   if (outbox_mutex) {
     vSemaphoreDelete(outbox_mutex);
     outbox_mutex = nullptr;
   }
+  if (flush_mutex) {
+    vSemaphoreDelete(flush_mutex);
+    flush_mutex = nullptr;
+  }
 
   handlers_deinit();
 
@@ -533,7 +547,8 @@ bool sockets_is_connected() {
   return esp_websocket_client_is_connected(ctx.client);
 }
 
-int sockets_send_text(const char* data, size_t len, TickType_t timeout) {
+int sockets_send_text(const char* data, size_t len, TickType_t timeout,
+                      uint8_t key) {
   if (!data || len == 0) return -1;
 
   // Fast path: nothing queued and the link is up, so send inline. This keeps
@@ -546,14 +561,20 @@ int sockets_send_text(const char* data, size_t len, TickType_t timeout) {
 
   // Link down, mutex busy, or messages already queued ahead of this one:
   // copy onto the outbox so it is delivered in order once the link is ready.
-  // The message is accepted (returns len) even though delivery is deferred.
-  char* copy = static_cast<char*>(malloc(len));
-  if (!copy) {
-    ESP_LOGE(TAG, "Failed to alloc %u bytes for outbox", (unsigned)len);
+  // The message is accepted (returns len) even though delivery is deferred;
+  // a full outbox refuses it (returns -1) so the caller can retry later.
+  if (!outbox_enqueue(data, len, key)) return -1;
+  outbox_flush();
+  return static_cast<int>(len);
+}
+
+int sockets_send_binary(const void* data, size_t len, TickType_t timeout) {
+  if (!data || len == 0) return -1;
+  // Binary frames are not queued: the outbox holds text only, and a binary
+  // message must not overtake text already waiting in it.
+  if (!outbox_is_empty()) return -1;
+  if (!ws_send_now(static_cast<const char*>(data), len, timeout, true)) {
     return -1;
   }
-  memcpy(copy, data, len);
-  outbox_enqueue(copy, len);
-  outbox_flush();
   return static_cast<int>(len);
 }
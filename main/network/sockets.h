@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include <freertos/FreeRTOS.h>
 
@@ -15,7 +16,27 @@ void sockets_deinit();
 /// True when the WebSocket connection is established.
 bool sockets_is_connected();
 
+/// Outbox keys for messages where only the latest value matters: a message
+/// still queued for the server is replaced by a newer one with the same key.
+enum : uint8_t {
+  SOCKETS_MSG_ANY = 0,  // never replaced (OUTBOX_KEY_NONE)
+  SOCKETS_MSG_CLIENT_INFO,
+  SOCKETS_MSG_QUEUED,
+  SOCKETS_MSG_DISPLAYING,
+  SOCKETS_MSG_PLAYLIST_MISSING,
+};
+
 /// Send a text frame on the active WebSocket. Mutex-protected against
-/// client teardown. Returns the byte count written (>= 0) on success,
-/// or a negative value on error / when not connected.
-int sockets_send_text(const char* data, size_t len, TickType_t timeout);
+/// client teardown. While the link is down (or earlier messages are still
+/// queued) the message is copied onto the outbox, replacing any queued
+/// message with the same @p key. Returns the byte count accepted (>= 0), or
+/// a negative value when the message could not be sent or queued: a full
+/// outbox refuses new messages instead of dropping queued ones, so retry
+/// once it has drained.
+int sockets_send_text(const char* data, size_t len, TickType_t timeout,
+                      uint8_t key = SOCKETS_MSG_ANY);
+
+/// Send a binary frame on the active WebSocket. Unlike sockets_send_text()
+/// nothing is queued: returns a negative value when the link is down or text
+/// is still waiting in the outbox, so the caller can fall back to text.
+int sockets_send_binary(const void* data, size_t len, TickType_t timeout);
@@ -12,6 +12,7 @@
 #include <freertos/task.h>
 
 #include "app_state.h"
+#include "boot_profile.h"
 #include "embedded_tz_db.h"
 #include "api_validation.h"
 #include "device_temperature.h"
@@ -19,12 +20,17 @@
 #include "diag_event_ring.h"
 #include "event_bus.h"
 #include "heap_monitor.h"
+#include "image_arena.h"
+#include "image_cache.h"
 #include "http_server.h"
 #include "mdns_service.h"
 #include "ntp.h"
 #include "nvs_settings.h"
 #include "ota_http_upload.h"
 #include "quiet_hours.h"
+#include "remote.h"
+#include "scheduler.h"
+#include "syslog.h"
 #include "version.h"
 #include "webp_player.h"
 #include "wifi.h"
@@ -136,6 +142,74 @@ esp_err_t status_handler(httpd_req_t* req) {
   return ESP_OK;
 }
 
+// One render-loop stage of gfx_timing_stats_t. Bucket i counts durations
+// below frame_stats_bucket_us[i]; the last bucket is open-ended.
+cJSON* timing_stage_json(const frame_hist_t& h) {
+  cJSON* obj = cJSON_CreateObject();
+  if (!obj) return nullptr;
+  cJSON_AddNumberToObject(obj, "count", h.count);
+  cJSON_AddNumberToObject(obj, "avg_us", frame_hist_avg_us(&h));
+  cJSON_AddNumberToObject(obj, "p50_us", frame_hist_percentile(&h, 50));
+  cJSON_AddNumberToObject(obj, "p90_us", frame_hist_percentile(&h, 90));
+  cJSON_AddNumberToObject(obj, "p99_us", frame_hist_percentile(&h, 99));
+  cJSON_AddNumberToObject(obj, "max_us", h.max_us);
+  cJSON* buckets = cJSON_CreateArray();
+  if (buckets) {
+    for (int i = 0; i < FRAME_STATS_BUCKETS; i++) {
+      cJSON_AddItemToArray(buckets, cJSON_CreateNumber(h.buckets[i]));
+    }
+    cJSON_AddItemToObject(obj, "buckets", buckets);
+  }
+  return obj;
+}
+
+// One boot of boot_profile: stage spans in microseconds since boot (end_us is
+// null while a stage runs; stages not reached are left out) and the chain of
+// stages that set the first-image time.
+cJSON* boot_timeline_json(const boot_timeline_t& t) {
+  cJSON* obj = cJSON_CreateObject();
+  if (!obj) return nullptr;
+  cJSON_AddNumberToObject(obj, "boot_count", t.boot_count);
+  const boot_span_t& first = t.spans[BOOT_STAGE_FIRST_IMAGE];
+  if (first.end_us != 0) {
+    cJSON_AddNumberToObject(obj, "first_image_ms", first.end_us / 1000);
+  } else {
+    cJSON_AddNullToObject(obj, "first_image_ms");
+  }
+
+  cJSON* stages = cJSON_CreateObject();
+  if (stages) {
+    for (int i = 0; i < BOOT_STAGE_COUNT; i++) {
+      const auto stage = static_cast<boot_stage_t>(i);
+      const boot_span_t& s = t.spans[i];
+      if (s.start_us == 0) continue;
+      cJSON* span = cJSON_CreateObject();
+      if (!span) continue;
+      cJSON_AddNumberToObject(span, "start_us", s.start_us);
+      if (s.end_us != 0) {
+        cJSON_AddNumberToObject(span, "end_us", s.end_us);
+      } else {
+        cJSON_AddNullToObject(span, "end_us");
+      }
+      cJSON_AddItemToObject(stages, boot_timeline_stage_name(stage), span);
+    }
+    cJSON_AddItemToObject(obj, "stages", stages);
+  }
+
+  boot_stage_t path[BOOT_STAGE_COUNT];
+  const int n = boot_timeline_critical_path(&t, BOOT_STAGE_FIRST_IMAGE, path,
+                                            BOOT_STAGE_COUNT);
+  cJSON* path_arr = cJSON_CreateArray();
+  if (path_arr) {
+    for (int i = 0; i < n; i++) {
+      cJSON_AddItemToArray(
+          path_arr, cJSON_CreateString(boot_timeline_stage_name(path[i])));
+    }
+    cJSON_AddItemToObject(obj, "critical_path", path_arr);
+  }
+  return obj;
+}
+
 esp_err_t diag_handler(httpd_req_t* req) {
   cJSON* root = cJSON_CreateObject();
   if (!root) {
@@ -155,6 +229,18 @@ esp_err_t diag_handler(httpd_req_t* req) {
     cJSON_AddNullToObject(root, "temperature_c");
   }
 
+  boot_timeline_t boot_now;
+  boot_timeline_t boot_prev;
+  const bool have_prev = boot_profile_get(&boot_now, &boot_prev);
+  cJSON* boot_obj = boot_timeline_json(boot_now);
+  if (boot_obj) {
+    if (have_prev) {
+      cJSON* prev_obj = boot_timeline_json(boot_prev);
+      if (prev_obj) cJSON_AddItemToObject(boot_obj, "previous", prev_obj);
+    }
+    cJSON_AddItemToObject(root, "boot", boot_obj);
+  }
+
   wifi_diag_stats_t wifi_stats = {};
   wifi_get_diag_stats(&wifi_stats);
   cJSON* wifi_obj = cJSON_CreateObject();
@@ -168,9 +254,205 @@ esp_err_t diag_handler(httpd_req_t* req) {
                             wifi_stats.disconnect_events);
     cJSON_AddNumberToObject(wifi_obj, "health_disconnect_checks",
                             wifi_stats.health_disconnect_checks);
+    cJSON* connect_obj = cJSON_CreateObject();
+    if (connect_obj) {
+      cJSON_AddBoolToObject(connect_obj, "fast", wifi_stats.last_connect_fast);
+      cJSON_AddNumberToObject(connect_obj, "total_ms",
+                              wifi_stats.last_connect_ms);
+      cJSON_AddNumberToObject(connect_obj, "scan_ms", wifi_stats.last_scan_ms);
+      cJSON_AddNumberToObject(connect_obj, "assoc_ms",
+                              wifi_stats.last_assoc_ms);
+      cJSON_AddNumberToObject(connect_obj, "dhcp_ms", wifi_stats.last_dhcp_ms);
+      cJSON_AddNumberToObject(connect_obj, "fast_connects",
+                              wifi_stats.fast_connects);
+      cJSON_AddNumberToObject(connect_obj, "fast_fallbacks",
+                              wifi_stats.fast_fallbacks);
+      cJSON_AddItemToObject(wifi_obj, "connect", connect_obj);
+    }
     cJSON_AddItemToObject(root, "wifi", wifi_obj);
   }
 
+  gfx_frame_cache_stats_t cache_stats = {};
+  gfx_get_frame_cache_stats(&cache_stats);
+  cJSON* player_obj = cJSON_CreateObject();
+  if (player_obj) {
+    cJSON* cache_obj = cJSON_CreateObject();
+    if (cache_obj) {
+      cJSON_AddNumberToObject(cache_obj, "hits", cache_stats.hits);
+      cJSON_AddNumberToObject(cache_obj, "misses", cache_stats.misses);
+      cJSON_AddNumberToObject(cache_obj, "active_bytes",
+                              cache_stats.active_bytes);
+      cJSON_AddBoolToObject(cache_obj, "active_complete",
+                            cache_stats.active_complete);
+      cJSON_AddItemToObject(player_obj, "frame_cache", cache_obj);
+    }
+    gfx_pipeline_stats_t pipe_stats = {};
+    gfx_get_pipeline_stats(&pipe_stats);
+    cJSON* pipe_obj = cJSON_CreateObject();
+    if (pipe_obj) {
+      cJSON_AddBoolToObject(pipe_obj, "enabled", pipe_stats.enabled);
+      cJSON_AddNumberToObject(pipe_obj, "frames_decoded",
+                              pipe_stats.frames_decoded);
+      cJSON_AddNumberToObject(pipe_obj, "frames_rendered",
+                              pipe_stats.frames_rendered);
+      cJSON_AddNumberToObject(pipe_obj, "decode_avg_us",
+                              pipe_stats.decode_avg_us);
+      cJSON_AddNumberToObject(pipe_obj, "decode_max_us",
+                              pipe_stats.decode_max_us);
+      cJSON_AddNumberToObject(pipe_obj, "render_avg_us",
+                              pipe_stats.render_avg_us);
+      cJSON_AddNumberToObject(pipe_obj, "render_max_us",
+                              pipe_stats.render_max_us);
+      cJSON_AddNumberToObject(pipe_obj, "render_starved",
+                              pipe_stats.render_starved);
+      cJSON_AddNumberToObject(pipe_obj, "decode_blocked",
+                              pipe_stats.decode_blocked);
+      cJSON_AddItemToObject(player_obj, "pipeline", pipe_obj);
+    }
+    gfx_timing_stats_t timing = {};
+    gfx_get_timing_stats(&timing);
+    cJSON* timing_obj = cJSON_CreateObject();
+    if (timing_obj) {
+      if (timing.source_type == GFX_SOURCE_EMBEDDED && timing.embedded_name) {
+        cJSON_AddStringToObject(timing_obj, "embedded", timing.embedded_name);
+      } else {
+        cJSON_AddNumberToObject(timing_obj, "counter", timing.counter);
+      }
+      const frame_stats_t& s = timing.stats;
+      cJSON_AddNumberToObject(timing_obj, "frames", s.frames);
+      cJSON_AddNumberToObject(timing_obj, "late", s.late);
+      cJSON_AddNumberToObject(timing_obj, "skipped", s.skipped);
+      cJSON_AddNumberToObject(timing_obj, "achieved_fps",
+                              frame_stats_achieved_fps_x100(&s) / 100.0);
+      cJSON_AddNumberToObject(timing_obj, "authored_fps",
+                              frame_stats_authored_fps_x100(&s) / 100.0);
+      cJSON* bounds = cJSON_CreateArray();
+      if (bounds) {
+        for (int i = 0; i < FRAME_STATS_BUCKETS - 1; i++) {
+          cJSON_AddItemToArray(bounds,
+                               cJSON_CreateNumber(frame_stats_bucket_us[i]));
+        }
+        cJSON_AddItemToObject(timing_obj, "bucket_us", bounds);
+      }
+      cJSON_AddItemToObject(timing_obj, "decode", timing_stage_json(s.decode));
+      cJSON_AddItemToObject(timing_obj, "diff", timing_stage_json(s.diff));
+      cJSON_AddItemToObject(timing_obj, "draw", timing_stage_json(s.draw));
+      cJSON_AddItemToObject(timing_obj, "flip", timing_stage_json(s.flip));
+      cJSON_AddItemToObject(player_obj, "timing", timing_obj);
+    }
+    cJSON_AddItemToObject(root, "player", player_obj);
+  }
+
+  image_arena_stats_t arena = {};
+  image_arena_get_stats(&arena);
+  cJSON* arena_obj = cJSON_CreateObject();
+  if (arena_obj) {
+    cJSON_AddNumberToObject(arena_obj, "slabs", arena.slabs);
+    cJSON_AddNumberToObject(arena_obj, "in_use", arena.in_use);
+    cJSON_AddNumberToObject(arena_obj, "peak_in_use", arena.peak_in_use);
+    cJSON_AddNumberToObject(arena_obj, "slab_allocs", arena.slab_allocs);
+    cJSON_AddNumberToObject(arena_obj, "heap_allocs", arena.heap_allocs);
+    cJSON_AddNumberToObject(arena_obj, "reserved_bytes", arena.reserved_bytes);
+    cJSON_AddItemToObject(root, "image_arena", arena_obj);
+  }
+
+  scheduler_playlist_stats_t playlist = {};
+  scheduler_playlist_get_stats(&playlist);
+  cJSON* playlist_obj = cJSON_CreateObject();
+  if (playlist_obj) {
+    cJSON_AddNumberToObject(playlist_obj, "entries", playlist.entries);
+    cJSON_AddNumberToObject(playlist_obj, "ready", playlist.ready);
+    cJSON_AddNumberToObject(playlist_obj, "bytes", playlist.bytes);
+    cJSON_AddNumberToObject(playlist_obj, "rotations", playlist.rotations);
+    cJSON_AddItemToObject(root, "playlist", playlist_obj);
+  }
+
+  event_bus_stats_t bus = {};
+  event_bus_get_stats(&bus);
+  cJSON* bus_obj = cJSON_CreateObject();
+  if (bus_obj) {
+    cJSON_AddNumberToObject(bus_obj, "subscribers", bus.subscribers);
+    cJSON_AddNumberToObject(bus_obj, "emitted", bus.emitted);
+    cJSON_AddNumberToObject(bus_obj, "dispatched", bus.dispatched);
+    cJSON_AddNumberToObject(bus_obj, "dropped", bus.dropped);
+    cJSON* drops = cJSON_CreateObject();
+    if (drops) {
+      for (uint16_t type = 100; type < 300; type++) {
+        const uint32_t n = event_bus_dropped(type);
+        if (n == 0) continue;
+        char key[8];
+        snprintf(key, sizeof(key), "%u", static_cast<unsigned>(type));
+        cJSON_AddNumberToObject(drops, key, n);
+      }
+      cJSON_AddItemToObject(bus_obj, "drops_by_type", drops);
+    }
+    cJSON_AddItemToObject(root, "event_bus", bus_obj);
+  }
+
+  syslog_stats_t sl = {};
+  syslog_get_stats(&sl);
+  cJSON* syslog_obj = cJSON_CreateObject();
+  if (syslog_obj) {
+    cJSON_AddBoolToObject(syslog_obj, "enabled", sl.enabled);
+    cJSON_AddNumberToObject(syslog_obj, "sent", sl.sent);
+    cJSON_AddNumberToObject(syslog_obj, "datagrams", sl.datagrams);
+    cJSON_AddNumberToObject(syslog_obj, "dropped", sl.dropped);
+    cJSON_AddItemToObject(root, "syslog", syslog_obj);
+  }
+
+  config_persist_stats_t cfg_stats = {};
+  config_get_persist_stats(&cfg_stats);
+  cJSON* cfg_obj = cJSON_CreateObject();
+  if (cfg_obj) {
+    cJSON_AddNumberToObject(cfg_obj, "saves", cfg_stats.saves);
+    cJSON_AddNumberToObject(cfg_obj, "writes", cfg_stats.writes);
+    cJSON_AddNumberToObject(cfg_obj, "unchanged", cfg_stats.unchanged);
+    cJSON_AddNumberToObject(cfg_obj, "bytes_written", cfg_stats.bytes_written);
+    cJSON_AddNumberToObject(cfg_obj, "record_bytes", cfg_stats.record_bytes);
+    cJSON_AddItemToObject(root, "config_store", cfg_obj);
+  }
+
+  image_cache_stats_t img_stats = {};
+  image_cache_get_stats(&img_stats);
+  cJSON* img_obj = cJSON_CreateObject();
+  if (img_obj) {
+    cJSON_AddBoolToObject(img_obj, "enabled", img_stats.enabled);
+    cJSON_AddNumberToObject(img_obj, "hits", img_stats.hits);
+    cJSON_AddNumberToObject(img_obj, "misses", img_stats.misses);
+    cJSON_AddNumberToObject(img_obj, "stores", img_stats.stores);
+    cJSON_AddNumberToObject(img_obj, "evictions", img_stats.evictions);
+    cJSON_AddNumberToObject(img_obj, "entries", img_stats.entries);
+    cJSON_AddNumberToObject(img_obj, "bytes", img_stats.bytes);
+    cJSON_AddNumberToObject(img_obj, "budget_bytes", img_stats.budget_bytes);
+    cJSON_AddItemToObject(root, "image_cache", img_obj);
+  }
+
+  remote_cache_stats_t http_stats = {};
+  remote_get_cache_stats(&http_stats);
+  cJSON* http_obj = cJSON_CreateObject();
+  if (http_obj) {
+    cJSON_AddNumberToObject(http_obj, "hits", http_stats.hits);
+    cJSON_AddNumberToObject(http_obj, "misses", http_stats.misses);
+    cJSON_AddNumberToObject(http_obj, "bytes_saved",
+                            static_cast<double>(http_stats.bytes_saved));
+    cJSON_AddNumberToObject(http_obj, "entries", http_stats.entries);
+    cJSON_AddNumberToObject(http_obj, "body_bytes", http_stats.body_bytes);
+    cJSON_AddItemToObject(root, "http_cache", http_obj);
+  }
+
+  remote_conn_stats_t conn_stats = {};
+  remote_get_conn_stats(&conn_stats);
+  cJSON* conn_obj = cJSON_CreateObject();
+  if (conn_obj) {
+    cJSON_AddNumberToObject(conn_obj, "requests", conn_stats.requests);
+    cJSON_AddNumberToObject(conn_obj, "reused", conn_stats.reused);
+    cJSON_AddNumberToObject(conn_obj, "connects", conn_stats.connects);
+    cJSON_AddNumberToObject(conn_obj, "avg_new_ms", conn_stats.avg_new_ms);
+    cJSON_AddNumberToObject(conn_obj, "avg_reused_ms",
+                            conn_stats.avg_reused_ms);
+    cJSON_AddItemToObject(root, "http_connection", conn_obj);
+  }
+
   // Heap-allocate large arrays to avoid stack overflow in httpd task
   constexpr size_t kTrendMax = 12;
   constexpr size_t kEventsMax = 16;
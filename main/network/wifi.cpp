@@ -28,6 +28,7 @@
 
 #include "ap.h"
 #include "app_state.h"
+#include "boot_profile.h"
 #include "diag_event_ring.h"
 #include "event_bus.h"
 #include "nvs_settings.h"
@@ -58,10 +59,39 @@ esp_timer_handle_t s_health_timer = nullptr;
 constexpr int64_t HEALTH_CHECK_INTERVAL_US = 30000 * 1000;  // 30 seconds
 void health_timer_callback(void*) { wifi_health_check(); }
 
+// --- Connect timing ---------------------------------------------------------
+// A cycle starts at boot or when an established link drops and ends at the
+// first IP; an attempt is one esp_wifi_connect() within it.
+int64_t s_cycle_start_us = 0;
+int64_t s_attempt_start_us = 0;
+int64_t s_assoc_done_us = 0;
+bool s_had_connection = false;  // got an IP since the last disconnect
+uint32_t s_last_scan_ms = 0;
+uint32_t s_last_assoc_ms = 0;
+uint32_t s_last_dhcp_ms = 0;
+uint32_t s_last_connect_ms = 0;
+bool s_last_connect_fast = false;
+
+// The current attempt targets the persisted last-good AP (BSSID + channel)
+// instead of scanning every channel.
+bool s_fast_attempt = false;
+uint32_t s_fast_connects = 0;
+uint32_t s_fast_fallbacks = 0;
+
+uint32_t ms_since(int64_t start_us) {
+  return static_cast<uint32_t>((esp_timer_get_time() - start_us) / 1000);
+}
+
+void start_attempt() {
+  s_attempt_start_us = esp_timer_get_time();
+  boot_profile_begin(BOOT_STAGE_WIFI_CONNECT);  // first attempt only
+  esp_wifi_connect();
+}
+
 esp_timer_handle_t s_reconnect_timer = nullptr;
 constexpr uint32_t RECONNECT_BASE_MS = 1000;
 constexpr uint32_t RECONNECT_MAX_MS = 60000;
-void reconnect_timer_cb(void*) { esp_wifi_connect(); }
+void reconnect_timer_cb(void*) { start_attempt(); }
 
 // --- Multi-network state ---------------------------------------------------
 // Only engaged when 2+ networks are stored. With 0 or 1 stored networks the
@@ -94,53 +124,90 @@ void schedule_reconnect(int attempt) {
     esp_timer_stop(s_reconnect_timer);  // cancel any pending attempt
     esp_timer_start_once(s_reconnect_timer, delay_us);
   } else {
-    esp_wifi_connect();
+    start_attempt();
   }
 }
 
-// Apply candidate `idx`'s credentials and start connecting. Resets the per-net
-// attempt counter. WIFI_CONNECT_AP_BY_SIGNAL picks the strongest BSSID when an
-// SSID is served by multiple access points (mesh/roaming).
-void connect_to_candidate(int idx) {
-  if (idx < 0 || idx >= s_candidate_count) return;
-  s_candidate_idx = idx;
-  s_per_net_attempts = 0;
-
+// Set the station config for candidate `idx`. With `fast` and a last-good AP
+// on that network, target its BSSID on its channel (authmode as the floor)
+// so the driver skips the all-channel scan; otherwise scan every channel and
+// let WIFI_CONNECT_AP_BY_SIGNAL pick the strongest BSSID when an SSID is
+// served by multiple access points (mesh/roaming). Returns whether the
+// config targets the cached AP.
+bool apply_sta_config(int idx, bool fast) {
   wifi_config_t sta = {};
   memcpy(sta.sta.ssid, s_candidates[idx].ssid, sizeof(sta.sta.ssid));
   memcpy(sta.sta.password, s_candidates[idx].password,
          sizeof(sta.sta.password));
   sta.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
   sta.sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
+
+  wifi_last_ap_t ap;
+  const bool targeted =
+      fast && wifi_last_ap_get(&ap) &&
+      strncmp(ap.ssid, s_candidates[idx].ssid, MAX_SSID_LEN) == 0;
+  if (targeted) {
+    sta.sta.scan_method = WIFI_FAST_SCAN;
+    sta.sta.channel = ap.channel;
+    sta.sta.bssid_set = true;
+    memcpy(sta.sta.bssid, ap.bssid, sizeof(sta.sta.bssid));
+    sta.sta.threshold.authmode = static_cast<wifi_auth_mode_t>(ap.authmode);
+  }
   esp_err_t err = esp_wifi_set_config(WIFI_IF_STA, &sta);
   if (err != ESP_OK) {
     ESP_LOGE(TAG, "set_config failed for '%s': %s", s_candidates[idx].ssid,
              esp_err_to_name(err));
   }
-  ESP_LOGI(TAG, "Connecting to candidate %d/%d: %s", idx + 1, s_candidate_count,
-           s_candidates[idx].ssid);
-  esp_wifi_connect();
+  s_fast_attempt = targeted && err == ESP_OK;
+  return s_fast_attempt;
+}
+
+// Apply candidate `idx`'s credentials and start connecting. Resets the per-net
+// attempt counter.
+void connect_to_candidate(int idx, bool fast = false) {
+  if (idx < 0 || idx >= s_candidate_count) return;
+  s_candidate_idx = idx;
+  s_per_net_attempts = 0;
+
+  const bool targeted = apply_sta_config(idx, fast);
+  ESP_LOGI(TAG, "Connecting to candidate %d/%d: %s%s", idx + 1,
+           s_candidate_count, s_candidates[idx].ssid,
+           targeted ? " (cached AP)" : "");
+  start_attempt();
 }
 
 // Build the ranked candidate list for this connection cycle. Every stored
-// network is a candidate; with 2+ stored we run an active scan and rank by live
+// network is a candidate. When `preferred` names a stored network (the one
+// with a cached AP) it goes first and the rest keep their stored RSSI order:
+// no scan. Otherwise, with 2+ stored we run an active scan and rank by live
 // RSSI (descending), breaking ties by user priority (ascending). Networks not
 // seen in the scan sort last but are still attempted. Returns the count.
-int build_candidates() {
+int build_candidates(const char* preferred) {
   wifi_network_t stored[MAX_WIFI_NETS];
   size_t stored_n = wifi_network_list_get(stored, MAX_WIFI_NETS);
   s_candidate_count = 0;
   s_candidate_idx = 0;
+  s_last_scan_ms = 0;
   if (stored_n == 0) return 0;
 
-  for (size_t i = 0; i < stored_n; i++) s_candidates[i] = stored[i];
+  bool have_preferred = false;
+  for (size_t i = 0; i < stored_n; i++) {
+    s_candidates[i] = stored[i];
+    if (preferred &&
+        strncmp(stored[i].ssid, preferred, MAX_SSID_LEN) == 0) {
+      have_preferred = true;
+    }
+  }
   s_candidate_count = (int)stored_n;
 
   if (stored_n < 2) return s_candidate_count;  // single network: no scan
 
+  const int64_t scan_start_us = esp_timer_get_time();
   wifi_scan_config_t scan_cfg = {};
   scan_cfg.show_hidden = true;
-  if (esp_wifi_scan_start(&scan_cfg, true) == ESP_OK) {
+  if (have_preferred) {
+    // Ranked by the RSSI stored at their last connects.
+  } else if (esp_wifi_scan_start(&scan_cfg, true) == ESP_OK) {
     uint16_t ap_num = 0;
     esp_wifi_scan_get_ap_num(&ap_num);
     if (ap_num > 40) ap_num = 40;  // cap the transient allocation
@@ -170,6 +237,7 @@ int build_candidates() {
   } else {
     ESP_LOGW(TAG, "Scan failed; ranking by stored RSSI");
   }
+  if (!have_preferred) s_last_scan_ms = ms_since(scan_start_us);
 
   // Insertion-friendly selection sort: RSSI desc, then priority asc.
   for (int a = 0; a < s_candidate_count; a++) {
@@ -184,12 +252,24 @@ int build_candidates() {
       }
     }
   }
+  if (have_preferred) {
+    for (int c = 1; c < s_candidate_count; c++) {
+      if (strncmp(s_candidates[c].ssid, preferred, MAX_SSID_LEN) != 0) {
+        continue;
+      }
+      wifi_network_t t = s_candidates[c];
+      for (int d = c; d > 0; d--) s_candidates[d] = s_candidates[d - 1];
+      s_candidates[0] = t;
+      break;
+    }
+  }
   ESP_LOGI(TAG, "Ranked %d candidate network(s); best: %s (%d dBm)",
            s_candidate_count, s_candidates[0].ssid, s_candidates[0].last_rssi);
   return s_candidate_count;
 }
 
 void handle_successful_ip_acquisition() {
+  boot_profile_end(BOOT_STAGE_WIFI_CONNECT);
   s_reconnect_attempts = 0;
   s_per_net_attempts = 0;
   if (s_reconnect_timer) esp_timer_stop(s_reconnect_timer);
@@ -200,11 +280,36 @@ void handle_successful_ip_acquisition() {
   // Record the signal strength of the AP we landed on so the next boot can rank
   // this network by a real measurement rather than a stale/unknown value.
   wifi_ap_record_t ap_info;
-  if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
+  const bool have_ap = esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK;
+  if (have_ap) {
     wifi_network_note_rssi(reinterpret_cast<const char*>(ap_info.ssid),
                            ap_info.rssi);
   }
 
+  // IPv4 and a global IPv6 address both land here; time the first.
+  if (!s_had_connection) {
+    s_had_connection = true;
+    s_last_connect_ms = ms_since(s_cycle_start_us);
+    s_last_dhcp_ms = ms_since(s_assoc_done_us);
+    s_last_connect_fast = s_fast_attempt;
+    if (s_fast_attempt) s_fast_connects++;
+    s_fast_attempt = false;
+    ESP_LOGI(TAG, "Connected in %lu ms (scan %lu, assoc %lu, ip %lu)%s",
+             (unsigned long)s_last_connect_ms, (unsigned long)s_last_scan_ms,
+             (unsigned long)s_last_assoc_ms, (unsigned long)s_last_dhcp_ms,
+             s_last_connect_fast ? " via cached AP" : "");
+
+    if (have_ap) {
+      wifi_last_ap_t last = {};
+      snprintf(last.ssid, sizeof(last.ssid), "%s",
+               reinterpret_cast<const char*>(ap_info.ssid));
+      memcpy(last.bssid, ap_info.bssid, sizeof(last.bssid));
+      last.channel = ap_info.primary;
+      last.authmode = static_cast<uint8_t>(ap_info.authmode);
+      wifi_last_ap_note(&last);
+    }
+  }
+
   event_bus_emit_simple(TRONBYT_EVENT_WIFI_CONNECTED);
   app_state_set_connectivity(CONNECTIVITY_CONNECTED);
 }
@@ -221,16 +326,26 @@ void wifi_event_handler(void* arg, esp_event_base_t event_base,
         // and the reconnect/health timers. So no esp_wifi_connect() here.
         break;
       case WIFI_EVENT_STA_CONNECTED:
+        s_assoc_done_us = esp_timer_get_time();
+        s_last_assoc_ms = ms_since(s_attempt_start_us);
         // Only create an IPv6 link-local when the user has opted in.
         // Sending an RS triggers an RA containing RDNSS IPv6 addresses;
         // ESP-IDF stores those in dns[0], overwriting the DHCP IPv4 DNS
         // and causing getaddrinfo() to fail at boot.
-        if (config_get().prefer_ipv6) {
+        if (ConfigSnapshot()->prefer_ipv6) {
           ESP_LOGI(TAG, "Connected to AP, creating IPv6 link local address");
           esp_netif_create_ip6_linklocal(s_sta_netif);
         }
         break;
       case WIFI_EVENT_STA_DISCONNECTED: {
+        // An established link dropping starts a new connect cycle; a failed
+        // attempt continues the current one.
+        const bool link_lost = s_had_connection;
+        s_had_connection = false;
+        if (link_lost) {
+          s_cycle_start_us = esp_timer_get_time();
+          s_last_scan_ms = 0;  // reconnects do not rerun the ranking scan
+        }
         s_reconnect_attempts++;
         s_disconnect_events++;
         xEventGroupClearBits(s_wifi_event_group,
@@ -254,8 +369,23 @@ void wifi_event_handler(void* arg, esp_event_base_t event_base,
                          "Repeated disconnects in 60s window");
         }
 
-        if (s_connection_given_up) {
+        if (s_fast_attempt && !s_connection_given_up) {
+          // The cached AP is gone or moved: scan every channel for the same
+          // network right away. Not counted against the network.
+          s_fast_attempt = false;
+          s_fast_fallbacks++;
+          ESP_LOGI(TAG, "Cached AP for '%s' not reachable, scanning",
+                   s_candidates[s_candidate_idx].ssid);
+          apply_sta_config(s_candidate_idx, false);
+          start_attempt();
+        } else if (s_connection_given_up) {
           // Already gave up this cycle; wait for the portal or a reboot.
+        } else if (link_lost && s_candidate_count > 0 &&
+                   apply_sta_config(s_candidate_idx, true)) {
+          // After an AP blip the AP is most likely where it was.
+          ESP_LOGI(TAG, "Link to '%s' lost, retrying cached AP",
+                   s_candidates[s_candidate_idx].ssid);
+          schedule_reconnect(1);
         } else if (s_candidate_count > 1) {
           // Multi-network: retry the current candidate a few times, then fail
           // over to the next ranked network.
@@ -270,7 +400,7 @@ void wifi_event_handler(void* arg, esp_event_base_t event_base,
                      s_candidates[s_candidate_idx].ssid,
                      s_candidates[s_candidate_idx + 1].ssid);
             connect_to_candidate(s_candidate_idx + 1);
-          } else if (config_get().ap_mode) {
+          } else if (ConfigSnapshot()->ap_mode) {
             ESP_LOGW(TAG, "All %d networks exhausted, raising portal",
                      s_candidate_count);
             s_connection_given_up = true;
@@ -282,7 +412,7 @@ void wifi_event_handler(void* arg, esp_event_base_t event_base,
                      s_candidate_count);
             connect_to_candidate(0);
           }
-        } else if (config_get().ap_mode &&
+        } else if (ConfigSnapshot()->ap_mode &&
                    s_reconnect_attempts >= MAX_RECONNECT_ATTEMPTS) {
           ESP_LOGW(TAG, "Maximum reconnection attempts (%d) reached, giving up",
                    MAX_RECONNECT_ATTEMPTS);
@@ -342,7 +472,7 @@ void wifi_event_handler(void* arg, esp_event_base_t event_base,
 int wifi_initialize(const char* ssid, const char* password) {
   ESP_LOGI(TAG, "Initializing WiFi");
 
-  if (!config_get().ap_mode) {
+  if (!ConfigSnapshot()->ap_mode) {
     ESP_LOGI(TAG, "AP mode disabled via settings");
   }
 
@@ -404,10 +534,14 @@ int wifi_initialize(const char* ssid, const char* password) {
 #endif
 
   if (has_credentials) {
-    // Rank stored networks (active scan when 2+ are stored) and connect to the
-    // strongest visible candidate. Failover is handled on disconnect.
-    if (build_candidates() > 0) {
-      connect_to_candidate(0);
+    // Go straight to the last-good AP when there is one; otherwise rank stored
+    // networks (active scan when 2+ are stored) and connect to the strongest
+    // visible candidate. Failover is handled on disconnect.
+    s_cycle_start_us = esp_timer_get_time();
+    wifi_last_ap_t last_ap;
+    const bool have_last_ap = wifi_last_ap_get(&last_ap);
+    if (build_candidates(have_last_ap ? last_ap.ssid : nullptr) > 0) {
+      connect_to_candidate(0, have_last_ap);
     } else {
       ESP_LOGW(TAG, "Stored networks present but none selectable");
     }
@@ -621,6 +755,7 @@ void wifi_health_check(void) {
 
   if (wifi_network_list_count() > 0) {
     ESP_LOGI(TAG, "Reconnecting in Health check...");
+    s_attempt_start_us = esp_timer_get_time();
     esp_err_t err = esp_wifi_connect();
     if (err != ESP_OK) {
       ESP_LOGW(TAG, "WiFi reconnect attempt failed: %s",
@@ -638,10 +773,17 @@ void wifi_get_diag_stats(wifi_diag_stats_t* out) {
   out->reconnect_attempts = s_reconnect_attempts;
   out->disconnect_events = s_disconnect_events;
   out->health_disconnect_checks = s_health_disconnect_checks;
+  out->last_connect_ms = s_last_connect_ms;
+  out->last_scan_ms = s_last_scan_ms;
+  out->last_assoc_ms = s_last_assoc_ms;
+  out->last_dhcp_ms = s_last_dhcp_ms;
+  out->last_connect_fast = s_last_connect_fast;
+  out->fast_connects = s_fast_connects;
+  out->fast_fallbacks = s_fast_fallbacks;
 }
 
 void wifi_apply_power_save(void) {
-  wifi_ps_type_t power_save_mode = config_get().wifi_power_save;
+  wifi_ps_type_t power_save_mode = ConfigSnapshot()->wifi_power_save;
   ESP_LOGI(TAG, "Setting WiFi Power Save Mode to %d...", power_save_mode);
   esp_wifi_set_ps(power_save_mode);
 }
@@ -97,6 +97,14 @@ typedef struct {
   int reconnect_attempts;
   uint32_t disconnect_events;
   uint32_t health_disconnect_checks;
+  // Phases of the last connect cycle (boot or link loss to first IP).
+  uint32_t last_connect_ms;
+  uint32_t last_scan_ms;   // 0 when the ranking scan was skipped
+  uint32_t last_assoc_ms;  // successful attempt start to associated
+  uint32_t last_dhcp_ms;   // associated to IP
+  bool last_connect_fast;  // went straight to the cached BSSID/channel
+  uint32_t fast_connects;
+  uint32_t fast_fallbacks;  // cached AP missed; fell back to a full scan
 } wifi_diag_stats_t;
 
 void wifi_get_diag_stats(wifi_diag_stats_t* out);
@@ -0,0 +1,98 @@
+#include "ws_control.h"
+
+#include <string.h>
+
+namespace {
+
+// Copy a string record into a key buffer; false when it is empty, too long
+// or holds a NUL.
+bool read_key(const uint8_t* v, size_t vlen, char* out, size_t out_len) {
+  if (vlen == 0 || vlen >= out_len || memchr(v, '\0', vlen)) return false;
+  memcpy(out, v, vlen);
+  out[vlen] = '\0';
+  return true;
+}
+
+constexpr uint8_t MAGIC[4] = {'T', 'B', 'Y', 'T'};
+constexpr size_t COUNTER_MESSAGE_LEN = WS_CONTROL_MIN_HEADER + 2 + 4;
+
+uint16_t read_u16(const uint8_t* p) {
+  return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+}  // namespace
+
+ws_control_result_t ws_control_parse(const uint8_t* data, size_t len,
+                                     ws_control_t* out) {
+  if (!data || len < sizeof(MAGIC) || memcmp(data, MAGIC, sizeof(MAGIC))) {
+    return WS_CONTROL_NONE;
+  }
+  if (len < WS_CONTROL_MIN_HEADER) return WS_CONTROL_SHORT;
+  if (data[4] != WS_CONTROL_VERSION) return WS_CONTROL_INVALID;
+  const size_t header_len = data[5];
+  if (header_len < WS_CONTROL_MIN_HEADER) return WS_CONTROL_INVALID;
+  if (len < header_len) return WS_CONTROL_SHORT;
+
+  ws_control_t ctl;
+  memset(&ctl, 0, sizeof(ctl));
+  ctl.header_len = static_cast<uint16_t>(header_len);
+
+  size_t pos = WS_CONTROL_MIN_HEADER;
+  while (pos < header_len) {
+    if (header_len - pos < 2) return WS_CONTROL_INVALID;
+    const uint8_t type = data[pos];
+    const size_t vlen = data[pos + 1];
+    const uint8_t* v = data + pos + 2;
+    if (header_len - pos - 2 < vlen) return WS_CONTROL_INVALID;
+
+    switch (type) {
+      case WS_CONTROL_DWELL_SECS: {
+        if (vlen != 2) return WS_CONTROL_INVALID;
+        const uint16_t dwell = read_u16(v);
+        if (dwell < 1 || dwell > 3600) return WS_CONTROL_INVALID;
+        ctl.has_dwell = true;
+        ctl.dwell_secs = dwell;
+        break;
+      }
+      case WS_CONTROL_BRIGHTNESS:
+        if (vlen != 1) return WS_CONTROL_INVALID;
+        ctl.has_brightness = true;
+        ctl.brightness = v[0];
+        break;
+      case WS_CONTROL_FLAGS:
+        if (vlen != 1) return WS_CONTROL_INVALID;
+        ctl.immediate = (v[0] & WS_CONTROL_FLAG_IMMEDIATE) != 0;
+        break;
+      case WS_CONTROL_PLAY_CACHED:
+        if (!read_key(v, vlen, ctl.play_cached, sizeof(ctl.play_cached))) {
+          return WS_CONTROL_INVALID;
+        }
+        break;
+      case WS_CONTROL_PLAYLIST_ID:
+        if (!read_key(v, vlen, ctl.playlist_id, sizeof(ctl.playlist_id))) {
+          return WS_CONTROL_INVALID;
+        }
+        break;
+      default:
+        break;
+    }
+    pos += 2 + vlen;
+  }
+
+  *out = ctl;
+  return WS_CONTROL_OK;
+}
+
+size_t ws_control_encode_counter(uint8_t type, uint32_t counter, uint8_t* out,
+                                 size_t out_len) {
+  if (!out || out_len < COUNTER_MESSAGE_LEN) return 0;
+  memcpy(out, MAGIC, sizeof(MAGIC));
+  out[4] = WS_CONTROL_VERSION;
+  out[5] = static_cast<uint8_t>(COUNTER_MESSAGE_LEN);
+  out[6] = type;
+  out[7] = 4;
+  for (int i = 0; i < 4; i++) {
+    out[8 + i] = static_cast<uint8_t>(counter >> (8 * i));
+  }
+  return COUNTER_MESSAGE_LEN;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Binary control framing (WebSocket protocol version 2). A binary message may
+// start with a small header that carries the settings for the image behind
+// it, so a push needs no JSON text message alongside it:
+//
+//   0..3  magic "TBYT"
+//   4     version (2)
+//   5     header length H in bytes, including these six (6..255)
+//   6..H  records: type (u8), value length (u8), value
+//   H..   WebP payload; empty for a control-only message
+//
+// Unknown record types are skipped, so the header can grow without a version
+// bump. Integers are little-endian. A message that does not start with the
+// magic is a bare WebP, as in version 1.
+//
+// Pure encode/decode with no RTOS or ESP dependencies so it is host-testable.
+
+#define WS_CONTROL_VERSION 2
+#define WS_CONTROL_MIN_HEADER 6
+// Matches IMAGE_CACHE_KEY_MAX.
+#define WS_CONTROL_KEY_MAX 80
+
+// Server -> device records.
+#define WS_CONTROL_DWELL_SECS 0x01   // u16, 1..3600
+#define WS_CONTROL_BRIGHTNESS 0x02   // u8
+#define WS_CONTROL_FLAGS 0x03        // u8, WS_CONTROL_FLAG_*
+#define WS_CONTROL_PLAY_CACHED 0x04  // cache key, not NUL terminated
+#define WS_CONTROL_PLAYLIST_ID 0x05  // store the image as this playlist entry
+
+#define WS_CONTROL_FLAG_IMMEDIATE 0x01
+
+// Device -> server records, sent as control-only messages.
+#define WS_CONTROL_QUEUED 0x10      // u32 counter
+#define WS_CONTROL_DISPLAYING 0x11  // u32 counter
+
+typedef enum {
+  WS_CONTROL_NONE = 0,  // no magic: a bare WebP
+  WS_CONTROL_OK,
+  WS_CONTROL_SHORT,    // header runs past the bytes given
+  WS_CONTROL_INVALID,  // bad version, length, record or value
+} ws_control_result_t;
+
+typedef struct {
+  uint16_t header_len;
+  bool has_dwell;
+  int32_t dwell_secs;
+  bool has_brightness;
+  uint8_t brightness;
+  bool immediate;
+  char play_cached[WS_CONTROL_KEY_MAX];  // empty when absent
+  char playlist_id[WS_CONTROL_KEY_MAX];  // empty when absent
+} ws_control_t;
+
+// Decode the header at the start of data (len bytes, at least the whole
+// header). *out is filled only on WS_CONTROL_OK.
+ws_control_result_t ws_control_parse(const uint8_t* data, size_t len,
+                                     ws_control_t* out);
+
+// Encode a control-only message with one u32 record (WS_CONTROL_QUEUED or
+// WS_CONTROL_DISPLAYING). Returns its length, 0 when out is too small.
+size_t ws_control_encode_counter(uint8_t type, uint32_t counter, uint8_t* out,
+                                 size_t out_len);
+
+#ifdef __cplusplus
+}
+#endif
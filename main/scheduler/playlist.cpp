@@ -0,0 +1,95 @@
+#include "playlist.h"
+
+#include <string.h>
+
+namespace {
+
+bool id_ok(const char* id) {
+  return id && id[0] != '\0' && strlen(id) < PLAYLIST_ID_MAX;
+}
+
+int index_of(const playlist_t* p, const char* id) {
+  for (int i = 0; i < p->count; i++) {
+    if (strcmp(p->entries[i].id, id) == 0) return i;
+  }
+  return -1;
+}
+
+}  // namespace
+
+void playlist_init(playlist_t* p) {
+  memset(p, 0, sizeof(*p));
+  p->cursor = -1;
+}
+
+int playlist_set(playlist_t* p, const playlist_item_t* items, int count,
+                 void* dropped[PLAYLIST_MAX_ENTRIES]) {
+  if (count < 0 || count > PLAYLIST_MAX_ENTRIES) return -1;
+  for (int i = 0; i < count; i++) {
+    if (!id_ok(items[i].id)) return -1;
+    for (int j = 0; j < i; j++) {
+      if (strcmp(items[i].id, items[j].id) == 0) return -1;
+    }
+  }
+
+  playlist_t next;
+  playlist_init(&next);
+  for (int i = 0; i < count; i++) {
+    playlist_entry_t& e = next.entries[next.count++];
+    strcpy(e.id, items[i].id);
+    e.dwell_secs = items[i].dwell_secs;
+    const int old = index_of(p, items[i].id);
+    if (old >= 0) {
+      e.body = p->entries[old].body;
+      e.len = p->entries[old].len;
+      next.body_bytes += e.len;
+      p->entries[old].body = nullptr;
+      if (old == p->cursor) next.cursor = i;
+    }
+  }
+
+  int n = 0;
+  for (int i = 0; i < p->count; i++) {
+    if (p->entries[i].body) dropped[n++] = p->entries[i].body;
+  }
+  *p = next;
+  return n;
+}
+
+const playlist_entry_t* playlist_find(const playlist_t* p, const char* id) {
+  if (!id_ok(id)) return nullptr;
+  const int i = index_of(p, id);
+  return i >= 0 ? &p->entries[i] : nullptr;
+}
+
+bool playlist_store(playlist_t* p, const char* id, void* body, uint32_t len,
+                    uint64_t budget_bytes, void** replaced) {
+  *replaced = nullptr;
+  if (!body || !id_ok(id)) return false;
+  const int i = index_of(p, id);
+  if (i < 0) return false;
+  playlist_entry_t& e = p->entries[i];
+  if (p->body_bytes - e.len + len > budget_bytes) return false;
+  *replaced = e.body;
+  p->body_bytes = p->body_bytes - e.len + len;
+  e.body = body;
+  e.len = len;
+  return true;
+}
+
+const playlist_entry_t* playlist_next(playlist_t* p) {
+  for (int step = 1; step <= p->count; step++) {
+    const int i = (p->cursor + step + p->count) % p->count;
+    if (p->entries[i].body) {
+      p->cursor = i;
+      return &p->entries[i];
+    }
+  }
+  return nullptr;
+}
+
+int playlist_ready(const playlist_t* p) {
+  int n = 0;
+  for (int i = 0; i < p->count; i++) n += p->entries[i].body ? 1 : 0;
+  return n;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PLAYLIST_MAX_ENTRIES 16
+// Matches WS_CONTROL_KEY_MAX, which carries the id of a playlist image.
+#define PLAYLIST_ID_MAX 80
+
+typedef struct {
+  char id[PLAYLIST_ID_MAX];
+  int32_t dwell_secs;
+  void* body;  // the entry's WebP, NULL until it arrives
+  uint32_t len;
+} playlist_entry_t;
+
+// A server-sent list of images the device rotates through on its own. Pure
+// bookkeeping with no RTOS or ESP dependencies so it is host-testable; NOT
+// thread safe, and the caller allocates and frees the bodies: calls that let
+// go of a body hand it back.
+typedef struct {
+  playlist_entry_t entries[PLAYLIST_MAX_ENTRIES];
+  int count;
+  int cursor;  // entry last handed out by playlist_next, -1 for none
+  uint64_t body_bytes;
+} playlist_t;
+
+typedef struct {
+  const char* id;
+  int32_t dwell_secs;
+} playlist_item_t;
+
+void playlist_init(playlist_t* p);
+
+// Replace the entries with items, in play order. Ids already in the playlist
+// keep their body, so only changed entries need sending again; the other
+// bodies are written to dropped[] for the caller to free and their number
+// returned. Rotation carries on after the current entry when it is still
+// listed, else from the top. Returns -1 and changes nothing when there are
+// more than PLAYLIST_MAX_ENTRIES items, or an id is empty, too long or listed
+// twice. An empty list clears the playlist.
+int playlist_set(playlist_t* p, const playlist_item_t* items, int count,
+                 void* dropped[PLAYLIST_MAX_ENTRIES]);
+
+// Entry for id, or NULL.
+const playlist_entry_t* playlist_find(const playlist_t* p, const char* id);
+
+// Give the entry for id its body of len bytes. False when id is not listed or
+// the body would take the playlist past budget_bytes; body then stays with
+// the caller. A body it replaces is written to *replaced (else NULL).
+bool playlist_store(playlist_t* p, const char* id, void* body, uint32_t len,
+                    uint64_t budget_bytes, void** replaced);
+
+// Advance to the next entry that has a body, wrapping around. NULL when none
+// has.
+const playlist_entry_t* playlist_next(playlist_t* p);
+
+// Number of entries that have a body.
+int playlist_ready(const playlist_t* p);
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,7 +2,8 @@
 // Modeled on matrx-fw's scheduler, adapted for our push (WS) + poll (HTTP)
 // model.
 //
-// WS mode:  passive — reacts to content pushed by the server.
+// WS mode:  passive — reacts to content pushed by the server, or rotates
+//           through a server-sent playlist on its own.
 // HTTP mode: active — prefetches next image before dwell expires.
 //
 // Concurrency model:
@@ -35,8 +36,10 @@
 
 #include "display.h"
 #include "event_bus.h"
+#include "image_arena.h"
 #include "nvs_settings.h"
 #include "ota.h"
+#include "playlist.h"
 #include "raii_utils.hpp"
 #include "remote.h"
 #include "scheduler_fsm.h"
@@ -63,6 +66,10 @@ constexpr int32_t DEFAULT_REFRESH_INTERVAL = 10;
 #else
 constexpr int32_t DEFAULT_REFRESH_INTERVAL = CONFIG_REFRESH_INTERVAL_SECONDS;
 #endif
+#ifndef CONFIG_PLAYLIST_KB
+#define CONFIG_PLAYLIST_KB 2048
+#endif
+constexpr uint64_t PLAYLIST_BUDGET_BYTES = CONFIG_PLAYLIST_KB * 1024ULL;
 
 // ---------------------------------------------------------------------------
 // Mode & State
@@ -109,7 +116,7 @@ struct PrefetchResult {
 
   void clear() {
     if (webp) {
-      free(webp);
+      image_arena_free(webp);
       webp = nullptr;
     }
     if (ota_url) {
@@ -149,6 +156,14 @@ struct Context {
   PrefetchResult prefetch;
   TaskHandle_t fetch_task = nullptr;
 
+  // WebSocket playlist; bodies are the received image_arena buffers, owned
+  // here. playlist_play_next lends one out while it copies without the lock;
+  // a body dropped meanwhile is freed by the borrower.
+  playlist_t playlist;
+  uint32_t playlist_rotations = 0;
+  const void* playlist_lent = nullptr;
+  bool playlist_lent_dropped = false;
+
   // Default brightness
   uint8_t brightness_pct = (CONFIG_HUB75_BRIGHTNESS * 100) / 255;
 
@@ -206,6 +221,72 @@ void start_retry_timer() {
   esp_timer_start_once(ctx.retry_timer, RETRY_DELAY_US);
 }
 
+// ---------------------------------------------------------------------------
+// WebSocket playlist
+// ---------------------------------------------------------------------------
+
+bool playlist_active() {
+  return ctx.mode == Mode::WEBSOCKET && playlist_ready(&ctx.playlist) > 0;
+}
+
+// Free a body the playlist let go of, unless it is lent out.
+void playlist_free_body(void* body) {
+  if (body && body == ctx.playlist_lent) {
+    ctx.playlist_lent_dropped = true;
+    return;
+  }
+  image_arena_free(body);
+}
+
+// Queue the next playlist image. The entry stays in the playlist, so the
+// player gets a copy of its own to release as usual. That copy can be as
+// large as a download, so ctx.mutex is released while it is taken.
+bool playlist_play_next() {
+  if (ctx.playlist_lent) return true;  // another caller is queueing one
+  const playlist_entry_t* e = playlist_next(&ctx.playlist);
+  if (!e) return false;
+  const playlist_entry_t entry = *e;
+
+  void* copy = image_arena_alloc(entry.len);
+  if (!copy) {
+    ESP_LOGE(TAG, "Playlist: no memory to queue %s (%" PRIu32 " bytes)",
+             entry.id, entry.len);
+    return false;
+  }
+  ctx.playlist_lent = entry.body;
+  xSemaphoreGive(ctx.mutex);
+  memcpy(copy, entry.body, entry.len);
+  xSemaphoreTake(ctx.mutex, portMAX_DELAY);
+  if (ctx.playlist_lent_dropped) image_arena_free(entry.body);
+  ctx.playlist_lent = nullptr;
+  ctx.playlist_lent_dropped = false;
+  // The playlist may have ended, or quiet hours begun, meanwhile.
+  if (!playlist_active() || ctx.paused) {
+    image_arena_free(copy);
+    return false;
+  }
+
+  int32_t dwell = effective_dwell_for_brightness(display_get_brightness(),
+                                                 entry.dwell_secs);
+  int counter = gfx_update(copy, entry.len, dwell);
+  if (counter < 0) {
+    ESP_LOGE(TAG, "Playlist: failed to queue %s", entry.id);
+    image_arena_free(copy);
+    return false;
+  }
+  ctx.playlist_rotations++;
+  ESP_LOGI(TAG, "Playlist: queued %s counter=%d dwell=%" PRId32, entry.id,
+           counter, dwell);
+  transition_to(State::PLAYING);
+  return true;
+}
+
+void playlist_clear() {
+  void* dropped[PLAYLIST_MAX_ENTRIES];
+  int n = playlist_set(&ctx.playlist, nullptr, 0, dropped);
+  for (int i = 0; i < n; i++) playlist_free_body(dropped[i]);
+}
+
 // ---------------------------------------------------------------------------
 // OTA helper
 // ---------------------------------------------------------------------------
@@ -262,7 +343,7 @@ void http_fetch_task(void* param) {
   // Phase 3 — publish result and decide what to do, under the lock.
   raii::MutexGuard lock(ctx.mutex);
   if (!lock) {
-    if (webp) free(webp);
+    image_arena_free(webp);
     if (ota_url) free(ota_url);
     if (image_url) free(image_url);
     vTaskDelete(nullptr);
@@ -271,7 +352,7 @@ void http_fetch_task(void* param) {
 
   // If scheduler was stopped while we were fetching, discard the result.
   if (ctx.mode != Mode::HTTP) {
-    if (webp) free(webp);
+    image_arena_free(webp);
     if (ota_url) free(ota_url);
     if (image_url) free(image_url);
     ctx.fetch_task = nullptr;
@@ -363,7 +444,7 @@ void http_apply_prefetch() {
       ESP_LOGI(TAG, "Image URL unchanged; no save needed");
     } else {
       snprintf(cfg.image_url, sizeof(cfg.image_url), "%s", new_url);
-      config_set(&cfg);  // persists to NVS synchronously
+      config_set(&cfg);
       ESP_LOGI(TAG, "Updated image_url to %s", cfg.image_url);
       ctx.prefetch.reboot_requested = true;
     }
@@ -383,8 +464,8 @@ void http_apply_prefetch() {
     } else {
       ESP_LOGI(TAG, "Reboot requested by server");
       ctx.prefetch.clear();
-      // Brief pause so the log line reaches the console/syslog. Settings are
-      // already committed by config_set(), so nothing is at risk here.
+      config_flush();  // a freshly-saved image URL must survive the restart
+      // Brief pause so the log line reaches the console/syslog.
       vTaskDelay(pdMS_TO_TICKS(200));
       esp_restart();
     }
@@ -463,7 +544,7 @@ void http_apply_prefetch() {
   int counter = gfx_update(ctx.prefetch.webp, ctx.prefetch.len, dwell);
   if (counter < 0) {
     ESP_LOGE(TAG, "Failed to queue HTTP-fetched WebP");
-    free(ctx.prefetch.webp);
+    image_arena_free(ctx.prefetch.webp);
     ctx.prefetch.webp = nullptr;
     ctx.prefetch.clear();
     start_retry_timer();
@@ -550,7 +631,12 @@ void on_player_stopped() {
 
   switch (ctx.mode) {
     case Mode::WEBSOCKET:
-      // WS mode: server pushes next content, just go idle
+      // A playlist rotates locally. A push waiting in the player goes first;
+      // the end of its dwell brings the rotation back.
+      if (playlist_active() && (gfx_has_pending() || playlist_play_next())) {
+        break;
+      }
+      // Otherwise the server pushes next content, just go idle
       transition_to(static_cast<State>(scheduler_fsm_next_state(
           SCHED_MODE_WEBSOCKET, static_cast<scheduler_state_t>(ctx.state),
           SCHED_EVT_PLAYER_STOPPED, false)));
@@ -650,6 +736,8 @@ void scheduler_init() {
     return;
   }
 
+  playlist_init(&ctx.playlist);
+
   // Create prefetch timer (HTTP mode)
   esp_timer_create_args_t prefetch_args = {};
   prefetch_args.callback = prefetch_timer_callback;
@@ -708,6 +796,7 @@ void scheduler_stop() {
   stop_timers();
 
   ctx.prefetch.clear();
+  playlist_clear();
   ctx.mode = Mode::NONE;
   transition_to(State::IDLE);
 
@@ -772,8 +861,9 @@ void scheduler_resume() {
       http_trigger_fetch();
       break;
     case Mode::WEBSOCKET:
-      // The server pushes content on its own cadence; just await the next one.
+      // Pick the playlist up again, or await the server's next push.
       transition_to(State::IDLE);
+      if (playlist_active()) playlist_play_next();
       break;
     default:
       transition_to(State::IDLE);
@@ -788,6 +878,12 @@ void scheduler_on_ws_connect() {
   if (!lock) return;
 
   ctx.ws_connected = true;
+  if (playlist_active()) {
+    // Keep rotating; the server resends its playlist and only the entries
+    // that changed.
+    ESP_LOGI(TAG, "WS connected — playlist continues");
+    return;
+  }
   gfx_interrupt();
   transition_to(State::IDLE);
   ESP_LOGI(TAG, "WS connected — awaiting content");
@@ -799,6 +895,10 @@ void scheduler_on_ws_disconnect() {
 
   ctx.ws_connected = false;
   stop_timers();
+  if (playlist_active()) {
+    ESP_LOGI(TAG, "WS disconnected — playlist keeps rotating");
+    return;
+  }
   gfx_play_embedded("no_connect", true);
   transition_to(static_cast<State>(scheduler_fsm_next_state(
       static_cast<scheduler_mode_t>(ctx.mode),
@@ -806,3 +906,63 @@ void scheduler_on_ws_disconnect() {
       false)));
   ESP_LOGI(TAG, "WS disconnected — showing no_connect sprite");
 }
+
+bool scheduler_playlist_set(const playlist_item_t* items, int count) {
+  raii::MutexGuard lock(ctx.mutex);
+  if (!lock) return false;
+
+  void* dropped[PLAYLIST_MAX_ENTRIES];
+  int n = playlist_set(&ctx.playlist, items, count, dropped);
+  if (n < 0) return false;
+  for (int i = 0; i < n; i++) playlist_free_body(dropped[i]);
+
+  ESP_LOGI(TAG, "Playlist: %d entries, %d with images", ctx.playlist.count,
+           playlist_ready(&ctx.playlist));
+  if (playlist_active() && !ctx.paused && ctx.state == State::IDLE) {
+    playlist_play_next();
+  }
+  return true;
+}
+
+bool scheduler_playlist_has_image(const char* id) {
+  raii::MutexGuard lock(ctx.mutex);
+  if (!lock) return false;
+  const playlist_entry_t* e = playlist_find(&ctx.playlist, id);
+  return e && e->body;
+}
+
+bool scheduler_playlist_store(const char* id, void* webp, size_t len) {
+  if (!webp || len == 0 || len > UINT32_MAX) {
+    image_arena_free(webp);
+    return false;
+  }
+
+  raii::MutexGuard lock(ctx.mutex);
+  void* replaced = nullptr;
+  if (!lock || !playlist_store(&ctx.playlist, id, webp,
+                               static_cast<uint32_t>(len),
+                               PLAYLIST_BUDGET_BYTES, &replaced)) {
+    ESP_LOGW(TAG, "Playlist: %s not listed or over budget; dropped", id);
+    image_arena_free(webp);
+    return false;
+  }
+  playlist_free_body(replaced);
+
+  ESP_LOGI(TAG, "Playlist: stored %s (%zu bytes, %d/%d ready)", id, len,
+           playlist_ready(&ctx.playlist), ctx.playlist.count);
+  if (playlist_active() && !ctx.paused && ctx.state == State::IDLE) {
+    playlist_play_next();
+  }
+  return true;
+}
+
+void scheduler_playlist_get_stats(scheduler_playlist_stats_t* out) {
+  if (!out) return;
+  *out = {};
+  raii::MutexGuard lock(ctx.mutex);
+  if (!lock) return;
+  out->entries = static_cast<uint32_t>(ctx.playlist.count);
+  out->ready = static_cast<uint32_t>(playlist_ready(&ctx.playlist));
+  out->bytes = static_cast<uint32_t>(ctx.playlist.body_bytes);
+  out->rotations = ctx.playlist_rotations;
+}
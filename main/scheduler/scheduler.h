@@ -1,5 +1,10 @@
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include "playlist.h"
+
 /// Initialize the scheduler (registers player event handlers, creates timers).
 /// Must be called after gfx_initialize().
 void scheduler_init();
@@ -31,3 +36,27 @@ void scheduler_on_ws_connect();
 
 /// Called by sockets module on WebSocket disconnect.
 void scheduler_on_ws_disconnect();
+
+/// WebSocket playlist: replace the server's list of images (ids in play
+/// order, with their dwell). The device rotates through the entries that have
+/// an image on its own, from PSRAM, and keeps rotating while the server is
+/// unreachable. Ids it already holds keep their image. An empty list ends
+/// playlist mode. Returns false when the list is rejected.
+bool scheduler_playlist_set(const playlist_item_t* items, int count);
+
+/// True when the playlist entry for @p id has its image.
+bool scheduler_playlist_has_image(const char* id);
+
+/// Hand an image_arena buffer to the playlist entry for @p id. The playlist
+/// takes ownership of @p webp either way, freeing it when the id is not
+/// listed or the image does not fit (returns false).
+bool scheduler_playlist_store(const char* id, void* webp, size_t len);
+
+typedef struct {
+  uint32_t entries;
+  uint32_t ready;  // entries with an image
+  uint32_t bytes;
+  uint32_t rotations;  // images queued from the playlist
+} scheduler_playlist_stats_t;
+
+void scheduler_playlist_get_stats(scheduler_playlist_stats_t* out);
@@ -1,20 +1,24 @@
 #include "runtime_orchestrator.h"
 
+#include <cstdio>
 #include <cstring>
 
 #include <esp_log.h>
 #include <esp_system.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/event_groups.h>
+#include <freertos/semphr.h>
 #include <freertos/task.h>
 
 #include "ap.h"
 #include "app_state.h"
+#include "boot_profile.h"
 #include "diag_event_ring.h"
 #include "ota.h"
 #include "display.h"
 #include "event_bus.h"
 #include "heap_monitor.h"
+#include "image_cache.h"
 #include "ntp.h"
 #include "nvs_settings.h"
 #include "quiet_hours.h"
@@ -32,9 +36,25 @@ const char* TAG = "startup";
 constexpr uint32_t RUNTIME_TASK_STACK_SIZE = 6144;
 constexpr int RUNTIME_TASK_PRIORITY = 5;
 constexpr EventBits_t CONFIG_CHANGED_BIT = BIT0;
+constexpr uint32_t STORAGE_TASK_STACK_SIZE = 4096;  // flash I/O: internal RAM
+constexpr int STORAGE_TASK_PRIORITY = 3;
 
 bool s_button_boot = false;
 EventGroupHandle_t s_config_event_group = nullptr;
+SemaphoreHandle_t s_storage_ready = nullptr;
+
+void mount_storage() {
+  boot_profile_begin(BOOT_STAGE_STORAGE);
+  webui_server_init();
+  image_cache_init();
+  boot_profile_end(BOOT_STAGE_STORAGE);
+}
+
+void storage_task(void*) {
+  mount_storage();
+  xSemaphoreGive(s_storage_ready);
+  vTaskDelete(nullptr);
+}
 
 void on_config_changed(const tronbyt_event_t*, void*) {
   if (s_config_event_group) {
@@ -43,6 +63,7 @@ void on_config_changed(const tronbyt_event_t*, void*) {
 }
 
 void runtime_task(void*) {
+  boot_profile_begin(BOOT_STAGE_RUNTIME);
   auto cfg = config_get();
 
   uint8_t mac[6];
@@ -55,7 +76,7 @@ void runtime_task(void*) {
   if (sta_connected) {
     ESP_LOGI(TAG, "WiFi connected successfully!");
 
-    if (config_get().prefer_ipv6) {
+    if (ConfigSnapshot()->prefer_ipv6) {
       ESP_LOGI(TAG, "IPv6 preference enabled, waiting for global address...");
       if (wifi_wait_for_ipv6(5000)) {
         ESP_LOGI(TAG, "IPv6 Ready!");
@@ -71,9 +92,12 @@ void runtime_task(void*) {
 
   ntp_init();
 
-  auto syslog_cfg = config_get();
-  if (strlen(syslog_cfg.syslog_addr) > 0) {
-    syslog_init(syslog_cfg.syslog_addr);
+  // Copied out: syslog_init resolves the host, too long to hold a snapshot.
+  char syslog_addr[MAX_SYSLOG_ADDR_LEN + 1];
+  snprintf(syslog_addr, sizeof(syslog_addr), "%s",
+           ConfigSnapshot()->syslog_addr);
+  if (syslog_addr[0] != '\0') {
+    syslog_init(syslog_addr);
   }
 
   sta_api_start();
@@ -102,6 +126,10 @@ void runtime_task(void*) {
     }
   }
 
+  if (s_storage_ready) {
+    xSemaphoreTake(s_storage_ready, portMAX_DELAY);
+  }
+
   // Register the wildcard catch-all AFTER all API and specific routes so
   // that /* does not shadow /api/* handlers (httpd matches by registration
   // order).  Only ONE wildcard GET handler can exist.  Use the AP
@@ -192,6 +220,7 @@ void runtime_task(void*) {
     ESP_LOGI(TAG, "Using HTTP polling with URL: %s", image_url);
     scheduler_start_http(image_url);
   }
+  boot_profile_end(BOOT_STAGE_RUNTIME);
 
   // Start quiet hours after the scheduler is live so its initial evaluation can
   // pause playback immediately if the device booted inside a quiet window.
@@ -203,6 +232,18 @@ void runtime_task(void*) {
 
 }  // namespace
 
+void runtime_orchestrator_mount_storage(void) {
+  s_storage_ready = xSemaphoreCreateBinary();
+  if (!s_storage_ready ||
+      xTaskCreate(storage_task, "boot_storage", STORAGE_TASK_STACK_SIZE,
+                  nullptr, STORAGE_TASK_PRIORITY, nullptr) != pdPASS) {
+    ESP_LOGW(TAG, "Mounting storage inline");
+    if (s_storage_ready) vSemaphoreDelete(s_storage_ready);
+    s_storage_ready = nullptr;
+    mount_storage();
+  }
+}
+
 void runtime_orchestrator_start(bool button_boot) {
   s_button_boot = button_boot;
 
@@ -1,4 +1,9 @@
 #pragma once
 
+// Mount the web UI and image cache filesystems on a short-lived task so the
+// flash work overlaps Wi-Fi bring-up. The runtime task waits for it before
+// serving the web UI or starting the scheduler.
+void runtime_orchestrator_mount_storage(void);
+
 void runtime_orchestrator_start(bool button_boot);
 
@@ -0,0 +1,68 @@
+#include "boot_profile.h"
+
+#include <string.h>
+
+#include <esp_attr.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+namespace {
+
+const char* TAG = "boot";
+
+// Survives software resets; after a power-on its magic is garbage and
+// boot_timeline_begin_boot starts over.
+RTC_NOINIT_ATTR boot_timeline_t s_timeline;
+boot_timeline_t s_previous = {};
+bool s_initialized = false;
+
+}  // namespace
+
+void boot_profile_init(void) {
+  if (s_initialized) return;
+  boot_timeline_begin_boot(&s_timeline, &s_previous);
+  s_initialized = true;
+
+  if (boot_timeline_valid(&s_previous)) {
+    const boot_span_t& first = s_previous.spans[BOOT_STAGE_FIRST_IMAGE];
+    ESP_LOGI(TAG, "Boot %lu; previous boot first image at %lu ms",
+             static_cast<unsigned long>(s_timeline.boot_count),
+             static_cast<unsigned long>(first.end_us / 1000));
+  }
+}
+
+void boot_profile_begin(boot_stage_t stage) {
+  if (!s_initialized) return;
+  boot_timeline_start(&s_timeline, stage, esp_timer_get_time());
+}
+
+void boot_profile_end(boot_stage_t stage) {
+  if (!s_initialized) return;
+  boot_timeline_end(&s_timeline, stage, esp_timer_get_time());
+  ESP_LOGD(TAG, "%s: %lu us", boot_timeline_stage_name(stage),
+           static_cast<unsigned long>(
+               boot_timeline_duration_us(&s_timeline, stage)));
+}
+
+void boot_profile_mark(boot_stage_t stage) {
+  if (!s_initialized || stage >= BOOT_STAGE_COUNT) return;
+  const bool first = s_timeline.spans[stage].end_us == 0;
+  boot_timeline_mark(&s_timeline, stage, esp_timer_get_time());
+  if (first) {
+    ESP_LOGI(TAG, "%s at %lu ms", boot_timeline_stage_name(stage),
+             static_cast<unsigned long>(s_timeline.spans[stage].end_us /
+                                        1000));
+  }
+}
+
+bool boot_profile_get(boot_timeline_t* current, boot_timeline_t* previous) {
+  if (current) {
+    if (s_initialized) {
+      memcpy(current, &s_timeline, sizeof(*current));
+    } else {
+      memset(current, 0, sizeof(*current));
+    }
+  }
+  if (previous) memcpy(previous, &s_previous, sizeof(*previous));
+  return boot_timeline_valid(&s_previous);
+}
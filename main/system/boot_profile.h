@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "boot_timeline.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Start this boot's timeline. Call first thing in app_main. The timeline is
+ * kept in RTC memory, so the one from before a reset (crash, watchdog, OTA
+ * reboot) stays readable through boot_profile_get.
+ */
+void boot_profile_init(void);
+
+/** Stamp the start / end of a stage now. Safe from any task. */
+void boot_profile_begin(boot_stage_t stage);
+void boot_profile_end(boot_stage_t stage);
+
+/** Stamp a milestone (start and end at once); later calls are ignored. */
+void boot_profile_mark(boot_stage_t stage);
+
+/**
+ * Copy this boot's timeline into current and the previous boot's into
+ * previous (either may be null). Returns whether previous holds a timeline;
+ * there is none after a power-on.
+ */
+bool boot_profile_get(boot_timeline_t* current, boot_timeline_t* previous);
+
+#ifdef __cplusplus
+}
+#endif
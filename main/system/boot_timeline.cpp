@@ -0,0 +1,133 @@
+#include "boot_timeline.h"
+
+#include <string.h>
+
+namespace {
+
+constexpr uint32_t MAGIC = 0x42544C31;  // "BTL1"
+
+#define DEP(s) (1u << (s))
+
+// Stages each one waits on before it can start, mirroring app_main and the
+// runtime task. Stages app_main runs back to back depend on their
+// predecessor; the storage mount and the Wi-Fi connect run alongside.
+const uint32_t kDeps[BOOT_STAGE_COUNT] = {
+    0,                                                       // NVS
+    DEP(BOOT_STAGE_NVS),                                     // EVENT_BUS
+    DEP(BOOT_STAGE_EVENT_BUS),                               // APP_STATE
+    DEP(BOOT_STAGE_APP_STATE),                               // DIAG_EVENTS
+    DEP(BOOT_STAGE_DIAG_EVENTS),                             // CONSOLE
+    DEP(BOOT_STAGE_CONSOLE),                                 // HEAP_MONITOR
+    DEP(BOOT_STAGE_HEAP_MONITOR),                            // IMAGE_ARENA
+    DEP(BOOT_STAGE_IMAGE_ARENA),                             // DISPLAY
+    DEP(BOOT_STAGE_DISPLAY),                                 // STORAGE
+    DEP(BOOT_STAGE_DISPLAY),                                 // WIFI_INIT
+    DEP(BOOT_STAGE_WIFI_INIT),                               // WIFI_CONNECT
+    DEP(BOOT_STAGE_WIFI_INIT),                               // SERVICES
+    DEP(BOOT_STAGE_SERVICES) | DEP(BOOT_STAGE_STORAGE),      // RUNTIME
+    DEP(BOOT_STAGE_RUNTIME) | DEP(BOOT_STAGE_WIFI_CONNECT),  // FIRST_IMAGE
+};
+
+#undef DEP
+
+const char* const kNames[BOOT_STAGE_COUNT] = {
+    "nvs",          "event_bus",   "app_state", "diag_events", "console",
+    "heap_monitor", "image_arena", "display",   "storage",     "wifi_init",
+    "wifi_connect", "services",    "runtime",   "first_image",
+};
+
+bool in_range(boot_stage_t stage) {
+  return static_cast<int>(stage) >= 0 && stage < BOOT_STAGE_COUNT;
+}
+
+// 0 means "not reached", so a stamp at exactly 0 us becomes 1.
+uint32_t stamp(int64_t now_us) {
+  if (now_us < 1) return 1;
+  if (now_us > static_cast<int64_t>(UINT32_MAX)) return UINT32_MAX;
+  return static_cast<uint32_t>(now_us);
+}
+
+}  // namespace
+
+const char* boot_timeline_stage_name(boot_stage_t stage) {
+  return in_range(stage) ? kNames[stage] : "unknown";
+}
+
+bool boot_timeline_valid(const boot_timeline_t* t) {
+  return t && t->magic == MAGIC;
+}
+
+void boot_timeline_begin_boot(boot_timeline_t* t, boot_timeline_t* prev) {
+  const bool had_prev = boot_timeline_valid(t);
+  if (prev) {
+    if (had_prev) {
+      memcpy(prev, t, sizeof(*prev));
+    } else {
+      memset(prev, 0, sizeof(*prev));
+    }
+  }
+  const uint32_t count = had_prev ? t->boot_count + 1 : 1;
+  memset(t, 0, sizeof(*t));
+  t->boot_count = count;
+  t->magic = MAGIC;
+}
+
+void boot_timeline_start(boot_timeline_t* t, boot_stage_t stage,
+                         int64_t now_us) {
+  if (!t || !in_range(stage) || t->spans[stage].start_us != 0) return;
+  t->spans[stage].start_us = stamp(now_us);
+}
+
+void boot_timeline_end(boot_timeline_t* t, boot_stage_t stage,
+                       int64_t now_us) {
+  if (!t || !in_range(stage) || t->spans[stage].end_us != 0) return;
+  const uint32_t now = stamp(now_us);
+  // An end without a recorded start still shows when the stage was done.
+  if (t->spans[stage].start_us == 0) t->spans[stage].start_us = now;
+  t->spans[stage].end_us = now;
+}
+
+void boot_timeline_mark(boot_timeline_t* t, boot_stage_t stage,
+                        int64_t now_us) {
+  boot_timeline_end(t, stage, now_us);
+}
+
+uint32_t boot_timeline_duration_us(const boot_timeline_t* t,
+                                   boot_stage_t stage) {
+  if (!t || !in_range(stage)) return 0;
+  const boot_span_t& s = t->spans[stage];
+  if (s.end_us == 0 || s.end_us < s.start_us) return 0;
+  return s.end_us - s.start_us;
+}
+
+int boot_timeline_critical_path(const boot_timeline_t* t, boot_stage_t goal,
+                                boot_stage_t* out, int max_out) {
+  if (!t || !out || max_out <= 0 || !in_range(goal) ||
+      t->spans[goal].end_us == 0) {
+    return 0;
+  }
+
+  // Collected goal first, then reversed.
+  int n = 0;
+  int stage = goal;
+  while (stage >= 0 && n < max_out) {
+    out[n++] = static_cast<boot_stage_t>(stage);
+    int latest = -1;
+    uint32_t latest_end = 0;
+    for (int d = 0; d < BOOT_STAGE_COUNT; d++) {
+      if (!(kDeps[stage] & (1u << d))) continue;
+      const uint32_t end = t->spans[d].end_us;
+      if (end != 0 && end >= latest_end) {
+        latest = d;
+        latest_end = end;
+      }
+    }
+    stage = latest;
+  }
+  for (int i = 0; i < n / 2; i++) {
+    const boot_stage_t tmp = out[i];
+    out[i] = out[n - 1 - i];
+    out[n - 1 - i] = tmp;
+  }
+  return n;
+}
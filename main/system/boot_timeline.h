@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Startup stages, in the order app_main reaches them. BOOT_STAGE_FIRST_IMAGE
+// is a milestone (start == end): the first server image starting to play.
+typedef enum {
+  BOOT_STAGE_NVS = 0,
+  BOOT_STAGE_EVENT_BUS,
+  BOOT_STAGE_APP_STATE,
+  BOOT_STAGE_DIAG_EVENTS,
+  BOOT_STAGE_CONSOLE,
+  BOOT_STAGE_HEAP_MONITOR,
+  BOOT_STAGE_IMAGE_ARENA,
+  BOOT_STAGE_DISPLAY,       // gfx_initialize: panel, version screen, player
+  BOOT_STAGE_STORAGE,       // LittleFS mounts for the web UI and image cache
+  BOOT_STAGE_WIFI_INIT,     // wifi_initialize, including any ranking scan
+  BOOT_STAGE_WIFI_CONNECT,  // first connect attempt until an IP
+  BOOT_STAGE_SERVICES,      // HTTP server, mDNS, touch, AP
+  BOOT_STAGE_RUNTIME,       // runtime task until the scheduler is running
+  BOOT_STAGE_FIRST_IMAGE,
+  BOOT_STAGE_COUNT,
+} boot_stage_t;
+
+typedef struct {
+  uint32_t start_us;  // since boot; 0 = not reached
+  uint32_t end_us;    // 0 = not finished
+} boot_span_t;
+
+// Start and end time of every stage of one boot. Plain data so it can live
+// in RTC memory and be read back after the next reset; the magic tells a
+// recorded timeline from power-on garbage. Each stage is written by the one
+// task that runs it, so no locking is needed. Pure, with no RTOS or ESP
+// dependencies so it is host-testable.
+typedef struct {
+  uint32_t magic;
+  uint32_t boot_count;  // boots recorded since power-on
+  boot_span_t spans[BOOT_STAGE_COUNT];
+} boot_timeline_t;
+
+const char* boot_timeline_stage_name(boot_stage_t stage);
+
+bool boot_timeline_valid(const boot_timeline_t* t);
+
+// Start recording a new boot into t. When t still holds the previous boot it
+// is copied to prev (if non-null) and the boot count carries on; otherwise
+// prev is marked invalid.
+void boot_timeline_begin_boot(boot_timeline_t* t, boot_timeline_t* prev);
+
+// Record a stage boundary. Only the first start and first end count, so a
+// stage that can be reached from several paths keeps its earliest time.
+// Times saturate at UINT32_MAX us (about 71 minutes).
+void boot_timeline_start(boot_timeline_t* t, boot_stage_t stage,
+                         int64_t now_us);
+void boot_timeline_end(boot_timeline_t* t, boot_stage_t stage,
+                       int64_t now_us);
+// start and end at once, for milestones.
+void boot_timeline_mark(boot_timeline_t* t, boot_stage_t stage,
+                        int64_t now_us);
+
+// end - start, or 0 while the stage has not finished.
+uint32_t boot_timeline_duration_us(const boot_timeline_t* t,
+                                   boot_stage_t stage);
+
+// Walk back from goal through the stages it waits on, each time following
+// the one that finished last: the chain that set goal's time. Writes it
+// root first into out and returns its length (0 when goal has not
+// finished).
+int boot_timeline_critical_path(const boot_timeline_t* t, boot_stage_t goal,
+                                boot_stage_t* out, int max_out);
+
+#ifdef __cplusplus
+}
+#endif
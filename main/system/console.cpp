@@ -18,6 +18,7 @@
 
 #include "display.h"
 #include "heap_monitor.h"
+#include "webp_player.h"
 
 #if CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
 #include <driver/usb_serial_jtag.h>
@@ -130,6 +131,39 @@ int cmd_assert(int argc, char** argv) {
   return 0;
 }
 
+void print_timing_stage(const char* name, const frame_hist_t& h) {
+  printf("%-7s %7" PRIu32 " %7" PRIu32 " %7" PRIu32 " %7" PRIu32 " %7" PRIu32
+         " %8" PRIu32 "\n",
+         name, h.count, frame_hist_avg_us(&h), frame_hist_percentile(&h, 50),
+         frame_hist_percentile(&h, 90), frame_hist_percentile(&h, 99),
+         h.max_us);
+}
+
+int cmd_timing(int argc, char** argv) {
+  gfx_timing_stats_t t = {};
+  gfx_get_timing_stats(&t);
+  const frame_stats_t& s = t.stats;
+  if (t.source_type == GFX_SOURCE_EMBEDDED && t.embedded_name) {
+    printf("image: %s\n", t.embedded_name);
+  } else {
+    printf("image: counter %d\n", t.counter);
+  }
+  const uint32_t achieved = frame_stats_achieved_fps_x100(&s);
+  const uint32_t authored = frame_stats_authored_fps_x100(&s);
+  printf("frames: %" PRIu32 " late: %" PRIu32 " skipped: %" PRIu32 "\n",
+         s.frames, s.late, s.skipped);
+  printf("fps: %" PRIu32 ".%02" PRIu32 " achieved / %" PRIu32 ".%02" PRIu32
+         " authored\n\n",
+         achieved / 100, achieved % 100, authored / 100, authored % 100);
+  printf("%-7s %7s %7s %7s %7s %7s %8s\n", "stage", "frames", "avg_us",
+         "p50", "p90", "p99", "max_us");
+  print_timing_stage("decode", s.decode);
+  print_timing_stage("diff", s.diff);
+  print_timing_stage("draw", s.draw);
+  print_timing_stage("flip", s.flip);
+  return 0;
+}
+
 // Panel hardware tuning. These exist to diagnose and repair a mis-wired or
 // marginal panel over serial without a rebuild, so each prints the current
 // value when called with no argument.
@@ -223,6 +257,15 @@ void register_commands() {
        .argtable = nullptr,
        .func_w_context = nullptr,
        .context = nullptr},
+      {.command = "timing",
+       .help =
+           "Frame timing of the current playback: per-stage percentiles, "
+           "late frames, achieved vs authored fps",
+       .hint = nullptr,
+       .func = &cmd_timing,
+       .argtable = nullptr,
+       .func_w_context = nullptr,
+       .context = nullptr},
       {.command = "assert",
        .help = "Crash the system for testing",
        .hint = nullptr,
@@ -1,31 +1,54 @@
 #include "diag_event_ring.h"
 
-#include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 
+#include <esp_heap_caps.h>
 #include <esp_log.h>
+#include <esp_system.h>
 #include <esp_timer.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
+#include <freertos/task.h>
 #include <nvs.h>
 
+#include "diag_record.h"
+#include "diag_stage.h"
+#include "sdkconfig.h"
+
+#ifndef CONFIG_DIAG_EVENT_FLUSH_SECS
+#define CONFIG_DIAG_EVENT_FLUSH_SECS 60
+#endif
+
 namespace {
 
 const char* TAG = "diag_evt";
 constexpr const char* NS = "diag_evt";
-constexpr const char* KEY_HEAD = "head";
-constexpr const char* KEY_COUNT = "count";
-constexpr const char* KEY_SEQ = "seq";
+constexpr const char* KEY_SEQ = "seq";  // last seq written to flash
 constexpr const char* KEY_ENABLED = "enabled";
-constexpr size_t RING_SIZE = 32;
-
+// Left by the string-per-slot format; their presence triggers a wipe.
+constexpr const char* KEY_LEGACY_HEAD = "head";
+constexpr const char* KEY_LEGACY_COUNT = "count";
+constexpr size_t RING_SIZE = DIAG_STAGE_SLOTS;
+
+// Events staged in RAM before the flush task is woken early.
+constexpr uint32_t FLUSH_BATCH = 8;
+constexpr size_t FLUSH_STACK_SIZE = 3072;  // NVS writes: internal RAM stack
+constexpr int FLUSH_TASK_PRIORITY = 1;
+// Task notification bits for the flush task.
+constexpr uint32_t NOTIFY_BATCH = 1u << 0;  // enough staged, flush early
+constexpr uint32_t NOTIFY_FLUSH = 1u << 1;  // diag_event_ring_flush waits
+constexpr TickType_t FLUSH_TIMEOUT = pdMS_TO_TICKS(1000);
+
+// Guards NVS access (flushes and the enabled flag); logging and reads only
+// touch the stage.
 SemaphoreHandle_t s_mutex = nullptr;
+TaskHandle_t s_flush_task = nullptr;
+SemaphoreHandle_t s_flushed = nullptr;  // given after a requested flush
 bool s_initialized = false;
-uint8_t s_head = 0;
-uint8_t s_count = 0;
-uint32_t s_seq = 0;
-bool s_enabled = false;
+bool s_enabled = true;
+diag_stage_t s_stage = {};
+uint32_t s_flushed_seq = 0;  // under s_mutex
 
 bool is_ota_event(const char* type) {
   return type && strncmp(type, "ota_", 4) == 0;
@@ -40,7 +63,7 @@ void sanitize(char* dst, size_t dst_len, const char* src) {
   size_t j = 0;
   for (size_t i = 0; src[i] != '\0' && j + 1 < dst_len; ++i) {
     char c = src[i];
-    if (c == '|' || c == '\n' || c == '\r' || c == '\t') {
+    if (c == '\n' || c == '\r' || c == '\t') {
       dst[j++] = ' ';
     } else {
       dst[j++] = c;
@@ -49,93 +72,115 @@ void sanitize(char* dst, size_t dst_len, const char* src) {
   dst[j] = '\0';
 }
 
-void slot_key(uint8_t idx, char* key, size_t key_len) {
-  snprintf(key, key_len, "e%02u", static_cast<unsigned>(idx));
+void slot_key(uint32_t seq, char* key, size_t key_len) {
+  snprintf(key, key_len, "e%02u", static_cast<unsigned>(seq % RING_SIZE));
 }
 
-bool parse_entry(const char* line, diag_event_t* out) {
-  if (!line || !out) return false;
-
-  char buffer[320];
-  snprintf(buffer, sizeof(buffer), "%s", line);
-
-  char* save = nullptr;
-  char* tok = strtok_r(buffer, "|", &save);
-  if (!tok) return false;
-  out->seq = static_cast<uint32_t>(strtoul(tok, nullptr, 10));
-
-  tok = strtok_r(nullptr, "|", &save);
-  if (!tok) return false;
-  out->uptime_ms = static_cast<uint32_t>(strtoul(tok, nullptr, 10));
-
-  tok = strtok_r(nullptr, "|", &save);
-  if (!tok) return false;
-  out->code = static_cast<int32_t>(strtol(tok, nullptr, 10));
-
-  tok = strtok_r(nullptr, "|", &save);
-  if (!tok) return false;
-  snprintf(out->level, sizeof(out->level), "%s", tok);
-
-  tok = strtok_r(nullptr, "|", &save);
-  if (!tok) return false;
-  snprintf(out->type, sizeof(out->type), "%s", tok);
-
-  tok = strtok_r(nullptr, "", &save);
-  if (!tok) tok = const_cast<char*>("");
-  snprintf(out->message, sizeof(out->message), "%s", tok);
-
-  return true;
+void wipe_legacy(nvs_handle_t h) {
+  uint8_t unused = 0;
+  if (nvs_get_u8(h, KEY_LEGACY_HEAD, &unused) != ESP_OK) return;
+
+  ESP_LOGI(TAG, "Dropping events stored in the old text format");
+  nvs_erase_key(h, KEY_LEGACY_HEAD);
+  nvs_erase_key(h, KEY_LEGACY_COUNT);
+  for (uint32_t i = 0; i < RING_SIZE; i++) {
+    char key[8];
+    slot_key(i, key, sizeof(key));
+    nvs_erase_key(h, key);
+  }
+  nvs_commit(h);
 }
 
-void persist_meta(nvs_handle_t h) {
-  nvs_set_u8(h, KEY_HEAD, s_head);
-  nvs_set_u8(h, KEY_COUNT, s_count);
-  nvs_set_u32(h, KEY_SEQ, s_seq);
+void load_persisted(nvs_handle_t h) {
+  for (uint32_t i = 0; i < RING_SIZE; i++) {
+    char key[8];
+    slot_key(i, key, sizeof(key));
+    uint8_t buf[DIAG_RECORD_MAX];
+    size_t len = sizeof(buf);
+    if (nvs_get_blob(h, key, buf, &len) != ESP_OK) continue;
+    diag_event_t ev;
+    if (!diag_record_decode(buf, len, &ev)) continue;
+    // A slot written after the seq was last committed is stale.
+    if (ev.seq % RING_SIZE != i || ev.seq > s_flushed_seq ||
+        s_flushed_seq - ev.seq >= RING_SIZE) {
+      continue;
+    }
+    diag_stage_restore(&s_stage, &ev);
+  }
 }
 
-void load_entry_by_ring_index(size_t ring_index, diag_event_t* out) {
-  if (!out) return;
-  memset(out, 0, sizeof(*out));
+// Write the events staged since the last flush with one commit. Caller holds
+// s_mutex.
+void flush_locked() {
+  const uint32_t last = diag_stage_last_seq(&s_stage);
+  if (last == s_flushed_seq) return;
 
   nvs_handle_t h;
-  if (nvs_open(NS, NVS_READONLY, &h) != ESP_OK) return;
+  if (nvs_open(NS, NVS_READWRITE, &h) != ESP_OK) return;
 
-  char key[8];
-  slot_key(static_cast<uint8_t>(ring_index % RING_SIZE), key, sizeof(key));
-
-  size_t len = 0;
-  if (nvs_get_str(h, key, nullptr, &len) != ESP_OK || len == 0 ||
-      len > 320) {
-    nvs_close(h);
-    return;
+  uint32_t seq = s_flushed_seq + 1;
+  if (last - s_flushed_seq > RING_SIZE) {
+    seq = last - RING_SIZE + 1;  // older ones were overwritten in RAM
   }
-
-  char buf[320];
-  if (nvs_get_str(h, key, buf, &len) == ESP_OK) {
-    parse_entry(buf, out);
+  uint32_t written = s_flushed_seq;
+  for (; seq <= last; seq++) {
+    diag_event_t ev;
+    const diag_stage_result_t rc = diag_stage_get(&s_stage, seq, &ev);
+    if (rc == DIAG_STAGE_PENDING) break;  // still being logged; next time
+    written = seq;
+    if (rc == DIAG_STAGE_GONE) continue;
+
+    uint8_t buf[DIAG_RECORD_MAX];
+    const size_t len = diag_record_encode(&ev, buf, sizeof(buf));
+    char key[8];
+    slot_key(seq, key, sizeof(key));
+    nvs_set_blob(h, key, buf, len);
   }
 
+  if (written != s_flushed_seq) {
+    nvs_set_u32(h, KEY_SEQ, written);
+    if (nvs_commit(h) == ESP_OK) {
+      s_flushed_seq = written;
+    }
+  }
   nvs_close(h);
 }
 
+void flush_task(void*) {
+  while (true) {
+    uint32_t bits = 0;
+    xTaskNotifyWait(0, UINT32_MAX, &bits,
+                    pdMS_TO_TICKS(CONFIG_DIAG_EVENT_FLUSH_SECS * 1000));
+    if (xSemaphoreTake(s_mutex, portMAX_DELAY) == pdTRUE) {
+      flush_locked();
+      xSemaphoreGive(s_mutex);
+    }
+    if (bits & NOTIFY_FLUSH) xSemaphoreGive(s_flushed);
+  }
+}
+
+void on_shutdown() { diag_event_ring_flush(); }
+
 size_t collect_entries(const char* type_filter, bool prefix_match,
                        diag_event_t* out, size_t max_events) {
   if (!out || max_events == 0) return 0;
 
+  const bool filtered = type_filter && type_filter[0] != '\0';
+  const size_t filter_len = filtered ? strlen(type_filter) : 0;
+  const uint32_t last = diag_stage_last_seq(&s_stage);
   size_t copied = 0;
-  for (size_t i = 0; i < s_count && copied < max_events; ++i) {
-    size_t idx = (s_head + RING_SIZE - 1 - i) % RING_SIZE;
-    diag_event_t entry = {};
-    load_entry_by_ring_index(idx, &entry);
-    if (entry.seq == 0 && entry.uptime_ms == 0 && entry.type[0] == '\0') {
+  for (uint32_t i = 0; i < RING_SIZE && i < last && copied < max_events;
+       ++i) {
+    diag_event_t entry;
+    if (diag_stage_get(&s_stage, last - i, &entry) != DIAG_STAGE_OK) {
       continue;
     }
-    if (type_filter && type_filter[0] != '\0' &&
-        !prefix_match) {
-      if (strcmp(type_filter, entry.type) != 0) continue;
+    if (filtered && !prefix_match && strcmp(type_filter, entry.type) != 0) {
+      continue;
     }
-    if (type_filter && type_filter[0] != '\0' && prefix_match) {
-      if (strncmp(entry.type, type_filter, strlen(type_filter)) != 0) continue;
+    if (filtered && prefix_match &&
+        strncmp(entry.type, type_filter, filter_len) != 0) {
+      continue;
     }
     out[copied++] = entry;
   }
@@ -148,45 +193,53 @@ void diag_event_ring_init(void) {
   if (s_initialized) return;
 
   s_mutex = xSemaphoreCreateMutex();
-  if (!s_mutex) {
-    ESP_LOGE(TAG, "Failed to create mutex");
+  auto* slots = static_cast<diag_event_t*>(
+      heap_caps_malloc(sizeof(diag_event_t) * RING_SIZE,
+                       MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+  if (!slots) {
+    slots = static_cast<diag_event_t*>(
+        heap_caps_malloc(sizeof(diag_event_t) * RING_SIZE, MALLOC_CAP_8BIT));
+  }
+  if (!s_mutex || !slots) {
+    ESP_LOGE(TAG, "Failed to allocate event ring");
+    heap_caps_free(slots);
+    if (s_mutex) vSemaphoreDelete(s_mutex);
+    s_mutex = nullptr;
     return;
   }
 
-  if (xSemaphoreTake(s_mutex, portMAX_DELAY) != pdTRUE) return;
-
   nvs_handle_t h;
   esp_err_t err = nvs_open(NS, NVS_READWRITE, &h);
-  if (err != ESP_OK) {
-    xSemaphoreGive(s_mutex);
+  if (err == ESP_OK) {
+    wipe_legacy(h);
+    nvs_get_u32(h, KEY_SEQ, &s_flushed_seq);
+    uint8_t enabled_u8 = 0;
+    if (nvs_get_u8(h, KEY_ENABLED, &enabled_u8) == ESP_OK) {
+      s_enabled = (enabled_u8 != 0);
+    }
+  } else {
     ESP_LOGE(TAG, "Failed to open NVS namespace: %s", esp_err_to_name(err));
-    return;
   }
 
-  nvs_get_u8(h, KEY_HEAD, &s_head);
-  nvs_get_u8(h, KEY_COUNT, &s_count);
-  nvs_get_u32(h, KEY_SEQ, &s_seq);
-  uint8_t enabled_u8 = 0;
-  if (nvs_get_u8(h, KEY_ENABLED, &enabled_u8) == ESP_OK) {
-    s_enabled = (enabled_u8 != 0);
-  } else {
-    // Default to off to reduce flash wear unless explicitly enabled.
-    s_enabled = false;
-    nvs_set_u8(h, KEY_ENABLED, 0);
-    nvs_commit(h);
+  diag_stage_init(&s_stage, slots, s_flushed_seq);
+  if (err == ESP_OK) {
+    load_persisted(h);
+    nvs_close(h);
   }
 
-  if (s_head >= RING_SIZE) s_head = 0;
-  if (s_count > RING_SIZE) s_count = 0;
-
-  nvs_close(h);
+  s_flushed = xSemaphoreCreateBinary();
+  if (!s_flushed ||
+      xTaskCreate(flush_task, "diag_flush", FLUSH_STACK_SIZE, nullptr,
+                  FLUSH_TASK_PRIORITY, &s_flush_task) != pdPASS) {
+    // Still logs to RAM; events reach flash only on shutdown.
+    ESP_LOGE(TAG, "Failed to create flush task");
+    s_flush_task = nullptr;
+  }
+  esp_register_shutdown_handler(&on_shutdown);
   s_initialized = true;
-  xSemaphoreGive(s_mutex);
 
-  ESP_LOGI(TAG, "Initialized event ring (enabled=%d head=%u count=%u seq=%lu)",
-           s_enabled,
-           static_cast<unsigned>(s_head), static_cast<unsigned>(s_count),
-           static_cast<unsigned long>(s_seq));
+  ESP_LOGI(TAG, "Initialized event ring (enabled=%d seq=%lu)", s_enabled,
+           static_cast<unsigned long>(s_flushed_seq));
 }
 
 void diag_event_log(const char* level, const char* type, int32_t code,
@@ -194,48 +247,39 @@ void diag_event_log(const char* level, const char* type, int32_t code,
   if (!s_initialized) {
     diag_event_ring_init();
   }
-  if (!s_mutex || (!s_enabled && !is_ota_event(type))) return;
-
-  if (xSemaphoreTake(s_mutex, pdMS_TO_TICKS(50)) != pdTRUE) {
-    return;
+  if (!s_initialized || (!s_enabled && !is_ota_event(type))) return;
+
+  diag_event_t ev = {};
+  sanitize(ev.level, sizeof(ev.level), level ? level : "INFO");
+  sanitize(ev.type, sizeof(ev.type), type ? type : "event");
+  sanitize(ev.message, sizeof(ev.message), message ? message : "");
+  ev.code = code;
+  ev.uptime_ms = static_cast<uint32_t>(esp_timer_get_time() / 1000ULL);
+  const uint32_t seq = diag_stage_push(&s_stage, &ev);
+
+  // Errors and OTA steps often precede a reset: get them to flash now
+  // rather than at the next periodic flush. s_flushed_seq is read unlocked;
+  // a stale value only moves the wakeup by one event.
+  const bool urgent = strcmp(ev.level, "ERROR") == 0 || is_ota_event(type);
+  if (s_flush_task && (urgent || seq - s_flushed_seq >= FLUSH_BATCH)) {
+    xTaskNotify(s_flush_task, NOTIFY_BATCH, eSetBits);
   }
+}
 
-  nvs_handle_t h;
-  esp_err_t err = nvs_open(NS, NVS_READWRITE, &h);
-  if (err != ESP_OK) {
-    xSemaphoreGive(s_mutex);
+void diag_event_ring_flush(void) {
+  if (!s_initialized) return;
+  if (s_flush_task && xTaskGetCurrentTaskHandle() != s_flush_task) {
+    // NVS writes need an internal-RAM stack, which the caller (http_fetch
+    // restarting on a server request, say) may not have.
+    xSemaphoreTake(s_flushed, 0);  // drop a stale completion
+    xTaskNotify(s_flush_task, NOTIFY_FLUSH, eSetBits);
+    if (xSemaphoreTake(s_flushed, FLUSH_TIMEOUT) != pdTRUE) {
+      ESP_LOGW(TAG, "Event flush timed out");
+    }
     return;
   }
-
-  char safe_level[DIAG_EVENT_LEVEL_MAX_LEN + 1];
-  char safe_type[DIAG_EVENT_TYPE_MAX_LEN + 1];
-  char safe_msg[DIAG_EVENT_MESSAGE_MAX_LEN + 1];
-  sanitize(safe_level, sizeof(safe_level), level ? level : "INFO");
-  sanitize(safe_type, sizeof(safe_type), type ? type : "event");
-  sanitize(safe_msg, sizeof(safe_msg), message ? message : "");
-
-  ++s_seq;
-  uint32_t uptime_ms = static_cast<uint32_t>(esp_timer_get_time() / 1000ULL);
-
-  char line[320];
-  snprintf(line, sizeof(line), "%lu|%lu|%ld|%s|%s|%s",
-           static_cast<unsigned long>(s_seq),
-           static_cast<unsigned long>(uptime_ms),
-           static_cast<long>(code), safe_level, safe_type, safe_msg);
-
-  char key[8];
-  slot_key(s_head, key, sizeof(key));
-  nvs_set_str(h, key, line);
-
-  s_head = static_cast<uint8_t>((s_head + 1) % RING_SIZE);
-  if (s_count < RING_SIZE) {
-    s_count++;
-  }
-
-  persist_meta(h);
-  nvs_commit(h);
-  nvs_close(h);
-
+  if (xSemaphoreTake(s_mutex, pdMS_TO_TICKS(100)) != pdTRUE) return;
+  flush_locked();
   xSemaphoreGive(s_mutex);
 }
 
@@ -243,7 +287,7 @@ void diag_event_ring_set_enabled(bool enabled) {
   if (!s_initialized) {
     diag_event_ring_init();
   }
-  if (!s_mutex) return;
+  if (!s_initialized) return;
 
   if (xSemaphoreTake(s_mutex, pdMS_TO_TICKS(100)) != pdTRUE) return;
 
@@ -268,15 +312,8 @@ size_t diag_event_get_recent(diag_event_t* out, size_t max_events) {
   if (!s_initialized) {
     diag_event_ring_init();
   }
-  if (!s_mutex) return 0;
-
-  if (xSemaphoreTake(s_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
-    return 0;
-  }
-
-  size_t copied = collect_entries(nullptr, false, out, max_events);
-  xSemaphoreGive(s_mutex);
-  return copied;
+  if (!s_initialized) return 0;
+  return collect_entries(nullptr, false, out, max_events);
 }
 
 size_t diag_event_get_recent_by_type(const char* type, diag_event_t* out,
@@ -284,15 +321,8 @@ size_t diag_event_get_recent_by_type(const char* type, diag_event_t* out,
   if (!s_initialized) {
     diag_event_ring_init();
   }
-  if (!s_mutex) return 0;
-
-  if (xSemaphoreTake(s_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
-    return 0;
-  }
-
-  size_t copied = collect_entries(type, false, out, max_events);
-  xSemaphoreGive(s_mutex);
-  return copied;
+  if (!s_initialized) return 0;
+  return collect_entries(type, false, out, max_events);
 }
 
 size_t diag_event_get_recent_by_prefix(const char* prefix, diag_event_t* out,
@@ -300,13 +330,6 @@ size_t diag_event_get_recent_by_prefix(const char* prefix, diag_event_t* out,
   if (!s_initialized) {
     diag_event_ring_init();
   }
-  if (!s_mutex) return 0;
-
-  if (xSemaphoreTake(s_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
-    return 0;
-  }
-
-  size_t copied = collect_entries(prefix, true, out, max_events);
-  xSemaphoreGive(s_mutex);
-  return copied;
+  if (!s_initialized) return 0;
+  return collect_entries(prefix, true, out, max_events);
 }
@@ -21,8 +21,16 @@ typedef struct {
   char message[DIAG_EVENT_MESSAGE_MAX_LEN + 1];
 } diag_event_t;
 
+// Recent events live in a RAM ring and are written to NVS in batches by a
+// background task (see CONFIG_DIAG_EVENT_FLUSH_SECS), so logging never
+// waits on flash. Reads are served from RAM, which is reloaded from NVS at
+// init.
 void diag_event_ring_init(void);
 
+// Write staged events to NVS now, on the flush task's internal-RAM stack:
+// callers wait for it, up to a second. Also runs from a shutdown handler.
+void diag_event_ring_flush(void);
+
 void diag_event_ring_set_enabled(bool enabled);
 
 bool diag_event_ring_is_enabled(void);
@@ -0,0 +1,77 @@
+#include "diag_record.h"
+
+#include <string.h>
+
+namespace {
+
+void put_u32(uint8_t* p, uint32_t v) {
+  p[0] = static_cast<uint8_t>(v);
+  p[1] = static_cast<uint8_t>(v >> 8);
+  p[2] = static_cast<uint8_t>(v >> 16);
+  p[3] = static_cast<uint8_t>(v >> 24);
+}
+
+uint32_t get_u32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+         (static_cast<uint32_t>(p[2]) << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+
+size_t bounded_len(const char* s, size_t max) {
+  size_t n = 0;
+  while (n < max && s[n] != '\0') n++;
+  return n;
+}
+
+}  // namespace
+
+size_t diag_record_encode(const diag_event_t* ev, uint8_t* out,
+                          size_t out_len) {
+  const size_t level_len = bounded_len(ev->level, DIAG_EVENT_LEVEL_MAX_LEN);
+  const size_t type_len = bounded_len(ev->type, DIAG_EVENT_TYPE_MAX_LEN);
+  const size_t msg_len = bounded_len(ev->message, DIAG_EVENT_MESSAGE_MAX_LEN);
+  const size_t total = DIAG_RECORD_HEADER + level_len + type_len + msg_len;
+  if (!out || out_len < total) return 0;
+
+  out[0] = DIAG_RECORD_VERSION;
+  out[1] = static_cast<uint8_t>(level_len);
+  out[2] = static_cast<uint8_t>(type_len);
+  out[3] = static_cast<uint8_t>(msg_len);
+  put_u32(out + 4, ev->seq);
+  put_u32(out + 8, ev->uptime_ms);
+  put_u32(out + 12, static_cast<uint32_t>(ev->code));
+  uint8_t* p = out + DIAG_RECORD_HEADER;
+  memcpy(p, ev->level, level_len);
+  p += level_len;
+  memcpy(p, ev->type, type_len);
+  p += type_len;
+  memcpy(p, ev->message, msg_len);
+  return total;
+}
+
+bool diag_record_decode(const uint8_t* data, size_t len, diag_event_t* out) {
+  if (!data || len < DIAG_RECORD_HEADER || data[0] != DIAG_RECORD_VERSION) {
+    return false;
+  }
+  const size_t level_len = data[1];
+  const size_t type_len = data[2];
+  const size_t msg_len = data[3];
+  if (level_len > DIAG_EVENT_LEVEL_MAX_LEN ||
+      type_len > DIAG_EVENT_TYPE_MAX_LEN ||
+      msg_len > DIAG_EVENT_MESSAGE_MAX_LEN ||
+      len != DIAG_RECORD_HEADER + level_len + type_len + msg_len) {
+    return false;
+  }
+
+  memset(out, 0, sizeof(*out));
+  out->seq = get_u32(data + 4);
+  out->uptime_ms = get_u32(data + 8);
+  out->code = static_cast<int32_t>(get_u32(data + 12));
+  const uint8_t* p = data + DIAG_RECORD_HEADER;
+  memcpy(out->level, p, level_len);
+  p += level_len;
+  memcpy(out->type, p, type_len);
+  p += type_len;
+  memcpy(out->message, p, msg_len);
+  return true;
+}
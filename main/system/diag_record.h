@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "diag_event_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Binary form of one diag_event_t as stored in NVS:
+//
+//   0      version (1)
+//   1..3   level, type and message lengths (no NUL terminators)
+//   4..15  seq, uptime_ms, code; u32/u32/i32 little-endian
+//   16..   level, type, message bytes
+//
+// Pure encode/decode with no RTOS or ESP dependencies so it is host-testable.
+
+#define DIAG_RECORD_VERSION 1
+#define DIAG_RECORD_HEADER 16
+#define DIAG_RECORD_MAX                                   \
+  (DIAG_RECORD_HEADER + DIAG_EVENT_LEVEL_MAX_LEN +        \
+   DIAG_EVENT_TYPE_MAX_LEN + DIAG_EVENT_MESSAGE_MAX_LEN)
+
+// Returns the encoded length, 0 when out is too small. Strings longer than
+// their diag_event_t field are truncated.
+size_t diag_record_encode(const diag_event_t* ev, uint8_t* out,
+                          size_t out_len);
+
+// Returns false for a wrong version or a record whose lengths do not add up.
+bool diag_record_decode(const uint8_t* data, size_t len, diag_event_t* out);
+
+#ifdef __cplusplus
+}
+#endif
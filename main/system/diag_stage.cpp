@@ -0,0 +1,58 @@
+#include "diag_stage.h"
+
+#include <string.h>
+
+void diag_stage_init(diag_stage_t* stage, diag_event_t* slots,
+                     uint32_t last_seq) {
+  stage->slots = slots;
+  memset(stage->published, 0, sizeof(stage->published));
+  memset(slots, 0, sizeof(diag_event_t) * DIAG_STAGE_SLOTS);
+  stage->last_seq = last_seq;
+}
+
+void diag_stage_restore(diag_stage_t* stage, const diag_event_t* ev) {
+  if (ev->seq == 0 || ev->seq > stage->last_seq) return;
+  const uint32_t i = ev->seq % DIAG_STAGE_SLOTS;
+  if (stage->published[i] >= ev->seq) return;
+  stage->slots[i] = *ev;
+  stage->published[i] = ev->seq;
+}
+
+uint32_t diag_stage_push(diag_stage_t* stage, const diag_event_t* ev) {
+  const uint32_t seq =
+      __atomic_add_fetch(&stage->last_seq, 1, __ATOMIC_RELAXED);
+  const uint32_t i = seq % DIAG_STAGE_SLOTS;
+
+  // Mark the slot busy before touching it so a reader copying it concurrently
+  // sees the change.
+  __atomic_store_n(&stage->published[i], 0, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  diag_event_t* slot = &stage->slots[i];
+  *slot = *ev;
+  slot->seq = seq;
+  __atomic_store_n(&stage->published[i], seq, __ATOMIC_RELEASE);
+  return seq;
+}
+
+uint32_t diag_stage_last_seq(const diag_stage_t* stage) {
+  return __atomic_load_n(&stage->last_seq, __ATOMIC_ACQUIRE);
+}
+
+diag_stage_result_t diag_stage_get(const diag_stage_t* stage, uint32_t seq,
+                                   diag_event_t* out) {
+  const uint32_t last = diag_stage_last_seq(stage);
+  if (seq == 0 || seq > last) return DIAG_STAGE_PENDING;
+  if (last - seq >= DIAG_STAGE_SLOTS) return DIAG_STAGE_GONE;
+
+  const uint32_t i = seq % DIAG_STAGE_SLOTS;
+  const uint32_t before = __atomic_load_n(&stage->published[i],
+                                          __ATOMIC_ACQUIRE);
+  if (before != seq) {
+    return before > seq ? DIAG_STAGE_GONE : DIAG_STAGE_PENDING;
+  }
+  *out = stage->slots[i];
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  const uint32_t after =
+      __atomic_load_n(&stage->published[i], __ATOMIC_RELAXED);
+  return after == seq ? DIAG_STAGE_OK : DIAG_STAGE_GONE;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "diag_event_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Matches the number of records kept in NVS.
+#define DIAG_STAGE_SLOTS 32
+
+typedef enum {
+  DIAG_STAGE_OK = 0,
+  DIAG_STAGE_PENDING,  // not written yet (claimed, or not reached)
+  DIAG_STAGE_GONE,     // overwritten by an event SLOTS or more later
+} diag_stage_result_t;
+
+// RAM ring of the most recent diagnostic events, indexed by sequence number
+// (event seq lives in slot seq % DIAG_STAGE_SLOTS). Logging claims a seq with
+// one atomic add and never blocks; readers copy a slot and check its
+// published seq afterwards to detect a concurrent overwrite. Pure data
+// structure using compiler atomics, with no RTOS or ESP dependencies so it is
+// host-testable.
+typedef struct {
+  diag_event_t* slots;  // DIAG_STAGE_SLOTS entries, may be SPIRAM
+  uint32_t published[DIAG_STAGE_SLOTS];  // seq held by each slot, 0 = none
+  uint32_t last_seq;                     // last seq handed out
+} diag_stage_t;
+
+// slots must hold DIAG_STAGE_SLOTS events; numbering continues after
+// last_seq. Not thread safe.
+void diag_stage_init(diag_stage_t* stage, diag_event_t* slots,
+                     uint32_t last_seq);
+
+// Put back an event loaded from flash at boot, keeping its seq (which must
+// be <= last_seq). Not thread safe.
+void diag_stage_restore(diag_stage_t* stage, const diag_event_t* ev);
+
+// Store ev under the next seq, which is returned. ev->seq is ignored.
+uint32_t diag_stage_push(diag_stage_t* stage, const diag_event_t* ev);
+
+uint32_t diag_stage_last_seq(const diag_stage_t* stage);
+
+// Copy out the event with this seq.
+diag_stage_result_t diag_stage_get(const diag_stage_t* stage, uint32_t seq,
+                                   diag_event_t* out);
+
+#ifdef __cplusplus
+}
+#endif
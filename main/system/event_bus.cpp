@@ -6,82 +6,146 @@
 #include <esp_log.h>
 #include <esp_timer.h>
 #include <freertos/FreeRTOS.h>
-#include <freertos/queue.h>
 #include <freertos/semphr.h>
 #include <freertos/task.h>
 
+#include "event_ring.h"
+#include "event_routes.h"
+
 namespace {
 
 const char* TAG = "event_bus";
 
-constexpr int EVENT_QUEUE_SIZE = 32;
-constexpr int MAX_SUBSCRIBERS = 32;
-constexpr uint16_t EVENT_TYPE_CATEGORY_ALL = 0xFFFF;
+// Display events (on/off, brightness, new image) take the priority lane so a
+// burst of network events cannot delay them.
+constexpr uint32_t PRIORITY_LANE_SIZE = 8;
+constexpr uint32_t NORMAL_LANE_SIZE = 32;
+constexpr int MAX_SUBSCRIBERS = EVENT_ROUTES_MAX_SUBSCRIBERS;
 constexpr size_t DISPATCH_STACK_SIZE = 4096;
 constexpr int DISPATCH_TASK_PRIORITY = 5;
 
-struct Subscriber {
-  uint16_t event_type;
-  uint16_t category;
-  tronbyt_event_handler_t handler;
+static_assert(sizeof(tronbyt_event_t) <= EVENT_RING_ITEM_BYTES,
+              "tronbyt_event_t must fit an event_ring cell");
+
+struct Handler {
+  tronbyt_event_handler_t fn;
   void* ctx;
 };
 
 struct EventBusState {
-  QueueHandle_t queue = nullptr;
-  Subscriber subscribers[MAX_SUBSCRIBERS] = {};
-  size_t subscriber_count = 0;
+  event_ring_cell_t priority_cells[PRIORITY_LANE_SIZE] = {};
+  event_ring_cell_t normal_cells[NORMAL_LANE_SIZE] = {};
+  event_ring_t priority_lane = {};
+  event_ring_t normal_lane = {};
+
+  // Guarded by mutex; handlers[i] belongs to routes subscriber i.
+  event_routes_t routes = {};
+  Handler handlers[MAX_SUBSCRIBERS] = {};
+
   TaskHandle_t dispatch_task = nullptr;
   SemaphoreHandle_t mutex = nullptr;
+  // Held by the dispatch task while it calls handlers, so unsubscribe can
+  // wait for a call already under way.
+  SemaphoreHandle_t in_flight = nullptr;
   bool initialized = false;
+
+  // Atomic counters; the last drops slot covers types outside the table.
+  uint32_t emitted = 0;
+  uint32_t dispatched = 0;
+  uint32_t dropped = 0;
+  uint32_t drops[EVENT_ROUTES_TYPES + 1] = {};
 };
 
 EventBusState s_bus;
 
-uint16_t event_type_to_category(uint16_t type) {
-  if (type >= 100 && type < 150) return TRONBYT_EVENT_CATEGORY_SYSTEM;
-  if (type >= 150 && type < 200) return TRONBYT_EVENT_CATEGORY_NETWORK;
-  if (type >= 200 && type < 250) return TRONBYT_EVENT_CATEGORY_DISPLAY;
-  if (type >= 250 && type < 300) return TRONBYT_EVENT_CATEGORY_OTA;
-  return TRONBYT_EVENT_CATEGORY_SYSTEM;
+size_t drop_slot(uint16_t type) {
+  if (type >= EVENT_ROUTES_FIRST_TYPE &&
+      type < EVENT_ROUTES_FIRST_TYPE + EVENT_ROUTES_TYPES) {
+    return type - EVENT_ROUTES_FIRST_TYPE;
+  }
+  return EVENT_ROUTES_TYPES;
+}
+
+void dispatch(const tronbyt_event_t& event) {
+  // Copy out the matching handlers and call them without the bus lock, so a
+  // slow handler does not hold up subscribe and a handler may itself
+  // (un)subscribe. Only unsubscribe waits, on in_flight.
+  Handler matched[MAX_SUBSCRIBERS];
+  int n = 0;
+  xSemaphoreTake(s_bus.in_flight, portMAX_DELAY);
+  xSemaphoreTake(s_bus.mutex, portMAX_DELAY);
+  uint32_t mask =
+      event_routes_match(&s_bus.routes, event.type, event.category);
+  while (mask) {
+    const int i = __builtin_ctz(mask);
+    mask &= mask - 1;
+    matched[n++] = s_bus.handlers[i];
+  }
+  xSemaphoreGive(s_bus.mutex);
+
+  for (int i = 0; i < n; i++) {
+    matched[i].fn(&event, matched[i].ctx);
+  }
+  xSemaphoreGive(s_bus.in_flight);
+  __atomic_fetch_add(&s_bus.dispatched, 1, __ATOMIC_RELAXED);
 }
 
 void dispatch_task(void*) {
   tronbyt_event_t event;
 
   while (true) {
-    if (xQueueReceive(s_bus.queue, &event, portMAX_DELAY) == pdTRUE) {
-      xSemaphoreTake(s_bus.mutex, portMAX_DELAY);
-
-      for (size_t i = 0; i < s_bus.subscriber_count; i++) {
-        Subscriber& sub = s_bus.subscribers[i];
-        bool match = (sub.event_type == event.type) ||
-                     (sub.event_type == EVENT_TYPE_CATEGORY_ALL &&
-                      sub.category == event.category);
-        if (match && sub.handler) {
-          sub.handler(&event, sub.ctx);
-        }
-      }
-
-      xSemaphoreGive(s_bus.mutex);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    // Recheck the priority lane before every normal event, so a display
+    // event waits for at most one other dispatch.
+    while (event_ring_pop(&s_bus.priority_lane, &event, sizeof(event)) ||
+           event_ring_pop(&s_bus.normal_lane, &event, sizeof(event))) {
+      dispatch(event);
     }
   }
 }
 
 esp_err_t emit_internal(uint16_t event_type, tronbyt_event_t* event) {
-  if (!s_bus.initialized || !s_bus.queue || !event) {
+  if (!s_bus.initialized || !event) {
     return ESP_ERR_INVALID_STATE;
   }
 
   event->type = event_type;
   if (event->category == 0) {
-    event->category = event_type_to_category(event_type);
+    event->category = event_routes_category(event_type);
   }
   event->timestamp_ms =
       static_cast<uint32_t>(esp_timer_get_time() / 1000ULL);
 
-  return (xQueueSend(s_bus.queue, event, 0) == pdTRUE) ? ESP_OK
-                                                        : ESP_ERR_TIMEOUT;
+  event_ring_t* lane = event->category == TRONBYT_EVENT_CATEGORY_DISPLAY
+                           ? &s_bus.priority_lane
+                           : &s_bus.normal_lane;
+  if (!event_ring_push(lane, event, sizeof(*event))) {
+    __atomic_fetch_add(&s_bus.dropped, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&s_bus.drops[drop_slot(event_type)], 1,
+                       __ATOMIC_RELAXED);
+    return ESP_ERR_TIMEOUT;
+  }
+  __atomic_fetch_add(&s_bus.emitted, 1, __ATOMIC_RELAXED);
+  xTaskNotifyGive(s_bus.dispatch_task);
+  return ESP_OK;
+}
+
+esp_err_t add_subscriber(uint16_t event_type, uint16_t category,
+                         tronbyt_event_handler_t handler, void* ctx) {
+  if (!s_bus.initialized || !handler) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  xSemaphoreTake(s_bus.mutex, portMAX_DELAY);
+  const int i = event_routes_add(&s_bus.routes, event_type, category);
+  if (i < 0) {
+    xSemaphoreGive(s_bus.mutex);
+    ESP_LOGE(TAG, "Max subscribers reached (%d)", MAX_SUBSCRIBERS);
+    return ESP_ERR_NO_MEM;
+  }
+  s_bus.handlers[i] = {handler, ctx};
+  xSemaphoreGive(s_bus.mutex);
+  return ESP_OK;
 }
 
 }  // namespace
@@ -91,15 +155,18 @@ esp_err_t event_bus_init(void) {
     return ESP_OK;
   }
 
-  s_bus.queue = xQueueCreate(EVENT_QUEUE_SIZE, sizeof(tronbyt_event_t));
-  if (!s_bus.queue) {
-    return ESP_ERR_NO_MEM;
-  }
+  event_ring_init(&s_bus.priority_lane, s_bus.priority_cells,
+                  PRIORITY_LANE_SIZE);
+  event_ring_init(&s_bus.normal_lane, s_bus.normal_cells, NORMAL_LANE_SIZE);
+  event_routes_init(&s_bus.routes);
 
   s_bus.mutex = xSemaphoreCreateMutex();
-  if (!s_bus.mutex) {
-    vQueueDelete(s_bus.queue);
-    s_bus.queue = nullptr;
+  s_bus.in_flight = xSemaphoreCreateMutex();
+  if (!s_bus.mutex || !s_bus.in_flight) {
+    if (s_bus.mutex) vSemaphoreDelete(s_bus.mutex);
+    if (s_bus.in_flight) vSemaphoreDelete(s_bus.in_flight);
+    s_bus.mutex = nullptr;
+    s_bus.in_flight = nullptr;
     return ESP_ERR_NO_MEM;
   }
 
@@ -116,13 +183,12 @@ esp_err_t event_bus_init(void) {
 
   if (rc != pdPASS) {
     vSemaphoreDelete(s_bus.mutex);
+    vSemaphoreDelete(s_bus.in_flight);
     s_bus.mutex = nullptr;
-    vQueueDelete(s_bus.queue);
-    s_bus.queue = nullptr;
+    s_bus.in_flight = nullptr;
     return ESP_ERR_NO_MEM;
   }
 
-  s_bus.subscriber_count = 0;
   s_bus.initialized = true;
   ESP_LOGI(TAG, "Event bus initialized");
   return ESP_OK;
@@ -130,49 +196,14 @@ esp_err_t event_bus_init(void) {
 
 esp_err_t event_bus_subscribe(uint16_t event_type,
                               tronbyt_event_handler_t handler, void* ctx) {
-  if (!s_bus.initialized || !handler) {
-    return ESP_ERR_INVALID_STATE;
-  }
-
-  xSemaphoreTake(s_bus.mutex, portMAX_DELAY);
-  if (s_bus.subscriber_count >= MAX_SUBSCRIBERS) {
-    xSemaphoreGive(s_bus.mutex);
-    ESP_LOGE(TAG, "Max subscribers reached (%d)", MAX_SUBSCRIBERS);
-    return ESP_ERR_NO_MEM;
-  }
-
-  Subscriber& sub = s_bus.subscribers[s_bus.subscriber_count++];
-  sub.event_type = event_type;
-  sub.category = event_type_to_category(event_type);
-  sub.handler = handler;
-  sub.ctx = ctx;
-
-  xSemaphoreGive(s_bus.mutex);
-  return ESP_OK;
+  return add_subscriber(event_type, event_routes_category(event_type),
+                        handler, ctx);
 }
 
 esp_err_t event_bus_subscribe_category(uint16_t category,
                                        tronbyt_event_handler_t handler,
                                        void* ctx) {
-  if (!s_bus.initialized || !handler) {
-    return ESP_ERR_INVALID_STATE;
-  }
-
-  xSemaphoreTake(s_bus.mutex, portMAX_DELAY);
-  if (s_bus.subscriber_count >= MAX_SUBSCRIBERS) {
-    xSemaphoreGive(s_bus.mutex);
-    ESP_LOGE(TAG, "Max subscribers reached (%d)", MAX_SUBSCRIBERS);
-    return ESP_ERR_NO_MEM;
-  }
-
-  Subscriber& sub = s_bus.subscribers[s_bus.subscriber_count++];
-  sub.event_type = EVENT_TYPE_CATEGORY_ALL;
-  sub.category = category;
-  sub.handler = handler;
-  sub.ctx = ctx;
-
-  xSemaphoreGive(s_bus.mutex);
-  return ESP_OK;
+  return add_subscriber(EVENT_ROUTES_ANY_TYPE, category, handler, ctx);
 }
 
 void event_bus_unsubscribe(tronbyt_event_handler_t handler) {
@@ -181,16 +212,22 @@ void event_bus_unsubscribe(tronbyt_event_handler_t handler) {
   }
 
   xSemaphoreTake(s_bus.mutex, portMAX_DELAY);
-  for (size_t i = 0; i < s_bus.subscriber_count; i++) {
-    if (s_bus.subscribers[i].handler == handler) {
-      for (size_t j = i; j < s_bus.subscriber_count - 1; j++) {
-        s_bus.subscribers[j] = s_bus.subscribers[j + 1];
-      }
-      s_bus.subscriber_count--;
-      break;
+  // Every subscription of the handler, not just the first.
+  for (int i = s_bus.routes.count - 1; i >= 0; i--) {
+    if (s_bus.handlers[i].fn != handler) continue;
+    for (int j = i; j < s_bus.routes.count - 1; j++) {
+      s_bus.handlers[j] = s_bus.handlers[j + 1];
     }
+    event_routes_remove(&s_bus.routes, i);
   }
   xSemaphoreGive(s_bus.mutex);
+
+  // A dispatch that copied the handler before its removal may still be
+  // calling it; wait that out. From a handler itself, that would deadlock.
+  if (xTaskGetCurrentTaskHandle() != s_bus.dispatch_task) {
+    xSemaphoreTake(s_bus.in_flight, portMAX_DELAY);
+    xSemaphoreGive(s_bus.in_flight);
+  }
 }
 
 esp_err_t event_bus_emit(uint16_t event_type, const tronbyt_event_t* event) {
@@ -218,3 +255,21 @@ esp_err_t event_bus_emit_ptr(uint16_t event_type, void* ptr) {
   event.payload.ptr = ptr;
   return emit_internal(event_type, &event);
 }
+
+void event_bus_get_stats(event_bus_stats_t* out) {
+  if (!out) return;
+  out->subscribers = 0;
+  if (s_bus.initialized) {
+    xSemaphoreTake(s_bus.mutex, portMAX_DELAY);
+    out->subscribers = static_cast<uint32_t>(s_bus.routes.count);
+    xSemaphoreGive(s_bus.mutex);
+  }
+  out->emitted = __atomic_load_n(&s_bus.emitted, __ATOMIC_RELAXED);
+  out->dispatched = __atomic_load_n(&s_bus.dispatched, __ATOMIC_RELAXED);
+  out->dropped = __atomic_load_n(&s_bus.dropped, __ATOMIC_RELAXED);
+}
+
+uint32_t event_bus_dropped(uint16_t event_type) {
+  return __atomic_load_n(&s_bus.drops[drop_slot(event_type)],
+                         __ATOMIC_RELAXED);
+}
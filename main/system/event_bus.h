@@ -30,6 +30,7 @@ typedef enum {
   TRONBYT_EVENT_CONNECTIVITY_CHANGED,
   TRONBYT_EVENT_OTA_SUBSTATE_CHANGED,
   TRONBYT_EVENT_TIME_SYNCED,
+  TRONBYT_EVENT_TIMEZONE_CHANGED,  // TZ applied; the clock may not be synced
 
   // Network events (150–199)
   TRONBYT_EVENT_WIFI_CONNECTED = 150,
@@ -75,7 +76,7 @@ typedef void (*tronbyt_event_handler_t)(const tronbyt_event_t* event,
 // API
 // ---------------------------------------------------------------------------
 
-/// Initialize the event bus (queue + dispatch task). Safe to call multiple
+/// Initialize the event bus (lanes + dispatch task). Safe to call multiple
 /// times; subsequent calls are no-ops.
 esp_err_t event_bus_init(void);
 
@@ -88,10 +89,16 @@ esp_err_t event_bus_subscribe_category(uint16_t category,
                                        tronbyt_event_handler_t handler,
                                        void* ctx);
 
-/// Remove a handler from all subscriptions.
+/// Remove a handler from all subscriptions. Returns once no dispatch can
+/// call it any more, waiting for a call already under way, so the caller may
+/// then tear down what the handler uses. Must not be called while holding a
+/// lock some handler takes. Called from a handler, it returns at once and
+/// only later dispatches skip the handler.
 void event_bus_unsubscribe(tronbyt_event_handler_t handler);
 
-/// Emit a fully-constructed event. Non-blocking.
+/// Emit a fully-constructed event. Non-blocking and lock-free; display
+/// events go through a priority lane that is drained first. Returns
+/// ESP_ERR_TIMEOUT when the event's lane is full and it was dropped.
 esp_err_t event_bus_emit(uint16_t event_type, const tronbyt_event_t* event);
 
 /// Emit an event with no payload. Non-blocking.
@@ -103,6 +110,18 @@ esp_err_t event_bus_emit_i32(uint16_t event_type, int32_t value);
 /// Emit an event with a pointer payload. Non-blocking.
 esp_err_t event_bus_emit_ptr(uint16_t event_type, void* ptr);
 
+typedef struct {
+  uint32_t subscribers;
+  uint32_t emitted;     // accepted into a lane
+  uint32_t dispatched;  // taken off a lane and delivered
+  uint32_t dropped;     // lane full, all types
+} event_bus_stats_t;
+
+void event_bus_get_stats(event_bus_stats_t* out);
+
+/// Events of this type dropped because their lane was full.
+uint32_t event_bus_dropped(uint16_t event_type);
+
 #ifdef __cplusplus
 }
 #endif
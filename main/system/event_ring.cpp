@@ -0,0 +1,64 @@
+#include "event_ring.h"
+
+#include <string.h>
+
+bool event_ring_init(event_ring_t* ring, event_ring_cell_t* cells,
+                     uint32_t capacity) {
+  if (!ring || !cells || capacity < 2 || capacity > (1u << 30) ||
+      (capacity & (capacity - 1)) != 0) {
+    return false;
+  }
+  ring->cells = cells;
+  ring->mask = capacity - 1;
+  for (uint32_t i = 0; i < capacity; i++) {
+    cells[i].seq = i;
+  }
+  ring->enqueue_pos = 0;
+  ring->dequeue_pos = 0;
+  return true;
+}
+
+bool event_ring_push(event_ring_t* ring, const void* item, size_t len) {
+  if (len > EVENT_RING_ITEM_BYTES) return false;
+
+  uint32_t pos = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_RELAXED);
+  event_ring_cell_t* cell;
+  while (true) {
+    cell = &ring->cells[pos & ring->mask];
+    const uint32_t seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+    const int32_t diff = static_cast<int32_t>(seq - pos);
+    if (diff == 0) {
+      // The cell is free for ticket pos; claim it.
+      if (__atomic_compare_exchange_n(&ring->enqueue_pos, &pos, pos + 1, true,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        break;
+      }
+      // pos now holds the current ticket; retry with it.
+    } else if (diff < 0) {
+      // Still holds the item from one lap ago: full.
+      return false;
+    } else {
+      // Another producer took this ticket.
+      pos = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_RELAXED);
+    }
+  }
+
+  memcpy(cell->item, item, len);
+  __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+bool event_ring_pop(event_ring_t* ring, void* out, size_t len) {
+  if (len > EVENT_RING_ITEM_BYTES) return false;
+
+  const uint32_t pos = ring->dequeue_pos;
+  event_ring_cell_t* cell = &ring->cells[pos & ring->mask];
+  const uint32_t seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+  if (static_cast<int32_t>(seq - (pos + 1)) < 0) return false;
+
+  memcpy(out, cell->item, len);
+  // Free the cell for the ticket one lap ahead.
+  __atomic_store_n(&cell->seq, pos + ring->mask + 1, __ATOMIC_RELEASE);
+  ring->dequeue_pos = pos + 1;
+  return true;
+}
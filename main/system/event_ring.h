@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Holds one tronbyt_event_t (16 bytes with 64-bit pointers, 12 on the ESP32).
+#define EVENT_RING_ITEM_BYTES 16
+
+typedef struct {
+  uint32_t seq;
+  uint8_t item[EVENT_RING_ITEM_BYTES];
+} event_ring_cell_t;
+
+// Bounded lock-free queue for many producers and ONE consumer. Each cell
+// carries a sequence number that tells a producer whether the cell is free
+// for its ticket and the consumer whether it has been filled, so producers
+// only contend on one compare-and-swap and never block or take a lock.
+// Pure data structure using compiler atomics, with no RTOS or ESP
+// dependencies so it is host-testable.
+typedef struct {
+  event_ring_cell_t* cells;
+  uint32_t mask;         // capacity - 1
+  uint32_t enqueue_pos;  // shared by producers
+  uint32_t dequeue_pos;  // consumer only
+} event_ring_t;
+
+// cells must hold capacity entries, a power of two (2..2^30). Not thread
+// safe; initialize before the ring is shared.
+bool event_ring_init(event_ring_t* ring, event_ring_cell_t* cells,
+                     uint32_t capacity);
+
+// Copy len (<= EVENT_RING_ITEM_BYTES) bytes in. Safe from any number of
+// tasks at once. Returns false when the ring is full.
+bool event_ring_push(event_ring_t* ring, const void* item, size_t len);
+
+// Copy the oldest item into out (len bytes). Consumer only. Returns false
+// when empty, including while the producer of the oldest item is still
+// copying it in.
+bool event_ring_pop(event_ring_t* ring, void* out, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,70 @@
+#include "event_routes.h"
+
+#include <string.h>
+
+namespace {
+
+bool type_indexed(uint16_t event_type) {
+  return event_type >= EVENT_ROUTES_FIRST_TYPE &&
+         event_type < EVENT_ROUTES_FIRST_TYPE + EVENT_ROUTES_TYPES;
+}
+
+void rebuild(event_routes_t* r) {
+  memset(r->by_type, 0, sizeof(r->by_type));
+  memset(r->by_category, 0, sizeof(r->by_category));
+  for (int i = 0; i < r->count; i++) {
+    const uint32_t bit = 1u << i;
+    if (r->event_type[i] == EVENT_ROUTES_ANY_TYPE) {
+      if (r->category[i] < EVENT_ROUTES_CATEGORIES) {
+        r->by_category[r->category[i]] |= bit;
+      }
+    } else if (type_indexed(r->event_type[i])) {
+      r->by_type[r->event_type[i] - EVENT_ROUTES_FIRST_TYPE] |= bit;
+    }
+  }
+}
+
+}  // namespace
+
+uint16_t event_routes_category(uint16_t event_type) {
+  // Values match tronbyt_event_category_t.
+  if (event_type >= 150 && event_type < 200) return 2;  // NETWORK
+  if (event_type >= 200 && event_type < 250) return 3;  // DISPLAY
+  if (event_type >= 250 && event_type < 300) return 4;  // OTA
+  return 1;                                             // SYSTEM
+}
+
+void event_routes_init(event_routes_t* r) { memset(r, 0, sizeof(*r)); }
+
+int event_routes_add(event_routes_t* r, uint16_t event_type,
+                     uint16_t category) {
+  if (r->count >= EVENT_ROUTES_MAX_SUBSCRIBERS) return -1;
+  const int i = r->count++;
+  r->event_type[i] = event_type;
+  r->category[i] = category;
+  rebuild(r);
+  return i;
+}
+
+void event_routes_remove(event_routes_t* r, int index) {
+  if (index < 0 || index >= r->count) return;
+  for (int i = index; i < r->count - 1; i++) {
+    r->event_type[i] = r->event_type[i + 1];
+    r->category[i] = r->category[i + 1];
+  }
+  r->count--;
+  rebuild(r);
+}
+
+uint32_t event_routes_match(const event_routes_t* r, uint16_t event_type,
+                            uint16_t category) {
+  uint32_t mask =
+      category < EVENT_ROUTES_CATEGORIES ? r->by_category[category] : 0;
+  if (type_indexed(event_type)) {
+    return mask | r->by_type[event_type - EVENT_ROUTES_FIRST_TYPE];
+  }
+  for (int i = 0; i < r->count; i++) {
+    if (r->event_type[i] == event_type) mask |= 1u << i;
+  }
+  return mask;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One bit per subscriber in a uint32_t mask.
+#define EVENT_ROUTES_MAX_SUBSCRIBERS 32
+// Event types 100..299 (tronbyt_event_type_t) are routed through a table;
+// others fall back to a scan.
+#define EVENT_ROUTES_FIRST_TYPE 100
+#define EVENT_ROUTES_TYPES 200
+#define EVENT_ROUTES_CATEGORIES 8
+// Subscriber event_type for a whole-category subscription.
+#define EVENT_ROUTES_ANY_TYPE 0xFFFF
+
+// Which subscribers an event goes to, precomputed per event type and per
+// category whenever the subscriber list changes, so routing an event is a
+// table lookup. Pure bookkeeping with no RTOS or ESP dependencies so it is
+// host-testable; NOT thread safe (event_bus.cpp guards it with a mutex).
+typedef struct {
+  uint16_t event_type[EVENT_ROUTES_MAX_SUBSCRIBERS];  // or ANY_TYPE
+  uint16_t category[EVENT_ROUTES_MAX_SUBSCRIBERS];
+  int count;
+  uint32_t by_type[EVENT_ROUTES_TYPES];
+  uint32_t by_category[EVENT_ROUTES_CATEGORIES];
+} event_routes_t;
+
+// Default category of an event type (tronbyt_event_category_t).
+uint16_t event_routes_category(uint16_t event_type);
+
+void event_routes_init(event_routes_t* r);
+
+// Add a subscriber to one event type, or with EVENT_ROUTES_ANY_TYPE to every
+// event of category. Returns its index (its bit in the masks), -1 when full.
+int event_routes_add(event_routes_t* r, uint16_t event_type,
+                     uint16_t category);
+
+// Remove subscriber index; those after it move down one index.
+void event_routes_remove(event_routes_t* r, int index);
+
+// Subscribers for an event of this type and category.
+uint32_t event_routes_match(const event_routes_t* r, uint16_t event_type,
+                            uint16_t category);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,112 @@
+#include "log_ring.h"
+
+#include <string.h>
+
+namespace {
+
+// Header word in front of every record: bytes the record spans (header and
+// padding included) in the low 16 bits, used payload bytes above them.
+constexpr uint32_t READY = 1u << 31;
+constexpr uint32_t PAD = 1u << 30;
+constexpr uint32_t HEADER = 4;
+
+uint32_t* header_at(log_ring_t* ring, uint32_t pos) {
+  return reinterpret_cast<uint32_t*>(ring->buf + (pos & (ring->size - 1)));
+}
+
+uint32_t span_of(uint32_t hdr) { return hdr & 0xFFFF; }
+
+}  // namespace
+
+bool log_ring_init(log_ring_t* ring, uint8_t* buf, uint32_t size) {
+  if (!ring || !buf || size < 64 || size > LOG_RING_MAX_SIZE ||
+      (size & (size - 1)) != 0 || (reinterpret_cast<uintptr_t>(buf) & 3)) {
+    return false;
+  }
+  memset(buf, 0, size);
+  ring->buf = buf;
+  ring->size = size;
+  ring->head = 0;
+  ring->tail = 0;
+  return true;
+}
+
+uint8_t* log_ring_reserve(log_ring_t* ring, size_t len) {
+  if (len == 0 || len > LOG_RING_MAX_RECORD) return nullptr;
+  const uint32_t span = HEADER + ((static_cast<uint32_t>(len) + 3) & ~3u);
+  if (span > ring->size / 2) return nullptr;
+
+  uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+  uint32_t pad;
+  while (true) {
+    const uint32_t offset = head & (ring->size - 1);
+    pad = offset + span > ring->size ? ring->size - offset : 0;
+    const uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    if (head + pad + span - tail > ring->size) return nullptr;
+    if (__atomic_compare_exchange_n(&ring->head, &head, head + pad + span,
+                                    true, __ATOMIC_RELAXED,
+                                    __ATOMIC_RELAXED)) {
+      break;
+    }
+  }
+
+  if (pad) {
+    // Nothing is written in the skipped tail; publish it at once.
+    __atomic_store_n(header_at(ring, head), READY | PAD | pad,
+                     __ATOMIC_RELEASE);
+    head += pad;
+  }
+  // Stash the span until commit; READY stays clear so the consumer waits.
+  __atomic_store_n(header_at(ring, head), span, __ATOMIC_RELAXED);
+  return reinterpret_cast<uint8_t*>(header_at(ring, head)) + HEADER;
+}
+
+void log_ring_commit(log_ring_t* ring, uint8_t* record, size_t used) {
+  uint32_t* hdr = reinterpret_cast<uint32_t*>(record - HEADER);
+  uint32_t span = span_of(*hdr);
+  if (used > span - HEADER) used = span - HEADER;
+
+  const uint32_t fit = HEADER + ((static_cast<uint32_t>(used) + 3) & ~3u);
+  if (fit < span) {
+    // An unpublished record keeps the consumer behind it, so head is within
+    // one ring of it and matches its end only if nothing was claimed since.
+    const uint32_t mask = ring->size - 1;
+    const uint32_t end =
+        static_cast<uint32_t>(reinterpret_cast<uint8_t*>(hdr) - ring->buf) +
+        span;
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    if ((head & mask) == (end & mask)) {
+      // Zero the tail first: the next record's header goes there.
+      memset(reinterpret_cast<uint8_t*>(hdr) + fit, 0, span - fit);
+      if (__atomic_compare_exchange_n(&ring->head, &head, head - (span - fit),
+                                      false, __ATOMIC_RELAXED,
+                                      __ATOMIC_RELAXED)) {
+        span = fit;
+      }
+    }
+  }
+  __atomic_store_n(hdr, READY | (static_cast<uint32_t>(used) << 16) | span,
+                   __ATOMIC_RELEASE);
+}
+
+const uint8_t* log_ring_peek(log_ring_t* ring, size_t* len) {
+  while (true) {
+    uint32_t* hdr = header_at(ring, ring->tail);
+    const uint32_t word = __atomic_load_n(hdr, __ATOMIC_ACQUIRE);
+    if (!(word & READY)) return nullptr;
+    if (word & PAD) {
+      log_ring_release(ring);
+      continue;
+    }
+    *len = (word & ~(READY | PAD)) >> 16;
+    return reinterpret_cast<const uint8_t*>(hdr) + HEADER;
+  }
+}
+
+void log_ring_release(log_ring_t* ring) {
+  uint32_t* hdr = header_at(ring, ring->tail);
+  const uint32_t span = span_of(__atomic_load_n(hdr, __ATOMIC_ACQUIRE));
+  // Zero the whole record so stale payload can never read as a header.
+  memset(hdr, 0, span);
+  __atomic_store_n(&ring->tail, ring->tail + span, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Largest record payload; records are padded to 4 bytes plus a 4-byte header.
+#define LOG_RING_MAX_RECORD 1024
+#define LOG_RING_MAX_SIZE 32768
+
+// Byte ring of variable-length records for many producers and ONE consumer.
+// A producer claims space with one compare-and-swap, fills it in place and
+// commits it; the consumer reads records in claim order straight out of the
+// buffer and stops at the first one not yet committed. A record that would
+// run past the end of the buffer starts at the beginning instead, behind a
+// padding record. Pure data structure using compiler atomics, with no RTOS
+// or ESP dependencies so it is host-testable.
+typedef struct {
+  uint8_t* buf;   // 4-byte aligned, zeroed by log_ring_init
+  uint32_t size;  // power of two, 64..LOG_RING_MAX_SIZE
+  uint32_t head;  // bytes ever claimed; producers
+  uint32_t tail;  // bytes ever released; consumer
+} log_ring_t;
+
+bool log_ring_init(log_ring_t* ring, uint8_t* buf, uint32_t size);
+
+// Claim len bytes (1..LOG_RING_MAX_RECORD). Returns where to write them, or
+// NULL when the ring has no room. Must be followed by log_ring_commit.
+uint8_t* log_ring_reserve(log_ring_t* ring, size_t len);
+
+// Publish a reserved record with its first used bytes (<= the reserved len).
+// While it is still the newest claim, the unused tail goes back to the ring,
+// so a producer can reserve the most it might write and format in place.
+void log_ring_commit(log_ring_t* ring, uint8_t* record, size_t used);
+
+// Consumer: the oldest committed record, NULL when there is none yet. It
+// stays valid until log_ring_release.
+const uint8_t* log_ring_peek(log_ring_t* ring, size_t* len);
+
+// Consumer: drop the record returned by log_ring_peek.
+void log_ring_release(log_ring_t* ring);
+
+#ifdef __cplusplus
+}
+#endif
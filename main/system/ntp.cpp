@@ -92,6 +92,8 @@ void apply_timezone_local() {
   if (!posix) posix = "UTC0";
   setenv("TZ", posix, 1);
   tzset();
+  // Local time moved; says nothing about whether the clock is synced.
+  event_bus_emit_simple(TRONBYT_EVENT_TIMEZONE_CHANGED);
 }
 
 void apply_timezone_from_name(const char* name) {
@@ -247,7 +249,7 @@ void time_sync_callback(struct timeval* tv) {
   ESP_LOGI(TAG, "Time synchronized: %s", buf);
 
   // Let time-dependent subsystems (e.g. quiet hours) re-evaluate against a
-  // now-valid wall clock instead of waiting for their own periodic tick.
+  // now-valid wall clock and re-plan their timers.
   event_bus_emit_simple(TRONBYT_EVENT_TIME_SYNCED);
 }
 
@@ -1,5 +1,7 @@
 #include "quiet_hours.h"
 
+#include <sys/time.h>
+
 #include <atomic>
 #include <cstring>
 #include <ctime>
@@ -20,11 +22,6 @@ const char* TAG = "quiet_hours";
 constexpr const char* NVS_NAMESPACE = "quiet_hours";
 constexpr const char* NVS_KEY = "windows";
 
-// How often the evaluator re-checks the wall clock against the windows. A
-// half-minute cadence keeps the enter/exit edges within one tick of the minute
-// boundary the windows are defined on, without meaningful power cost.
-constexpr int64_t EVAL_PERIOD_US = 30 * 1000 * 1000;
-
 // bit0 = Sunday .. bit6 = Saturday.
 constexpr uint8_t ALL_DAYS_MASK = 0x7F;
 
@@ -42,6 +39,7 @@ std::atomic<bool> s_active{false};
 // window evaluation so either source can blank the display.
 std::atomic<bool> s_remote_active{false};
 SemaphoreHandle_t s_mutex = nullptr;
+// One-shot, armed for the next window edge; guarded by s_mutex.
 esp_timer_handle_t s_timer = nullptr;
 
 void load_from_nvs() {
@@ -89,26 +87,43 @@ void persist_locked() {
 
 void eval_timer_cb(void*) { quiet_hours_reevaluate(); }
 
+// Arm the evaluator for the instant `next` (0: none), measured from `now`.
+// Caller holds s_mutex, so a racing evaluation cannot leave the timer set for
+// windows that were just replaced.
+void schedule_locked(time_t next, const struct timeval& now) {
+  if (!s_timer) return;
+  esp_timer_stop(s_timer);
+  if (next == 0) return;
+  const int64_t delay_us =
+      static_cast<int64_t>(next - now.tv_sec) * 1000000 - now.tv_usec;
+  // Firing a little early is harmless: the evaluation re-arms for the same
+  // edge a moment later.
+  esp_timer_start_once(s_timer, delay_us > 0 ? delay_us : 1);
+}
+
 }  // namespace
 
 void quiet_hours_reevaluate(void) {
   bool local_active = false;
 
   // Fail open until the clock is real. Without a synced clock the local time is
-  // meaningless and could blank the display at the wrong moment.
-  if (ntp_is_synced()) {
-    time_t now = time(nullptr);
-    struct tm local = {};
-    localtime_r(&now, &local);
-
-    quiet_window_t snapshot[QUIET_HOURS_MAX_WINDOWS];
-    size_t count = 0;
-    if (s_mutex && xSemaphoreTake(s_mutex, portMAX_DELAY) == pdTRUE) {
-      count = s_count;
-      memcpy(snapshot, s_windows, sizeof(snapshot));
-      xSemaphoreGive(s_mutex);
+  // meaningless and could blank the display at the wrong moment. Nothing is
+  // scheduled meanwhile; the time-sync event evaluates again.
+  const bool synced = ntp_is_synced();
+  if (s_mutex && xSemaphoreTake(s_mutex, portMAX_DELAY) == pdTRUE) {
+    time_t next = 0;
+    struct timeval tv = {};
+    if (synced) {
+      gettimeofday(&tv, nullptr);
+      const time_t now = tv.tv_sec;
+      struct tm local = {};
+      localtime_r(&now, &local);
+      local_active = quiet_hours_any_active(s_windows, s_count, &local);
+      // Rather than polling, sleep until the next edge.
+      next = quiet_hours_next_transition(s_windows, s_count, now);
     }
-    local_active = quiet_hours_any_active(snapshot, count, &local);
+    schedule_locked(next, tv);
+    xSemaphoreGive(s_mutex);
   }
 
   // The server signal does not depend on the local clock, so it counts even
@@ -268,23 +283,25 @@ void quiet_hours_init(void) {
 
   load_from_nvs();
 
-  // Re-evaluate the moment the clock becomes valid so a device that booted
-  // inside a quiet window blanks as soon as time syncs.
-  event_bus_subscribe(TRONBYT_EVENT_TIME_SYNCED,
-                      [](const tronbyt_event_t*, void*) {
-                        quiet_hours_reevaluate();
-                      },
-                      nullptr);
-
   esp_timer_create_args_t args = {};
   args.callback = eval_timer_cb;
   args.name = "quiet_eval";
-  if (esp_timer_create(&args, &s_timer) == ESP_OK) {
-    esp_timer_start_periodic(s_timer, EVAL_PERIOD_US);
-  } else {
+  if (esp_timer_create(&args, &s_timer) != ESP_OK) {
     ESP_LOGE(TAG, "Failed to create evaluator timer");
+    s_timer = nullptr;
   }
 
+  // Re-evaluate the moment the clock becomes valid so a device that booted
+  // inside a quiet window blanks as soon as time syncs. Every later sync and
+  // timezone change re-plans the next edge against the corrected clock, and
+  // a dropped link fails open as the clock stops counting as synced.
+  auto reevaluate = [](const tronbyt_event_t*, void*) {
+    quiet_hours_reevaluate();
+  };
+  event_bus_subscribe(TRONBYT_EVENT_TIME_SYNCED, reevaluate, nullptr);
+  event_bus_subscribe(TRONBYT_EVENT_TIMEZONE_CHANGED, reevaluate, nullptr);
+  event_bus_subscribe(TRONBYT_EVENT_WIFI_DISCONNECTED, reevaluate, nullptr);
+
   quiet_hours_reevaluate();
   ESP_LOGI(TAG, "Quiet hours initialized");
 }
@@ -12,10 +12,11 @@ extern "C" {
 #endif
 
 // Start the quiet-hours subsystem: load stored windows from NVS, run an initial
-// evaluation, and start the periodic evaluator. Must be called after the event
-// bus, display, scheduler, and NTP have been initialized, because the initial
-// evaluation may already publish a display-off event that the scheduler acts
-// on. Safe to call once.
+// evaluation, and arm the evaluator for the next window edge (see
+// quiet_hours_next_transition), so nothing runs between edges. Must be called
+// after the event bus, display, scheduler, and NTP have been initialized,
+// because the initial evaluation may already publish a display-off event that
+// the scheduler acts on. Safe to call once.
 void quiet_hours_init(void);
 
 // True while the device is inside an enabled quiet window. Fails open (returns
@@ -30,8 +31,9 @@ size_t quiet_hours_get_windows(quiet_window_t* out, size_t max);
 // capped at QUIET_HOURS_MAX_WINDOWS), persist to NVS, and re-evaluate now.
 void quiet_hours_set_windows(const quiet_window_t* windows, size_t count);
 
-// Force an immediate re-evaluation. Used on config change and time sync so the
-// display responds without waiting for the next periodic tick.
+// Force an immediate re-evaluation, which also re-plans the next edge. Used on
+// config change, time sync and timezone change so the display responds at
+// once and the next edge is planned against the current clock and zone.
 void quiet_hours_reevaluate(void);
 
 // Report the server-driven quiet signal (the Tronbyt-Quiet header on the HTTP
@@ -2,8 +2,80 @@
 
 namespace {
 
+constexpr int HORIZON_DAYS = 8;
+constexpr time_t DAY_SECS = 24 * 60 * 60;
+
 int minutes_of_day(int hour, int min) { return hour * 60 + min; }
 
+bool active_at(const quiet_window_t* windows, size_t count, time_t t) {
+  struct tm local = {};
+  localtime_r(&t, &local);
+  return quiet_hours_any_active(windows, count, &local);
+}
+
+bool is_dst(time_t t) {
+  struct tm local = {};
+  localtime_r(&t, &local);
+  return local.tm_isdst > 0;
+}
+
+// Keeps the earliest candidate after now at which the state is not `from`.
+struct Search {
+  const quiet_window_t* windows;
+  size_t count;
+  time_t now;
+  bool from;
+  time_t best;
+
+  void offer(time_t t) {
+    if (t <= now || (best != 0 && t >= best)) return;
+    if (active_at(windows, count, t) != from) best = t;
+  }
+};
+
+// Every instant from `base`'s date onwards at which the wall clock reads
+// hour:min. mktime picks one reading of a time the DST shift repeats, so ask
+// for both the standard and the daylight one and keep those that exist.
+void offer_wall_time(Search* s, const struct tm& base, int hour, int min) {
+  for (int day = 0; day <= HORIZON_DAYS; day++) {
+    for (int dst = 0; dst <= 1; dst++) {
+      struct tm want = base;
+      want.tm_mday += day;
+      want.tm_hour = hour;
+      want.tm_min = min;
+      want.tm_sec = 0;
+      want.tm_isdst = dst;
+      const time_t t = mktime(&want);
+      if (t == static_cast<time_t>(-1)) continue;
+      struct tm got = {};
+      localtime_r(&t, &got);
+      if (got.tm_hour == hour && got.tm_min == min && got.tm_sec == 0) {
+        s->offer(t);
+      }
+    }
+  }
+}
+
+// The instants the UTC offset changes: the wall clock jumps, possibly over a
+// window edge that then never appears on it.
+void offer_dst_shifts(Search* s) {
+  for (int day = 0; day < HORIZON_DAYS; day++) {
+    time_t lo = s->now + day * DAY_SECS;
+    time_t hi = lo + DAY_SECS;
+    const bool dst = is_dst(lo);
+    if (is_dst(hi) == dst) continue;
+    while (hi - lo > 1) {
+      const time_t mid = lo + (hi - lo) / 2;
+      if (is_dst(mid) == dst) {
+        lo = mid;
+      } else {
+        hi = mid;
+      }
+    }
+    s->offer(hi);
+  }
+}
+
 }  // namespace
 
 bool quiet_window_contains(const quiet_window_t* w, const struct tm* local) {
@@ -44,3 +116,24 @@ bool quiet_hours_any_active(const quiet_window_t* windows, size_t count,
   }
   return false;
 }
+
+time_t quiet_hours_next_transition(const quiet_window_t* windows, size_t count,
+                                   time_t now) {
+  if (!windows) return 0;
+
+  // The state only changes where the wall clock reaches a window edge or
+  // jumps, so the earliest such instant with a different state is the edge.
+  Search s = {windows, count, now, active_at(windows, count, now), 0};
+  struct tm base = {};
+  localtime_r(&now, &base);
+  bool any = false;
+  for (size_t i = 0; i < count; ++i) {
+    const quiet_window_t& w = windows[i];
+    if (!w.enabled || w.day_mask == 0) continue;
+    any = true;
+    offer_wall_time(&s, base, w.start_hour, w.start_min);
+    offer_wall_time(&s, base, w.end_hour, w.end_min);
+  }
+  if (any) offer_dst_shifts(&s);
+  return s.best;
+}
@@ -37,6 +37,15 @@ bool quiet_window_contains(const quiet_window_t* w, const struct tm* local);
 bool quiet_hours_any_active(const quiet_window_t* windows, size_t count,
                             const struct tm* local);
 
+// The first instant after `now` at which quiet_hours_any_active changes, or 0
+// when it never does. Local time follows the TZ in effect (localtime_r and
+// mktime), so a DST shift that jumps into or out of a window is an edge of
+// its own and a wall-clock time repeated by the shift counts both times.
+// Looks a week and a day ahead: windows repeat weekly, so a set with no edge
+// in that span has none at all.
+time_t quiet_hours_next_transition(const quiet_window_t* windows, size_t count,
+                                   time_t now);
+
 #ifdef __cplusplus
 }
 #endif
@@ -7,33 +7,92 @@
 #include <ctime>
 #include <netdb.h>
 #include <sys/socket.h>
+#include <sys/time.h>
 
+#include <esp_heap_caps.h>
 #include <esp_log.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
 #include <freertos/task.h>
 
+#include "event_bus.h"
+#include "log_ring.h"
 #include "nvs_settings.h"
 #include "raii_utils.hpp"
+#include "sdkconfig.h"
 
 namespace {
 
 constexpr int SYSLOG_FACILITY = 16;  // local0
 constexpr size_t MAX_SYSLOG_MSG_LEN = 512;
+// Staged log text waiting for the sender task; falls back to a smaller
+// internal RAM ring on boards without SPIRAM.
+constexpr uint32_t RING_BYTES = 16384;
+constexpr uint32_t RING_BYTES_INTERNAL = 4096;
+// Stays under a typical 1500-byte MTU, so a batch is never fragmented.
+constexpr size_t DATAGRAM_MAX = 1400;
+constexpr size_t SENDER_STACK_SIZE = 4096;
+constexpr int SENDER_TASK_PRIORITY = 1;
+
+// Stored in front of each staged chunk: when it was logged.
+struct ChunkMeta {
+  uint32_t sec;
+  uint32_t msec;
+};
 
 int s_sock = -1;
 struct sockaddr_in s_dest_addr;
 bool s_enabled = false;
 vprintf_like_t s_prev_logger = nullptr;
-SemaphoreHandle_t s_log_mutex = nullptr;
+// Guards s_sock and s_hostname against init/deinit and config changes.
+SemaphoreHandle_t s_sock_mutex = nullptr;
 
 char s_host[128] = {0};
 uint16_t s_port = 514;
 char s_hostname[33] = CONFIG_LWIP_LOCAL_HOSTNAME;
 
-char s_log_buffer[MAX_SYSLOG_MSG_LEN];
-size_t s_log_len = 0;
-char s_packet_buf[MAX_SYSLOG_MSG_LEN + 128];
+log_ring_t s_ring = {};
+TaskHandle_t s_sender_task = nullptr;
+
+// Sender task only.
+char s_line[MAX_SYSLOG_MSG_LEN];
+size_t s_line_len = 0;
+ChunkMeta s_line_meta = {};
+char s_msg_buf[MAX_SYSLOG_MSG_LEN + 128];
+char s_datagram[DATAGRAM_MAX];
+size_t s_datagram_len = 0;
+time_t s_stamp_sec = 0;
+char s_stamp[24] = "-";  // "%Y-%m-%dT%H:%M:%S" of s_stamp_sec
+uint32_t s_reported_drops = 0;
+
+// Atomic counters.
+uint32_t s_dropped = 0;
+uint32_t s_sent = 0;
+uint32_t s_datagrams = 0;
+
+// Formats once, straight into room for the longest chunk; the commit hands
+// the unused part back to the ring.
+void stage_chunk(const char* fmt, va_list args) {
+  uint8_t* rec =
+      log_ring_reserve(&s_ring, sizeof(ChunkMeta) + MAX_SYSLOG_MSG_LEN);
+  if (!rec) {
+    __atomic_fetch_add(&s_dropped, 1, __ATOMIC_RELAXED);
+    return;
+  }
+
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  const ChunkMeta meta = {static_cast<uint32_t>(tv.tv_sec),
+                          static_cast<uint32_t>(tv.tv_usec / 1000)};
+  memcpy(rec, &meta, sizeof(meta));
+  const int n = vsnprintf(reinterpret_cast<char*>(rec) + sizeof(meta),
+                          MAX_SYSLOG_MSG_LEN, fmt, args);
+  size_t len = n > 0 ? static_cast<size_t>(n) : 0;
+  if (len >= MAX_SYSLOG_MSG_LEN) len = MAX_SYSLOG_MSG_LEN - 1;
+  // A reserved record must be committed; an empty one is skipped on send.
+  log_ring_commit(&s_ring, rec, sizeof(meta) + len);
+  if (len > 0) xTaskNotifyGive(s_sender_task);
+}
 
 int syslog_vprintf(const char* fmt, va_list args) {
   va_list args_copy;
@@ -46,83 +105,198 @@ int syslog_vprintf(const char* fmt, va_list args) {
     ret = vprintf(fmt, args);
   }
 
-  if (!s_enabled || s_sock < 0) {
-    va_end(args_copy);
-    return ret;
-  }
-
-  if (xPortInIsrContext()) {
-    va_end(args_copy);
-    return ret;
-  }
-
-  raii::MutexGuard lock(s_log_mutex, 10 / portTICK_PERIOD_MS);
-  if (lock) {
-    int n = vsnprintf(s_log_buffer + s_log_len,
-                      sizeof(s_log_buffer) - s_log_len, fmt, args_copy);
-
-    if (n > 0) {
-      size_t written = static_cast<size_t>(n);
-      if (s_log_len + written >= sizeof(s_log_buffer)) {
-        written = sizeof(s_log_buffer) - s_log_len - 1;
-      }
-      s_log_len += written;
-      s_log_buffer[s_log_len] = '\0';
-
-      if (s_log_buffer[s_log_len - 1] == '\n') {
-        s_log_buffer[--s_log_len] = '\0';
-
-        int severity = 6;
-        if (s_log_len > 0) {
-          char* p = s_log_buffer;
-          while (*p && (*p == ' ' || *p == '\t' || *p == '\r' ||
-                        *p == '\n')) {
-            p++;
-          }
-          switch (*p) {
-            case 'E': severity = 3; break;
-            case 'W': severity = 4; break;
-            case 'I': severity = 6; break;
-            case 'D': severity = 7; break;
-            case 'V': severity = 7; break;
-          }
-        }
-        int pri = (SYSLOG_FACILITY * 8) + severity;
-
-        char time_str[32] = "-";
-        time_t now;
-        struct tm timeinfo;
-        time(&now);
-        localtime_r(&now, &timeinfo);
-        if (timeinfo.tm_year > (2016 - 1900)) {
-          strftime(time_str, sizeof(time_str),
-                   "%Y-%m-%dT%H:%M:%S.000Z", &timeinfo);
-        }
-
-        snprintf(s_hostname, sizeof(s_hostname), "%s",
-                 config_get().hostname);
-        if (strlen(s_hostname) == 0) strcpy(s_hostname, "-");
-
-        int pkt_len =
-            snprintf(s_packet_buf, sizeof(s_packet_buf),
-                     "<%d>1 %s %s tronbyt - - - %s", pri, time_str,
-                     s_hostname, s_log_buffer);
-
-        if (s_sock >= 0 && pkt_len > 0) {
-          sendto(s_sock, s_packet_buf, pkt_len, 0,
-                 reinterpret_cast<struct sockaddr*>(&s_dest_addr),
-                 sizeof(s_dest_addr));
-        }
-
-        s_log_len = 0;
-      }
-    }
+  // Only stage the text here; the sender task formats and sends it, so
+  // logging never waits on the network.
+  if (s_enabled && s_sender_task && !xPortInIsrContext()) {
+    stage_chunk(fmt, args_copy);
   }
 
   va_end(args_copy);
   return ret;
 }
 
+void refresh_hostname() {
+  char hostname[sizeof(s_hostname)];
+  {
+    ConfigSnapshot cfg;
+    snprintf(hostname, sizeof(hostname), "%s",
+             cfg->hostname[0] != '\0' ? cfg->hostname : "-");
+  }
+  raii::MutexGuard lock(s_sock_mutex);
+  memcpy(s_hostname, hostname, sizeof(s_hostname));
+}
+
+void on_config_changed(const tronbyt_event_t*, void*) { refresh_hostname(); }
+
+void send_datagram(const char* data, size_t len) {
+  raii::MutexGuard lock(s_sock_mutex, pdMS_TO_TICKS(100));
+  if (!lock || s_sock < 0 || len == 0) return;
+  if (sendto(s_sock, data, len, 0,
+             reinterpret_cast<struct sockaddr*>(&s_dest_addr),
+             sizeof(s_dest_addr)) >= 0) {
+    __atomic_fetch_add(&s_datagrams, 1, __ATOMIC_RELAXED);
+  }
+}
+
+void flush_datagram() {
+  send_datagram(s_datagram, s_datagram_len);
+  s_datagram_len = 0;
+}
+
+const char* stamp_for(uint32_t sec) {
+  if (static_cast<time_t>(sec) != s_stamp_sec) {
+    s_stamp_sec = static_cast<time_t>(sec);
+    struct tm timeinfo;
+    gmtime_r(&s_stamp_sec, &timeinfo);
+    if (timeinfo.tm_year > (2016 - 1900)) {
+      strftime(s_stamp, sizeof(s_stamp), "%Y-%m-%dT%H:%M:%S", &timeinfo);
+    } else {
+      strcpy(s_stamp, "-");
+    }
+  }
+  return s_stamp;
+}
+
+void emit_message(const ChunkMeta& meta, const char* text, size_t len) {
+  int severity = 6;
+  size_t i = 0;
+  while (i < len && (text[i] == ' ' || text[i] == '\t' || text[i] == '\r' ||
+                     text[i] == '\n')) {
+    i++;
+  }
+  if (i < len) {
+    switch (text[i]) {
+      case 'E': severity = 3; break;
+      case 'W': severity = 4; break;
+      case 'I': severity = 6; break;
+      case 'D': severity = 7; break;
+      case 'V': severity = 7; break;
+    }
+  }
+  const int pri = (SYSLOG_FACILITY * 8) + severity;
+
+  const char* stamp = stamp_for(meta.sec);
+  char time_str[32];
+  if (stamp[0] == '-') {
+    strcpy(time_str, "-");
+  } else {
+    snprintf(time_str, sizeof(time_str), "%s.%03uZ", stamp,
+             static_cast<unsigned>(meta.msec));
+  }
+
+  int pkt_len;
+  {
+    raii::MutexGuard lock(s_sock_mutex, pdMS_TO_TICKS(100));
+    pkt_len = snprintf(s_msg_buf, sizeof(s_msg_buf),
+                       "<%d>1 %s %s tronbyt - - - %.*s", pri, time_str,
+                       lock ? s_hostname : "-", static_cast<int>(len), text);
+  }
+  if (pkt_len <= 0) return;
+  size_t msg_len = static_cast<size_t>(pkt_len);
+  if (msg_len >= sizeof(s_msg_buf)) msg_len = sizeof(s_msg_buf) - 1;
+  __atomic_fetch_add(&s_sent, 1, __ATOMIC_RELAXED);
+
+#if CONFIG_SYSLOG_BATCH_DATAGRAMS
+  // Newline-separated messages, as accepted by collectors that split UDP
+  // payloads on LF (rsyslog, syslog-ng, Vector).
+  if (s_datagram_len + msg_len + 1 > sizeof(s_datagram)) flush_datagram();
+  if (msg_len + 1 > sizeof(s_datagram)) {
+    send_datagram(s_msg_buf, msg_len);
+    return;
+  }
+  if (s_datagram_len > 0) s_datagram[s_datagram_len++] = '\n';
+  memcpy(s_datagram + s_datagram_len, s_msg_buf, msg_len);
+  s_datagram_len += msg_len;
+#else
+  send_datagram(s_msg_buf, msg_len);
+#endif
+}
+
+// Chunks accumulate into s_line until one ends the line.
+void append_chunk(const uint8_t* rec, size_t len) {
+  if (len < sizeof(ChunkMeta)) return;
+  ChunkMeta meta;
+  memcpy(&meta, rec, sizeof(meta));
+  const char* text = reinterpret_cast<const char*>(rec) + sizeof(meta);
+  size_t text_len = len - sizeof(meta);
+
+  if (s_line_len == 0) s_line_meta = meta;
+  const bool ends_line = text_len > 0 && text[text_len - 1] == '\n';
+  if (ends_line) text_len--;
+  const size_t room = sizeof(s_line) - s_line_len;
+  const size_t n = text_len < room ? text_len : room;
+  memcpy(s_line + s_line_len, text, n);
+  s_line_len += n;
+
+  if (ends_line || s_line_len == sizeof(s_line)) {
+    emit_message(s_line_meta, s_line, s_line_len);
+    s_line_len = 0;
+  }
+}
+
+void report_drops() {
+  const uint32_t dropped = __atomic_load_n(&s_dropped, __ATOMIC_RELAXED);
+  if (dropped == s_reported_drops) return;
+  char note[64];
+  const int n = snprintf(note, sizeof(note), "W syslog: %lu log lines dropped",
+                         static_cast<unsigned long>(dropped - s_reported_drops));
+  s_reported_drops = dropped;
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  const ChunkMeta meta = {static_cast<uint32_t>(tv.tv_sec),
+                          static_cast<uint32_t>(tv.tv_usec / 1000)};
+  emit_message(meta, note, static_cast<size_t>(n));
+}
+
+void sender_task(void*) {
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    // Everything staged since the last wakeup goes out in this pass; at low
+    // priority that is usually several lines.
+    size_t len = 0;
+    const uint8_t* rec;
+    while ((rec = log_ring_peek(&s_ring, &len)) != nullptr) {
+      if (s_enabled) append_chunk(rec, len);
+      log_ring_release(&s_ring);
+    }
+    if (s_enabled) {
+      report_drops();
+      flush_datagram();
+    } else {
+      s_line_len = 0;
+      s_datagram_len = 0;
+    }
+  }
+}
+
+bool start_sender() {
+  if (s_sender_task) return true;
+
+  uint32_t bytes = RING_BYTES;
+  auto* buf = static_cast<uint8_t*>(
+      heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+  if (!buf) {
+    bytes = RING_BYTES_INTERNAL;
+    buf = static_cast<uint8_t*>(heap_caps_malloc(bytes, MALLOC_CAP_8BIT));
+  }
+  if (!buf || !log_ring_init(&s_ring, buf, bytes)) {
+    heap_caps_free(buf);
+    return false;
+  }
+
+  if (xTaskCreate(sender_task, "syslog", SENDER_STACK_SIZE, nullptr,
+                  SENDER_TASK_PRIORITY, &s_sender_task) != pdPASS) {
+    s_sender_task = nullptr;
+    heap_caps_free(buf);
+    s_ring = {};
+    return false;
+  }
+
+  event_bus_subscribe(TRONBYT_EVENT_CONFIG_CHANGED, on_config_changed,
+                      nullptr);
+  return true;
+}
+
 }  // namespace
 
 esp_err_t syslog_init(const char* addr) {
@@ -130,9 +304,14 @@ esp_err_t syslog_init(const char* addr) {
     return ESP_ERR_INVALID_ARG;
   }
 
-  if (!s_log_mutex) {
-    s_log_mutex = xSemaphoreCreateMutex();
+  if (!s_sock_mutex) {
+    s_sock_mutex = xSemaphoreCreateMutex();
+  }
+  if (!s_sock_mutex || !start_sender()) {
+    printf("syslog: Unable to start sender task\n");
+    return ESP_ERR_NO_MEM;
   }
+  refresh_hostname();
 
   if (s_enabled) {
     syslog_deinit();
@@ -169,8 +348,8 @@ esp_err_t syslog_init(const char* addr) {
   memcpy(&s_dest_addr, res->ai_addr, sizeof(s_dest_addr));
   freeaddrinfo(res);
 
-  s_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
-  if (s_sock < 0) {
+  int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+  if (sock < 0) {
     printf("syslog: Unable to create socket: errno %d\n", errno);
     return ESP_FAIL;
   }
@@ -178,10 +357,14 @@ esp_err_t syslog_init(const char* addr) {
   struct timeval tv;
   tv.tv_sec = 0;
   tv.tv_usec = 100000;
-  if (setsockopt(s_sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) < 0) {
+  if (setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) < 0) {
     printf("syslog: Failed to set SO_SNDTIMEO: errno %d\n", errno);
   }
 
+  {
+    raii::MutexGuard lock(s_sock_mutex);
+    s_sock = sock;
+  }
   s_enabled = true;
 
   if (!s_prev_logger) {
@@ -194,10 +377,19 @@ esp_err_t syslog_init(const char* addr) {
 
 void syslog_deinit(void) {
   s_enabled = false;
+  raii::MutexGuard lock(s_sock_mutex);
   if (s_sock >= 0) {
     close(s_sock);
     s_sock = -1;
   }
 }
 
+void syslog_get_stats(syslog_stats_t* out) {
+  if (!out) return;
+  out->enabled = s_enabled;
+  out->sent = __atomic_load_n(&s_sent, __ATOMIC_RELAXED);
+  out->datagrams = __atomic_load_n(&s_datagrams, __ATOMIC_RELAXED);
+  out->dropped = __atomic_load_n(&s_dropped, __ATOMIC_RELAXED);
+}
+
 void syslog_update_config(const char* addr) { syslog_init(addr); }
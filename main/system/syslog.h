@@ -2,11 +2,15 @@
 
 #include <esp_err.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /**
  * @brief Initialize Syslog logging
  *
- * Sets up the UDP socket and registers the logging redirect.
+ * Sets up the UDP socket and registers the logging redirect. Log lines are
+ * copied into a RAM ring and sent by a low-priority task, so logging never
+ * blocks on the network; lines that find the ring full are dropped and
+ * counted.
  *
  * @param addr Address of the syslog server (format "host:port" or "host")
  * @return esp_err_t ESP_OK on success
@@ -26,3 +30,15 @@ void syslog_deinit(void);
  * @param addr New address
  */
 void syslog_update_config(const char *addr);
+
+typedef struct {
+  bool enabled;
+  uint32_t sent;       // messages
+  uint32_t datagrams;  // UDP packets; fewer than sent when batching
+  uint32_t dropped;    // log lines that found the ring full
+} syslog_stats_t;
+
+/**
+ * @brief Counters since boot
+ */
+void syslog_get_stats(syslog_stats_t *out);
@@ -0,0 +1,180 @@
+#include "frame_diff.h"
+
+#include <string.h>
+
+namespace {
+
+// Native word: 32-bit on Xtensa, 64-bit on the host. The frame copies live in
+// PSRAM, so the scan is bound by cache-line fills rather than ALU work; wide
+// loads with four words folded per test keep the loop overhead out of the way.
+using word_t = uintptr_t;
+constexpr size_t kWord = sizeof(word_t);
+
+inline word_t diff4(const word_t* a, const word_t* b, size_t k) {
+  return (a[k] ^ b[k]) | (a[k + 1] ^ b[k + 1]) | (a[k + 2] ^ b[k + 2]) |
+         (a[k + 3] ^ b[k + 3]);
+}
+
+// Index of the first differing byte in [0, len), or -1 when equal.
+long first_diff(const uint8_t* a, const uint8_t* b, size_t len, bool aligned) {
+  size_t i = 0;
+  if (aligned) {
+    const word_t* wa = reinterpret_cast<const word_t*>(a);
+    const word_t* wb = reinterpret_cast<const word_t*>(b);
+    const size_t n = len / kWord;
+    size_t k = 0;
+    while (k + 4 <= n && diff4(wa, wb, k) == 0) k += 4;
+    while (k < n && wa[k] == wb[k]) k++;
+    i = k * kWord;
+  }
+  for (; i < len; i++) {
+    if (a[i] != b[i]) return static_cast<long>(i);
+  }
+  return -1;
+}
+
+// Index of the last differing byte in [0, len), or -1 when equal.
+long last_diff(const uint8_t* a, const uint8_t* b, size_t len, bool aligned) {
+  size_t end = len;
+  if (aligned) {
+    const word_t* wa = reinterpret_cast<const word_t*>(a);
+    const word_t* wb = reinterpret_cast<const word_t*>(b);
+    const size_t n = len / kWord;
+    for (size_t j = len; j > n * kWord; j--) {
+      if (a[j - 1] != b[j - 1]) return static_cast<long>(j - 1);
+    }
+    size_t k = n;
+    while (k >= 4 && diff4(wa, wb, k - 4) == 0) k -= 4;
+    while (k > 0 && wa[k - 1] == wb[k - 1]) k--;
+    end = k * kWord;
+  }
+  for (size_t j = end; j > 0; j--) {
+    if (a[j - 1] != b[j - 1]) return static_cast<long>(j - 1);
+  }
+  return -1;
+}
+
+// Diff pixels [x0, x0 + w) of every row in [y0, y1); rows outside are
+// marked clean.
+int diff_window(const uint8_t* cur, const uint8_t* prev, int width,
+                int height, size_t bpp, int x0, int w, int y0, int y1,
+                frame_diff_span_t* spans) {
+  const size_t row_bytes = static_cast<size_t>(width) * bpp;
+  const size_t len = static_cast<size_t>(w) * bpp;
+  // Word loads need every segment start aligned, not just the buffers.
+  const uintptr_t base = reinterpret_cast<uintptr_t>(cur) |
+                         reinterpret_cast<uintptr_t>(prev);
+  const bool aligned =
+      ((base | row_bytes | static_cast<size_t>(x0) * bpp) % kWord) == 0;
+
+  int dirty = 0;
+  for (int y = 0; y < height; y++) {
+    spans[y].first = -1;
+    spans[y].last = -1;
+    if (y < y0 || y >= y1) continue;
+    const size_t off = y * row_bytes + static_cast<size_t>(x0) * bpp;
+    const uint8_t* a = cur + off;
+    const uint8_t* b = prev + off;
+    // Clean rows are the common case (static content, small tickers), and
+    // the libc memcmp beats the word scan at proving equality; the scan only
+    // runs to locate the edges of a row that differs.
+    if (memcmp(a, b, len) == 0) continue;
+    const long first = first_diff(a, b, len, aligned);
+    if (first < 0) continue;
+    // The segment differs, so the right-hand scan stops at or after `first`.
+    const long last = last_diff(a, b, len, aligned);
+    spans[y].first =
+        static_cast<int16_t>(x0 + first / static_cast<long>(bpp));
+    spans[y].last = static_cast<int16_t>(x0 + last / static_cast<long>(bpp));
+    dirty++;
+  }
+  return dirty;
+}
+
+}  // namespace
+
+int frame_diff_rows(const uint8_t* cur, const uint8_t* prev, int width,
+                    int height, size_t bpp, frame_diff_span_t* spans) {
+  if (!cur || !prev || !spans || width <= 0 || height <= 0 || bpp == 0) {
+    return 0;
+  }
+  return diff_window(cur, prev, width, height, bpp, 0, width, 0, height,
+                     spans);
+}
+
+int frame_diff_rows_in(const uint8_t* cur, const uint8_t* prev, int width,
+                       int height, size_t bpp, const frame_diff_rect_t* bounds,
+                       frame_diff_span_t* spans) {
+  if (!cur || !prev || !spans || !bounds || width <= 0 || height <= 0 ||
+      bpp == 0) {
+    return 0;
+  }
+  // Clip to the canvas; an empty window just reports every row clean.
+  const int x0 = bounds->x > 0 ? bounds->x : 0;
+  const int y0 = bounds->y > 0 ? bounds->y : 0;
+  const int x1 = bounds->x + bounds->w < width ? bounds->x + bounds->w : width;
+  const int y1 =
+      bounds->y + bounds->h < height ? bounds->y + bounds->h : height;
+  const int w = x1 > x0 ? x1 - x0 : 0;
+  return diff_window(cur, prev, width, height, bpp, x0, w, y0,
+                     w > 0 ? y1 : y0, spans);
+}
+
+frame_diff_rect_t frame_diff_rect_union(frame_diff_rect_t a,
+                                        frame_diff_rect_t b) {
+  if (a.w <= 0 || a.h <= 0) return b;
+  if (b.w <= 0 || b.h <= 0) return a;
+  const int x0 = a.x < b.x ? a.x : b.x;
+  const int y0 = a.y < b.y ? a.y : b.y;
+  const int x1 = a.x + a.w > b.x + b.w ? a.x + a.w : b.x + b.w;
+  const int y1 = a.y + a.h > b.y + b.h ? a.y + a.h : b.y + b.h;
+  frame_diff_rect_t r;
+  r.x = static_cast<int16_t>(x0);
+  r.y = static_cast<int16_t>(y0);
+  r.w = static_cast<int16_t>(x1 - x0);
+  r.h = static_cast<int16_t>(y1 - y0);
+  return r;
+}
+
+int frame_diff_build_rects(const frame_diff_span_t* spans, int height,
+                           frame_diff_rect_t* rects, int max_rects) {
+  if (!spans || !rects || max_rects <= 0) return 0;
+
+  int count = 0;
+  for (int y = 0; y < height; y++) {
+    const frame_diff_span_t& s = spans[y];
+    if (s.first < 0) continue;
+
+    if (count > 0) {
+      frame_diff_rect_t& r = rects[count - 1];
+      const int r_last = r.x + r.w - 1;
+      const bool adjacent = r.y + r.h == y && s.first <= r_last + 1 &&
+                            s.last + 1 >= r.x;
+      if (adjacent || count == max_rects) {
+        const int x0 = s.first < r.x ? s.first : r.x;
+        const int x1 = s.last > r_last ? s.last : r_last;
+        r.x = static_cast<int16_t>(x0);
+        r.w = static_cast<int16_t>(x1 - x0 + 1);
+        r.h = static_cast<int16_t>(y - r.y + 1);
+        continue;
+      }
+    }
+
+    frame_diff_rect_t& r = rects[count++];
+    r.x = s.first;
+    r.y = static_cast<int16_t>(y);
+    r.w = static_cast<int16_t>(s.last - s.first + 1);
+    r.h = 1;
+  }
+  return count;
+}
+
+int frame_diff_rect_dirty_px(const frame_diff_span_t* spans,
+                             frame_diff_rect_t r) {
+  if (!spans) return 0;
+  int px = 0;
+  for (int y = r.y; y < r.y + r.h; y++) {
+    if (spans[y].first >= 0) px += spans[y].last - spans[y].first + 1;
+  }
+  return px;
+}
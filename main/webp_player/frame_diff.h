@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Changed pixel range of one row, inclusive. first < 0 marks a clean row.
+typedef struct {
+  int16_t first;
+  int16_t last;
+} frame_diff_span_t;
+
+// Canvas-coordinate rectangle covering one or more dirty rows.
+typedef struct {
+  int16_t x;
+  int16_t y;
+  int16_t w;
+  int16_t h;
+} frame_diff_rect_t;
+
+// Compare two frames of width x height pixels (bpp bytes each, rows packed
+// back to back) and record each row's changed pixel range in spans[0..height).
+// One pass: every row is scanned from the left up to its first difference and
+// from the right down to its last, comparing a machine word at a time when
+// the rows are word aligned. Returns the number of dirty rows.
+//
+// Pure and allocation-free so it is host-testable and benchmarkable.
+int frame_diff_rows(const uint8_t* cur, const uint8_t* prev, int width,
+                    int height, size_t bpp, frame_diff_span_t* spans);
+
+// Same as frame_diff_rows, but only pixels inside *bounds (clipped to the
+// canvas) are compared; everything outside is reported clean. For callers
+// that already know where the frames can differ, e.g. from the decoder's
+// per-frame change rectangle.
+int frame_diff_rows_in(const uint8_t* cur, const uint8_t* prev, int width,
+                       int height, size_t bpp, const frame_diff_rect_t* bounds,
+                       frame_diff_span_t* spans);
+
+// Smallest rectangle covering both a and b. A rectangle with w or h <= 0 is
+// empty and contributes nothing.
+frame_diff_rect_t frame_diff_rect_union(frame_diff_rect_t a,
+                                        frame_diff_rect_t b);
+
+// Coalesce the dirty rows in spans[0..height) into at most max_rects
+// rectangles. Vertically adjacent dirty rows whose spans overlap or touch
+// share a rectangle covering the union of their spans; the last rectangle
+// absorbs whatever is left once max_rects is reached. Returns the number of
+// rectangles written.
+int frame_diff_build_rects(const frame_diff_span_t* spans, int height,
+                           frame_diff_rect_t* rects, int max_rects);
+
+// Pixels the spans of rows [r.y, r.y + r.h) actually cover: how much of a
+// rectangle from frame_diff_build_rects changed. A staircase of spans or the
+// overflow rectangle can be mostly unchanged pixels.
+int frame_diff_rect_dirty_px(const frame_diff_span_t* spans,
+                             frame_diff_rect_t r);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,83 @@
+#include "frame_stats.h"
+
+#include <string.h>
+
+const uint32_t frame_stats_bucket_us[FRAME_STATS_BUCKETS - 1] = {
+    500, 1000, 2000, 4000, 8000, 16000, 33000, 66000};
+
+void frame_stats_reset(frame_stats_t* s) {
+  if (s) memset(s, 0, sizeof(*s));
+}
+
+void frame_hist_add(frame_hist_t* h, int64_t us) {
+  if (!h) return;
+  const uint32_t v = us > 0 ? (us > UINT32_MAX ? UINT32_MAX
+                                               : static_cast<uint32_t>(us))
+                            : 0;
+  int b = 0;
+  while (b < FRAME_STATS_BUCKETS - 1 && v >= frame_stats_bucket_us[b]) b++;
+  h->buckets[b]++;
+  h->count++;
+  h->total_us += v;
+  if (v > h->max_us) h->max_us = v;
+}
+
+uint32_t frame_hist_percentile(const frame_hist_t* h, int pct) {
+  if (!h || h->count == 0) return 0;
+  if (pct < 0) pct = 0;
+  if (pct > 100) pct = 100;
+  // Smallest rank covering pct percent of the samples, at least the first.
+  uint64_t rank = (static_cast<uint64_t>(h->count) * pct + 99) / 100;
+  if (rank == 0) rank = 1;
+  uint64_t seen = 0;
+  for (int b = 0; b < FRAME_STATS_BUCKETS - 1; b++) {
+    seen += h->buckets[b];
+    if (seen >= rank) {
+      return frame_stats_bucket_us[b] < h->max_us ? frame_stats_bucket_us[b]
+                                                  : h->max_us;
+    }
+  }
+  return h->max_us;
+}
+
+uint32_t frame_hist_avg_us(const frame_hist_t* h) {
+  if (!h || h->count == 0) return 0;
+  return static_cast<uint32_t>(h->total_us / h->count);
+}
+
+void frame_stats_frame_shown(frame_stats_t* s, int64_t now_us,
+                             uint32_t delay_ms) {
+  if (!s) return;
+  if (s->frames == 0) {
+    s->first_us = now_us;
+  } else {
+    s->authored_ms += s->pending_delay_ms;
+    s->authored_intervals++;
+  }
+  s->last_us = now_us;
+  s->pending_delay_ms = delay_ms;
+  s->frames++;
+}
+
+void frame_stats_frame_skipped(frame_stats_t* s, uint32_t delay_ms) {
+  if (!s) return;
+  s->skipped++;
+  if (s->frames == 0) return;  // before the timeline's first shown frame
+  s->authored_ms += s->pending_delay_ms;
+  s->authored_intervals++;
+  s->pending_delay_ms = delay_ms;
+}
+
+uint32_t frame_stats_achieved_fps_x100(const frame_stats_t* s) {
+  if (!s || s->frames < 2 || s->last_us <= s->first_us) return 0;
+  const uint64_t intervals = s->frames - 1;
+  return static_cast<uint32_t>(intervals * 100000000ULL /
+                               static_cast<uint64_t>(s->last_us - s->first_us));
+}
+
+uint32_t frame_stats_authored_fps_x100(const frame_stats_t* s) {
+  if (!s || s->frames < 2 || s->authored_ms == 0) return 0;
+  return static_cast<uint32_t>(
+      static_cast<uint64_t>(s->authored_intervals) * 100000ULL /
+      s->authored_ms);
+}
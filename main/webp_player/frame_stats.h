@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bucket upper bounds in microseconds (exclusive); the last bucket is open.
+// Roughly doubling from 0.5 ms, with 33 ms and 66 ms marking one and two
+// frames at 30 fps.
+#define FRAME_STATS_BUCKETS 9
+extern const uint32_t frame_stats_bucket_us[FRAME_STATS_BUCKETS - 1];
+
+// Per-frame durations of one stage of the render loop.
+typedef struct {
+  uint32_t count;
+  uint32_t max_us;
+  uint64_t total_us;
+  uint32_t buckets[FRAME_STATS_BUCKETS];
+} frame_hist_t;
+
+// Timing of one playback. Frames count what reached the panel (identical
+// frames that needed no redraw included). authored_ms sums the WebP delays of
+// every frame since the first shown one, skipped frames included, except the
+// newest, whose interval has not ended yet; so it spans the same stretch as
+// last_us - first_us, over authored_intervals frame steps.
+typedef struct {
+  frame_hist_t decode;  // libwebp (or frame cache) per frame
+  frame_hist_t diff;    // comparing against the frame copies
+  frame_hist_t draw;    // writes into the DMA buffers
+  frame_hist_t flip;    // vsync wait plus buffer swap
+  uint32_t frames;
+  uint32_t late;     // frames that started after their due time
+  uint32_t skipped;  // frames decoded but never shown
+  uint64_t authored_ms;
+  uint32_t authored_intervals;
+  int64_t first_us;
+  int64_t last_us;
+  uint32_t pending_delay_ms;  // delay of the newest shown frame
+} frame_stats_t;
+
+void frame_stats_reset(frame_stats_t* s);
+
+// Record one duration; negative values count as zero.
+void frame_hist_add(frame_hist_t* h, int64_t us);
+
+// Upper bound of the bucket holding the pct-th percentile, capped at max_us
+// (so the open bucket reports the worst case). 0 when empty.
+uint32_t frame_hist_percentile(const frame_hist_t* h, int pct);
+
+uint32_t frame_hist_avg_us(const frame_hist_t* h);
+
+// A frame reached the panel at now_us and is meant to stay for delay_ms.
+void frame_stats_frame_shown(frame_stats_t* s, int64_t now_us,
+                             uint32_t delay_ms);
+
+// A frame was decoded but dropped to catch up with the authored timeline.
+// Its delay still counts towards authored time.
+void frame_stats_frame_skipped(frame_stats_t* s, uint32_t delay_ms);
+
+// Frame rates over the playback so far, in hundredths of a frame per second:
+// achieved from wall-clock time between the first and newest shown frame,
+// authored from the WebP delays over the same stretch (skipped frames count
+// there). 0 until two frames have been shown.
+uint32_t frame_stats_achieved_fps_x100(const frame_stats_t* s);
+uint32_t frame_stats_authored_fps_x100(const frame_stats_t* s);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,128 @@
+#include "image_arena.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+
+#include "image_slabs.h"
+#include "sdkconfig.h"
+
+namespace {
+
+const char* TAG = "image_arena";
+
+// Most app renders are well under 64 KB; 2x panels and long animations reach
+// a few hundred. Enough slabs per class for the steady state: the image
+// playing, the one queued behind it, the download in flight and the cache
+// copies taken from it. The large slab takes anything up to the download
+// limit.
+constexpr size_t SMALL_SLAB = 64 * 1024;
+constexpr size_t MEDIUM_SLAB = 160 * 1024;
+constexpr size_t LARGE_SLAB = (CONFIG_HTTP_BUFFER_SIZE_MAX + 4095) & ~4095;
+constexpr size_t SLAB_SIZES[] = {SMALL_SLAB, MEDIUM_SLAB, LARGE_SLAB};
+constexpr int SLAB_COUNTS[] = {4, 3, 1};
+constexpr int SLAB_CLASSES = sizeof(SLAB_SIZES) / sizeof(SLAB_SIZES[0]);
+
+portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+image_slabs_t s_slabs = {};
+image_arena_stats_t s_stats = {};
+
+void* slab_alloc(size_t size) {
+  portENTER_CRITICAL(&s_lock);
+  void* p = image_slabs_alloc(&s_slabs, size);
+  if (p) {
+    s_stats.slab_allocs++;
+    s_stats.in_use++;
+    if (s_stats.in_use > s_stats.peak_in_use) {
+      s_stats.peak_in_use = s_stats.in_use;
+    }
+  }
+  portEXIT_CRITICAL(&s_lock);
+  return p;
+}
+
+void* heap_alloc(size_t size) {
+  void* p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+  if (p) {
+    portENTER_CRITICAL(&s_lock);
+    s_stats.heap_allocs++;
+    portEXIT_CRITICAL(&s_lock);
+  }
+  return p;
+}
+
+size_t slab_capacity(const void* p) {
+  portENTER_CRITICAL(&s_lock);
+  const size_t cap = image_slabs_capacity(&s_slabs, p);
+  portEXIT_CRITICAL(&s_lock);
+  return cap;
+}
+
+}  // namespace
+
+void image_arena_init(void) {
+#if CONFIG_IMAGE_ARENA
+  if (s_slabs.base) return;
+  const size_t bytes =
+      image_slabs_region_bytes(SLAB_SIZES, SLAB_COUNTS, SLAB_CLASSES);
+  auto* region = static_cast<uint8_t*>(
+      heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+  if (!region) {
+    ESP_LOGW(TAG, "Could not reserve %zu bytes; image buffers use the heap",
+             bytes);
+    return;
+  }
+  portENTER_CRITICAL(&s_lock);
+  image_slabs_init(&s_slabs, region, SLAB_SIZES, SLAB_COUNTS, SLAB_CLASSES);
+  s_stats.slabs = static_cast<uint32_t>(s_slabs.count);
+  s_stats.reserved_bytes = static_cast<uint32_t>(bytes);
+  portEXIT_CRITICAL(&s_lock);
+  ESP_LOGI(TAG, "Reserved %d image slabs (%zu bytes)", s_slabs.count, bytes);
+#endif
+}
+
+void* image_arena_alloc(size_t size) {
+  if (size == 0) return nullptr;
+  void* p = slab_alloc(size);
+  return p ? p : heap_alloc(size);
+}
+
+void* image_arena_grow(void* p, size_t used, size_t size) {
+  if (!p) return image_arena_alloc(size);
+  const size_t cap = slab_capacity(p);
+  if (cap >= size) return p;
+
+  // A heap block can grow in place; only a slab must move.
+  void* grown = slab_alloc(size);
+  if (!grown && cap == 0) {
+    grown = heap_caps_realloc(p, size, MALLOC_CAP_SPIRAM);
+    if (grown) return grown;
+  }
+  if (!grown) grown = heap_alloc(size);
+  if (!grown) {
+    image_arena_free(p);
+    return nullptr;
+  }
+  memcpy(grown, p, used);
+  image_arena_free(p);
+  return grown;
+}
+
+void image_arena_free(void* p) {
+  if (!p) return;
+  portENTER_CRITICAL(&s_lock);
+  const bool slab = image_slabs_free(&s_slabs, p);
+  if (slab) s_stats.in_use--;
+  portEXIT_CRITICAL(&s_lock);
+  if (!slab) free(p);
+}
+
+void image_arena_get_stats(image_arena_stats_t* out) {
+  if (!out) return;
+  portENTER_CRITICAL(&s_lock);
+  *out = s_stats;
+  portEXIT_CRITICAL(&s_lock);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Reserve the image buffer slabs in SPIRAM. Call once, early at boot, before
+/// the heap has a chance to fragment. Without CONFIG_IMAGE_ARENA, or when the
+/// reservation fails, every allocation falls back to the heap.
+void image_arena_init(void);
+
+/// Buffer for an encoded image of @p size bytes: the smallest free slab that
+/// holds it, else a SPIRAM heap block. NULL when neither is available.
+void* image_arena_alloc(size_t size);
+
+/// Make @p p (holding @p used bytes, may be NULL) hold @p size bytes. Returns
+/// p itself when its slab is already big enough, else a new buffer with the
+/// data moved over. On failure p is freed and NULL returned.
+void* image_arena_grow(void* p, size_t used, size_t size);
+
+/// Release any image buffer whose ownership passed through gfx_update(),
+/// whether it came from the arena or from the heap.
+void image_arena_free(void* p);
+
+typedef struct {
+  uint32_t slabs;        // reserved at boot
+  uint32_t in_use;
+  uint32_t peak_in_use;
+  uint32_t slab_allocs;  // served from a slab
+  uint32_t heap_allocs;  // fell back to the heap (too big or all busy)
+  uint32_t reserved_bytes;
+} image_arena_stats_t;
+
+void image_arena_get_stats(image_arena_stats_t* out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,84 @@
+#include "image_slabs.h"
+
+#include <string.h>
+
+namespace {
+
+constexpr size_t SLAB_ALIGN = 16;
+
+size_t aligned(size_t n) { return (n + SLAB_ALIGN - 1) & ~(SLAB_ALIGN - 1); }
+
+int slab_at(const image_slabs_t* s, const void* p) {
+  if (!p || !s->base) return -1;
+  const auto* bp = static_cast<const uint8_t*>(p);
+  for (int i = 0; i < s->count; i++) {
+    if (bp == s->base + s->offset[i]) return i;
+  }
+  return -1;
+}
+
+}  // namespace
+
+size_t image_slabs_region_bytes(const size_t* sizes, const int* counts,
+                                int classes) {
+  size_t total = 0;
+  int slabs = 0;
+  for (int c = 0; c < classes; c++) {
+    if (counts[c] < 0) return 0;
+    slabs += counts[c];
+    total += aligned(sizes[c]) * counts[c];
+  }
+  return slabs <= IMAGE_SLABS_MAX ? total : 0;
+}
+
+bool image_slabs_init(image_slabs_t* s, uint8_t* base, const size_t* sizes,
+                      const int* counts, int classes) {
+  memset(s, 0, sizeof(*s));
+  if (!base || image_slabs_region_bytes(sizes, counts, classes) == 0) {
+    return false;
+  }
+  size_t offset = 0;
+  for (int c = 0; c < classes; c++) {
+    if (c > 0 && sizes[c] < sizes[c - 1]) {
+      memset(s, 0, sizeof(*s));
+      return false;
+    }
+    for (int k = 0; k < counts[c]; k++) {
+      s->size[s->count] = sizes[c];
+      s->offset[s->count] = offset;
+      s->count++;
+      offset += aligned(sizes[c]);
+    }
+  }
+  s->base = base;
+  return true;
+}
+
+void* image_slabs_alloc(image_slabs_t* s, size_t size) {
+  // Slabs are in ascending size order, so the first fit is the best fit.
+  for (int i = 0; i < s->count; i++) {
+    if (!s->used[i] && s->size[i] >= size) {
+      s->used[i] = true;
+      return s->base + s->offset[i];
+    }
+  }
+  return nullptr;
+}
+
+size_t image_slabs_capacity(const image_slabs_t* s, const void* p) {
+  const int i = slab_at(s, p);
+  return i >= 0 ? s->size[i] : 0;
+}
+
+bool image_slabs_free(image_slabs_t* s, void* p) {
+  const int i = slab_at(s, p);
+  if (i < 0) return false;
+  s->used[i] = false;
+  return true;
+}
+
+int image_slabs_in_use(const image_slabs_t* s) {
+  int n = 0;
+  for (int i = 0; i < s->count; i++) n += s->used[i] ? 1 : 0;
+  return n;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IMAGE_SLABS_MAX 16
+
+// Fixed-size slabs carved out of one region, each handed out whole. Pure
+// bookkeeping with no RTOS or ESP dependencies so it is host-testable; NOT
+// thread safe (image_arena.cpp guards it with a spinlock).
+typedef struct {
+  uint8_t* base;
+  int count;
+  size_t size[IMAGE_SLABS_MAX];  // ascending
+  size_t offset[IMAGE_SLABS_MAX];
+  bool used[IMAGE_SLABS_MAX];
+} image_slabs_t;
+
+// Bytes a region needs for counts[i] slabs of sizes[i] (i < classes), each
+// rounded up to 16 bytes. 0 when there are more than IMAGE_SLABS_MAX slabs.
+size_t image_slabs_region_bytes(const size_t* sizes, const int* counts,
+                                int classes);
+
+// Lay the slabs out in base, which holds image_slabs_region_bytes(). sizes
+// must be ascending. Returns false (and an empty pool) on bad arguments.
+bool image_slabs_init(image_slabs_t* s, uint8_t* base, const size_t* sizes,
+                      const int* counts, int classes);
+
+// Smallest free slab holding size bytes, or NULL.
+void* image_slabs_alloc(image_slabs_t* s, size_t size);
+
+// Capacity of the slab starting at p; 0 when p is not one of ours.
+size_t image_slabs_capacity(const image_slabs_t* s, const void* p);
+
+// Return a slab. False (nothing changed) when p is not one of ours.
+bool image_slabs_free(image_slabs_t* s, void* p);
+
+int image_slabs_in_use(const image_slabs_t* s);
+
+#ifdef __cplusplus
+}
+#endif
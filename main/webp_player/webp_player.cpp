@@ -14,16 +14,21 @@
 #include <esp_timer.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/event_groups.h>
+#include <freertos/queue.h>
 #include <freertos/semphr.h>
 #include <freertos/task.h>
 #include <http_parser.h>
 #include "webp_decoder.h"
 
 #include "assets.h"
+#include "boot_profile.h"
 #include "display.h"
+#include "frame_diff.h"
+#include "frame_stats.h"
+#include "image_arena.h"
+#include "messages.h"
 #include "nvs_settings.h"
 #include "raii_utils.hpp"
-#include "sockets.h"
 #include "version.h"
 
 static const char* TAG = "webp_player";
@@ -32,6 +37,14 @@ static const char* TAG = "webp_player";
 #define CONFIG_BACKGROUND_DWELL_CAP_SECONDS 30
 #endif
 
+#ifndef CONFIG_WEBP_FRAME_CACHE_KB
+#define CONFIG_WEBP_FRAME_CACHE_KB 1024
+#endif
+
+#ifndef CONFIG_PLAYER_PIPELINE_FRAMES
+#define CONFIG_PLAYER_PIPELINE_FRAMES 3
+#endif
+
 ESP_EVENT_DEFINE_BASE(GFX_PLAYER_EVENTS);
 
 int32_t effective_dwell_for_brightness(uint8_t brightness_pct,
@@ -61,11 +74,45 @@ namespace {
 constexpr uint32_t TASK_STACK_SIZE = 4096;
 constexpr int TASK_PRIORITY = 2;
 constexpr int TASK_CORE = 1;
+// Prefetch builds the next image's decoder on the other core, below the
+// player so it only uses slack.
+constexpr uint32_t PREFETCH_STACK_SIZE = 4096;
+constexpr int PREFETCH_PRIORITY = 1;
+constexpr int PREFETCH_CORE = 0;
+// Animations decode on the other core into a ring of frame buffers while
+// the player task renders (see Decode Pipeline).
+constexpr uint32_t DECODE_STACK_SIZE = 4096;
+constexpr int DECODE_PRIORITY = TASK_PRIORITY;
+constexpr int DECODE_CORE = 0;
+constexpr int MAX_PIPELINE_SLOTS = 4;
+constexpr TickType_t PIPELINE_POLL_TICKS = pdMS_TO_TICKS(20);
+constexpr TickType_t PIPELINE_FRAME_TIMEOUT = pdMS_TO_TICKS(1000);
 constexpr int DECODE_RETRY_COUNT = 3;
 constexpr int DECODE_RETRY_DELAY_MS = 200;
+constexpr int MAX_DIRTY_RECTS = 16;
+// A dirty rectangle is drawn span by span instead when it is more than this
+// many times the pixels that changed: pushing a box built from staggered
+// spans (scrolling text, a moving diagonal) costs more than the extra calls.
+constexpr int SPARSE_RECT_RATIO = 2;
+// Frame skipping (CONFIG_PLAYER_FRAME_SKIP) still draws at least one frame in
+// this many, so an animation whose decode alone outruns its frame delays
+// keeps moving instead of freezing on a stale frame.
+constexpr int MAX_SKIP_RUN = 4;
+// How long the version screen stays up before the boot animation.
+constexpr int64_t VERSION_HOLD_US = 2000000;
 
 constexpr EventBits_t BIT_IDLE = BIT0;
 
+// Decode straight into the layout the display layer hands to the driver.
+constexpr size_t kBpp = DISPLAY_BYTES_PER_PIXEL;
+#if defined(CONFIG_DISPLAY_PIXEL_FORMAT_RGB565)
+constexpr WebpPixelFormat kDecodeFormat = WebpPixelFormat::RGB565;
+#elif defined(CONFIG_DISPLAY_PIXEL_FORMAT_RGB888)
+constexpr WebpPixelFormat kDecodeFormat = WebpPixelFormat::RGB888;
+#else
+constexpr WebpPixelFormat kDecodeFormat = WebpPixelFormat::RGBA8888;
+#endif
+
 //------------------------------------------------------------------------------
 // Player State
 //------------------------------------------------------------------------------
@@ -85,6 +132,45 @@ struct PendingCmd {
   int counter = 0;
   gfx_source_type_t source_type = GFX_SOURCE_RAM;
   const char* embedded_name = nullptr;
+  bool preview = false;  // queued by gfx_update_preview
+};
+
+//------------------------------------------------------------------------------
+// Staged Image (prefetched decoder for the pending image)
+//------------------------------------------------------------------------------
+
+struct StagedImage {
+  WebpDecoder decoder;
+  WebpDecoderInfo info = {};
+  const uint8_t* first_frame = nullptr;  // owned by decoder
+  WebpFrameInfo first_info = {};
+  const void* buf = nullptr;  // image data the decoder reads
+  int counter = -1;           // pending counter it was built for
+  bool ready = false;
+};
+
+//------------------------------------------------------------------------------
+// Decode Pipeline
+//------------------------------------------------------------------------------
+
+// One decoded frame handed from the decode stage to the render stage.
+struct PipelineSlot {
+  uint8_t* pixels = nullptr;
+  WebpFrameInfo info = {};
+  uint32_t delay_ms = 0;
+  bool ok = false;
+};
+
+struct Pipeline {
+  TaskHandle_t task = nullptr;
+  QueueHandle_t free_q = nullptr;       // slot indices to decode into
+  QueueHandle_t ready_q = nullptr;      // slot indices holding frames
+  SemaphoreHandle_t stopped = nullptr;  // given when the decode stage exits
+  PipelineSlot slots[MAX_PIPELINE_SLOTS];
+  size_t slot_capacity = 0;  // bytes allocated per slot
+  size_t frame_bytes = 0;    // bytes per frame of the current session
+  std::atomic<bool> stop{false};
+  bool active = false;  // player task only
 };
 
 //------------------------------------------------------------------------------
@@ -102,6 +188,8 @@ struct PlayerContext {
   PendingCmd pending;
   int counter = 0;
   int loaded_counter = 0;
+  // Playing a gfx_update_preview still; the real image preempts it.
+  std::atomic<bool> showing_preview{false};
 
   // Current playback data (task-local)
   void* webp_buf = nullptr;
@@ -115,6 +203,62 @@ struct PlayerContext {
   WebpDecoder decoder;
   WebpDecoderInfo decoder_info = {};
 
+  // Prefetch. The prefetch task builds the pending image's decoder and
+  // decodes its first frame into `staged` (guarded by mutex) while the
+  // current image dwells; taking the pending command moves it to `next`
+  // (task-local), and start_playback adopts it instead of decoding.
+  // prefetch_busy is the buffer being decoded from; releasing it meanwhile
+  // only sets prefetch_orphan, and the prefetch task frees it when done.
+  TaskHandle_t prefetch_task = nullptr;
+  StagedImage staged;
+  StagedImage next;
+  const uint8_t* primed_frame = nullptr;  // next frame to render, pre-decoded
+  WebpFrameInfo primed_info = {};
+  portMUX_TYPE prefetch_lock = portMUX_INITIALIZER_UNLOCKED;
+  const void* prefetch_busy = nullptr;
+  bool prefetch_orphan = false;
+
+  // Frame cache counters. The *_base totals cover decoders already destroyed;
+  // the live values mirror the current decoder and are folded into the base
+  // when it goes away. Atomic because /api/diag reads them from httpd.
+  std::atomic<uint32_t> cache_hits_base{0};
+  std::atomic<uint32_t> cache_misses_base{0};
+  std::atomic<uint32_t> cache_hits{0};
+  std::atomic<uint32_t> cache_misses{0};
+  std::atomic<uint32_t> cache_bytes{0};
+  std::atomic<bool> cache_complete{false};
+
+  // Decode/render split. While a session is active the decode task owns
+  // `decoder`; the player task must stop_pipeline() before touching it.
+  Pipeline pipe;
+
+  // Per-stage timing since boot (gfx_get_pipeline_stats). Decode counters
+  // are written by whichever task decodes, render counters by the player.
+  std::atomic<uint32_t> stat_decoded{0};
+  std::atomic<uint32_t> stat_rendered{0};
+  std::atomic<uint64_t> stat_decode_us{0};
+  std::atomic<uint64_t> stat_render_us{0};
+  std::atomic<uint32_t> stat_decode_max_us{0};
+  std::atomic<uint32_t> stat_render_max_us{0};
+  std::atomic<uint32_t> stat_render_starved{0};
+  std::atomic<uint32_t> stat_decode_blocked{0};
+
+  // Per-playback frame timing (gfx_get_timing_stats), reset when playback
+  // starts so it always describes the current or last image. Written by the
+  // player and the decode task, read from httpd; all under timing_lock.
+  portMUX_TYPE timing_lock = portMUX_INITIALIZER_UNLOCKED;
+  frame_stats_t timing = {};
+  int timing_counter = -1;
+  gfx_source_type_t timing_source = GFX_SOURCE_RAM;
+  const char* timing_name = nullptr;
+  // Stage times of the frame being rendered (player task only).
+  int64_t frame_diff_us = 0;
+  int64_t frame_draw_us = 0;
+  int64_t frame_flip_us = 0;
+  // The player task holds the version screen until then; gfx_initialize
+  // returns straight away so boot carries on meanwhile.
+  int64_t version_hold_until_us = 0;
+
   // Frame copies for row diffing (lazily allocated). shown_frame mirrors what
   // the panel displays; back_frame mirrors the back DMA buffer, which after a
   // flip holds the frame from two flips ago. Anything that draws outside
@@ -126,9 +270,25 @@ struct PlayerContext {
   bool shown_valid = false;
   bool back_valid = false;
 
+  // Decoder-reported change rectangles (WebpFrameInfo) of the newest decoded
+  // frame and the one before it, each relative to its predecessor. frame_seq
+  // numbers decoded frames; shown_seq/back_seq record which one each copy
+  // holds, so a copy one or two frames behind only needs comparing inside
+  // those rectangles.
+  uint32_t frame_seq = 0;
+  frame_diff_rect_t change_rect = {};
+  frame_diff_rect_t prev_change_rect = {};
+  uint32_t shown_seq = 0;
+  uint32_t back_seq = 0;
+
   // Timing
   TickType_t next_frame_tick = 0;
   int64_t playback_start_us = 0;
+  // Authored timeline (CONFIG_PLAYER_FRAME_SKIP): when the next animation
+  // frame is due, in us after playback_start_us, from the cumulative WebP
+  // frame delays; and how many frames in a row were dropped to keep up.
+  int64_t timeline_due_us = 0;
+  int skip_run = 0;
 
   // Error tracking
   int decode_error_count = 0;
@@ -144,10 +304,12 @@ PlayerContext ctx;
 // Ported from matrx-fw. Skips DMA-buffer writes for content that did not
 // change since the previous frame: identical frames are skipped entirely,
 // mostly-changed frames render in full (which hits the driver's fused
-// full-frame path), and otherwise only the changed span of each dirty row is
-// written. Row spans write into the live buffer, so they are only safe
-// without CONFIG_HUB75_DOUBLE_BUFFER; with double buffering the back buffer
-// holds stale content and partial writes would tear.
+// full-frame path), and otherwise only the dirty rectangles built from each
+// row's changed span (frame_diff.h) are written. For animations the compare
+// itself is confined to the decoder's per-frame change rectangle, so its cost
+// follows the animated content rather than the canvas size. Under
+// CONFIG_HUB75_DOUBLE_BUFFER partial writes go to the back buffer and are
+// diffed against its own copy, which is two frames old.
 
 void invalidate_prev_frame() {
   ctx.shown_valid = false;
@@ -166,19 +328,55 @@ uint8_t* alloc_frame_copy(size_t needed) {
   return p;
 }
 
+// Charge the time since *mark to *stage and restart the mark.
+void charge_stage(int64_t* stage, int64_t* mark) {
+  const int64_t now = esp_timer_get_time();
+  *stage += now - *mark;
+  *mark = now;
+}
+
 void render_frame_full(const uint8_t* frame, int canvas_w, int canvas_h) {
+  int64_t mark = esp_timer_get_time();
 #ifdef CONFIG_DISPLAY_FRAME_SYNC
   display_draw_buffer(frame, canvas_w, canvas_h);
+  charge_stage(&ctx.frame_draw_us, &mark);
   display_wait_frame(50);
   display_flip();
+  charge_stage(&ctx.frame_flip_us, &mark);
 #else
   display_draw(frame, canvas_w, canvas_h);
+  charge_stage(&ctx.frame_draw_us, &mark);
 #endif
 }
 
+// Area in which the newest decoded frame can differ from the copy holding
+// decoded frame `seq`. False when the copy is too far behind to tell.
+bool change_bounds(uint32_t seq, frame_diff_rect_t* out) {
+  if (seq == ctx.frame_seq - 1) {
+    *out = ctx.change_rect;
+    return true;
+  }
+  if (seq == ctx.frame_seq - 2) {
+    *out = frame_diff_rect_union(ctx.change_rect, ctx.prev_change_rect);
+    return true;
+  }
+  return false;
+}
+
+// Record the decoder's change rectangle for the frame about to be rendered.
+void note_decoded_frame(const WebpFrameInfo& info) {
+  ctx.prev_change_rect = ctx.change_rect;
+  ctx.change_rect.x = static_cast<int16_t>(info.dirty_x);
+  ctx.change_rect.y = static_cast<int16_t>(info.dirty_y);
+  ctx.change_rect.w = static_cast<int16_t>(info.dirty_width);
+  ctx.change_rect.h = static_cast<int16_t>(info.dirty_height);
+  ctx.frame_seq++;
+}
+
 void render_frame_diffed(const uint8_t* frame, int canvas_w, int canvas_h) {
-  const size_t row_bytes = static_cast<size_t>(canvas_w) * 4;
+  const size_t row_bytes = static_cast<size_t>(canvas_w) * kBpp;
   const size_t needed = row_bytes * canvas_h;
+  int64_t mark = esp_timer_get_time();
 
   if (!ctx.shown_frame || ctx.prev_w != canvas_w || ctx.prev_h != canvas_h) {
     heap_caps_free(ctx.shown_frame);
@@ -193,10 +391,27 @@ void render_frame_diffed(const uint8_t* frame, int canvas_w, int canvas_h) {
     ctx.prev_h = canvas_h;
   }
 
-  // Identical frame: leave the panel untouched (no draw, no flip).
-  if (ctx.shown_frame && ctx.shown_valid &&
-      memcmp(frame, ctx.shown_frame, needed) == 0) {
-    return;
+  // display_span_supported bounds canvas_h to the panel height, which is
+  // what sizes the span array.
+  const bool spans_ok = display_span_supported(canvas_w, canvas_h);
+  frame_diff_span_t spans[CONFIG_HUB75_PANEL_HEIGHT];
+  frame_diff_rect_t bounds;
+
+  // Identical frame: leave the panel untouched (no draw, no flip). With the
+  // decoder's change rectangle only that area needs comparing.
+  int shown_dirty = -1;
+  if (ctx.shown_frame && ctx.shown_valid) {
+    if (spans_ok && change_bounds(ctx.shown_seq, &bounds)) {
+      shown_dirty = frame_diff_rows_in(frame, ctx.shown_frame, canvas_w,
+                                       canvas_h, kBpp, &bounds, spans);
+      if (shown_dirty == 0) {
+        charge_stage(&ctx.frame_diff_us, &mark);
+        return;
+      }
+    } else if (memcmp(frame, ctx.shown_frame, needed) == 0) {
+      charge_stage(&ctx.frame_diff_us, &mark);
+      return;
+    }
   }
 
   // Span writes land in the buffer that becomes visible next, so they must
@@ -205,57 +420,78 @@ void render_frame_diffed(const uint8_t* frame, int canvas_w, int canvas_h) {
 #if CONFIG_HUB75_DOUBLE_BUFFER
   uint8_t* ref = ctx.back_frame;
   const bool ref_valid = ctx.back_valid;
+  const uint32_t ref_seq = ctx.back_seq;
 #else
   uint8_t* ref = ctx.shown_frame;
   const bool ref_valid = ctx.shown_valid;
+  const uint32_t ref_seq = ctx.shown_seq;
 #endif
 
-  if (ref && ref_valid && display_span_supported(canvas_w, canvas_h)) {
-    // Single compare pass over the (PSRAM) frame copies: remember which rows
-    // differ so the span loop below does not memcmp the same rows again.
-    // display_span_supported bounds canvas_h to the panel height.
-    uint8_t row_dirty[CONFIG_HUB75_PANEL_HEIGHT];
-    int dirty_rows = 0;
-    for (int y = 0; y < canvas_h; y++) {
-      row_dirty[y] =
-          memcmp(frame + y * row_bytes, ref + y * row_bytes, row_bytes) != 0;
-      dirty_rows += row_dirty[y];
+  if (ref && ref_valid && spans_ok) {
+    // Single compare pass over the (PSRAM) frame copies yields each row's
+    // changed span, restricted to the decoder's change rectangle when the
+    // reference is recent enough. Without double buffering the identical
+    // check above already produced exactly these spans.
+    int dirty_rows;
+    if (ref == ctx.shown_frame && shown_dirty >= 0) {
+      dirty_rows = shown_dirty;
+    } else if (change_bounds(ref_seq, &bounds)) {
+      dirty_rows = frame_diff_rows_in(frame, ref, canvas_w, canvas_h, kBpp,
+                                      &bounds, spans);
+    } else {
+      dirty_rows = frame_diff_rows(frame, ref, canvas_w, canvas_h, kBpp, spans);
     }
+    charge_stage(&ctx.frame_diff_us, &mark);
 
     if (dirty_rows <= (canvas_h * 3) / 4) {
-      for (int y = 0; y < canvas_h; y++) {
-        if (!row_dirty[y]) {
+      frame_diff_rect_t rects[MAX_DIRTY_RECTS];
+      const int rect_count =
+          frame_diff_build_rects(spans, canvas_h, rects, MAX_DIRTY_RECTS);
+      for (int i = 0; i < rect_count; i++) {
+        const frame_diff_rect_t& r = rects[i];
+        if (r.w * r.h <= SPARSE_RECT_RATIO *
+                             frame_diff_rect_dirty_px(spans, r)) {
+          display_draw_rect(frame, r.x, r.y, r.w, r.h, canvas_w, canvas_h);
           continue;
         }
-        const uint32_t* cur =
-            reinterpret_cast<const uint32_t*>(frame + y * row_bytes);
-        uint32_t* prev = reinterpret_cast<uint32_t*>(ref + y * row_bytes);
-        int first = 0;
-        while (cur[first] == prev[first]) first++;
-        int last = canvas_w - 1;
-        while (cur[last] == prev[last]) last--;
-        const int span = last - first + 1;
-        display_draw_span(reinterpret_cast<const uint8_t*>(cur + first), first,
-                          y, span, canvas_w, canvas_h);
-        memcpy(prev + first, cur + first, static_cast<size_t>(span) * 4);
+        for (int y = r.y; y < r.y + r.h; y++) {
+          if (spans[y].first < 0) continue;
+          display_draw_span(frame + y * row_bytes + spans[y].first * kBpp,
+                            spans[y].first, y,
+                            spans[y].last - spans[y].first + 1, canvas_w,
+                            canvas_h);
+        }
+      }
+      charge_stage(&ctx.frame_draw_us, &mark);
+      // Keeping the copies current is part of what diffing costs.
+      for (int y = 0; y < canvas_h; y++) {
+        if (spans[y].first < 0) continue;
+        const size_t off = y * row_bytes + spans[y].first * kBpp;
+        memcpy(ref + off, frame + off,
+               static_cast<size_t>(spans[y].last - spans[y].first + 1) * kBpp);
       }
+      charge_stage(&ctx.frame_diff_us, &mark);
 #if CONFIG_HUB75_DOUBLE_BUFFER
 #ifdef CONFIG_DISPLAY_FRAME_SYNC
       display_wait_frame(50);
 #endif
       display_flip();
+      charge_stage(&ctx.frame_flip_us, &mark);
       // The buffer just written is now visible; the old shown content became
       // the back buffer. Swap the copies to match.
       uint8_t* tmp = ctx.shown_frame;
       ctx.shown_frame = ctx.back_frame;
       ctx.back_frame = tmp;
       ctx.back_valid = ctx.shown_valid;
+      ctx.back_seq = ctx.shown_seq;
       ctx.shown_valid = true;
 #endif
+      ctx.shown_seq = ctx.frame_seq;
       return;
     }
   }
 
+  charge_stage(&ctx.frame_diff_us, &mark);
   render_frame_full(frame, canvas_w, canvas_h);
 #if CONFIG_HUB75_DOUBLE_BUFFER
   // Full render flipped: the old shown content is now the back buffer.
@@ -263,10 +499,14 @@ void render_frame_diffed(const uint8_t* frame, int canvas_w, int canvas_h) {
   ctx.shown_frame = ctx.back_frame;
   ctx.back_frame = tmp;
   ctx.back_valid = ctx.shown_valid;
+  ctx.back_seq = ctx.shown_seq;
 #endif
   if (ctx.shown_frame) {
+    mark = esp_timer_get_time();
     memcpy(ctx.shown_frame, frame, needed);
+    charge_stage(&ctx.frame_diff_us, &mark);
     ctx.shown_valid = true;
+    ctx.shown_seq = ctx.frame_seq;
   } else {
     ctx.shown_valid = false;
   }
@@ -282,9 +522,139 @@ bool is_static_asset(const void* ptr) { return asset_is_static(ptr); }
 // Decoder Management
 //------------------------------------------------------------------------------
 
+void publish_cache_stats() {
+  WebpFrameCacheStats cs = ctx.decoder.get_cache_stats();
+  ctx.cache_hits.store(cs.hits, std::memory_order_relaxed);
+  ctx.cache_misses.store(cs.misses, std::memory_order_relaxed);
+  ctx.cache_bytes.store(static_cast<uint32_t>(cs.bytes),
+                        std::memory_order_relaxed);
+  ctx.cache_complete.store(cs.complete, std::memory_order_relaxed);
+}
+
+void note_stage_time(std::atomic<uint64_t>& total,
+                     std::atomic<uint32_t>& max_us, int64_t us) {
+  const uint32_t v = us > 0 ? static_cast<uint32_t>(us) : 0;
+  total.fetch_add(v, std::memory_order_relaxed);
+  if (v > max_us.load(std::memory_order_relaxed)) {
+    max_us.store(v, std::memory_order_relaxed);
+  }
+}
+
+void note_decode_time(int64_t us) {
+  ctx.stat_decoded.fetch_add(1, std::memory_order_relaxed);
+  note_stage_time(ctx.stat_decode_us, ctx.stat_decode_max_us, us);
+  portENTER_CRITICAL(&ctx.timing_lock);
+  frame_hist_add(&ctx.timing.decode, us);
+  portEXIT_CRITICAL(&ctx.timing_lock);
+}
+
+// Decode stage: pulls free slots, decodes the next frame into them and
+// queues them for the player. Runs one session per start notification until
+// stop is raised, then gives `stopped`. After a decode error it idles until
+// stopped; the player recreates the decoder from its own task.
+void decode_task(void*) {
+  Pipeline& p = ctx.pipe;
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    bool failed = false;
+    while (!p.stop.load(std::memory_order_acquire)) {
+      if (failed) {
+        vTaskDelay(PIPELINE_POLL_TICKS);
+        continue;
+      }
+
+      uint8_t idx = 0;
+      if (xQueueReceive(p.free_q, &idx, 0) != pdTRUE) {
+        // Ring full: the render side (or the frame delay) sets the pace.
+        ctx.stat_decode_blocked.fetch_add(1, std::memory_order_relaxed);
+        bool got = false;
+        while (!got && !p.stop.load(std::memory_order_acquire)) {
+          got = xQueueReceive(p.free_q, &idx, PIPELINE_POLL_TICKS) == pdTRUE;
+        }
+        if (!got) break;
+      }
+
+      PipelineSlot& slot = p.slots[idx];
+      const int64_t t0 = esp_timer_get_time();
+      const uint8_t* frame = nullptr;
+      slot.ok = ctx.decoder.get_next_frame(&frame, &slot.info) == ESP_OK;
+      if (slot.ok) {
+        memcpy(slot.pixels, frame, p.frame_bytes);
+        slot.delay_ms = ctx.decoder.get_frame_delay();
+        note_decode_time(esp_timer_get_time() - t0);
+      }
+      publish_cache_stats();
+      failed = !slot.ok;
+      xQueueSend(p.ready_q, &idx, 0);  // never full: one entry per slot
+    }
+    xSemaphoreGive(p.stopped);
+  }
+}
+
+// Hand the current decoder to the decode task. Call after rendering a frame
+// decoded in the player task, so no frame pointer into the decoder is live.
+void start_pipeline() {
+  Pipeline& p = ctx.pipe;
+  const int slots = CONFIG_PLAYER_PIPELINE_FRAMES < MAX_PIPELINE_SLOTS
+                        ? CONFIG_PLAYER_PIPELINE_FRAMES
+                        : MAX_PIPELINE_SLOTS;
+  if (p.active || !p.task || slots < 2) return;
+
+  const size_t bytes = static_cast<size_t>(ctx.decoder_info.canvas_width) *
+                       ctx.decoder_info.canvas_height * kBpp;
+  if (bytes > p.slot_capacity) {
+    for (auto& slot : p.slots) {
+      heap_caps_free(slot.pixels);
+      slot.pixels = nullptr;
+    }
+    p.slot_capacity = 0;
+    for (int i = 0; i < slots; i++) {
+      p.slots[i].pixels = alloc_frame_copy(bytes);
+      if (!p.slots[i].pixels) {
+        ESP_LOGW(TAG, "Pipeline slot alloc failed (%zu bytes); decoding inline",
+                 bytes);
+        for (auto& slot : p.slots) {
+          heap_caps_free(slot.pixels);
+          slot.pixels = nullptr;
+        }
+        return;
+      }
+    }
+    p.slot_capacity = bytes;
+  }
+  p.frame_bytes = bytes;
+
+  xQueueReset(p.free_q);
+  xQueueReset(p.ready_q);
+  for (uint8_t i = 0; i < slots; i++) {
+    xQueueSend(p.free_q, &i, 0);
+  }
+  p.stop.store(false, std::memory_order_release);
+  p.active = true;
+  xTaskNotifyGive(p.task);
+}
+
+// Take the decoder back from the decode task; blocks until it has let go.
+void stop_pipeline() {
+  Pipeline& p = ctx.pipe;
+  if (!p.active) return;
+  p.stop.store(true, std::memory_order_release);
+  xSemaphoreTake(p.stopped, portMAX_DELAY);
+  p.active = false;
+}
+
 void destroy_decoder() {
+  stop_pipeline();
+  ctx.cache_hits_base.fetch_add(ctx.cache_hits.exchange(0),
+                                std::memory_order_relaxed);
+  ctx.cache_misses_base.fetch_add(ctx.cache_misses.exchange(0),
+                                  std::memory_order_relaxed);
+  ctx.cache_bytes.store(0, std::memory_order_relaxed);
+  ctx.cache_complete.store(false, std::memory_order_relaxed);
   ctx.decoder = WebpDecoder();  // Reset to default
   ctx.decoder_info = {};
+  ctx.primed_frame = nullptr;
   if (ctx.shown_frame) {
     heap_caps_free(ctx.shown_frame);
     ctx.shown_frame = nullptr;
@@ -297,49 +667,159 @@ void destroy_decoder() {
   ctx.back_valid = false;
 }
 
-bool create_decoder() {
-  destroy_decoder();
-
-  if (!ctx.webp_buf || ctx.webp_len == 0) {
+// Shared by the player and the prefetch task; touches no ctx state.
+bool init_decoder(const void* buf, size_t len, WebpDecoder* decoder,
+                  WebpDecoderInfo* info) {
+  if (!buf || len == 0) {
     ESP_LOGE(TAG, "No WebP data");
     return false;
   }
 
-  esp_err_t err = ctx.decoder.init(
-      static_cast<const uint8_t*>(ctx.webp_buf), ctx.webp_len);
+  esp_err_t err = decoder->init(static_cast<const uint8_t*>(buf), len,
+                                kDecodeFormat);
   if (err != ESP_OK) {
     ESP_LOGE(TAG, "Decoder init failed: %s", esp_err_to_name(err));
     return false;
   }
 
-  ctx.decoder_info = ctx.decoder.get_info();
+  *info = decoder->get_info();
 
   // Bound the canvas even though the decoder owns the frame buffer: a huge
   // canvas would still cost decode time and diff-copy allocations downstream.
-  size_t frame_size = static_cast<size_t>(ctx.decoder_info.canvas_width) *
-                      ctx.decoder_info.canvas_height * 4;
+  size_t frame_size = static_cast<size_t>(info->canvas_width) *
+                      info->canvas_height * 4;
   if (frame_size > CONFIG_HTTP_BUFFER_SIZE_MAX) {
     ESP_LOGE(TAG, "Decoded frame too large: %zu bytes (%ux%u)",
-             frame_size, ctx.decoder_info.canvas_width,
-             ctx.decoder_info.canvas_height);
-    ctx.decoder = WebpDecoder();
+             frame_size, info->canvas_width, info->canvas_height);
+    *decoder = WebpDecoder();
+    *info = {};
     return false;
   }
 
-  ESP_LOGI(TAG, "Decoder created: %u frames, %ux%u",
-           ctx.decoder_info.frame_count, ctx.decoder_info.canvas_width,
-           ctx.decoder_info.canvas_height);
+  ESP_LOGI(TAG, "Decoder created: %u frames, %ux%u", info->frame_count,
+           info->canvas_width, info->canvas_height);
   return true;
 }
 
+void enable_frame_cache() {
+  if (ctx.decoder_info.is_animated && CONFIG_WEBP_FRAME_CACHE_KB > 0) {
+    // Leave at least half of the largest SPIRAM block free so the next
+    // image download still finds a contiguous buffer.
+    size_t budget = static_cast<size_t>(CONFIG_WEBP_FRAME_CACHE_KB) * 1024;
+    size_t headroom = heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM) / 2;
+    if (budget > headroom) budget = headroom;
+    ctx.decoder.enable_frame_cache(budget);
+  }
+  publish_cache_stats();
+}
+
+bool create_decoder() {
+  destroy_decoder();
+  if (!init_decoder(ctx.webp_buf, ctx.webp_len, &ctx.decoder,
+                    &ctx.decoder_info)) {
+    return false;
+  }
+  enable_frame_cache();
+  return true;
+}
+
+// Take over the prefetched decoder when it was built for the image about to
+// play. Its first frame is already decoded, so the switch costs no decode.
+bool adopt_prefetched() {
+  StagedImage next = std::move(ctx.next);
+  ctx.next = StagedImage();
+  if (!next.ready || next.buf != ctx.webp_buf) return false;
+
+  destroy_decoder();
+  ctx.decoder = std::move(next.decoder);
+  ctx.decoder_info = next.info;
+  ctx.primed_frame = next.first_frame;
+  ctx.primed_info = next.first_info;
+  // Reserved only now, so two images never hold caches at once.
+  enable_frame_cache();
+  ESP_LOGI(TAG, "Using prefetched decoder (counter=%d)", next.counter);
+  return true;
+}
+
+// Free a RAM image buffer, unless the prefetch task is still decoding from
+// it; then it is freed by that task once done.
+void release_image_buf(void* buf) {
+  if (!buf || is_static_asset(buf)) return;
+  portENTER_CRITICAL(&ctx.prefetch_lock);
+  const bool busy = buf == ctx.prefetch_busy;
+  if (busy) ctx.prefetch_orphan = true;
+  portEXIT_CRITICAL(&ctx.prefetch_lock);
+  if (!busy) image_arena_free(buf);
+}
+
+// Replace-side cleanup for the pending slot; caller holds ctx.mutex.
+void drop_pending_locked() {
+  release_image_buf(ctx.pending.buf);
+  ctx.pending.buf = nullptr;
+  ctx.staged = StagedImage();
+}
+
+void prefetch_task(void*) {
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    const void* buf = nullptr;
+    size_t len = 0;
+    int counter = -1;
+    {
+      raii::MutexGuard lock(ctx.mutex);
+      if (!lock) continue;
+      // Embedded sprites and previews are small; only RAM images are worth
+      // staging, and only once per pending image.
+      if (!ctx.pending.valid.load(std::memory_order_acquire) ||
+          ctx.pending.preview || ctx.pending.source_type != GFX_SOURCE_RAM ||
+          !ctx.pending.buf || ctx.staged.counter == ctx.pending.counter) {
+        continue;
+      }
+      buf = ctx.pending.buf;
+      len = ctx.pending.len;
+      counter = ctx.pending.counter;
+      portENTER_CRITICAL(&ctx.prefetch_lock);
+      ctx.prefetch_busy = buf;
+      portEXIT_CRITICAL(&ctx.prefetch_lock);
+    }
+
+    // Decode outside the lock so gfx_update never waits on libwebp.
+    StagedImage staged;
+    staged.buf = buf;
+    staged.counter = counter;
+    staged.ready =
+        init_decoder(buf, len, &staged.decoder, &staged.info) &&
+        staged.decoder.get_next_frame(&staged.first_frame,
+                                      &staged.first_info) == ESP_OK;
+
+    {
+      raii::MutexGuard lock(ctx.mutex);
+      // Only keep it if the same image is still pending.
+      if (lock && staged.ready &&
+          ctx.pending.valid.load(std::memory_order_acquire) &&
+          ctx.pending.counter == counter && ctx.pending.buf == buf) {
+        ctx.staged = std::move(staged);
+        ESP_LOGD(TAG, "Prefetched counter=%d", counter);
+      }
+    }
+    staged = StagedImage();
+
+    portENTER_CRITICAL(&ctx.prefetch_lock);
+    const bool orphaned = ctx.prefetch_orphan;
+    ctx.prefetch_busy = nullptr;
+    ctx.prefetch_orphan = false;
+    portEXIT_CRITICAL(&ctx.prefetch_lock);
+    if (orphaned) image_arena_free(const_cast<void*>(buf));
+  }
+}
+
 //------------------------------------------------------------------------------
 // Buffer Management
 //------------------------------------------------------------------------------
 
 void free_buffer() {
-  if (ctx.webp_buf && !is_static_asset(ctx.webp_buf)) {
-    free(ctx.webp_buf);
-  }
+  release_image_buf(ctx.webp_buf);
   ctx.webp_buf = nullptr;
   ctx.webp_len = 0;
 }
@@ -378,35 +858,12 @@ void emit_stopped_event() {
 // WebSocket Notifications
 //------------------------------------------------------------------------------
 
-constexpr TickType_t WS_SEND_TIMEOUT = pdMS_TO_TICKS(2000);
-
+// Binary or JSON depending on what the server speaks; see messages.h.
 void send_displaying_notification(int counter) {
-  char message[64];
-  int len =
-      snprintf(message, sizeof(message), "{\"displaying\":%d}", counter);
-  if (len > 0 && static_cast<size_t>(len) < sizeof(message)) {
-    int sent = sockets_send_text(message, len, WS_SEND_TIMEOUT);
-    if (sent < 0) {
-      ESP_LOGD(TAG, "WS send skipped (displaying:%d)", counter);
-    } else {
-      ESP_LOGD(TAG, "WS send: %s", message);
-    }
-  }
+  msg_send_displaying(counter);
 }
 
-void send_queued_notification(int counter) {
-  char message[64];
-  int len =
-      snprintf(message, sizeof(message), "{\"queued\":%d}", counter);
-  if (len > 0 && static_cast<size_t>(len) < sizeof(message)) {
-    int sent = sockets_send_text(message, len, WS_SEND_TIMEOUT);
-    if (sent < 0) {
-      ESP_LOGD(TAG, "WS send skipped (queued:%d)", counter);
-    } else {
-      ESP_LOGD(TAG, "WS Send: %s", message);
-    }
-  }
-}
+void send_queued_notification(int counter) { msg_send_queued(counter); }
 
 //------------------------------------------------------------------------------
 // State Transitions
@@ -414,6 +871,7 @@ void send_queued_notification(int counter) {
 
 void goto_idle() {
   destroy_decoder();
+  ctx.showing_preview.store(false, std::memory_order_release);
   ctx.state.store(State::IDLE);
   xEventGroupSetBits(ctx.event_group, BIT_IDLE);
 }
@@ -422,17 +880,32 @@ bool start_playback() {
   ctx.decode_error_count = 0;
   ctx.static_rendered = false;
 
-  if (!create_decoder()) {
+  if (!adopt_prefetched() && !create_decoder()) {
     return false;
   }
 
   ctx.playback_start_us = esp_timer_get_time();
   ctx.next_frame_tick = xTaskGetTickCount();
+  ctx.timeline_due_us = 0;
+  ctx.skip_run = 0;
+  portENTER_CRITICAL(&ctx.timing_lock);
+  frame_stats_reset(&ctx.timing);
+  ctx.timing_counter = ctx.active_counter;
+  ctx.timing_source = ctx.source_type;
+  ctx.timing_name = ctx.embedded_name;
+  portEXIT_CRITICAL(&ctx.timing_lock);
   ctx.state.store(State::PLAYING);
   xEventGroupClearBits(ctx.event_group, BIT_IDLE);
   clear_error_indicator_pixel();
 
-  send_displaying_notification(ctx.active_counter);
+  // A preview is not the image the server queued; it gets its displaying
+  // notification when the full image replaces the preview.
+  if (!ctx.showing_preview.load(std::memory_order_acquire)) {
+    send_displaying_notification(ctx.active_counter);
+  }
+  if (ctx.source_type == GFX_SOURCE_RAM) {
+    boot_profile_mark(BOOT_STAGE_FIRST_IMAGE);
+  }
   emit_playing_event();
   ESP_LOGI(TAG, "Playback started: counter=%d, dwell=%ld",
            ctx.active_counter, static_cast<long>(ctx.dwell_secs));
@@ -535,13 +1008,21 @@ void handle_pending_command(bool emit_stopped_before_replace = false) {
     ctx.webp_len = ctx.pending.len;
     ctx.dwell_secs = ctx.pending.dwell_secs;
     ctx.active_counter = ctx.pending.counter;
-    ctx.loaded_counter = ctx.pending.counter;
+    if (!ctx.pending.preview) ctx.loaded_counter = ctx.pending.counter;
+    ctx.showing_preview.store(ctx.pending.preview, std::memory_order_release);
     ctx.source_type = ctx.pending.source_type;
     ctx.embedded_name = ctx.pending.embedded_name;
 
+    // A decoder prefetched for this image comes along with it.
+    if (ctx.staged.ready && ctx.staged.counter == ctx.pending.counter) {
+      ctx.next = std::move(ctx.staged);
+    }
+    ctx.staged = StagedImage();
+
     ctx.pending.buf = nullptr;
     ctx.pending.len = 0;
     ctx.pending.embedded_name = nullptr;
+    ctx.pending.preview = false;
     ctx.pending.valid.store(false, std::memory_order_release);
   }
 
@@ -583,19 +1064,110 @@ int decode_and_render_frame() {
     return 60000;  // Unlimited duration: sleep up to 60s per iteration
   }
 
-  const uint8_t* frame = nullptr;
-  if (ctx.decoder.get_next_frame(&frame) != ESP_OK) {
+  // Frame source, in order: the prefetched first frame, the decode
+  // pipeline's ring, or an inline decode.
+  const uint8_t* frame = ctx.primed_frame;
+  WebpFrameInfo frame_info = ctx.primed_info;
+  uint32_t frame_delay_ms = 0;
+  int slot_idx = -1;
+  ctx.primed_frame = nullptr;
+  bool ok = true;
+  if (frame) {
+    frame_delay_ms = ctx.decoder.get_frame_delay();
+  } else if (ctx.pipe.active) {
+    uint8_t idx = 0;
+    if (xQueueReceive(ctx.pipe.ready_q, &idx, 0) != pdTRUE) {
+      // Nothing decoded yet: decode is the bottleneck for this frame.
+      ctx.stat_render_starved.fetch_add(1, std::memory_order_relaxed);
+      if (xQueueReceive(ctx.pipe.ready_q, &idx, PIPELINE_FRAME_TIMEOUT) !=
+          pdTRUE) {
+        ESP_LOGE(TAG, "Decode stage stalled");
+        ctx.frame_seq += 2;
+        return -1;
+      }
+    }
+    const PipelineSlot& slot = ctx.pipe.slots[idx];
+    slot_idx = idx;
+    ok = slot.ok;
+    frame = slot.pixels;
+    frame_info = slot.info;
+    frame_delay_ms = slot.delay_ms;
+  } else {
+    const int64_t t0 = esp_timer_get_time();
+    ok = ctx.decoder.get_next_frame(&frame, &frame_info) == ESP_OK;
+    if (ok) {
+      frame_delay_ms = ctx.decoder.get_frame_delay();
+      note_decode_time(esp_timer_get_time() - t0);
+      publish_cache_stats();
+    }
+  }
+
+  if (!ok) {
+    // The failed decode may have advanced past a frame we never saw, and
+    // handle_decode_error then recreates the decoder (stopping the pipeline
+    // and resetting its queues). Either way the next change rectangle is not
+    // relative to anything the copies hold, so put them out of reach of
+    // change_bounds and force a full diff.
+    ctx.frame_seq += 2;
     return -1;
   }
+  note_decoded_frame(frame_info);
 
   // Reset error count on successful decode
   ctx.decode_error_count = 0;
 
+#if CONFIG_PLAYER_FRAME_SKIP
+  // Behind the authored timeline far enough that this frame's whole display
+  // interval has already passed: drop it rather than play everything late.
+  // The frame copies simply fall further behind; change_bounds notices.
+  if (ctx.decoder_info.is_animated) {
+    const bool first = ctx.timeline_due_us == 0;
+    ctx.timeline_due_us += static_cast<int64_t>(frame_delay_ms) * 1000;
+    const int64_t behind_us = esp_timer_get_time() - ctx.playback_start_us -
+                              ctx.timeline_due_us;
+    if (!first && behind_us >= 0 && ctx.skip_run < MAX_SKIP_RUN) {
+      ctx.skip_run++;
+      portENTER_CRITICAL(&ctx.timing_lock);
+      frame_stats_frame_skipped(&ctx.timing, frame_delay_ms);
+      portEXIT_CRITICAL(&ctx.timing_lock);
+      if (slot_idx >= 0) {
+        const uint8_t idx = static_cast<uint8_t>(slot_idx);
+        xQueueSend(ctx.pipe.free_q, &idx, 0);
+      }
+      return 1;
+    }
+    ctx.skip_run = 0;
+  }
+#endif
+
   // Render frame, skipping unchanged content
+  const int64_t t0 = esp_timer_get_time();
+  ctx.frame_diff_us = 0;
+  ctx.frame_draw_us = 0;
+  ctx.frame_flip_us = 0;
   render_frame_diffed(frame, ctx.decoder_info.canvas_width,
                       ctx.decoder_info.canvas_height);
+  const int64_t t1 = esp_timer_get_time();
+  ctx.stat_rendered.fetch_add(1, std::memory_order_relaxed);
+  note_stage_time(ctx.stat_render_us, ctx.stat_render_max_us, t1 - t0);
+  portENTER_CRITICAL(&ctx.timing_lock);
+  frame_hist_add(&ctx.timing.diff, ctx.frame_diff_us);
+  frame_hist_add(&ctx.timing.draw, ctx.frame_draw_us);
+  frame_hist_add(&ctx.timing.flip, ctx.frame_flip_us);
+  frame_stats_frame_shown(&ctx.timing, t1, frame_delay_ms);
+  portEXIT_CRITICAL(&ctx.timing_lock);
+
+  if (slot_idx >= 0) {
+    const uint8_t idx = static_cast<uint8_t>(slot_idx);
+    xQueueSend(ctx.pipe.free_q, &idx, 0);
+  } else if (ctx.decoder_info.is_animated &&
+             ctx.decoder_info.frame_count > 1) {
+    // Decoded inline (first frame or after an error); decode ahead from
+    // here on.
+    start_pipeline();
+  }
 
-  int delay_ms = static_cast<int>(ctx.decoder.get_frame_delay());
+  int delay_ms = static_cast<int>(frame_delay_ms);
 
   // Static image: mark as rendered and compute remaining dwell time.
   if (!ctx.decoder_info.is_animated) {
@@ -626,10 +1198,34 @@ int decode_and_render_frame() {
 TickType_t calculate_wait_ticks(int delay_ms) {
   if (delay_ms <= 0) return 0;
 
+#if CONFIG_PLAYER_FRAME_SKIP
+  // Animations wait for the next frame's slot on the authored timeline, so
+  // lateness is made up by skipping rather than carried forward.
+  if (ctx.decoder_info.is_animated) {
+    const int64_t ahead_us = ctx.playback_start_us + ctx.timeline_due_us -
+                             esp_timer_get_time();
+    if (ahead_us > 0) return pdMS_TO_TICKS((ahead_us + 999) / 1000);
+    // A frame just dropped is accounted as skipped, not late.
+    if (ctx.skip_run == 0 && ahead_us < -1000) {
+      portENTER_CRITICAL(&ctx.timing_lock);
+      ctx.timing.late++;
+      portEXIT_CRITICAL(&ctx.timing_lock);
+    }
+    return 0;
+  }
+#endif
+
   TickType_t target = ctx.next_frame_tick + pdMS_TO_TICKS(delay_ms);
   TickType_t now = xTaskGetTickCount();
 
   if (now >= target) {
+    // Behind the authored timeline: this frame starts late and the schedule
+    // restarts from now.
+    if (now > target && ctx.decoder_info.is_animated) {
+      portENTER_CRITICAL(&ctx.timing_lock);
+      ctx.timing.late++;
+      portEXIT_CRITICAL(&ctx.timing_lock);
+    }
     ctx.next_frame_tick = now;
     return 0;
   }
@@ -710,7 +1306,7 @@ void display_version_info(const char* img_url) {
   int x = (64 - text_width) / 2;
   display_text(version_text, x, 24, 255, 255, 255, 1);
   display_flip();
-  vTaskDelay(pdMS_TO_TICKS(2000));
+  ctx.version_hold_until_us = esp_timer_get_time() + VERSION_HOLD_US;
 }
 
 //------------------------------------------------------------------------------
@@ -720,6 +1316,14 @@ void display_version_info(const char* img_url) {
 void player_task(void*) {
   ESP_LOGD(TAG, "Player task started on core %d", xPortGetCoreID());
 
+  const int64_t hold_us = ctx.version_hold_until_us - esp_timer_get_time();
+  if (hold_us > 0) {
+    vTaskDelay(pdMS_TO_TICKS(hold_us / 1000));
+    // The boot animation's schedule starts when it is first shown.
+    ctx.playback_start_us = esp_timer_get_time();
+    ctx.next_frame_tick = xTaskGetTickCount();
+  }
+
   while (true) {
     // --- Truly an useless log, but can be helpful for verifying task is running and not stuck in a dead loop ---
     //UBaseType_t stack_free = uxTaskGetStackHighWaterMark(NULL);
@@ -839,7 +1443,7 @@ int gfx_initialize(const char* img_url) {
            heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT));
 
   // Boot animation — use static asset directly (unless skipped)
-  if (!config_get().skip_boot_animation) {
+  if (!ConfigSnapshot()->skip_boot_animation) {
     auto* boot = asset_boot();
     ctx.webp_buf = const_cast<void*>(static_cast<const void*>(boot->data));
     ctx.webp_len = boot->size;
@@ -865,13 +1469,19 @@ int gfx_initialize(const char* img_url) {
 
   if (display_initialize()) return 1;
 
-  auto cfg = config_get();
+  bool skip_boot_animation = false;
+  bool skip_display_version = false;
+  {
+    ConfigSnapshot cfg;
+    skip_boot_animation = cfg->skip_boot_animation;
+    skip_display_version = cfg->skip_display_version;
+  }
 
-  if (cfg.skip_boot_animation) {
+  if (skip_boot_animation) {
     display_clear();
   }
 
-  if (!cfg.skip_display_version) {
+  if (!skip_display_version) {
     display_version_info(img_url);
   }
 
@@ -882,7 +1492,24 @@ int gfx_initialize(const char* img_url) {
     ctx.state.store(State::PLAYING);
   }
 
-  BaseType_t ret = xTaskCreatePinnedToCore(
+  // Optional, and created before the player task that hands it work:
+  // without it animations decode inline in the player task.
+  BaseType_t ret = pdFAIL;
+  ctx.pipe.free_q = xQueueCreate(MAX_PIPELINE_SLOTS, sizeof(uint8_t));
+  ctx.pipe.ready_q = xQueueCreate(MAX_PIPELINE_SLOTS, sizeof(uint8_t));
+  ctx.pipe.stopped = xSemaphoreCreateBinary();
+  if (ctx.pipe.free_q && ctx.pipe.ready_q && ctx.pipe.stopped &&
+      CONFIG_PLAYER_PIPELINE_FRAMES >= 2) {
+    ret = xTaskCreatePinnedToCore(decode_task, "gfx_decode", DECODE_STACK_SIZE,
+                                  nullptr, DECODE_PRIORITY, &ctx.pipe.task,
+                                  DECODE_CORE);
+    if (ret != pdPASS) {
+      ESP_LOGW(TAG, "Could not create decode task");
+      ctx.pipe.task = nullptr;
+    }
+  }
+
+  ret = xTaskCreatePinnedToCore(
       player_task, "webp_player", TASK_STACK_SIZE, nullptr,
       TASK_PRIORITY, &ctx.task, TASK_CORE);
   if (ret != pdPASS) {
@@ -890,6 +1517,16 @@ int gfx_initialize(const char* img_url) {
     return 1;
   }
 
+  // Optional: without it every image is decoded at the switch.
+  ret = xTaskCreatePinnedToCore(prefetch_task, "gfx_prefetch",
+                                PREFETCH_STACK_SIZE, nullptr,
+                                PREFETCH_PRIORITY, &ctx.prefetch_task,
+                                PREFETCH_CORE);
+  if (ret != pdPASS) {
+    ESP_LOGW(TAG, "Could not create prefetch task");
+    ctx.prefetch_task = nullptr;
+  }
+
   ESP_LOGI(TAG, "WebP player initialized (task core=%d, stack=%u)", TASK_CORE,
            TASK_STACK_SIZE);
   return 0;
@@ -904,10 +1541,11 @@ int gfx_update(void* webp, size_t len, int32_t dwell_secs) {
 
   // Free any unconsumed pending buffer (frame-dropping).
   // This also cleans up buffers left behind by an interrupt.
-  if (ctx.pending.buf && !is_static_asset(ctx.pending.buf)) {
+  if (ctx.pending.buf && !is_static_asset(ctx.pending.buf) &&
+      !ctx.pending.preview) {
     ESP_LOGW(TAG, "Dropping queued image (counter %d)", ctx.counter);
-    free(ctx.pending.buf);
   }
+  drop_pending_locked();
 
   ctx.counter++;
   int counter = ctx.counter;
@@ -918,6 +1556,7 @@ int gfx_update(void* webp, size_t len, int32_t dwell_secs) {
   ctx.pending.counter = counter;
   ctx.pending.source_type = GFX_SOURCE_RAM;
   ctx.pending.embedded_name = nullptr;
+  ctx.pending.preview = false;
   ctx.pending.valid.store(true, std::memory_order_release);
 
   ESP_LOGI(TAG, "Queued image counter=%d size=%zu dwell=%ld",
@@ -925,6 +1564,16 @@ int gfx_update(void* webp, size_t len, int32_t dwell_secs) {
 
   lock.release();
 
+  // The preview on screen stands in for this image; replace it now rather
+  // than after its dwell. Otherwise, if the image has to wait for the
+  // current one's dwell, build its decoder in the meantime.
+  if (ctx.showing_preview.load(std::memory_order_acquire)) {
+    ctx.interrupt_request.store(InterruptRequest::PREEMPT_PENDING,
+                                std::memory_order_release);
+  } else if (ctx.prefetch_task && ctx.state.load() == State::PLAYING) {
+    xTaskNotifyGive(ctx.prefetch_task);
+  }
+
   // Always notify after enqueue to avoid races where state flips to IDLE
   // between queueing and the task's next wait. This does not force preemption:
   // PLAYING state still keeps queued images until dwell expires unless an
@@ -937,6 +1586,39 @@ int gfx_update(void* webp, size_t len, int32_t dwell_secs) {
   return counter;
 }
 
+int gfx_update_preview(void* webp, size_t len, int32_t dwell_secs) {
+  raii::MutexGuard lock(ctx.mutex);
+  if (!lock) {
+    ESP_LOGE(TAG, "Could not take mutex");
+    return -1;
+  }
+
+  // A real image already waiting wins over a preview of a later one.
+  if (ctx.pending.valid.load(std::memory_order_acquire) &&
+      !ctx.pending.preview) {
+    return -1;
+  }
+  drop_pending_locked();
+
+  ctx.pending.buf = webp;
+  ctx.pending.len = len;
+  ctx.pending.dwell_secs = dwell_secs;
+  ctx.pending.counter = ctx.counter + 1;  // the image it stands in for
+  ctx.pending.source_type = GFX_SOURCE_RAM;
+  ctx.pending.embedded_name = nullptr;
+  ctx.pending.preview = true;
+  ctx.pending.valid.store(true, std::memory_order_release);
+
+  ESP_LOGI(TAG, "Queued preview size=%zu dwell=%ld", len,
+           static_cast<long>(dwell_secs));
+
+  lock.release();
+  if (ctx.task) {
+    xTaskNotifyGive(ctx.task);
+  }
+  return 0;
+}
+
 int gfx_get_loaded_counter(void) {
   if (!ctx.initialized) return -1;
   raii::MutexGuard lock(ctx.mutex);
@@ -944,6 +1626,51 @@ int gfx_get_loaded_counter(void) {
   return ctx.loaded_counter;
 }
 
+void gfx_get_pipeline_stats(gfx_pipeline_stats_t* out) {
+  if (!out) return;
+  out->enabled = ctx.pipe.task != nullptr;
+  out->frames_decoded = ctx.stat_decoded.load(std::memory_order_relaxed);
+  out->frames_rendered = ctx.stat_rendered.load(std::memory_order_relaxed);
+  out->decode_avg_us =
+      out->frames_decoded
+          ? static_cast<uint32_t>(
+                ctx.stat_decode_us.load(std::memory_order_relaxed) /
+                out->frames_decoded)
+          : 0;
+  out->render_avg_us =
+      out->frames_rendered
+          ? static_cast<uint32_t>(
+                ctx.stat_render_us.load(std::memory_order_relaxed) /
+                out->frames_rendered)
+          : 0;
+  out->decode_max_us = ctx.stat_decode_max_us.load(std::memory_order_relaxed);
+  out->render_max_us = ctx.stat_render_max_us.load(std::memory_order_relaxed);
+  out->render_starved =
+      ctx.stat_render_starved.load(std::memory_order_relaxed);
+  out->decode_blocked =
+      ctx.stat_decode_blocked.load(std::memory_order_relaxed);
+}
+
+void gfx_get_timing_stats(gfx_timing_stats_t* out) {
+  if (!out) return;
+  portENTER_CRITICAL(&ctx.timing_lock);
+  out->source_type = ctx.timing_source;
+  out->embedded_name = ctx.timing_name;
+  out->counter = ctx.timing_counter;
+  out->stats = ctx.timing;
+  portEXIT_CRITICAL(&ctx.timing_lock);
+}
+
+void gfx_get_frame_cache_stats(gfx_frame_cache_stats_t* out) {
+  if (!out) return;
+  out->hits = ctx.cache_hits_base.load(std::memory_order_relaxed) +
+              ctx.cache_hits.load(std::memory_order_relaxed);
+  out->misses = ctx.cache_misses_base.load(std::memory_order_relaxed) +
+                ctx.cache_misses.load(std::memory_order_relaxed);
+  out->active_bytes = ctx.cache_bytes.load(std::memory_order_relaxed);
+  out->active_complete = ctx.cache_complete.load(std::memory_order_relaxed);
+}
+
 int gfx_play_embedded(const char* name, bool immediate) {
   const embedded_asset_t* asset = asset_find(name);
   if (!asset) {
@@ -962,9 +1689,7 @@ int gfx_play_embedded(const char* name, bool immediate) {
   }
 
   // Free any unconsumed pending buffer.
-  if (ctx.pending.buf && !is_static_asset(ctx.pending.buf)) {
-    free(ctx.pending.buf);
-  }
+  drop_pending_locked();
 
   ctx.counter++;
   int counter = ctx.counter;
@@ -976,6 +1701,7 @@ int gfx_play_embedded(const char* name, bool immediate) {
   ctx.pending.counter = counter;
   ctx.pending.source_type = GFX_SOURCE_EMBEDDED;
   ctx.pending.embedded_name = asset->name;
+  ctx.pending.preview = false;
   ctx.pending.valid.store(true, std::memory_order_release);
 
   ESP_LOGI(TAG, "Queued embedded sprite '%s' counter=%d", name, counter);
@@ -1031,6 +1757,12 @@ void gfx_preempt(void) {
   if (ctx.task) xTaskNotifyGive(ctx.task);
 }
 
+bool gfx_has_pending(void) {
+  raii::MutexGuard lock(ctx.mutex);
+  return lock && ctx.pending.valid.load(std::memory_order_acquire) &&
+         ctx.pending.source_type == GFX_SOURCE_RAM && !ctx.pending.preview;
+}
+
 void gfx_wait_idle(void) {
   if (!ctx.event_group) return;
   xEventGroupWaitBits(ctx.event_group, BIT_IDLE, pdFALSE, pdTRUE,
@@ -5,6 +5,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "frame_stats.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -63,12 +65,24 @@ void gfx_shutdown(void);
 
 /**
  * Queue a RAM WebP buffer for playback.
- * Ownership of @p webp transfers to the player only on success.
- * On error (return < 0), caller retains ownership and must free it.
+ * Ownership of @p webp transfers to the player only on success; the player
+ * releases it with image_arena_free(), so it may come from image_arena_alloc()
+ * or the heap. On error (return < 0), caller retains ownership and must free
+ * it.
  * @return counter value, or -1 on error
  */
 int gfx_update(void* webp, size_t len, int32_t dwell_secs);
 
+/**
+ * Queue a still preview (first frame of an image that is still arriving).
+ * Unlike gfx_update() it never displaces a queued real image, does not
+ * consume a counter or notify the server, and the next gfx_update() preempts
+ * it immediately instead of waiting out its dwell.
+ * Ownership of @p webp transfers to the player only on success (return 0).
+ * @return 0 on success, -1 if refused (caller keeps @p webp)
+ */
+int gfx_update_preview(void* webp, size_t len, int32_t dwell_secs);
+
 /**
  * Cap dwell time while the panel is dark (brightness 0%) so the device returns
  * for the next image sooner, keeping HTTP/WebSocket playlists warm. Returns
@@ -104,6 +118,9 @@ void gfx_interrupt(void);
 /** Interrupt current playback and immediately apply pending content if any. */
 void gfx_preempt(void);
 
+/** True while an image queued with gfx_update() waits for the player. */
+bool gfx_has_pending(void);
+
 /** Block until the gfx task finishes the current animation. */
 void gfx_wait_idle(void);
 
@@ -119,6 +136,49 @@ bool gfx_is_animating(void);
 
 int gfx_get_loaded_counter(void);
 
+typedef struct {
+  uint32_t hits;          // frames replayed from the cache (all images)
+  uint32_t misses;        // frames decoded by libwebp (all images)
+  uint32_t active_bytes;  // cache reserved for the current image, 0 if none
+  bool active_complete;   // current image is fully cached
+} gfx_frame_cache_stats_t;
+
+/** Animation frame cache counters since boot. */
+void gfx_get_frame_cache_stats(gfx_frame_cache_stats_t* out);
+
+typedef struct {
+  bool enabled;              // animations decode on the other core
+  uint32_t frames_decoded;   // decode stage (pipelined or inline)
+  uint32_t frames_rendered;  // diff + draw stage
+  uint32_t decode_avg_us;
+  uint32_t decode_max_us;
+  uint32_t render_avg_us;
+  uint32_t render_max_us;
+  uint32_t render_starved;  // render had to wait for a decoded frame
+  uint32_t decode_blocked;  // decode found every ring slot still queued
+} gfx_pipeline_stats_t;
+
+/**
+ * Decode/render stage timing since boot. A growing render_starved means
+ * decode limits the frame rate; decode_blocked grows whenever decode runs
+ * ahead of the frame delay, which is the healthy case.
+ */
+void gfx_get_pipeline_stats(gfx_pipeline_stats_t* out);
+
+typedef struct {
+  gfx_source_type_t source_type;
+  const char* embedded_name;  // Valid if source_type == GFX_SOURCE_EMBEDDED
+  int counter;                // image the stats belong to
+  frame_stats_t stats;
+} gfx_timing_stats_t;
+
+/**
+ * Frame timing of the current playback, or of the last one while idle:
+ * per-stage histograms (decode, diff, draw, flip), late frames and the
+ * achieved vs authored frame rate (frame_stats.h).
+ */
+void gfx_get_timing_stats(gfx_timing_stats_t* out);
+
 #ifdef __cplusplus
 }
 #endif
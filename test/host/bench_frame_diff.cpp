@@ -0,0 +1,96 @@
+// Host benchmark for the player's frame diff: the scalar row memcmp + pixel
+// walk render_frame_diffed used to run against frame_diff_rows.
+//
+//   cmake -S test/host -B test/host/build
+//   cmake --build test/host/build --target host_frame_diff_bench
+//   test/host/build/host_frame_diff_bench
+//
+// Absolute numbers are host numbers. Both paths prove clean rows with the libc
+// memcmp, so dirty_rows=0 should come out level. Identical frames never reach either path: the player
+// short-circuits them with a whole-frame memcmp first.
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "frame_diff.h"
+
+namespace {
+
+constexpr int kIterations = 2000;
+
+int scalar_diff_rows(const uint8_t* cur, const uint8_t* prev, int w, int h,
+                     size_t bpp, frame_diff_span_t* spans) {
+  const size_t row_bytes = (size_t)w * bpp;
+  int dirty = 0;
+  for (int y = 0; y < h; y++) {
+    const uint8_t* a = cur + y * row_bytes;
+    const uint8_t* b = prev + y * row_bytes;
+    if (memcmp(a, b, row_bytes) == 0) {
+      spans[y].first = spans[y].last = -1;
+      continue;
+    }
+    int first = 0;
+    while (memcmp(a + first * bpp, b + first * bpp, bpp) == 0) first++;
+    int last = w - 1;
+    while (memcmp(a + last * bpp, b + last * bpp, bpp) == 0) last--;
+    spans[y].first = (int16_t)first;
+    spans[y].last = (int16_t)last;
+    dirty++;
+  }
+  return dirty;
+}
+
+template <typename Fn>
+double ns_per_frame(Fn fn) {
+  volatile int sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; i++) sink = sink + fn();
+  auto end = std::chrono::steady_clock::now();
+  (void)sink;
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+         kIterations;
+}
+
+// Typical clock/ticker content: a small block of changed pixels per frame.
+void make_frames(uint8_t* prev, uint8_t* cur, int w, int h, size_t bpp,
+                 int changed_rows) {
+  const size_t bytes = (size_t)w * h * bpp;
+  for (size_t i = 0; i < bytes; i++) prev[i] = (uint8_t)(i * 31);
+  memcpy(cur, prev, bytes);
+  for (int y = 0; y < changed_rows; y++) {
+    uint8_t* row = cur + (size_t)(h / 4 + y) * w * bpp;
+    for (int x = w / 3; x < w / 3 + 10; x++) row[x * bpp] ^= 0xFF;
+  }
+}
+
+void run_case(int w, int h, size_t bpp, int changed_rows) {
+  const size_t bytes = (size_t)w * h * bpp;
+  uint8_t* prev = (uint8_t*)malloc(bytes);
+  uint8_t* cur = (uint8_t*)malloc(bytes);
+  frame_diff_span_t spans[64];
+  make_frames(prev, cur, w, h, bpp, changed_rows);
+
+  double scalar = ns_per_frame(
+      [&] { return scalar_diff_rows(cur, prev, w, h, bpp, spans); });
+  double kernel =
+      ns_per_frame([&] { return frame_diff_rows(cur, prev, w, h, bpp, spans); });
+  printf("%3dx%-3d bpp=%zu dirty_rows=%-3d scalar %8.0f ns  kernel %8.0f ns"
+         "  (%.2fx)\n",
+         w, h, bpp, changed_rows, scalar, kernel, scalar / kernel);
+  free(prev);
+  free(cur);
+}
+
+}  // namespace
+
+int main() {
+  const size_t bpps[] = {4, 3, 2};
+  for (size_t bpp : bpps) {
+    run_case(128, 64, bpp, 0);
+    run_case(128, 64, bpp, 8);
+    run_case(128, 64, bpp, 48);
+    run_case(64, 32, bpp, 8);
+  }
+  return 0;
+}
@@ -0,0 +1,147 @@
+// Host benchmark for the 64x32-on-128x64 dirty-rectangle path: diff at source
+// resolution, coalesce into rectangles, then upscale and blit each one. The
+// old display_draw_rect upscaled and blitted one source row at a time; the
+// block path doubles as many rows as fit in the 4 KB scale buffer per blit,
+// and like the player falls back to one blit per span for a rectangle that is
+// mostly unchanged pixels.
+//
+//   cmake -S test/host -B test/host/build
+//   cmake --build test/host/build --target host_upscale_bench
+//   test/host/build/host_upscale_bench
+//
+// draw_pixels is stood in for by a copy into a 128x64 panel buffer. On the
+// device each call also pays the driver's per-call setup and bit-plane
+// conversion, so the call counts printed matter at least as much as the time.
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "frame_diff.h"
+#include "upscale2x.h"
+
+namespace {
+
+constexpr int kIterations = 2000;
+constexpr int kSrcW = 64;
+constexpr int kSrcH = 32;
+constexpr int kMaxRects = 16;
+constexpr size_t kScalePx = 128 * 8;
+constexpr int kSparseRatio = 2;  // SPARSE_RECT_RATIO in webp_player.cpp
+
+uint8_t panel[128 * 64 * 4];
+uint8_t scale_buf[kScalePx * 4];
+long draw_calls = 0;
+
+void fake_draw_pixels(int x, int y, int w, int h, const uint8_t* px,
+                      size_t bpp) {
+  draw_calls++;
+  for (int r = 0; r < h; r++) {
+    memcpy(panel + ((size_t)(y + r) * 128 + x) * bpp, px + (size_t)r * w * bpp,
+           (size_t)w * bpp);
+  }
+}
+
+// The previous path: each source row of the rectangle doubled into a
+// two-row blit of its own.
+void draw_rows(const uint8_t* frame, const frame_diff_rect_t& r, size_t bpp,
+               const frame_diff_span_t* = nullptr) {
+  const size_t stride = (size_t)kSrcW * bpp;
+  for (int row = r.y; row < r.y + r.h; row++) {
+    upscale2x_block(frame + row * stride + r.x * bpp, stride, r.w, 1, bpp,
+                    scale_buf);
+    fake_draw_pixels(r.x * 2, row * 2, r.w * 2, 2, scale_buf, bpp);
+  }
+}
+
+void draw_block(const uint8_t* frame, const frame_diff_rect_t& r,
+                size_t bpp, const frame_diff_span_t* spans) {
+  const size_t stride = (size_t)kSrcW * bpp;
+  if (r.w * r.h > kSparseRatio * frame_diff_rect_dirty_px(spans, r)) {
+    for (int y = r.y; y < r.y + r.h; y++) {
+      if (spans[y].first < 0) continue;
+      const int16_t w = (int16_t)(spans[y].last - spans[y].first + 1);
+      const frame_diff_rect_t span = {spans[y].first, (int16_t)y, w, 1};
+      draw_rows(frame, span, bpp);
+    }
+    return;
+  }
+  const int batch = upscale2x_rows_per_batch(r.w, kScalePx);
+  for (int row = 0; row < r.h; row += batch) {
+    const int n = r.h - row < batch ? r.h - row : batch;
+    upscale2x_block(frame + (r.y + row) * stride + r.x * bpp, stride, r.w, n,
+                    bpp, scale_buf);
+    fake_draw_pixels(r.x * 2, (r.y + row) * 2, r.w * 2, n * 2, scale_buf,
+                     bpp);
+  }
+}
+
+template <typename Draw>
+double ns_per_frame(const uint8_t* cur, const uint8_t* prev, size_t bpp,
+                    Draw draw, long* calls) {
+  frame_diff_span_t spans[kSrcH];
+  frame_diff_rect_t rects[kMaxRects];
+  draw_calls = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; i++) {
+    frame_diff_rows(cur, prev, kSrcW, kSrcH, bpp, spans);
+    const int n = frame_diff_build_rects(spans, kSrcH, rects, kMaxRects);
+    for (int k = 0; k < n; k++) draw(cur, rects[k], bpp, spans);
+  }
+  auto end = std::chrono::steady_clock::now();
+  *calls = draw_calls / kIterations;
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+         kIterations;
+}
+
+struct Case {
+  const char* name;
+  int x, y, w, h;  // changed block in source pixels
+  int shift;       // > 0: a staircase, each row's w pixels this far right
+};
+
+void run_case(const Case& c, size_t bpp) {
+  const size_t bytes = (size_t)kSrcW * kSrcH * bpp;
+  uint8_t* prev = (uint8_t*)malloc(bytes);
+  uint8_t* cur = (uint8_t*)malloc(bytes);
+  for (size_t i = 0; i < bytes; i++) prev[i] = (uint8_t)(i * 31);
+  memcpy(cur, prev, bytes);
+  for (int y = c.y; y < c.y + c.h; y++) {
+    const int x0 = c.x + (y - c.y) * c.shift;
+    for (int x = x0; x < x0 + c.w && x < kSrcW; x++) {
+      cur[((size_t)y * kSrcW + x) * bpp] ^= 0xFF;
+    }
+  }
+
+  long row_calls = 0;
+  long block_calls = 0;
+  const double rows = ns_per_frame(cur, prev, bpp, draw_rows, &row_calls);
+  const double block = ns_per_frame(cur, prev, bpp, draw_block, &block_calls);
+  printf("%-10s bpp=%zu rows %8.0f ns %3ld calls  block %8.0f ns %3ld calls"
+         "  (%.2fx)\n",
+         c.name, bpp, rows, row_calls, block, block_calls, rows / block);
+  free(prev);
+  free(cur);
+}
+
+}  // namespace
+
+int main() {
+  // Typical 64x32 apps: clock digits, a one-line ticker, a bouncing sprite,
+  // and a full-canvas change (e.g. a transition). The staircases are the
+  // edges of scrolling italic text or a moving diagonal: each row's change
+  // touches the next one's, so they merge into one mostly-clean box.
+  const Case cases[] = {
+      {"clock", 20, 12, 24, 7, 0},
+      {"ticker", 0, 24, 64, 8, 0},
+      {"sprite", 10, 6, 16, 16, 0},
+      {"full", 0, 0, 64, 32, 0},
+      {"italic", 0, 22, 4, 10, 3},
+      {"diagonal", 0, 0, 3, 32, 2},
+  };
+  const size_t bpps[] = {4, 3, 2};
+  for (size_t bpp : bpps) {
+    for (const Case& c : cases) run_case(c, bpp);
+  }
+  return 0;
+}
@@ -3,13 +3,29 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "boot_timeline.h"
 #include "config_contract.h"
+#include "config_record.h"
+#include "config_snapshot.h"
+#include "diag_record.h"
+#include "diag_stage.h"
+#include "etag_table.h"
+#include "event_ring.h"
+#include "event_routes.h"
+#include "frame_diff.h"
+#include "frame_stats.h"
+#include "image_cache_index.h"
+#include "image_slabs.h"
+#include "log_ring.h"
 #include "ota_bundle.h"
 #include "ota_url_utils.h"
 #include "outbox_ring.h"
+#include "playlist.h"
 #include "quiet_hours_eval.h"
 #include "scheduler_fsm.h"
+#include "upscale2x.h"
 #include "webp_frame.h"
+#include "ws_control.h"
 
 static void test_ota_url_parser() {
   ota_url_parts_t parts = {};
@@ -53,6 +69,102 @@ static void test_config_mutation() {
                                       sizeof(err)));
 }
 
+static void test_config_record() {
+  struct Cfg {
+    char name[9];
+    char url[33];
+    bool flag;
+    int mode;
+  };
+  const config_field_t fields[] = {
+      {1, CONFIG_FIELD_STR, offsetof(Cfg, name), sizeof(Cfg::name)},
+      {2, CONFIG_FIELD_STR, offsetof(Cfg, url), sizeof(Cfg::url)},
+      {3, CONFIG_FIELD_RAW, offsetof(Cfg, flag), sizeof(Cfg::flag)},
+      {4, CONFIG_FIELD_RAW, offsetof(Cfg, mode), sizeof(Cfg::mode)},
+  };
+  const size_t n = sizeof(fields) / sizeof(fields[0]);
+
+  Cfg a = {};
+  strcpy(a.name, "tronbyt");
+  strcpy(a.url, "http://x/");
+  a.flag = true;
+  a.mode = 2;
+  uint8_t buf[128];
+  assert(config_record_max_size(fields, n) == 1 + 4 * 3 + 9 + 33 + 1 + 4);
+  // Strings are stored without their padding.
+  const size_t len = config_record_encode(fields, n, &a, buf, sizeof(buf));
+  assert(len == 1 + 4 * 3 + 7 + 9 + 1 + 4);
+  assert(config_record_encode(fields, n, &a, buf, len - 1) == 0);
+
+  Cfg b = {};
+  b.mode = 7;
+  assert(config_record_changed(fields, n, &a, &b) == 0xF);
+  assert(config_record_decode(fields, n, buf, len, &b));
+  assert(memcmp(&a, &b, sizeof(a)) == 0);
+  assert(config_record_changed(fields, n, &a, &b) == 0);
+  b.url[20] = 'z';  // past the NUL: not a change
+  assert(config_record_changed(fields, n, &a, &b) == 0);
+  strcpy(b.url, "http://y/");
+  assert(config_record_changed(fields, n, &a, &b) == 0x2);
+
+  // Fields missing from a record keep their value; unknown tags, oversized
+  // strings and raw fields of the wrong size are skipped or clipped.
+  const uint8_t older[] = {CONFIG_RECORD_VERSION, 9, 2, 0, 'h', 'i',
+                           1, 12, 0, 'a', 'b', 'c', 'd', 'e', 'f',
+                           'g', 'h', 'i', 'j', 'k', 'l',
+                           4, 2, 0, 1, 1};
+  assert(config_record_decode(fields, n, older, sizeof(older), &b));
+  assert(strcmp(b.name, "abcdefgh") == 0);
+  assert(strcmp(b.url, "http://y/") == 0 && b.flag && b.mode == 2);
+
+  // Truncated or foreign records are rejected.
+  assert(!config_record_decode(fields, n, buf, len - 1, &b));
+  buf[0] = CONFIG_RECORD_VERSION + 1;
+  assert(!config_record_decode(fields, n, buf, len, &b));
+}
+
+static void test_config_snapshot() {
+  struct Cfg {
+    int value;
+    char name[8];
+  };
+  Cfg bufs[CONFIG_SNAPSHOT_SLOTS];
+  config_snapshot_t s;
+  const Cfg first = {1, "one"};
+  assert(!config_snapshot_init(&s, bufs, 0, &first));
+  assert(config_snapshot_init(&s, bufs, sizeof(Cfg), &first));
+
+  const Cfg* a = static_cast<const Cfg*>(config_snapshot_acquire(&s));
+  assert(a->value == 1 && strcmp(a->name, "one") == 0);
+
+  // A publish leaves the borrowed copy alone; new readers see the new one.
+  const Cfg second = {2, "two"};
+  assert(config_snapshot_publish(&s, &second));
+  assert(a->value == 1);
+  const Cfg* b = static_cast<const Cfg*>(config_snapshot_acquire(&s));
+  assert(b != a && b->value == 2);
+
+  // With every spare held the writer must wait for a release.
+  const Cfg third = {3, "three"};
+  assert(config_snapshot_publish(&s, &third));
+  const Cfg fourth = {4, "four"};
+  assert(!config_snapshot_publish(&s, &fourth));
+  config_snapshot_release(&s, a);
+  assert(config_snapshot_publish(&s, &fourth));
+  assert(b->value == 2);
+  config_snapshot_release(&s, b);
+
+  // Released buffers are reused round after round.
+  for (int i = 5; i < 20; i++) {
+    const Cfg next = {i, "n"};
+    assert(config_snapshot_publish(&s, &next));
+    const Cfg* c = static_cast<const Cfg*>(config_snapshot_acquire(&s));
+    assert(c->value == i);
+    config_snapshot_release(&s, c);
+  }
+  for (const auto& slot : s.slots) assert(slot.refs == 0);
+}
+
 static void test_scheduler_fsm() {
   assert(scheduler_fsm_next_state(SCHED_MODE_WEBSOCKET, SCHED_STATE_PLAYING,
                                   SCHED_EVT_PLAYER_STOPPED,
@@ -163,6 +275,128 @@ static struct tm make_local(int wday, int hour, int min) {
   return t;
 }
 
+static void test_ws_control() {
+  ws_control_t ctl;
+  // A bare WebP is not a control message.
+  const uint8_t riff[] = {'R', 'I', 'F', 'F', 0, 0, 0, 0};
+  assert(ws_control_parse(riff, sizeof(riff), &ctl) == WS_CONTROL_NONE);
+
+  // dwell 30, brightness 40, immediate, play_cached "k1", an unknown record
+  // that must be skipped, then two bytes of payload.
+  const uint8_t msg[] = {'T', 'B', 'Y', 'T', 2, 25,
+                         0x01, 2, 30, 0,
+                         0x02, 1, 40,
+                         0x03, 1, 0x01,
+                         0x7f, 2, 0xaa, 0xbb,
+                         0x04, 2, 'k', '1',
+                         0x00,
+                         'R', 'I'};
+  // The trailing record header is cut short: invalid.
+  assert(ws_control_parse(msg, sizeof(msg), &ctl) == WS_CONTROL_INVALID);
+
+  uint8_t ok[sizeof(msg)];
+  memcpy(ok, msg, sizeof(msg));
+  ok[5] = 24;
+  assert(ws_control_parse(ok, sizeof(ok), &ctl) == WS_CONTROL_OK);
+  assert(ctl.header_len == 24);
+  assert(ctl.has_dwell && ctl.dwell_secs == 30);
+  assert(ctl.has_brightness && ctl.brightness == 40);
+  assert(ctl.immediate);
+  assert(strcmp(ctl.play_cached, "k1") == 0);
+
+  // The header must be wholly present.
+  assert(ws_control_parse(ok, 10, &ctl) == WS_CONTROL_SHORT);
+  assert(ws_control_parse(ok, 5, &ctl) == WS_CONTROL_SHORT);
+
+  // Wrong version, dwell out of range, short header length.
+  ok[4] = 3;
+  assert(ws_control_parse(ok, sizeof(ok), &ctl) == WS_CONTROL_INVALID);
+  ok[4] = 2;
+  ok[8] = 0;
+  assert(ws_control_parse(ok, sizeof(ok), &ctl) == WS_CONTROL_INVALID);
+  ok[8] = 30;
+  ok[5] = 5;
+  assert(ws_control_parse(ok, sizeof(ok), &ctl) == WS_CONTROL_INVALID);
+
+  // A header with no records is a valid, empty control message.
+  const uint8_t empty[] = {'T', 'B', 'Y', 'T', 2, 6};
+  assert(ws_control_parse(empty, sizeof(empty), &ctl) == WS_CONTROL_OK);
+  assert(!ctl.has_dwell && !ctl.has_brightness && !ctl.immediate);
+  assert(ctl.play_cached[0] == '\0' && ctl.playlist_id[0] == '\0');
+
+  // Playlist id; a NUL inside a key is rejected.
+  uint8_t entry[] = {'T', 'B', 'Y', 'T', 2, 9, 0x05, 1, 'a', 'R'};
+  assert(ws_control_parse(entry, sizeof(entry), &ctl) == WS_CONTROL_OK);
+  assert(strcmp(ctl.playlist_id, "a") == 0 && ctl.header_len == 9);
+  entry[8] = '\0';
+  assert(ws_control_parse(entry, sizeof(entry), &ctl) == WS_CONTROL_INVALID);
+
+  // Notifications round-trip through the same framing.
+  uint8_t out[16];
+  assert(ws_control_encode_counter(WS_CONTROL_QUEUED, 7, out, 11) == 0);
+  size_t n = ws_control_encode_counter(WS_CONTROL_DISPLAYING, 0x01020304, out,
+                                       sizeof(out));
+  assert(n == 12);
+  const uint8_t want[] = {'T', 'B', 'Y', 'T', 2, 12,
+                          WS_CONTROL_DISPLAYING, 4, 4, 3, 2, 1};
+  assert(memcmp(out, want, n) == 0);
+  assert(ws_control_parse(out, n, &ctl) == WS_CONTROL_OK);
+  assert(ctl.header_len == 12);
+}
+
+static void test_playlist() {
+  playlist_t p;
+  playlist_init(&p);
+  void* dropped[PLAYLIST_MAX_ENTRIES];
+  assert(playlist_next(&p) == nullptr);
+
+  const playlist_item_t abc[] = {{"a", 10}, {"b", 20}, {"c", 30}};
+  assert(playlist_set(&p, abc, 3, dropped) == 0);
+  static char ba[4], bb[8], bc[16], bb2[6];
+  void* replaced = nullptr;
+  assert(playlist_store(&p, "a", ba, sizeof(ba), 100, &replaced));
+  assert(replaced == nullptr);
+  assert(!playlist_store(&p, "zz", bb, sizeof(bb), 100, &replaced));
+  // Over budget: the body stays with the caller.
+  assert(!playlist_store(&p, "c", bc, sizeof(bc), 12, &replaced));
+  assert(playlist_store(&p, "c", bc, sizeof(bc), 100, &replaced));
+  assert(playlist_ready(&p) == 2 && p.body_bytes == 20);
+
+  // Rotation skips entries still waiting for their image and wraps.
+  assert(playlist_next(&p)->body == ba);
+  assert(playlist_next(&p)->body == bc);
+  assert(playlist_next(&p)->body == ba);
+
+  // Replacing a body hands back the old one.
+  assert(playlist_store(&p, "b", bb, sizeof(bb), 100, &replaced));
+  assert(playlist_store(&p, "b", bb2, sizeof(bb2), 100, &replaced));
+  assert(replaced == bb && p.body_bytes == 26);
+  assert(playlist_find(&p, "b")->dwell_secs == 20);
+
+  // A new list keeps the ids it shares with the old one and continues after
+  // the current entry ("a").
+  const playlist_item_t cad[] = {{"c", 5}, {"a", 6}, {"d", 7}};
+  assert(playlist_set(&p, cad, 3, dropped) == 1 && dropped[0] == bb2);
+  assert(playlist_find(&p, "b") == nullptr);
+  assert(playlist_find(&p, "c")->body == bc);
+  assert(playlist_find(&p, "c")->dwell_secs == 5);
+  assert(playlist_find(&p, "d")->body == nullptr);
+  assert(playlist_next(&p)->body == bc);
+  assert(p.body_bytes == 20);
+
+  // Bad lists change nothing.
+  const playlist_item_t dup[] = {{"x", 1}, {"x", 2}};
+  assert(playlist_set(&p, dup, 2, dropped) == -1);
+  const playlist_item_t empty_id[] = {{"", 1}};
+  assert(playlist_set(&p, empty_id, 1, dropped) == -1);
+  assert(playlist_set(&p, cad, PLAYLIST_MAX_ENTRIES + 1, dropped) == -1);
+  assert(p.count == 3);
+
+  // An empty list clears it.
+  assert(playlist_set(&p, nullptr, 0, dropped) == 2);
+  assert(p.count == 0 && p.body_bytes == 0 && playlist_next(&p) == nullptr);
+}
+
 static void test_quiet_hours() {
   // Overnight window 22:00 -> 07:00, every day.
   quiet_window_t overnight = {true, 22, 0, 7, 0, 0x7F};
@@ -215,79 +449,856 @@ static void test_quiet_hours() {
   assert(!quiet_hours_any_active(set, 2, &t));
 }
 
+static void set_tz(const char* tz) {
+  setenv("TZ", tz, 1);
+  tzset();
+}
+
+static void test_quiet_hours_schedule() {
+  set_tz("UTC0");
+  // Friday-night window spanning midnight. 2024-03-29 is a Friday.
+  const time_t fri_2100 = 1711746000, fri_2200 = 1711749600,
+               fri_2300 = 1711753200, sat_0700 = 1711782000,
+               sat_0800 = 1711785600, next_fri_2200 = 1712354400;
+  quiet_window_t fri = {true, 22, 0, 7, 0, (uint8_t)(1u << 5)};
+  assert(quiet_hours_next_transition(&fri, 1, fri_2100) == fri_2200);
+  // The edge itself is not "after now".
+  assert(quiet_hours_next_transition(&fri, 1, fri_2200) == sat_0700);
+  assert(quiet_hours_next_transition(&fri, 1, fri_2300) == sat_0700);
+  // Saturday is not a start day: the next edge is a week on.
+  assert(quiet_hours_next_transition(&fri, 1, sat_0800) == next_fri_2200);
+
+  // Back-to-back windows merge: no edge at 07:00.
+  quiet_window_t pair[2] = {{true, 22, 0, 7, 0, 0x7F},
+                            {true, 7, 0, 9, 0, 0x7F}};
+  assert(quiet_hours_next_transition(pair, 2, fri_2300) ==
+         1711789200);  // Sat 09:00
+
+  // Nothing to schedule without an enabled, non-empty window.
+  quiet_window_t off = {false, 22, 0, 7, 0, 0x7F};
+  quiet_window_t zero_len = {true, 10, 0, 10, 0, 0x7F};
+  quiet_window_t no_days = {true, 22, 0, 7, 0, 0};
+  assert(quiet_hours_next_transition(&off, 1, fri_2100) == 0);
+  assert(quiet_hours_next_transition(&zero_len, 1, fri_2100) == 0);
+  assert(quiet_hours_next_transition(&no_days, 1, fri_2100) == 0);
+  assert(quiet_hours_next_transition(nullptr, 0, fri_2100) == 0);
+
+  set_tz("CET-1CEST,M3.5.0,M10.5.0/3");
+  // Spring forward on 2024-03-31: 02:00 CET jumps to 03:00 CEST, skipping
+  // the 02:30 start, so the window begins with the jump.
+  quiet_window_t skipped = {true, 2, 30, 4, 0, 0x7F};
+  assert(quiet_hours_next_transition(&skipped, 1, 1711839600) ==  // 00:00
+         1711846800);  // 03:00 CEST
+  assert(quiet_hours_next_transition(&skipped, 1, 1711846800) ==
+         1711850400);  // 04:00 CEST
+
+  // Fall back on 2024-10-27: 03:00 CEST returns to 02:00 CET, so the wall
+  // clock passes through 01:00-02:30 twice: out at 02:30 CEST, back in when
+  // 02:00 CET comes around, out again at 02:30 CET.
+  quiet_window_t repeated = {true, 1, 0, 2, 30, 0x7F};
+  time_t now = 1729980000;  // 00:00 CEST
+  const time_t edges[] = {1729983600, 1729989000, 1729990800, 1729992600,
+                          1730073600};
+  for (time_t edge : edges) {
+    now = quiet_hours_next_transition(&repeated, 1, now);
+    assert(now == edge);
+  }
+  set_tz("UTC0");
+}
+
+static void test_event_routes() {
+  assert(event_routes_category(150) == 2);
+  assert(event_routes_category(201) == 3);
+  assert(event_routes_category(299) == 4);
+  assert(event_routes_category(42) == 1);
+
+  event_routes_t r;
+  event_routes_init(&r);
+  assert(event_routes_match(&r, 150, 2) == 0);
+
+  // 0: type 150, 1: network category, 2: type 200, 3: out-of-table type.
+  assert(event_routes_add(&r, 150, 2) == 0);
+  assert(event_routes_add(&r, EVENT_ROUTES_ANY_TYPE, 2) == 1);
+  assert(event_routes_add(&r, 200, 3) == 2);
+  assert(event_routes_add(&r, 7, 1) == 3);
+  assert(event_routes_match(&r, 150, 2) == 0x3);
+  assert(event_routes_match(&r, 151, 2) == 0x2);
+  assert(event_routes_match(&r, 200, 3) == 0x4);
+  assert(event_routes_match(&r, 7, 1) == 0x8);
+  assert(event_routes_match(&r, 101, 1) == 0);
+  // A category given explicitly by the emitter routes by it.
+  assert(event_routes_match(&r, 200, 2) == 0x6);
+
+  // Removing shifts the later subscribers' bits down.
+  event_routes_remove(&r, 1);
+  assert(r.count == 3);
+  assert(event_routes_match(&r, 150, 2) == 0x1);
+  assert(event_routes_match(&r, 151, 2) == 0);
+  assert(event_routes_match(&r, 200, 3) == 0x2);
+  assert(event_routes_match(&r, 7, 1) == 0x4);
+  event_routes_remove(&r, 5);
+  assert(r.count == 3);
+
+  while (r.count < EVENT_ROUTES_MAX_SUBSCRIBERS) {
+    assert(event_routes_add(&r, 250, 4) >= 0);
+  }
+  assert(event_routes_add(&r, 250, 4) == -1);
+  assert(event_routes_match(&r, 250, 4) == 0xFFFFFFF8u);
+}
+
+static void test_event_ring() {
+  event_ring_cell_t cells[4];
+  event_ring_t ring;
+  assert(!event_ring_init(&ring, cells, 3));
+  assert(event_ring_init(&ring, cells, 4));
+
+  uint32_t v = 0;
+  assert(!event_ring_pop(&ring, &v, sizeof(v)));
+
+  // FIFO across several laps, full at capacity.
+  uint32_t next_in = 0, next_out = 0;
+  for (int lap = 0; lap < 5; lap++) {
+    while (event_ring_push(&ring, &next_in, sizeof(next_in))) next_in++;
+    assert(next_in - next_out == 4);
+    assert(event_ring_pop(&ring, &v, sizeof(v)) && v == next_out++);
+    assert(event_ring_pop(&ring, &v, sizeof(v)) && v == next_out++);
+  }
+  while (event_ring_pop(&ring, &v, sizeof(v))) assert(v == next_out++);
+  assert(next_out == next_in);
+
+  uint8_t big[EVENT_RING_ITEM_BYTES + 1] = {};
+  assert(!event_ring_push(&ring, big, sizeof(big)));
+  assert(event_ring_push(&ring, big, EVENT_RING_ITEM_BYTES));
+}
+
+static void test_diag_record() {
+  diag_event_t ev = {};
+  ev.seq = 0x01020304;
+  ev.uptime_ms = 123456;
+  ev.code = -42;
+  strcpy(ev.level, "ERROR");
+  strcpy(ev.type, "wifi_disconnect");
+  strcpy(ev.message, "reason 201");
+
+  uint8_t buf[DIAG_RECORD_MAX];
+  const size_t len = diag_record_encode(&ev, buf, sizeof(buf));
+  assert(len == DIAG_RECORD_HEADER + 5 + 15 + 10);
+  assert(buf[0] == DIAG_RECORD_VERSION && buf[4] == 0x04 && buf[7] == 0x01);
+  assert(diag_record_encode(&ev, buf, len - 1) == 0);
+
+  diag_event_t out;
+  assert(diag_record_decode(buf, len, &out));
+  assert(out.seq == ev.seq && out.uptime_ms == ev.uptime_ms);
+  assert(out.code == -42);
+  assert(strcmp(out.level, "ERROR") == 0);
+  assert(strcmp(out.type, "wifi_disconnect") == 0);
+  assert(strcmp(out.message, "reason 201") == 0);
+
+  // Truncated, padded and wrong-version records are rejected.
+  assert(!diag_record_decode(buf, len - 1, &out));
+  assert(!diag_record_decode(buf, len + 1, &out));
+  buf[0] = 2;
+  assert(!diag_record_decode(buf, len, &out));
+
+  // A full message fits DIAG_RECORD_MAX exactly.
+  memset(ev.message, 'x', DIAG_EVENT_MESSAGE_MAX_LEN);
+  ev.message[DIAG_EVENT_MESSAGE_MAX_LEN] = '\0';
+  strcpy(ev.level, "WARNING");
+  memset(ev.type, 't', DIAG_EVENT_TYPE_MAX_LEN);
+  ev.type[DIAG_EVENT_TYPE_MAX_LEN] = '\0';
+  assert(diag_record_encode(&ev, buf, sizeof(buf)) == DIAG_RECORD_MAX);
+  assert(diag_record_decode(buf, DIAG_RECORD_MAX, &out));
+  assert(strlen(out.message) == DIAG_EVENT_MESSAGE_MAX_LEN);
+}
+
+static void test_diag_stage() {
+  static diag_event_t slots[DIAG_STAGE_SLOTS];
+  diag_stage_t stage;
+  diag_stage_init(&stage, slots, 100);
+  diag_event_t out;
+  assert(diag_stage_get(&stage, 100, &out) == DIAG_STAGE_PENDING);
+
+  // Events from flash come back under their own seq.
+  diag_event_t ev = {};
+  ev.seq = 99;
+  strcpy(ev.type, "boot");
+  diag_stage_restore(&stage, &ev);
+  assert(diag_stage_get(&stage, 99, &out) == DIAG_STAGE_OK);
+  assert(strcmp(out.type, "boot") == 0);
+  ev.seq = 101;  // beyond last_seq: ignored
+  diag_stage_restore(&stage, &ev);
+  assert(diag_stage_get(&stage, 101, &out) == DIAG_STAGE_PENDING);
+
+  strcpy(ev.type, "new");
+  ev.code = 1;
+  assert(diag_stage_push(&stage, &ev) == 101);
+  assert(diag_stage_last_seq(&stage) == 101);
+  assert(diag_stage_get(&stage, 101, &out) == DIAG_STAGE_OK);
+  assert(out.seq == 101 && out.code == 1 && strcmp(out.type, "new") == 0);
+
+  // One lap later the oldest are gone and the slot holds the newer event.
+  for (int i = 0; i < DIAG_STAGE_SLOTS; i++) {
+    ev.code = 2 + i;
+    diag_stage_push(&stage, &ev);
+  }
+  assert(diag_stage_last_seq(&stage) == 101 + DIAG_STAGE_SLOTS);
+  assert(diag_stage_get(&stage, 99, &out) == DIAG_STAGE_GONE);
+  assert(diag_stage_get(&stage, 101, &out) == DIAG_STAGE_GONE);
+  assert(diag_stage_get(&stage, 102, &out) == DIAG_STAGE_OK && out.code == 2);
+  assert(diag_stage_get(&stage, 101 + DIAG_STAGE_SLOTS, &out) ==
+         DIAG_STAGE_OK);
+  assert(out.code == 1 + DIAG_STAGE_SLOTS);
+}
+
+static void test_boot_timeline() {
+  boot_timeline_t t;
+  memset(&t, 0xA5, sizeof(t));  // power-on garbage
+  boot_timeline_t prev;
+  boot_timeline_begin_boot(&t, &prev);
+  assert(boot_timeline_valid(&t) && !boot_timeline_valid(&prev));
+  assert(t.boot_count == 1);
+
+  boot_stage_t path[BOOT_STAGE_COUNT];
+  assert(boot_timeline_critical_path(&t, BOOT_STAGE_FIRST_IMAGE, path,
+                                     BOOT_STAGE_COUNT) == 0);
+
+  // Only the first start and end count.
+  boot_timeline_start(&t, BOOT_STAGE_NVS, 0);
+  boot_timeline_end(&t, BOOT_STAGE_NVS, 1000);
+  boot_timeline_end(&t, BOOT_STAGE_NVS, 5000);
+  assert(t.spans[BOOT_STAGE_NVS].start_us == 1);
+  assert(boot_timeline_duration_us(&t, BOOT_STAGE_NVS) == 999);
+  boot_timeline_start(&t, BOOT_STAGE_RUNTIME, 10);
+  assert(boot_timeline_duration_us(&t, BOOT_STAGE_RUNTIME) == 0);
+  boot_timeline_end(&t, BOOT_STAGE_WIFI_CONNECT, 20);  // end without start
+  assert(t.spans[BOOT_STAGE_WIFI_CONNECT].start_us == 20);
+  boot_timeline_mark(&t, BOOT_STAGE_STORAGE, 1LL << 40);
+  assert(t.spans[BOOT_STAGE_STORAGE].end_us == UINT32_MAX);
+  assert(strcmp(boot_timeline_stage_name(BOOT_STAGE_FIRST_IMAGE),
+                "first_image") == 0);
+  assert(strcmp(boot_timeline_stage_name(BOOT_STAGE_COUNT), "unknown") == 0);
+
+  // The path follows whichever dependency finished last: here the Wi-Fi
+  // connect, not the runtime task.
+  boot_timeline_begin_boot(&t, nullptr);
+  int64_t now = 100;
+  for (int s = BOOT_STAGE_NVS; s <= BOOT_STAGE_WIFI_INIT; s++) {
+    if (s == BOOT_STAGE_STORAGE) continue;
+    boot_timeline_end(&t, static_cast<boot_stage_t>(s), now += 100);
+  }
+  boot_timeline_end(&t, BOOT_STAGE_STORAGE, now += 100);
+  boot_timeline_end(&t, BOOT_STAGE_SERVICES, now += 100);
+  boot_timeline_end(&t, BOOT_STAGE_RUNTIME, now += 100);
+  boot_timeline_end(&t, BOOT_STAGE_WIFI_CONNECT, now += 5000);
+  boot_timeline_mark(&t, BOOT_STAGE_FIRST_IMAGE, now += 100);
+  int n = boot_timeline_critical_path(&t, BOOT_STAGE_FIRST_IMAGE, path,
+                                      BOOT_STAGE_COUNT);
+  assert(n == 11);
+  assert(path[0] == BOOT_STAGE_NVS);
+  assert(path[7] == BOOT_STAGE_DISPLAY);
+  assert(path[8] == BOOT_STAGE_WIFI_INIT);
+  assert(path[9] == BOOT_STAGE_WIFI_CONNECT);
+  assert(path[10] == BOOT_STAGE_FIRST_IMAGE);
+  // Truncated paths keep the stages nearest the goal.
+  assert(boot_timeline_critical_path(&t, BOOT_STAGE_FIRST_IMAGE, path, 2) ==
+         2);
+  assert(path[0] == BOOT_STAGE_WIFI_CONNECT);
+  assert(path[1] == BOOT_STAGE_FIRST_IMAGE);
+
+  // The next boot keeps this one as the previous.
+  boot_timeline_begin_boot(&t, &prev);
+  assert(boot_timeline_valid(&prev) && prev.boot_count == 2);
+  assert(prev.spans[BOOT_STAGE_FIRST_IMAGE].end_us == now);
+  assert(t.boot_count == 3 && t.spans[BOOT_STAGE_FIRST_IMAGE].end_us == 0);
+}
+
+static void test_log_ring() {
+  alignas(4) static uint8_t buf[128];
+  log_ring_t ring;
+  assert(!log_ring_init(&ring, buf, 96));
+  assert(log_ring_init(&ring, buf, sizeof(buf)));
+  size_t len = 0;
+  assert(log_ring_peek(&ring, &len) == nullptr);
+
+  // A reserved record is invisible until committed, and blocks later ones.
+  uint8_t* a = log_ring_reserve(&ring, 10);
+  uint8_t* b = log_ring_reserve(&ring, 5);
+  assert(a && b);
+  memcpy(b, "bbbbb", 5);
+  log_ring_commit(&ring, b, 5);
+  assert(log_ring_peek(&ring, &len) == nullptr);
+  memcpy(a, "aaaa", 4);
+  log_ring_commit(&ring, a, 4);  // shorter than reserved
+  const uint8_t* p = log_ring_peek(&ring, &len);
+  assert(p && len == 4 && memcmp(p, "aaaa", 4) == 0);
+  log_ring_release(&ring);
+  p = log_ring_peek(&ring, &len);
+  assert(p && len == 5 && memcmp(p, "bbbbb", 5) == 0);
+  log_ring_release(&ring);
+
+  // 28 bytes in, 40-byte records: two fit before the end, and once the
+  // first is consumed the third wraps to the start behind padding.
+  assert(!log_ring_reserve(&ring, 0));
+  assert(!log_ring_reserve(&ring, 64));
+  uint8_t* r[3];
+  for (int i = 0; i < 3; i++) {
+    if (i == 2) {
+      assert(!log_ring_reserve(&ring, 36));
+      p = log_ring_peek(&ring, &len);
+      assert(p == r[0] && len == 36 && p[35] == 'x');
+      log_ring_release(&ring);
+    }
+    r[i] = log_ring_reserve(&ring, 36);
+    assert(r[i]);
+    memset(r[i], 'x' + i, 36);
+    log_ring_commit(&ring, r[i], 36);
+  }
+  assert(r[2] == buf + 4);
+  assert(!log_ring_reserve(&ring, 36));
+  for (int i = 1; i < 3; i++) {
+    p = log_ring_peek(&ring, &len);
+    assert(p == r[i] && len == 36 && p[35] == 'x' + i);
+    log_ring_release(&ring);
+  }
+  assert(log_ring_peek(&ring, &len) == nullptr);
+  assert(log_ring_reserve(&ring, 36));
+
+  // The newest claim hands back what it did not use; the next record
+  // starts right behind its used bytes.
+  assert(log_ring_init(&ring, buf, sizeof(buf)));
+  a = log_ring_reserve(&ring, 60);
+  memset(a, 'y', 60);
+  log_ring_commit(&ring, a, 5);
+  b = log_ring_reserve(&ring, 8);
+  assert(b == a + 12);
+  assert(log_ring_reserve(&ring, 60));  // fits only in the returned space
+  memcpy(b, "bbbbbbbb", 8);
+  log_ring_commit(&ring, b, 8);
+  p = log_ring_peek(&ring, &len);
+  assert(p == a && len == 5 && p[4] == 'y');
+  log_ring_release(&ring);
+  p = log_ring_peek(&ring, &len);
+  assert(p == b && len == 8 && memcmp(p, "bbbbbbbb", 8) == 0);
+  log_ring_release(&ring);
+  assert(log_ring_peek(&ring, &len) == nullptr);
+}
+
 static void test_outbox_ring() {
-  outbox_ring_t ring;
+  static outbox_ring_t ring;
   outbox_ring_init(&ring);
-  outbox_ring_slot_t slot = {};
+  char out[OUTBOX_RING_BYTES];
 
-  // Empty ring: nothing to pop.
+  // Empty ring: nothing to pop; empty and oversized messages are refused.
   assert(outbox_ring_count(&ring) == 0);
-  assert(!outbox_ring_pop(&ring, &slot));
+  assert(outbox_ring_pop(&ring, out) == 0);
+  assert(!outbox_ring_push(&ring, "x", 0, OUTBOX_KEY_NONE));
+  static char huge[OUTBOX_RING_BYTES + 1];
+  assert(!outbox_ring_push(&ring, huge, sizeof(huge), OUTBOX_KEY_NONE));
 
   // FIFO order is preserved.
   for (int i = 0; i < 3; i++) {
     char buf[16];
     snprintf(buf, sizeof(buf), "msg-%d", i);
-    assert(!outbox_ring_push(&ring, strdup(buf), strlen(buf)));
+    assert(outbox_ring_push(&ring, buf, strlen(buf), OUTBOX_KEY_NONE));
   }
   assert(outbox_ring_count(&ring) == 3);
   for (int i = 0; i < 3; i++) {
     char expect[16];
     snprintf(expect, sizeof(expect), "msg-%d", i);
-    assert(outbox_ring_pop(&ring, &slot));
-    assert(slot.len == strlen(expect));
-    assert(strncmp(slot.data, expect, slot.len) == 0);
-    free(slot.data);
+    size_t len = outbox_ring_pop(&ring, out);
+    assert(len == strlen(expect));
+    assert(strncmp(out, expect, len) == 0);
   }
-  assert(!outbox_ring_pop(&ring, &slot));
+  assert(outbox_ring_pop(&ring, out) == 0);
 
-  // Overflow frees and drops the oldest entry and reports the drop.
+  // A full queue refuses new messages and keeps what it holds.
   for (int i = 0; i < OUTBOX_RING_DEPTH; i++) {
     char buf[16];
     snprintf(buf, sizeof(buf), "m%02d", i);
-    assert(!outbox_ring_push(&ring, strdup(buf), 3));
+    assert(outbox_ring_push(&ring, buf, 3, OUTBOX_KEY_NONE));
   }
-  assert(outbox_ring_push(&ring, strdup("new"), 3));  // drops m00
+  assert(!outbox_ring_push(&ring, "new", 3, OUTBOX_KEY_NONE));
+  assert(!outbox_ring_push(&ring, "key", 3, 1));
   assert(outbox_ring_count(&ring) == OUTBOX_RING_DEPTH);
 
-  // Wraparound: pop one, push one, then drain and verify full FIFO order
-  // across the index seam (m01 was popped, m00 was dropped).
-  assert(outbox_ring_pop(&ring, &slot));
-  assert(strncmp(slot.data, "m01", 3) == 0);
-  free(slot.data);
-  assert(!outbox_ring_push(&ring, strdup("wrp"), 3));
-  for (int i = 2; i < OUTBOX_RING_DEPTH; i++) {
+  // Pop one, push one, then drain and verify full FIFO order.
+  assert(outbox_ring_pop(&ring, out) == 3 && strncmp(out, "m00", 3) == 0);
+  assert(outbox_ring_push(&ring, "wrp", 3, OUTBOX_KEY_NONE));
+  for (int i = 1; i < OUTBOX_RING_DEPTH; i++) {
     char expect[16];
     snprintf(expect, sizeof(expect), "m%02d", i);
-    assert(outbox_ring_pop(&ring, &slot));
-    assert(strncmp(slot.data, expect, 3) == 0);
-    free(slot.data);
+    assert(outbox_ring_pop(&ring, out) == 3);
+    assert(strncmp(out, expect, 3) == 0);
   }
-  assert(outbox_ring_pop(&ring, &slot));
-  assert(strncmp(slot.data, "new", 3) == 0);
-  free(slot.data);
-  assert(outbox_ring_pop(&ring, &slot));
-  assert(strncmp(slot.data, "wrp", 3) == 0);
-  free(slot.data);
+  assert(outbox_ring_pop(&ring, out) == 3 && strncmp(out, "wrp", 3) == 0);
   assert(outbox_ring_count(&ring) == 0);
 
-  // Clear frees everything and empties the ring.
+  // Keyed messages replace their queued predecessor in place, growing or
+  // shrinking it without disturbing the entries around it.
+  assert(outbox_ring_push(&ring, "{\"queued\":9}", 12, 1));
+  assert(outbox_ring_push(&ring, "cache", 5, OUTBOX_KEY_NONE));
+  assert(outbox_ring_push(&ring, "{\"displaying\":8}", 16, 2));
+  assert(outbox_ring_push(&ring, "{\"queued\":10}", 13, 1));
+  assert(outbox_ring_push(&ring, "{\"displaying\":9}", 16, 2));
+  assert(outbox_ring_push(&ring, "{\"queued\":1}", 12, 1));
+  assert(outbox_ring_count(&ring) == 3);
+  assert(outbox_ring_pop(&ring, out) == 12);
+  assert(strncmp(out, "{\"queued\":1}", 12) == 0);
+  assert(outbox_ring_pop(&ring, out) == 5 && strncmp(out, "cache", 5) == 0);
+  assert(outbox_ring_pop(&ring, out) == 16);
+  assert(strncmp(out, "{\"displaying\":9}", 16) == 0);
+
+  // Running out of bytes refuses the message, keyed or not, even when it
+  // would replace a smaller queued one.
+  static char big[OUTBOX_RING_BYTES / 2];
+  memset(big, 'b', sizeof(big));
+  assert(outbox_ring_push(&ring, "a", 1, OUTBOX_KEY_NONE));
+  assert(outbox_ring_push(&ring, big, sizeof(big), OUTBOX_KEY_NONE));
+  assert(outbox_ring_push(&ring, "k", 1, 3));
+  assert(!outbox_ring_push(&ring, big, sizeof(big), OUTBOX_KEY_NONE));
+  assert(!outbox_ring_push(&ring, big, sizeof(big), 3));
+  assert(outbox_ring_count(&ring) == 3);
+  assert(outbox_ring_pop(&ring, out) == 1 && out[0] == 'a');
+  assert(outbox_ring_pop(&ring, out) == sizeof(big) && out[0] == 'b');
+  assert(outbox_ring_pop(&ring, out) == 1 && out[0] == 'k');
+
+  // Clear forgets everything.
   for (int i = 0; i < 5; i++) {
-    assert(!outbox_ring_push(&ring, strdup("x"), 1));
+    assert(outbox_ring_push(&ring, "x", 1, OUTBOX_KEY_NONE));
   }
   outbox_ring_clear(&ring);
   assert(outbox_ring_count(&ring) == 0);
-  assert(!outbox_ring_pop(&ring, &slot));
+  assert(outbox_ring_pop(&ring, out) == 0);
+}
+
+// Reference for frame_diff_rows: the scalar loop render_frame_diffed used
+// before the kernel (row memcmp, then a per-pixel walk from both ends).
+static int scalar_diff_rows(const uint8_t* cur, const uint8_t* prev, int w,
+                            int h, size_t bpp, frame_diff_span_t* spans) {
+  const size_t row_bytes = (size_t)w * bpp;
+  int dirty = 0;
+  for (int y = 0; y < h; y++) {
+    const uint8_t* a = cur + y * row_bytes;
+    const uint8_t* b = prev + y * row_bytes;
+    if (memcmp(a, b, row_bytes) == 0) {
+      spans[y].first = spans[y].last = -1;
+      continue;
+    }
+    int first = 0;
+    while (memcmp(a + first * bpp, b + first * bpp, bpp) == 0) first++;
+    int last = w - 1;
+    while (memcmp(a + last * bpp, b + last * bpp, bpp) == 0) last--;
+    spans[y].first = (int16_t)first;
+    spans[y].last = (int16_t)last;
+    dirty++;
+  }
+  return dirty;
+}
+
+static void test_frame_diff() {
+  const int sizes[][2] = {{64, 32}, {128, 64}, {13, 7}};
+  const size_t bpps[] = {4, 3, 2};
+  frame_diff_span_t got[64];
+  frame_diff_span_t want[64];
+  srand(1234);
+
+  for (const auto& size : sizes) {
+    const int w = size[0];
+    const int h = size[1];
+    for (size_t bpp : bpps) {
+      const size_t bytes = (size_t)w * h * bpp;
+      // +1 so the unaligned pass below can shift both frames by a byte.
+      uint8_t* prev = (uint8_t*)malloc(bytes + 1);
+      uint8_t* cur = (uint8_t*)malloc(bytes + 1);
+      for (int round = 0; round < 50; round++) {
+        for (size_t i = 0; i < bytes; i++) prev[i] = (uint8_t)rand();
+        memcpy(cur, prev, bytes);
+        // Touch a few random bytes, including single channels of a pixel.
+        const int edits = round % 8;
+        for (int e = 0; e < edits; e++) cur[rand() % bytes] ^= 0x5A;
+        if (round == 1) cur[0] ^= 1;             // first byte of the frame
+        if (round == 2) cur[bytes - 1] ^= 1;     // last byte of the frame
+
+        int n_want = scalar_diff_rows(cur, prev, w, h, bpp, want);
+        int n_got = frame_diff_rows(cur, prev, w, h, bpp, got);
+        assert(n_got == n_want);
+        for (int y = 0; y < h; y++) {
+          assert(got[y].first == want[y].first);
+          assert(got[y].last == want[y].last);
+        }
+
+        // Misaligned rows take the byte-wise path and must agree too.
+        memmove(prev + 1, prev, bytes);
+        memmove(cur + 1, cur, bytes);
+        n_got = frame_diff_rows(cur + 1, prev + 1, w, h, bpp, got);
+        assert(n_got == n_want);
+        for (int y = 0; y < h; y++) {
+          assert(got[y].first == want[y].first);
+          assert(got[y].last == want[y].last);
+        }
+      }
+      free(prev);
+      free(cur);
+    }
+  }
+
+  // Rectangles: overlapping adjacent rows merge, gaps and disjoint spans
+  // split, and the last rectangle absorbs the rest at the cap.
+  frame_diff_span_t spans[8] = {{2, 5}, {4, 9}, {-1, -1}, {0, 1},
+                                {20, 22}, {10, 11}, {-1, -1}, {3, 3}};
+  frame_diff_rect_t rects[8];
+  int n = frame_diff_build_rects(spans, 8, rects, 8);
+  assert(n == 5);
+  assert(rects[0].x == 2 && rects[0].y == 0 && rects[0].w == 8 &&
+         rects[0].h == 2);
+  assert(rects[1].x == 0 && rects[1].y == 3 && rects[1].w == 2 &&
+         rects[1].h == 1);
+  assert(rects[2].x == 20 && rects[2].y == 4 && rects[2].h == 1);
+  assert(rects[3].x == 10 && rects[3].y == 5 && rects[3].w == 2);
+  assert(rects[4].x == 3 && rects[4].y == 7 && rects[4].w == 1);
+
+  n = frame_diff_build_rects(spans, 8, rects, 2);
+  assert(n == 2);
+  assert(rects[1].x == 0 && rects[1].y == 3 && rects[1].w == 23 &&
+         rects[1].h == 5);
+  // The overflow box covers 115 pixels of which 8 changed.
+  assert(frame_diff_rect_dirty_px(spans, rects[0]) == 4 + 6);
+  assert(frame_diff_rect_dirty_px(spans, rects[1]) == 2 + 3 + 2 + 1);
+
+  frame_diff_span_t clean[4] = {{-1, -1}, {-1, -1}, {-1, -1}, {-1, -1}};
+  assert(frame_diff_build_rects(clean, 4, rects, 8) == 0);
+}
+
+static void test_frame_diff_bounded() {
+  const int w = 32;
+  const int h = 16;
+  const size_t bpps[] = {4, 3, 2};
+  frame_diff_span_t got[16];
+  frame_diff_span_t want[16];
+  srand(99);
+
+  for (size_t bpp : bpps) {
+    const size_t bytes = (size_t)w * h * bpp;
+    uint8_t* prev = (uint8_t*)malloc(bytes);
+    uint8_t* cur = (uint8_t*)malloc(bytes);
+    for (int round = 0; round < 200; round++) {
+      for (size_t i = 0; i < bytes; i++) prev[i] = (uint8_t)rand();
+      memcpy(cur, prev, bytes);
+      // Changes confined to a random rectangle, as an ANMF frame would make.
+      frame_diff_rect_t r;
+      r.x = (int16_t)(rand() % w);
+      r.y = (int16_t)(rand() % h);
+      r.w = (int16_t)(1 + rand() % (w - r.x));
+      r.h = (int16_t)(1 + rand() % (h - r.y));
+      for (int e = 0; e < 4; e++) {
+        const int x = r.x + rand() % r.w;
+        const int y = r.y + rand() % r.h;
+        cur[((size_t)y * w + x) * bpp + rand() % bpp] ^= 0x81;
+      }
+
+      const int n_want = scalar_diff_rows(cur, prev, w, h, bpp, want);
+      const int n_got = frame_diff_rows_in(cur, prev, w, h, bpp, &r, got);
+      assert(n_got == n_want);
+      for (int y = 0; y < h; y++) {
+        assert(got[y].first == want[y].first);
+        assert(got[y].last == want[y].last);
+      }
+    }
+
+    // Bounds are clipped to the canvas; an empty window reports all clean.
+    memcpy(cur, prev, bytes);
+    cur[bytes - 1] ^= 1;
+    frame_diff_rect_t big = {-5, -5, 100, 100};
+    assert(frame_diff_rows_in(cur, prev, w, h, bpp, &big, got) == 1);
+    assert(got[h - 1].first == w - 1 && got[h - 1].last == w - 1);
+    frame_diff_rect_t empty = {0, 0, 0, 0};
+    assert(frame_diff_rows_in(cur, prev, w, h, bpp, &empty, got) == 0);
+    assert(got[h - 1].first == -1);
+    free(prev);
+    free(cur);
+  }
+
+  frame_diff_rect_t a = {2, 3, 4, 5};
+  frame_diff_rect_t b = {10, 1, 2, 2};
+  frame_diff_rect_t u = frame_diff_rect_union(a, b);
+  assert(u.x == 2 && u.y == 1 && u.w == 10 && u.h == 7);
+  frame_diff_rect_t none = {0, 0, 0, 0};
+  u = frame_diff_rect_union(none, b);
+  assert(u.x == 10 && u.y == 1 && u.w == 2 && u.h == 2);
+}
+
+static void test_frame_stats() {
+  frame_hist_t h = {};
+  assert(frame_hist_percentile(&h, 50) == 0 && frame_hist_avg_us(&h) == 0);
+  frame_hist_add(&h, -5);     // clamps to 0 -> first bucket
+  frame_hist_add(&h, 499);    // still first bucket
+  frame_hist_add(&h, 500);    // bounds are exclusive
+  frame_hist_add(&h, 20000);  // < 33000
+  frame_hist_add(&h, 90000);  // open bucket
+  assert(h.count == 5 && h.max_us == 90000);
+  assert(h.buckets[0] == 2 && h.buckets[1] == 1 && h.buckets[6] == 1 &&
+         h.buckets[FRAME_STATS_BUCKETS - 1] == 1);
+  assert(frame_hist_avg_us(&h) == (499 + 500 + 20000 + 90000) / 5);
+  assert(frame_hist_percentile(&h, 0) == 500);
+  assert(frame_hist_percentile(&h, 40) == 500);
+  assert(frame_hist_percentile(&h, 60) == 1000);
+  assert(frame_hist_percentile(&h, 80) == 33000);
+  assert(frame_hist_percentile(&h, 100) == 90000);
+  // Percentiles never exceed the worst sample.
+  frame_hist_t small = {};
+  frame_hist_add(&small, 700);
+  assert(frame_hist_percentile(&small, 50) == 700);
+
+  frame_stats_t s;
+  frame_stats_reset(&s);
+  frame_stats_frame_shown(&s, 1000000, 100);
+  assert(frame_stats_achieved_fps_x100(&s) == 0);
+  assert(frame_stats_authored_fps_x100(&s) == 0);
+  // Authored 10 fps, shown every 125 ms: 8 fps achieved.
+  for (int i = 1; i <= 8; i++) {
+    frame_stats_frame_shown(&s, 1000000 + i * 125000, 100);
+  }
+  assert(s.frames == 9 && s.authored_ms == 800);
+  assert(frame_stats_authored_fps_x100(&s) == 1000);
+  assert(frame_stats_achieved_fps_x100(&s) == 800);
+
+  // Skipping every other frame of a 10 fps animation keeps it on its
+  // timeline: shown at 5 fps, still authored at 10.
+  frame_stats_reset(&s);
+  frame_stats_frame_shown(&s, 0, 100);
+  for (int i = 1; i <= 4; i++) {
+    frame_stats_frame_skipped(&s, 100);
+    frame_stats_frame_shown(&s, i * 200000, 100);
+  }
+  assert(s.frames == 5 && s.skipped == 4 && s.authored_ms == 800);
+  assert(frame_stats_authored_fps_x100(&s) == 1000);
+  assert(frame_stats_achieved_fps_x100(&s) == 500);
+  frame_stats_reset(&s);
+  assert(s.frames == 0 && s.authored_ms == 0 && s.decode.count == 0);
+}
+
+static void test_upscale2x() {
+  const int sw = 8;
+  const size_t bpps[] = {4, 3, 2};
+  for (size_t bpp : bpps) {
+    uint8_t src[8 * 4 * 4];
+    for (size_t i = 0; i < sizeof(src); i++) src[i] = (uint8_t)(i * 7 + 1);
+    // Block (2, 1) 5x3 of the 8x4 source.
+    const int bx = 2, by = 1, bw = 5, bh = 3;
+    const size_t stride = sw * bpp;
+    uint8_t dst[10 * 6 * 4];
+    memset(dst, 0, sizeof(dst));
+    upscale2x_block(src + by * stride + bx * bpp, stride, bw, bh, bpp, dst);
+    for (int y = 0; y < bh * 2; y++) {
+      for (int x = 0; x < bw * 2; x++) {
+        const uint8_t* want = src + (by + y / 2) * stride + (bx + x / 2) * bpp;
+        const uint8_t* got = dst + ((size_t)y * bw * 2 + x) * bpp;
+        assert(memcmp(want, got, bpp) == 0);
+      }
+    }
+  }
+
+  // 128x8 scale buffer: full-width 64px rows go 4 at a time, narrow blocks
+  // proportionally more.
+  assert(upscale2x_rows_per_batch(64, 128 * 8) == 4);
+  assert(upscale2x_rows_per_batch(16, 128 * 8) == 16);
+  assert(upscale2x_rows_per_batch(0, 128 * 8) == 0);
+  assert(upscale2x_rows_per_batch(600, 128 * 8) == 0);
+}
+
+static void test_image_slabs() {
+  const size_t sizes[] = {100, 1000};
+  const int counts[] = {2, 1};
+  const size_t bytes = image_slabs_region_bytes(sizes, counts, 2);
+  assert(bytes == 112 * 2 + 1008);
+  static uint8_t region[112 * 2 + 1008];
+  image_slabs_t s;
+  assert(image_slabs_init(&s, region, sizes, counts, 2));
+
+  // Best fit first, larger classes once the small ones are taken.
+  void* a = image_slabs_alloc(&s, 50);
+  void* b = image_slabs_alloc(&s, 100);
+  void* c = image_slabs_alloc(&s, 60);
+  assert(a == region && b == region + 112 && c == region + 224);
+  assert(image_slabs_capacity(&s, c) == 1000);
+  assert(image_slabs_alloc(&s, 1) == nullptr);
+  assert(image_slabs_in_use(&s) == 3);
+
+  // Foreign and interior pointers are not ours.
+  int on_heap = 0;
+  assert(!image_slabs_free(&s, &on_heap));
+  assert(!image_slabs_free(&s, region + 1));
+  assert(image_slabs_capacity(&s, &on_heap) == 0);
+
+  assert(image_slabs_free(&s, a));
+  assert(image_slabs_alloc(&s, 1001) == nullptr);
+  assert(image_slabs_alloc(&s, 80) == a);
+
+  // Descending classes and too many slabs are rejected.
+  const size_t desc[] = {1000, 100};
+  assert(!image_slabs_init(&s, region, desc, counts, 2));
+  const int many[] = {IMAGE_SLABS_MAX, 1};
+  assert(image_slabs_region_bytes(sizes, many, 2) == 0);
+}
+
+static void test_etag_table() {
+  etag_table_t t;
+  etag_table_init(&t);
+  static char bodies[ETAG_TABLE_SLOTS + 2][4];
+  void* dropped[ETAG_TABLE_SLOTS];
+  bool kept = false;
+
+  assert(etag_table_put(&t, "", bodies[0], 1, 100, &kept, dropped) == -1);
+  assert(etag_table_put(&t, "\"a\"", bodies[0], 40, 100, &kept, dropped) == 0);
+  assert(kept);
+  assert(etag_table_put(&t, "\"b\"", bodies[1], 40, 100, &kept, dropped) == 0);
+  // "a" was used last, so "b" gives up its body to make room for "c".
+  assert(etag_table_find(&t, "\"a\"")->body == bodies[0]);
+  assert(etag_table_put(&t, "\"c\"", bodies[2], 40, 100, &kept, dropped) == 1);
+  assert(kept && dropped[0] == bodies[1]);
+  assert(etag_table_find(&t, "\"b\"") && !etag_table_find(&t, "\"b\"")->body);
+  assert(t.count == 3 && t.body_bytes == 80);
+
+  // Over budget: validator only, body stays with the caller.
+  assert(etag_table_put(&t, "\"d\"", bodies[3], 101, 100, &kept, dropped) == 0);
+  assert(!kept && etag_table_find(&t, "\"d\"")->len == 101);
+
+  // Only entries with a body are offered, current first, no repeats.
+  char out[64];
+  etag_table_format_validators(&t, "\"a\"", out, sizeof(out));
+  assert(strcmp(out, "\"a\", \"c\"") == 0);
+  assert(etag_list_append(out, sizeof(out), "\"c\""));
+  assert(etag_list_append(out, sizeof(out), "W/\"a\""));
+  assert(strcmp(out, "\"a\", \"c\", W/\"a\"") == 0);
+  assert(!etag_list_append(out, 20, "\"zz\""));
+
+  // Positions by descending stamp.
+  const uint32_t uses[] = {5, 9, 1, 7};
+  int order[4];
+  etag_mru_order(uses, 4, order);
+  assert(order[0] == 1 && order[1] == 3 && order[2] == 0 && order[3] == 2);
+
+  // Replacing an entry hands back its old body; a full table evicts the LRU.
+  assert(etag_table_put(&t, "\"c\"", bodies[4], 10, 100, &kept, dropped) == 1);
+  assert(dropped[0] == bodies[2] && t.body_bytes == 50);
+  for (int i = t.count; i < ETAG_TABLE_SLOTS; i++) {
+    char etag[16];
+    snprintf(etag, sizeof(etag), "\"%d\"", i);
+    assert(etag_table_put(&t, etag, nullptr, 1, 100, &kept, dropped) == 0);
+  }
+  etag_table_find(&t, "\"b\"");
+  etag_table_find(&t, "\"d\"");
+  assert(etag_table_put(&t, "\"e\"", nullptr, 1, 100, &kept, dropped) == 1);
+  assert(dropped[0] == bodies[0] && !etag_table_find(&t, "\"a\""));
+  assert(t.count == ETAG_TABLE_SLOTS && t.body_bytes == 10);
+}
+
+static void test_image_cache_index() {
+  image_cache_index_t idx;
+  image_cache_index_init(&idx);
+  char victims[IMAGE_CACHE_MAX_ENTRIES][IMAGE_CACHE_KEY_MAX];
+
+  assert(image_cache_index_make_room(&idx, 400, 1000, victims, 4) == 0);
+  assert(image_cache_index_add(&idx, "\"a\"", 400) >= 0);
+  assert(image_cache_index_add(&idx, "\"b\"", 300) >= 0);
+  assert(image_cache_index_add(&idx, "W/\"c\"", 200) >= 0);
+  assert(idx.count == 3 && idx.bytes == 900);
+  assert(image_cache_index_add(&idx, "", 10) == -1);
+
+  // Most recently used first, after (and without repeating) what is listed.
+  char out[64] = "";
+  image_cache_index_append_validators(&idx, out, sizeof(out));
+  assert(strcmp(out, "W/\"c\", \"b\", \"a\"") == 0);
+  snprintf(out, sizeof(out), "\"b\"");
+  image_cache_index_append_validators(&idx, out, sizeof(out));
+  assert(strcmp(out, "\"b\", W/\"c\", \"a\"") == 0);
+  // Keys that do not fit are dropped whole.
+  out[0] = '\0';
+  assert(image_cache_index_append_validators(&idx, out, 12) == 10);
+  assert(strcmp(out, "W/\"c\", \"b\"") == 0);
+  // Content-hash keys are never offered as validators.
+  const char* hash_key = IMAGE_CACHE_HASH_PREFIX "00ff";
+  assert(image_cache_index_add(&idx, hash_key, 10) >= 0);
+  out[0] = '\0';
+  image_cache_index_append_validators(&idx, out, sizeof(out));
+  assert(strcmp(out, "W/\"c\", \"b\", \"a\"") == 0);
+  image_cache_index_remove(&idx, image_cache_index_find(&idx, hash_key));
+
+  // A hit on "a" makes "b" the eviction candidate.
+  image_cache_index_touch(&idx, image_cache_index_find(&idx, "\"a\""));
+  assert(image_cache_index_make_room(&idx, 200, 1000, victims, 4) == 1);
+  assert(strcmp(victims[0], "\"b\"") == 0);
+  assert(image_cache_index_find(&idx, "\"b\"") == -1);
+  assert(idx.count == 2 && idx.bytes == 600);
+
+  // Refusals leave the index untouched.
+  assert(image_cache_index_make_room(&idx, 1001, 1000, victims, 4) == -1);
+  assert(image_cache_index_make_room(&idx, 900, 1000, victims, 1) == -1);
+  assert(idx.count == 2);
+  assert(image_cache_index_make_room(&idx, 900, 1000, victims, 2) == 2);
+  assert(idx.count == 0 && idx.bytes == 0);
+
+  // Re-adding a key replaces its size; the entry cap forces eviction too.
+  image_cache_index_add(&idx, "\"a\"", 10);
+  image_cache_index_add(&idx, "\"a\"", 30);
+  assert(idx.count == 1 && idx.bytes == 30);
+  for (int i = 1; i < IMAGE_CACHE_MAX_ENTRIES; i++) {
+    char key[16];
+    snprintf(key, sizeof(key), "\"k%d\"", i);
+    assert(image_cache_index_add(&idx, key, 1) >= 0);
+  }
+  assert(image_cache_index_add(&idx, "\"x\"", 1) == -1);
+  assert(image_cache_index_make_room(&idx, 1, 1000, victims, 4) == 1);
+  assert(strcmp(victims[0], "\"a\"") == 0);
+
+  char name_a[IMAGE_CACHE_NAME_LEN], name_b[IMAGE_CACHE_NAME_LEN];
+  image_cache_file_name("\"a\"", name_a);
+  image_cache_file_name("\"b\"", name_b);
+  assert(strlen(name_a) == 16 && strcmp(name_a, name_b) != 0);
+
+  // Only a second sighting is worth a store; the oldest are forgotten first.
+  image_cache_seen_t seen;
+  image_cache_seen_init(&seen);
+  assert(!image_cache_seen_note(&seen, "\"a\""));
+  assert(image_cache_seen_note(&seen, "\"a\""));
+  assert(image_cache_seen_note(&seen, "\"a\""));
+  assert(!image_cache_seen_note(&seen, ""));
+  for (int i = 1; i < IMAGE_CACHE_SEEN_SLOTS; i++) {
+    char key[16];
+    snprintf(key, sizeof(key), "\"s%d\"", i);
+    assert(!image_cache_seen_note(&seen, key));
+  }
+  assert(image_cache_seen_note(&seen, "\"a\""));
+  assert(!image_cache_seen_note(&seen, "\"b\""));
+  assert(!image_cache_seen_note(&seen, "\"a\""));
 }
 
 int main() {
   test_ota_url_parser();
   test_config_mutation();
+  test_config_record();
+  test_config_snapshot();
   test_scheduler_fsm();
   test_tbup_parser();
   test_webp_frame_offsets();
+  test_ws_control();
+  test_playlist();
   test_quiet_hours();
+  test_quiet_hours_schedule();
+  test_event_routes();
+  test_event_ring();
+  test_diag_record();
+  test_diag_stage();
+  test_boot_timeline();
+  test_log_ring();
   test_outbox_ring();
+  test_frame_diff();
+  test_frame_diff_bounded();
+  test_frame_stats();
+  test_upscale2x();
+  test_image_slabs();
+  test_etag_table();
+  test_image_cache_index();
   printf("host_unit_tests: PASS\n");
   return 0;
 }